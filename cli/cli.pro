@@ -0,0 +1,27 @@
+!include(../qtpass.pri) { error("Couldn't find the qtpass.pri file!") }
+
+TEMPLATE   = app
+# only the wire format is shared with QtPass, the client does not link the
+# widgets or the backends
+QT         = core network
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+INCLUDEPATH += ../src
+
+TARGET = qtpass-cli
+
+SOURCES   += main.cpp \
+             ../src/localapi.cpp
+HEADERS   += ../src/localapi.h
+
+isEmpty(PREFIX) {
+ PREFIX = $$(PREFIX)
+}
+
+isEmpty(PREFIX) {
+ PREFIX = /usr/local
+}
+target.path = $$PREFIX/bin/
+
+INSTALLS += target
@@ -0,0 +1,241 @@
+#include "localapi.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QLocalSocket>
+#include <QProcess>
+#include <QTextStream>
+#include <QThread>
+
+static const int timeout = 1000;
+/**
+ * @brief daemonStartup how long a daemon started for the request gets to
+ * listen, in ms
+ */
+static const int daemonStartup = 5000;
+/**
+ * @brief replyTimeout default for --timeout, in seconds. Long enough to type
+ * a passphrase into pinentry.
+ */
+static const int replyTimeout = 60;
+
+/**
+ * @brief usage print the supported commands
+ * @return exit code for wrong usage
+ */
+static int usage() {
+  QTextStream(stderr)
+      << "Usage: qtpass-cli [--timeout <seconds>] <command> [arguments]\n"
+         "\n"
+         "  --timeout <seconds>    wait this long for the answer, 0 for no\n"
+         "                         limit, the default is 60\n"
+         "\n"
+         "  status                 show what is being served\n"
+         "  ls                     list all entries\n"
+         "  search <query>         list entries matching query\n"
+         "  match <url>            list entries for a URL or host name,\n"
+         "                         best match first\n"
+         "  show <entry> [field]   print an entry or one of its fields\n"
+         "  copy <entry> [field]   copy the password or a field to the\n"
+         "                         clipboard of the running QtPass\n"
+         "  otp <entry>            print the current OTP code\n"
+         "  generate [length]      print a new random password\n";
+  return 2;
+}
+
+/**
+ * @brief buildRequest turn the command line into a LocalApi request
+ * @param args  command line without the program name
+ * @param request receives the request
+ * @return false if the command line is not valid
+ */
+static bool buildRequest(QStringList args, QJsonObject *request) {
+  if (args.isEmpty())
+    return false;
+  QString cmd = args.takeFirst();
+  if (cmd == "ls")
+    cmd = "list";
+  *request = LocalApi::request(cmd);
+
+  if ((cmd == "status" || cmd == "list") && args.isEmpty())
+    return true;
+  if (cmd == "search") {
+    (*request)["query"] = args.join(" ");
+    return true;
+  }
+  if (cmd == "match" && args.size() == 1) {
+    (*request)["url"] = args.at(0);
+    return true;
+  }
+  if ((cmd == "show" || cmd == "copy") && !args.isEmpty() &&
+      args.size() <= 2) {
+    (*request)["entry"] = args.at(0);
+    if (args.size() == 2)
+      (*request)["field"] = args.at(1);
+    return true;
+  }
+  if (cmd == "otp" && args.size() == 1) {
+    (*request)["entry"] = args.at(0);
+    return true;
+  }
+  if (cmd == "generate" && args.size() <= 1) {
+    if (args.isEmpty())
+      return true;
+    bool ok;
+    (*request)["length"] = args.at(0).toInt(&ok);
+    return ok;
+  }
+  return false;
+}
+
+/**
+ * @brief askRunningInstance send the request to a running QtPass or daemon
+ * @param key       socket name of the running instance
+ * @param request
+ * @param seconds   how long to wait for the reply, 0 for no limit
+ * @param reply     receives the answer
+ * @return false if nothing is running, true once there is a reply
+ */
+static bool askRunningInstance(const QString &key, const QJsonObject &request,
+                               int seconds, QJsonObject *reply) {
+  QLocalSocket socket;
+  socket.connectToServer(key);
+  if (!socket.waitForConnected(timeout))
+    return false;
+
+  socket.write(LocalApi::frame(request));
+  QElapsedTimer waiting;
+  waiting.start();
+  QByteArray buffer;
+  forever {
+    switch (LocalApi::takeFrame(buffer, reply)) {
+    case LocalApi::FRAME_OK:
+      return true;
+    case LocalApi::FRAME_INVALID:
+      *reply = LocalApi::errorReply(request, "Invalid reply");
+      return true;
+    case LocalApi::FRAME_INCOMPLETE:
+      break;
+    }
+    // decryption may wait for a pinentry, the default leaves time for it
+    int left = seconds > 0 ? qMax(qint64(1), seconds * 1000 - waiting.elapsed())
+                           : -1;
+    if (!socket.waitForReadyRead(int(left))) {
+      QString error = socket.error() == QLocalSocket::SocketTimeoutError
+                          ? QString("No reply within %1 seconds").arg(seconds)
+                          : socket.errorString();
+      *reply = LocalApi::errorReply(request, error);
+      return true;
+    }
+    buffer.append(socket.readAll());
+  }
+}
+
+/**
+ * @brief startDaemon start "qtpass --daemon" to answer the request when
+ * nothing is running, the client itself does not link the backends
+ * @param key   socket name the daemon listens on
+ * @return whether it is listening
+ */
+static bool startDaemon(const QString &key) {
+  QString qtpass = QDir(QCoreApplication::applicationDirPath())
+                       .absoluteFilePath("qtpass");
+  if (!QFileInfo(qtpass).isExecutable())
+    qtpass = "qtpass";
+  if (!QProcess::startDetached(qtpass, QStringList("--daemon")))
+    return false;
+  QElapsedTimer waiting;
+  waiting.start();
+  while (waiting.elapsed() < daemonStartup) {
+    QLocalSocket socket;
+    socket.connectToServer(key);
+    if (socket.waitForConnected(timeout))
+      return true;
+    QThread::msleep(100);
+  }
+  return false;
+}
+
+/**
+ * @brief printReply write the result of a successful request to stdout
+ * @param reply
+ */
+static void printReply(const QJsonObject &reply) {
+  QTextStream out(stdout);
+  if (reply.contains("entries") && reply.value("entries").isArray()) {
+    foreach (const QJsonValue &entry, reply.value("entries").toArray())
+      out << entry.toString() << "\n";
+  } else if (reply.contains("value")) {
+    out << reply.value("value").toString() << "\n";
+  } else if (reply.contains("code")) {
+    out << reply.value("code").toString() << "\n";
+  } else if (reply.contains("fields")) {
+    out << reply.value("password").toString() << "\n";
+    QJsonObject fields = reply.value("fields").toObject();
+    for (auto it = fields.constBegin(); it != fields.constEnd(); ++it)
+      out << it.key() << ": " << it.value().toString() << "\n";
+    out << reply.value("remaining").toString();
+  } else if (reply.contains("password")) {
+    out << reply.value("password").toString() << "\n";
+  } else {
+    QStringList internal = {"v", "id", "ok"};
+    for (auto it = reply.constBegin(); it != reply.constEnd(); ++it) {
+      if (!internal.contains(it.key()))
+        out << it.key() << ": " << it.value().toVariant().toString() << "\n";
+    }
+  }
+}
+
+/**
+ * @brief main qtpass-cli, ask the running QtPass or daemon, start the daemon
+ * when neither runs.
+ * @param argc
+ * @param argv
+ * @return 0 on success, 1 on errors, 2 on wrong usage
+ */
+int main(int argc, char *argv[]) {
+  QCoreApplication::setOrganizationName("IJHack");
+  QCoreApplication::setOrganizationDomain("ijhack.org");
+  QCoreApplication::setApplicationName("QtPass");
+  QCoreApplication::setApplicationVersion(VERSION);
+  QCoreApplication app(argc, argv);
+
+  QStringList args = app.arguments().mid(1);
+  int seconds = replyTimeout;
+  if (!args.isEmpty() && args.first() == "--timeout") {
+    bool ok = args.size() > 1;
+    if (ok)
+      seconds = args.at(1).toInt(&ok);
+    if (!ok || seconds < 0)
+      return usage();
+    args = args.mid(2);
+  }
+  QJsonObject request;
+  if (!buildRequest(args, &request))
+    return usage();
+
+  QString name = qgetenv("USER");
+  if (name.isEmpty())
+    name = qgetenv("USERNAME");
+  // the GUI first, it has the clipboard
+  QString gui = name + "QtPass";
+  QString daemon = name + "QtPass-daemon";
+
+  QJsonObject reply;
+  if (!askRunningInstance(gui, request, seconds, &reply) &&
+      !askRunningInstance(daemon, request, seconds, &reply) &&
+      (!startDaemon(daemon) ||
+       !askRunningInstance(daemon, request, seconds, &reply)))
+    reply = LocalApi::errorReply(request, "QtPass is not running and its "
+                                          "daemon could not be started");
+
+  if (!reply.value("ok").toBool()) {
+    QTextStream(stderr) << "qtpass-cli: " << reply.value("error").toString()
+                        << "\n";
+    return 1;
+  }
+  printReply(reply);
+  return 0;
+}
@@ -1,5 +1,9 @@
 #include "mainwindow.h"
+#include "startupprofile.h"
+#include "tracer.h"
 #if SINGLE_APP
+#include "daemon.h"
+#include "localapiserver.h"
 #include "singleapplication.h"
 #endif
 
@@ -39,22 +43,55 @@
  * @return
  */
 int main(int argc, char *argv[]) {
+  StartupProfile::start();
   QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
   QString text = "";
+  QString traceFile;
   for (int i = 1; i < argc; ++i) {
-    if (i > 1)
+    // --trace <file>: record spans and write them there on exit
+    if (QString(argv[i]) == "--trace" && i + 1 < argc) {
+      traceFile = QString::fromLocal8Bit(argv[++i]);
+      continue;
+    }
+    if (QString(argv[i]) == "--profile-startup") {
+      StartupProfile::setEnabled(true);
+      continue;
+    }
+    if (!text.isEmpty())
       text += " ";
     text += argv[i];
   }
+  if (!traceFile.isEmpty())
+    Tracer::setEnabled(true);
+  StartupProfile::phase("arguments");
 
   if ((text.indexOf("-psn_") == 0) || (text.indexOf("-session") == 0)) {
     text.clear();
   }
 
+  QCoreApplication::setOrganizationName("IJHack");
+  QCoreApplication::setOrganizationDomain("ijhack.org");
+  QCoreApplication::setApplicationName("QtPass");
+  QCoreApplication::setApplicationVersion(VERSION);
+
 #if SINGLE_APP
   QString name = qgetenv("USER");
   if (name.isEmpty())
     name = qgetenv("USERNAME");
+
+  // headless: no widgets, so no display needed. A key of its own, the GUI
+  // can still be started while the daemon runs.
+  if (text == "--daemon") {
+    QCoreApplication app(argc, argv);
+    Daemon daemon(name + "QtPass-daemon");
+    if (!daemon.start())
+      return 1;
+    int status = app.exec();
+    if (!traceFile.isEmpty())
+      Tracer::write(traceFile);
+    return status;
+  }
+
   SingleApplication app(argc, argv, name + "QtPass");
   if (app.isRunning()) {
     if (text.length() > 0)
@@ -64,11 +101,7 @@ int main(int argc, char *argv[]) {
 #else
   QApplication app(argc, argv);
 #endif
-
-  QCoreApplication::setOrganizationName("IJHack");
-  QCoreApplication::setOrganizationDomain("ijhack.org");
-  QCoreApplication::setApplicationName("QtPass");
-  QCoreApplication::setApplicationVersion(VERSION);
+  StartupProfile::phase("application");
 
   // Setup and load translator for localization
   QTranslator translator;
@@ -80,6 +113,7 @@ int main(int argc, char *argv[]) {
   app.installTranslator(&translator);
   app.setLayoutDirection(QObject::tr("LTR") == "RTL" ? Qt::RightToLeft
                                                      : Qt::LeftToRight);
+  StartupProfile::phase("translator");
   MainWindow w(text);
 
   app.setActiveWindow(&w);
@@ -89,9 +123,16 @@ int main(int argc, char *argv[]) {
 #if SINGLE_APP
   QObject::connect(&app, SIGNAL(messageAvailable(QString)), &w,
                    SLOT(messageAvailable(QString)));
+  if (app.localApi())
+    QObject::connect(app.localApi(), SIGNAL(copyToClipboard(QString)), &w,
+                     SLOT(copyTextToClipboard(QString)));
 #endif
 
   w.show();
+  StartupProfile::phase("show");
 
-  return app.exec();
+  int status = app.exec();
+  if (!traceFile.isEmpty())
+    Tracer::write(traceFile);
+  return status;
 }
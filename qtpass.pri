@@ -11,13 +11,13 @@ CONFIG(debug, debug|release) {
 }
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+QT += network
 
 clang|gcc:QMAKE_CXXFLAGS_WARN_ON += -Wno-unknown-pragmas
 
 nosingleapp {
     QMAKE_CXXFLAGS += -DSINGLE_APP=0
 } else {
-    QT      += network
     QMAKE_CXXFLAGS += -DSINGLE_APP=1
 }
 
@@ -70,7 +70,7 @@ win32 {
     }
     gcc:QMAKE_LFLAGS += -Wl,--dynamicbase -Wl,--nxcompat
     msvc:QMAKE_LFLAGS += /DYNAMICBASE /NXCOMPAT
-    LIBS    += -lmpr -lbcrypt
+    LIBS    += -lbcrypt
 } else:macx {
     ICON = ../artwork/icon.icns
     QMAKE_INFO_PLIST = $$(PWD)/qtpass.plist
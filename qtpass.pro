@@ -5,6 +5,10 @@ SUBDIRS += src tests main
 main.depends = src
 tests.depends = main
 
+!nosingleapp {
+    SUBDIRS += cli
+}
+
 OTHER_FILES += LICENSE \
                README.md \
                qtpass.1
@@ -23,6 +27,20 @@ codecov.commands += cd src/ && codecov $$escape_expand(\\n\\t)
 codecov.commands += $$escape_expand(\\n)
 codecov.depends = check
 
+# add Makefile target to run the benchmarks, see tests/bench. They are not
+# part of the normal build, the targets generate their Makefile on demand.
+benchmakefile.target = tests/bench/Makefile
+benchmakefile.commands = $(MKDIR) tests/bench && cd tests/bench && \
+    $(QMAKE) $$PWD/tests/bench/bench.pro
+benchmakefile.depends = sub-src
+bench.target = bench
+bench.commands = cd tests/bench && $(MAKE) bench
+bench.depends = benchmakefile
+benchcompare.target = bench-compare
+benchcompare.commands = cd tests/bench && $(MAKE) bench-compare
+benchcompare.depends = benchmakefile
+unix: QMAKE_EXTRA_TARGETS += benchmakefile bench benchcompare
+
 LCOV_OUTPUT_DIR = src/$$OBJECTS_DIR/lcov/
 # add Makefile target to generate code coverage using lcov
 lcov_initial.target = lcov_initial
@@ -41,6 +41,7 @@ ConfigDialog::ConfigDialog(MainWindow *parent)
   ui->plainTextEditTemplate->setPlainText(QtPassSettings::getPassTemplate());
   ui->checkBoxTemplateAllFields->setChecked(
       QtPassSettings::isTemplateAllFields());
+  ui->checkBoxUseFieldIndex->setChecked(QtPassSettings::isUseFieldIndex());
   ui->checkBoxAutoPull->setChecked(QtPassSettings::isAutoPull());
   ui->checkBoxAutoPush->setChecked(QtPassSettings::isAutoPush());
   ui->checkBoxAlwaysOnTop->setChecked(QtPassSettings::isAlwaysOnTop());
@@ -155,6 +156,7 @@ void ConfigDialog::on_accepted() {
   QtPassSettings::setPassTemplate(ui->plainTextEditTemplate->toPlainText());
   QtPassSettings::setTemplateAllFields(
       ui->checkBoxTemplateAllFields->isChecked());
+  QtPassSettings::setUseFieldIndex(ui->checkBoxUseFieldIndex->isChecked());
   QtPassSettings::setAutoPush(ui->checkBoxAutoPush->isChecked());
   QtPassSettings::setAutoPull(ui->checkBoxAutoPull->isChecked());
   QtPassSettings::setAlwaysOnTop(ui->checkBoxAlwaysOnTop->isChecked());
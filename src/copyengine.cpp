@@ -0,0 +1,280 @@
+#include "copyengine.h"
+#include "debughelper.h"
+#include <QAtomicInt>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QRunnable>
+#include <QThreadPool>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief CopyEngine::copyFile copy one file, never overwriting dest
+ * @param src
+ * @param dest
+ * @param error     why it failed
+ * @return how the file was copied, FAILED if it was not
+ */
+CopyEngine::Method CopyEngine::copyFile(const QString &src,
+                                        const QString &dest, QString *error) {
+  QString reason;
+  if (!error)
+    error = &reason;
+  if (QFileInfo::exists(dest)) {
+    *error = QObject::tr("%1 already exists").arg(dest);
+    return FAILED;
+  }
+#ifdef Q_OS_LINUX
+  return copyFileNative(src, dest, error);
+#else
+  if (!QFile::copy(src, dest)) {
+    *error = QObject::tr("Could not copy %1 to %2").arg(src).arg(dest);
+    return FAILED;
+  }
+  return BUFFERED;
+#endif
+}
+
+#ifdef Q_OS_LINUX
+/**
+ * @brief copyRange copy_file_range all of in to out
+ * @param in
+ * @param out
+ * @param size
+ * @return bytes copied, -1 if the kernel or filesystem can not do it
+ */
+static qint64 copyRange(int in, int out, qint64 size) {
+#ifdef SYS_copy_file_range
+  qint64 copied = 0;
+  while (copied < size) {
+    ssize_t n = syscall(SYS_copy_file_range, in, nullptr, out, nullptr,
+                        static_cast<size_t>(size - copied), 0u);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return copied == 0 && n < 0 ? -1 : copied;
+    copied += n;
+  }
+  return copied;
+#else
+  Q_UNUSED(in)
+  Q_UNUSED(out)
+  Q_UNUSED(size)
+  return -1;
+#endif
+}
+
+/**
+ * @brief copyBuffered read and write the rest of in to out
+ * @param in
+ * @param out
+ * @return false on a read or write error
+ */
+static bool copyBuffered(int in, int out) {
+  char buffer[64 * 1024];
+  for (;;) {
+    ssize_t n = ::read(in, buffer, sizeof(buffer));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0)
+      return false;
+    if (n == 0)
+      return true;
+    for (ssize_t written = 0; written < n;) {
+      ssize_t w = ::write(out, buffer + written, n - written);
+      if (w < 0 && errno == EINTR)
+        continue;
+      if (w < 0)
+        return false;
+      written += w;
+    }
+  }
+}
+#endif
+
+/**
+ * @brief CopyEngine::copyFileNative clone, copy in the kernel or copy
+ * through a buffer, whatever works first
+ * @param src
+ * @param dest
+ * @param error
+ * @return how the file was copied
+ */
+CopyEngine::Method CopyEngine::copyFileNative(const QString &src,
+                                              const QString &dest,
+                                              QString *error) {
+#ifdef Q_OS_LINUX
+  QByteArray srcName = QFile::encodeName(src);
+  QByteArray destName = QFile::encodeName(dest);
+  int in = ::open(srcName.constData(), O_RDONLY | O_CLOEXEC);
+  struct stat info;
+  if (in < 0 || ::fstat(in, &info) != 0) {
+    *error = QObject::tr("Could not read %1: %2").arg(src).arg(
+        QString::fromLocal8Bit(strerror(errno)));
+    if (in >= 0)
+      ::close(in);
+    return FAILED;
+  }
+  mode_t mode = info.st_mode & 07777;
+  int out = ::open(destName.constData(),
+                   O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, mode | S_IWUSR);
+  if (out < 0) {
+    *error = QObject::tr("Could not create %1: %2").arg(dest).arg(
+        QString::fromLocal8Bit(strerror(errno)));
+    ::close(in);
+    return FAILED;
+  }
+
+  // errno of what failed, close() and unlink() may change it afterwards
+  int failure = 0;
+  Method method = FAILED;
+#ifdef FICLONE
+  if (::ioctl(out, FICLONE, in) == 0)
+    method = REFLINK;
+#endif
+  if (method == FAILED) {
+    qint64 copied = copyRange(in, out, info.st_size);
+    if (copied == info.st_size)
+      method = COPY_FILE_RANGE;
+    else if (copied < 0 && ::ftruncate(out, 0) == 0)
+      method = copyBuffered(in, out) ? BUFFERED : FAILED;
+    else if (copied >= 0 && copyBuffered(in, out))
+      // the file grew while it was copied
+      method = COPY_FILE_RANGE;
+    if (method == FAILED)
+      failure = errno;
+  }
+  // the umask may have taken bits away
+  if (method != FAILED && ::fchmod(out, mode) != 0) {
+    failure = errno;
+    method = FAILED;
+  }
+  if (::close(out) != 0 && method != FAILED) {
+    failure = errno;
+    method = FAILED;
+  }
+  ::close(in);
+  if (method == FAILED) {
+    *error = QObject::tr("Could not copy %1 to %2: %3")
+                 .arg(src)
+                 .arg(dest)
+                 .arg(QString::fromLocal8Bit(strerror(failure)));
+    ::unlink(destName.constData());
+  }
+  return method;
+#else
+  Q_UNUSED(src)
+  Q_UNUSED(dest)
+  Q_UNUSED(error)
+  return FAILED;
+#endif
+}
+
+/*!
+    \class CopyFolderFiles
+    \brief Copies the files of one folder, run on the pool of copyTree.
+ */
+class CopyFolderFiles : public QRunnable {
+public:
+  CopyFolderFiles(const QString &src, const QString &dest,
+                  const QStringList &files, QAtomicInt *failed, QMutex *mutex,
+                  QString *error)
+      : m_src(src), m_dest(dest), m_files(files), m_failed(failed),
+        m_mutex(mutex), m_error(error) {}
+
+  void run() Q_DECL_OVERRIDE {
+    foreach (const QString &file, m_files) {
+      if (m_failed->load())
+        return;
+      QString error;
+      if (CopyEngine::copyFile(m_src + "/" + file, m_dest + "/" + file,
+                               &error) == CopyEngine::FAILED) {
+        QMutexLocker lock(m_mutex);
+        if (m_failed->testAndSetOrdered(0, 1))
+          *m_error = error;
+        return;
+      }
+    }
+  }
+
+private:
+  QString m_src;
+  QString m_dest;
+  QStringList m_files;
+  QAtomicInt *m_failed;
+  QMutex *m_mutex;
+  QString *m_error;
+};
+
+/**
+ * @brief CopyEngine::copyTree copy a folder with everything in it,
+ * including hidden files like .gpg-id
+ * @param src
+ * @param dest      must not exist yet, or be an empty folder
+ * @param error     why it failed
+ * @param threads   how many folders are copied at once, 0 for one per core
+ * @return false if anything could not be copied, what was copied is left
+ */
+bool CopyEngine::copyTree(const QString &src, const QString &dest,
+                          QString *error, int threads) {
+  QString reason;
+  if (!error)
+    error = &reason;
+  QDir srcDir(src);
+  if (!srcDir.exists()) {
+    *error = QObject::tr("%1 does not exist").arg(src);
+    return false;
+  }
+
+  // folders first, so the workers never have to create any. They stay
+  // writable until the files are in, a read-only source folder would
+  // keep the workers out otherwise.
+  QStringList dirs = {QString()};
+  QDirIterator it(src, QDir::Dirs | QDir::Hidden | QDir::NoDotAndDotDot,
+                  QDirIterator::Subdirectories);
+  while (it.hasNext())
+    dirs << srcDir.relativeFilePath(it.next());
+  foreach (const QString &dir, dirs) {
+    QString target = QDir::cleanPath(dest + "/" + dir);
+    if (!QDir().mkpath(target)) {
+      *error = QObject::tr("Could not create %1").arg(target);
+      return false;
+    }
+  }
+
+  QThreadPool pool;
+  if (threads > 0)
+    pool.setMaxThreadCount(threads);
+  QAtomicInt failed(0);
+  QMutex mutex;
+  foreach (const QString &dir, dirs) {
+    QString from = QDir::cleanPath(src + "/" + dir);
+    QStringList files =
+        QDir(from).entryList(QDir::Files | QDir::Hidden | QDir::System);
+    if (files.isEmpty())
+      continue;
+    pool.start(new CopyFolderFiles(from, QDir::cleanPath(dest + "/" + dir),
+                                   files, &failed, &mutex, error));
+  }
+  pool.waitForDone();
+  // deepest first, a parent that loses its write bit does not matter then
+  for (int n = dirs.size() - 1; n >= 0; --n)
+    QFile::setPermissions(QDir::cleanPath(dest + "/" + dirs.at(n)),
+                          QFileInfo(srcDir.filePath(dirs.at(n))).permissions());
+  if (failed.load())
+    dbg() << "copyTree" << src << "to" << dest << "failed:" << *error;
+  return !failed.load();
+}
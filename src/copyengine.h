@@ -0,0 +1,37 @@
+#ifndef COPYENGINE_H
+#define COPYENGINE_H
+
+#include <QString>
+
+/*!
+    \class CopyEngine
+    \brief Copies files and folder trees the cheapest way the filesystem
+    allows.
+
+    On Linux a file is first cloned with the FICLONE ioctl, which shares the
+    data blocks on Btrfs, XFS and the like, then copied in the kernel with
+    copy_file_range, and only then through a buffer. Elsewhere QFile::copy
+    is used. Permissions are kept either way.
+
+    copyTree creates all folders first and then copies the files of each
+    folder on a thread pool, so trees with many folders are copied in
+    parallel.
+ */
+class CopyEngine {
+public:
+  /**
+   * @brief Method  how a file was copied
+   */
+  enum Method { FAILED = -1, REFLINK = 0, COPY_FILE_RANGE, BUFFERED };
+
+  static Method copyFile(const QString &src, const QString &dest,
+                         QString *error = nullptr);
+  static bool copyTree(const QString &src, const QString &dest,
+                       QString *error = nullptr, int threads = 0);
+
+private:
+  static Method copyFileNative(const QString &src, const QString &dest,
+                               QString *error);
+};
+
+#endif // COPYENGINE_H
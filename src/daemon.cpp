@@ -0,0 +1,99 @@
+#include "daemon.h"
+#include "debughelper.h"
+#include "localapiserver.h"
+#include "qtpasssettings.h"
+
+#include <QLocalSocket>
+
+/**
+ * @brief Daemon::Daemon headless backend, call start to run it.
+ * @param uniqueKey name of the shared memory and socket, not the one a GUI
+ * instance uses.
+ * @param parent
+ */
+Daemon::Daemon(const QString &uniqueKey, QObject *parent)
+    : QObject(parent), m_uniqueKey(uniqueKey), m_server(nullptr) {
+  m_syncTimer.setInterval(syncInterval);
+  connect(&m_syncTimer, &QTimer::timeout, this, &Daemon::sync);
+}
+
+/**
+ * @brief Daemon::start claim the single instance, start serving and
+ * scheduling pulls.
+ * @return false when another daemon is running or the socket can not be
+ * set up
+ */
+bool Daemon::start() {
+  m_sharedMemory.setKey(m_uniqueKey);
+  if (m_sharedMemory.attach()) {
+    QLocalSocket probe;
+    probe.connectToServer(m_uniqueKey);
+    if (probe.waitForConnected(timeout)) {
+      qWarning() << "The QtPass daemon is already running";
+      return false;
+    }
+    // left behind by an instance that did not shut down cleanly
+    m_sharedMemory.detach();
+  }
+  if (!m_sharedMemory.create(1)) {
+    qWarning() << "Unable to create single instance:"
+               << m_sharedMemory.errorString();
+    return false;
+  }
+
+  m_server = new LocalApiServer(this);
+  connect(m_server, &LocalApiServer::messageAvailable, this,
+          &Daemon::messageAvailable);
+  if (!m_server->listen(m_uniqueKey)) {
+    qWarning() << "Unable to listen:" << m_server->errorString();
+    return false;
+  }
+  // build the index now instead of on the first request
+  m_server->index()->entries();
+
+  Pass *pass = QtPassSettings::getPass();
+  pass->updateEnv();
+  connect(pass, &Pass::finishedGitPull, this, &Daemon::syncFinished);
+  connect(pass, &Pass::processErrorExit, this, &Daemon::processErrorExit);
+
+  m_syncTimer.start();
+  sync();
+  return true;
+}
+
+/**
+ * @brief Daemon::sync pull the store if the settings ask for it
+ */
+void Daemon::sync() {
+  if (!QtPassSettings::isUseGit() || !QtPassSettings::isAutoPull())
+    return;
+  dbg() << "Pulling password-store";
+  QtPassSettings::getPass()->GitPull();
+}
+
+/**
+ * @brief Daemon::syncFinished the pull changed the store, do not wait for
+ * the file system watcher to catch up.
+ */
+void Daemon::syncFinished(const QString &, const QString &) {
+  m_server->index()->invalidate();
+}
+
+/**
+ * @brief Daemon::processErrorExit there is nobody to show errors to, log
+ * them instead.
+ * @param exitCode
+ * @param err
+ */
+void Daemon::processErrorExit(int exitCode, const QString &err) {
+  qWarning() << "Process exited with code" << exitCode << err.trimmed();
+}
+
+/**
+ * @brief Daemon::messageAvailable a legacy message reached the daemon
+ * socket, there is no window to show.
+ * @param message
+ */
+void Daemon::messageAvailable(QString message) {
+  qWarning() << "Running as daemon, ignoring:" << message;
+}
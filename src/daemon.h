@@ -0,0 +1,42 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <QObject>
+#include <QSharedMemory>
+#include <QTimer>
+
+/*!
+    \class Daemon
+    \brief Runs the QtPass backend without any widgets.
+
+    Serves the LocalApi on a socket of its own, next to the one of a GUI
+    instance, so both can run at the same time. Keeps the store index warm
+    and pulls the git repository periodically when git and automatic
+    pulling are enabled. Meant for headless machines that look up secrets
+    often, started with "qtpass --daemon".
+ */
+class LocalApiServer;
+class Daemon : public QObject {
+  Q_OBJECT
+
+public:
+  explicit Daemon(const QString &uniqueKey, QObject *parent = nullptr);
+  bool start();
+
+private slots:
+  void sync();
+  void syncFinished(const QString &, const QString &);
+  void processErrorExit(int exitCode, const QString &err);
+  void messageAvailable(QString message);
+
+private:
+  QString m_uniqueKey;
+  QSharedMemory m_sharedMemory;
+  LocalApiServer *m_server;
+  QTimer m_syncTimer;
+
+  static const int timeout = 1000;
+  static const int syncInterval = 5 * 60 * 1000;
+};
+
+#endif // DAEMON_H
@@ -40,7 +40,11 @@ private:
    * @param event
    */
   virtual void mousePressEvent(QMouseEvent *event) {
-    clickSelected = selectionModel()->isSelected(indexAt(event->pos()));
+    // ctrl and shift clicks change a multi-selection, and a click in one
+    // selects just that item
+    clickSelected = event->modifiers() == Qt::NoModifier &&
+                    selectionModel()->selectedRows().size() <= 1 &&
+                    selectionModel()->isSelected(indexAt(event->pos()));
     QTreeView::mousePressEvent(event);
   }
 
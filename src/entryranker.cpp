@@ -0,0 +1,115 @@
+#include "entryranker.h"
+
+#include <QPair>
+#include <algorithm>
+
+/**
+ * @brief EntryRanker::EntryRanker ranker without entries, see setEntries
+ */
+EntryRanker::EntryRanker() {}
+
+/**
+ * @brief EntryRanker::setEntries replace the entries to rank
+ * @param entries   relative entry paths without .gpg suffix, see
+ *                  StoreIndex::entries
+ */
+void EntryRanker::setEntries(const QStringList &entries) {
+  m_entries = entries;
+  m_lower.clear();
+  m_lower.reserve(entries.size());
+  foreach (const QString &entry, entries)
+    m_lower.append(entry.toLower());
+  m_query.clear();
+  m_matches.clear();
+}
+
+/**
+ * @brief EntryRanker::size
+ * @return number of entries
+ */
+int EntryRanker::size() const { return m_entries.size(); }
+
+/**
+ * @brief EntryRanker::rank find the best entries for a query
+ * @param query text typed so far
+ * @param limit most entries to return
+ * @return best entry first, the first entries in order for an empty query
+ */
+QStringList EntryRanker::rank(const QString &query, int limit) {
+  QString lower = query.toLower();
+  QStringList terms = lower.split(' ', QString::SkipEmptyParts);
+  if (terms.isEmpty()) {
+    m_query.clear();
+    m_matches.clear();
+    return m_entries.mid(0, limit);
+  }
+
+  // what does not match "ab" does not match "abc" or "ab c" either
+  bool narrow = !m_query.isEmpty() && lower.startsWith(m_query);
+  int count = narrow ? m_matches.size() : m_lower.size();
+  QVector<QPair<int, int>> scored;
+  QVector<int> matches;
+  matches.reserve(count);
+  for (int n = 0; n < count; ++n) {
+    int entry = narrow ? m_matches.at(n) : n;
+    int points = score(m_lower.at(entry), terms);
+    if (points < 0)
+      continue;
+    matches.append(entry);
+    scored.append(qMakePair(points, entry));
+  }
+  m_query = lower;
+  m_matches = matches;
+
+  const QStringList &entries = m_entries;
+  auto better = [&entries](const QPair<int, int> &a,
+                           const QPair<int, int> &b) {
+    if (a.first != b.first)
+      return a.first > b.first;
+    return entries.at(a.second) < entries.at(b.second);
+  };
+  int top = qMin(limit, scored.size());
+  std::partial_sort(scored.begin(), scored.begin() + top, scored.end(),
+                    better);
+  QStringList ranked;
+  for (int n = 0; n < top; ++n)
+    ranked.append(m_entries.at(scored.at(n).second));
+  return ranked;
+}
+
+/**
+ * @brief EntryRanker::score how well an entry matches the terms of a query
+ * @param lowerEntry    entry path in lower case
+ * @param lowerTerms    terms of the query in lower case
+ * @return -1 if a term is missing, higher is better otherwise
+ */
+int EntryRanker::score(const QString &lowerEntry,
+                       const QStringList &lowerTerms) {
+  static const QString wordStart = "/.-_@ ";
+  int nameStart = lowerEntry.lastIndexOf('/') + 1;
+  int points = 0;
+  int from = 0;
+  for (int n = 0; n < lowerTerms.size(); ++n) {
+    const QString &term = lowerTerms.at(n);
+    int pos = -1;
+    // the last term is best found in the name, "git" in "github/git"
+    if (n == lowerTerms.size() - 1 && from < nameStart)
+      pos = lowerEntry.indexOf(term, nameStart);
+    if (pos < 0)
+      pos = lowerEntry.indexOf(term, from);
+    if (pos < 0)
+      return -1;
+    if (pos == 0 || wordStart.contains(lowerEntry.at(pos - 1)))
+      points += 10;
+    from = pos + term.size();
+    if (n == lowerTerms.size() - 1 && pos >= nameStart) {
+      points += 20;
+      if (pos == nameStart)
+        points += 10;
+      if (pos == nameStart && from == lowerEntry.size())
+        points += 50;
+    }
+  }
+  // shorter paths are closer to what was typed
+  return points * 256 + 255 - qMin(lowerEntry.size(), 255);
+}
@@ -0,0 +1,41 @@
+#ifndef ENTRYRANKER_H
+#define ENTRYRANKER_H
+
+#include <QStringList>
+#include <QVector>
+
+/*!
+    \class EntryRanker
+    \brief Ranks the entries of a store against a search, for quick open.
+
+    Terms are separated by spaces and have to be found in the entry path in
+    that order, case is ignored, like the search box does it. Hits at the
+    start of a word and in the name of the entry, after the last "/", rank
+    higher, then shorter paths, then the path itself.
+
+    The lower case paths are kept, so a keystroke only has to look for the
+    terms in plain strings. When a query continues the previous one, only
+    the entries that matched that one are searched again.
+ */
+class EntryRanker {
+public:
+  EntryRanker();
+
+  void setEntries(const QStringList &entries);
+  int size() const;
+  QStringList rank(const QString &query, int limit);
+
+  static int score(const QString &lowerEntry, const QStringList &lowerTerms);
+
+private:
+  QStringList m_entries;
+  QStringList m_lower;
+  /**
+   * @brief m_query the previous query, m_matches the entries that matched
+   * it
+   */
+  QString m_query;
+  QVector<int> m_matches;
+};
+
+#endif // ENTRYRANKER_H
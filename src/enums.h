@@ -32,6 +32,9 @@ enum PROCESS {
   PROCESS_COUNT,
   INVALID,
   PASS_OTP_GENERATE,
+  PASS_IMPORT,
+  PASS_EXPORT,
+  PASS_INDEX,
 };
 
 } // namespace Enums
@@ -1,14 +1,21 @@
 #include "executor.h"
 #include "debughelper.h"
+#include "securebuffer.h"
+#include "tracer.h"
+#include "transaction.h"
 #include <QCoreApplication>
 #include <QDir>
-#include <QTextCodec>
+#include <utility>
 
 /**
  * @brief Executor::Executor executes external applications
  * @param parent
  */
-Executor::Executor(QObject *parent) : QObject(parent), running(false) {
+Executor::Executor(QObject *parent)
+    : QObject(parent), running(false), m_timedOut(false),
+      m_failedToStart(false), m_defaultTimeout(2 * 60 * 1000),
+      m_blockingTimeout(2 * 60 * 1000), m_started(0), m_spawned(0),
+      m_bytesIn(0) {
   connect(&m_process,
           static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(
               &QProcess::finished),
@@ -16,6 +23,12 @@ Executor::Executor(QObject *parent) : QObject(parent), running(false) {
           static_cast<void (Executor::*)(int, QProcess::ExitStatus)>(
               &Executor::finished));
   connect(&m_process, &QProcess::started, this, &Executor::starting);
+  connect(&m_process, &QProcess::started, this,
+          [this]() { m_spawned = Tracer::now(); });
+  connect(&m_process, SIGNAL(error(QProcess::ProcessError)), this,
+          SLOT(processError(QProcess::ProcessError)));
+  m_watchdog.setSingleShot(true);
+  connect(&m_watchdog, &QTimer::timeout, this, &Executor::watchdog);
 }
 
 /**
@@ -26,16 +39,37 @@ void Executor::executeNext() {
     if (!m_execQueue.isEmpty()) {
       const execQueueItem &i = m_execQueue.head();
       running = true;
+      m_started = m_spawned = Tracer::now();
+      m_bytesIn = i.input.size();
+      if (i.transaction) {
+        i.transaction->setWorkingDirectory(i.workingDir);
+        i.transaction->setEnvironment(m_process.environment());
+        // a transaction may run for long, but none of its steps should
+        i.transaction->setStepTimeout(timeout(i.id));
+        connect(i.transaction, &Transaction::finished, this,
+                &Executor::transactionFinished);
+        int id = i.id;
+        quint64 tag = i.tag;
+        connect(i.transaction, &Transaction::progress, this,
+                [this, id, tag](int done, int total) {
+                  emit progress(id, done, total, tag);
+                });
+        emit starting();
+        i.transaction->start();
+        return;
+      }
       if (!i.workingDir.isEmpty())
         m_process.setWorkingDirectory(i.workingDir);
+      m_timedOut = false;
+      m_failedToStart = false;
       m_process.start(i.app, i.args);
-      if (!i.input.isEmpty()) {
-        m_process.waitForStarted(-1);
-        QByteArray data = i.input.toUtf8();
-        if (m_process.write(data) != data.length())
-          dbg() << "Not all data written to process:" << i.id << " " << i.app;
-      }
+      // written once the process is up, no need to wait for it here
+      if (!i.input.isEmpty() && m_process.write(i.input) != i.input.length())
+        dbg() << "Not all data written to process:" << i.id << " " << i.app;
       m_process.closeWriteChannel();
+      SecureBuffer::wipe(&m_execQueue.head().input);
+      if (timeout(i.id) > 0)
+        m_watchdog.start(timeout(i.id));
     }
   }
 }
@@ -50,7 +84,7 @@ void Executor::executeNext() {
  */
 void Executor::execute(int id, const QString &app, const QStringList &args,
                        bool readStdout, bool readStderr) {
-  execute(id, QString(), app, args, QString(), readStdout, readStderr);
+  execute(id, QString(), app, args, QByteArray(), readStdout, readStderr);
 }
 
 /**
@@ -65,7 +99,7 @@ void Executor::execute(int id, const QString &app, const QStringList &args,
 void Executor::execute(int id, const QString &workDir, const QString &app,
                        const QStringList &args, bool readStdout,
                        bool readStderr) {
-  execute(id, workDir, app, args, QString(), readStdout, readStderr);
+  execute(id, workDir, app, args, QByteArray(), readStdout, readStderr);
 }
 
 /**
@@ -73,13 +107,15 @@ void Executor::execute(int id, const QString &workDir, const QString &app,
  * @param id
  * @param app
  * @param args
- * @param input
+ * @param input     wiped once it is written, pass it on with std::move so
+ *                  no other copy is left
  * @param readStdout
  * @param readStderr
  */
 void Executor::execute(int id, const QString &app, const QStringList &args,
-                       QString input, bool readStdout, bool readStderr) {
-  execute(id, QString(), app, args, input, readStdout, readStderr);
+                       QByteArray input, bool readStdout, bool readStderr) {
+  execute(id, QString(), app, args, std::move(input), readStdout,
+          readStderr);
 }
 
 /**
@@ -89,24 +125,42 @@ void Executor::execute(int id, const QString &app, const QStringList &args,
  * @param workDir
  * @param app
  * @param args
- * @param input
+ * @param input     wiped once it is written, see above
  * @param readStdout
  * @param readStderr
+ * @param tag   passed back with finished()
  */
 void Executor::execute(int id, const QString &workDir, const QString &app,
-                       const QStringList &args, QString input, bool readStdout,
-                       bool readStderr) {
+                       const QStringList &args, QByteArray input,
+                       bool readStdout, bool readStderr, quint64 tag) {
   // Happens a lot if e.g. git binary is not set.
   // This will result in bogus "QProcess::FailedToStart" messages,
   // also hiding legitimate errors from the gpg commands.
   if (app.isEmpty()) {
     dbg() << "Trying to execute nothing...";
+    SecureBuffer::wipe(&input);
     return;
   }
   QString appPath =
       QDir(QCoreApplication::applicationDirPath()).absoluteFilePath(app);
-  m_execQueue.push_back(
-      {id, appPath, args, input, readStdout, readStderr, workDir});
+  m_execQueue.push_back({id, appPath, args, std::move(input), readStdout,
+                         readStderr, workDir, tag, Q_NULLPTR, Tracer::now()});
+  executeNext();
+}
+
+/**
+ * @brief Executor::execute queue a transaction, it runs once everything
+ * queued before it is done and nothing else runs until it is finished.
+ * @param id
+ * @param workDir
+ * @param transaction   taken over by the executor
+ * @param tag   passed back with finished()
+ */
+void Executor::execute(int id, const QString &workDir,
+                       Transaction *transaction, quint64 tag) {
+  transaction->setParent(this);
+  m_execQueue.push_back({id, QString(), {}, QByteArray(), true, true, workDir,
+                         tag, transaction, Tracer::now()});
   executeNext();
 }
 
@@ -115,7 +169,7 @@ void Executor::execute(int id, const QString &workDir, const QString &app,
  * takes input and presents it as stdin
  * @param app
  * @param args
- * @param input
+ * @param input     wiped once it is written, like with execute()
  * @param process_out
  * @param process_err
  * @return
@@ -123,27 +177,36 @@ void Executor::execute(int id, const QString &workDir, const QString &app,
  * TODO(bezet): it might make sense to throw here, a lot of possible errors
  */
 int Executor::executeBlocking(QString app, const QStringList &args,
-                              QString input, QString *process_out,
-                              QString *process_err) {
+                              QByteArray input, QByteArray *process_out,
+                              QByteArray *process_err) {
   QProcess internal;
   internal.start(app, args);
   if (!input.isEmpty()) {
-    QByteArray data = input.toUtf8();
-    internal.waitForStarted(-1);
-    if (internal.write(data) != data.length()) {
+    if (internal.write(input) != input.length()) {
       dbg() << "Not all input written:" << app;
     }
     internal.closeWriteChannel();
+    SecureBuffer::wipe(&input);
+  }
+  if (!internal.waitForFinished(m_blockingTimeout > 0 ? m_blockingTimeout
+                                                      : -1)) {
+    if (internal.state() == QProcess::NotRunning) {
+      dbg() << "Failed to start:" << app << internal.errorString();
+      return -1;
+    }
+    noteTimeout(blockingId, app);
+    internal.terminate();
+    if (!internal.waitForFinished(killGrace)) {
+      internal.kill();
+      internal.waitForFinished(killGrace);
+    }
+    return -1;
   }
-  internal.waitForFinished(-1);
   if (internal.exitStatus() == QProcess::NormalExit) {
-    QTextCodec *codec = QTextCodec::codecForLocale();
-    QString pout = codec->toUnicode(internal.readAllStandardOutput());
-    QString perr = codec->toUnicode(internal.readAllStandardError());
     if (process_out != Q_NULLPTR)
-      *process_out = pout;
+      *process_out = internal.readAllStandardOutput();
     if (process_err != Q_NULLPTR)
-      *process_err = perr;
+      *process_err = internal.readAllStandardError();
     return internal.exitCode();
   } else {
     //  TODO(bezet): emit error() ?
@@ -160,8 +223,94 @@ int Executor::executeBlocking(QString app, const QStringList &args,
  * @return
  */
 int Executor::executeBlocking(QString app, const QStringList &args,
-                              QString *process_out, QString *process_err) {
-  return executeBlocking(app, args, QString(), process_out, process_err);
+                              QByteArray *process_out,
+                              QByteArray *process_err) {
+  return executeBlocking(app, args, QByteArray(), process_out, process_err);
+}
+
+/**
+ * @brief Executor::timeout
+ * @param id
+ * @return how long processes with this id may run, 0 for no limit
+ */
+int Executor::timeout(int id) const {
+  return m_timeout.value(id, m_defaultTimeout);
+}
+
+/**
+ * @brief Executor::setTimeout set the deadline of processes with this id
+ * @param id
+ * @param msecs     0 for no limit
+ */
+void Executor::setTimeout(int id, int msecs) { m_timeout.insert(id, msecs); }
+
+/**
+ * @brief Executor::setDefaultTimeout deadline of ids without their own
+ * @param msecs     0 for no limit
+ */
+void Executor::setDefaultTimeout(int msecs) { m_defaultTimeout = msecs; }
+
+/**
+ * @brief Executor::setBlockingTimeout deadline of executeBlocking
+ * @param msecs     0 for no limit
+ */
+void Executor::setBlockingTimeout(int msecs) { m_blockingTimeout = msecs; }
+
+/**
+ * @brief Executor::timeoutCount
+ * @param id    blockingId for executeBlocking
+ * @return how often processes with this id were stopped for missing their
+ * deadline
+ */
+int Executor::timeoutCount(int id) const { return m_timeouts.value(id); }
+
+/**
+ * @brief Executor::timeoutCount
+ * @return how often any process was stopped for missing its deadline
+ */
+int Executor::timeoutCount() const {
+  int count = 0;
+  foreach (int n, m_timeouts)
+    count += n;
+  return count;
+}
+
+/**
+ * @brief Executor::noteTimeout count and report a missed deadline
+ * @param id
+ * @param app
+ */
+void Executor::noteTimeout(int id, const QString &app) {
+  ++m_timeouts[id];
+  qWarning() << "Stopping" << app << "after it missed its deadline," << id
+             << "timed out" << m_timeouts.value(id) << "times";
+  emit timedOut(id);
+}
+
+/**
+ * @brief Executor::trace record how long an item waited in the queue and how
+ * long it ran
+ * @param i
+ * @param exitCode
+ * @param bytesOut  size of what the process wrote to stdout
+ */
+void Executor::trace(const execQueueItem &i, int exitCode, qint64 bytesOut) {
+  if (!Tracer::isEnabled())
+    return;
+  QString name = i.transaction ? QString("transaction")
+                               : QFileInfo(i.app).fileName();
+  QVariantMap args;
+  args["id"] = i.id;
+  Tracer::complete(name, "queue", i.queued, m_started - i.queued, args,
+                   Tracer::QUEUE);
+  args["app"] = name;
+  args["queueWait"] = m_started - i.queued;
+  args["spawn"] = m_spawned - m_started;
+  args["bytesIn"] = m_bytesIn;
+  args["bytesOut"] = bytesOut;
+  args["exitCode"] = exitCode;
+  Tracer::complete(name, "process", m_started, Tracer::now() - m_started, args,
+                   Tracer::EXECUTOR);
 }
 
 /**
@@ -174,15 +323,31 @@ void Executor::setEnvironment(const QStringList &env) {
 }
 
 /**
- * @brief Executor::cancelNext  cancels execution of first process in queue
- *                              if it's not already running
+ * @brief Executor::cancel  drop all queued processes with the given tag that
+ *                          have not been started yet
  *
- * @return  id of the cancelled process or -1 on error
+ * finished() is still emitted for each of them, with exit code 0 and no
+ * output, so callers that count processes stay in step. A running
+ * transaction with the tag is cancelled and rolled back.
+ * @param tag
  */
-int Executor::cancelNext() {
-  if (running || m_execQueue.isEmpty())
-    return -1; //  TODO(bezet): definitely throw here
-  return m_execQueue.dequeue().id;
+void Executor::cancel(quint64 tag) {
+  QList<execQueueItem> skipped;
+  int n = running ? 1 : 0;
+  while (n < m_execQueue.size()) {
+    if (m_execQueue.at(n).tag == tag)
+      skipped.append(m_execQueue.takeAt(n));
+    else
+      ++n;
+  }
+  foreach (const execQueueItem &i, skipped) {
+    if (i.transaction)
+      i.transaction->deleteLater();
+    emit finished(i.id, 0, QByteArray(), QByteArray(), i.tag);
+  }
+  if (running && m_execQueue.head().tag == tag &&
+      m_execQueue.head().transaction)
+    m_execQueue.head().transaction->cancel();
 }
 
 /**
@@ -193,18 +358,101 @@ int Executor::cancelNext() {
 void Executor::finished(int exitCode, QProcess::ExitStatus exitStatus) {
   execQueueItem i = m_execQueue.dequeue();
   running = false;
-  if (exitStatus == QProcess::NormalExit) {
-    QString output, err;
-    QTextCodec *codec = QTextCodec::codecForLocale();
+  m_watchdog.stop();
+  trace(i, m_timedOut || exitStatus != QProcess::NormalExit ? -1 : exitCode,
+        m_process.bytesAvailable());
+  if (m_timedOut) {
+    emit finished(i.id, -1, QByteArray(),
+                  tr("%1 did not finish within %2 seconds and was stopped.")
+                      .arg(QFileInfo(i.app).fileName())
+                      .arg(timeout(i.id) / 1000)
+                      .toUtf8(),
+                  i.tag);
+  } else if (exitStatus == QProcess::NormalExit) {
+    QByteArray output, err;
     if (i.readStdout)
-      output = codec->toUnicode(m_process.readAllStandardOutput());
+      output = m_process.readAllStandardOutput();
     if (i.readStderr or exitCode != 0) {
-      err = codec->toUnicode(m_process.readAllStandardError());
+      err = m_process.readAllStandardError();
       if (exitCode != 0)
         dbg() << exitCode << err;
     }
-    emit finished(i.id, exitCode, output, err);
+    emit finished(i.id, exitCode, output, err, i.tag);
+    // the receivers copied what they keep, decrypted content included
+    SecureBuffer::wipe(&output);
+  } else {
+    dbg() << "Process crashed:" << i.id << i.app;
+    emit finished(i.id, -1, QByteArray(), m_process.errorString().toUtf8(),
+                  i.tag);
   }
-  //	else: emit crashed with ID, which may give a chance to recover ?
   executeNext();
 }
+
+/**
+ * @brief Executor::transactionFinished called when a queued transaction is
+ * done, successful or rolled back
+ * @param exitCode
+ * @param output
+ * @param errout
+ */
+void Executor::transactionFinished(int exitCode, const QByteArray &output,
+                                   const QByteArray &errout) {
+  execQueueItem i = m_execQueue.dequeue();
+  running = false;
+  for (int n = i.transaction->timeoutCount(); n > 0; --n)
+    noteTimeout(i.id, tr("a step of a transaction"));
+  trace(i, exitCode, output.size());
+  i.transaction->deleteLater();
+  emit finished(i.id, exitCode, output, errout, i.tag);
+  executeNext();
+}
+
+/**
+ * @brief Executor::processError a process that failed to start does not
+ * emit finished, its item is taken off the queue from the event loop
+ * @param error
+ */
+void Executor::processError(QProcess::ProcessError error) {
+  if (error != QProcess::FailedToStart || m_failedToStart)
+    return;
+  m_failedToStart = true;
+  QTimer::singleShot(0, this, SLOT(failedToStart()));
+}
+
+/**
+ * @brief Executor::failedToStart report the item that could not be started
+ * and go on with the next one
+ */
+void Executor::failedToStart() {
+  if (!running || m_execQueue.isEmpty() || m_execQueue.head().transaction ||
+      m_process.state() != QProcess::NotRunning)
+    return;
+  execQueueItem i = m_execQueue.dequeue();
+  running = false;
+  m_failedToStart = false;
+  m_watchdog.stop();
+  m_spawned = Tracer::now();
+  trace(i, -1, 0);
+  dbg() << "Failed to start:" << i.id << i.app;
+  emit finished(i.id, -1, QByteArray(), m_process.errorString().toUtf8(),
+                i.tag);
+  executeNext();
+}
+
+/**
+ * @brief Executor::watchdog the running process missed its deadline,
+ * terminate it and kill it if it does not exit within killGrace
+ */
+void Executor::watchdog() {
+  if (!running || m_execQueue.isEmpty() ||
+      m_process.state() == QProcess::NotRunning)
+    return;
+  if (!m_timedOut) {
+    m_timedOut = true;
+    noteTimeout(m_execQueue.head().id, m_execQueue.head().app);
+    m_process.terminate();
+    m_watchdog.start(killGrace);
+  } else {
+    m_process.kill();
+  }
+}
@@ -1,13 +1,25 @@
 #ifndef EXECUTOR_H
 #define EXECUTOR_H
 
+#include <QHash>
 #include <QObject>
 #include <QProcess>
 #include <QQueue>
+#include <QTimer>
+
+class Transaction;
 
 /*!
     \class Executor
     \brief Executes external commands for handleing password, git and other data
+
+    Input and output are passed on as bytes, decoding is left to whoever
+    uses the output, so decrypted content is not copied around needlessly.
+
+    Every queued item gets a deadline depending on its id. A process that
+    misses it is terminated, and killed if it does not exit within
+    killGrace, so a gpg stuck on a pinentry nobody sees does not block the
+    queue for good.
 */
 class Executor : public QObject {
   Q_OBJECT
@@ -32,7 +44,7 @@ class Executor : public QObject {
     /**
      * @brief input     data to write to stdin of process
      */
-    QString input;
+    QByteArray input;
     /**
      * @brief readStdout    whether to read stdout
      */
@@ -48,12 +60,38 @@ class Executor : public QObject {
      *                      started
      */
     QString workingDir;
+    /**
+     * @brief tag   caller defined value handed back with the result, used to
+     *              match results to requests
+     */
+    quint64 tag;
+    /**
+     * @brief transaction   run instead of app when set, owned by the
+     *                      executor
+     */
+    Transaction *transaction;
+    /**
+     * @brief queued    Tracer::now() when the item was queued
+     */
+    qint64 queued;
   };
 
   QQueue<execQueueItem> m_execQueue;
   QProcess m_process;
   bool running;
+  QTimer m_watchdog;
+  bool m_timedOut;
+  bool m_failedToStart;
+  int m_defaultTimeout;
+  int m_blockingTimeout;
+  QHash<int, int> m_timeout;
+  QHash<int, int> m_timeouts;
+  qint64 m_started;
+  qint64 m_spawned;
+  qint64 m_bytesIn;
   void executeNext();
+  void noteTimeout(int id, const QString &app);
+  void trace(const execQueueItem &i, int exitCode, qint64 bytesOut);
 
 public:
   explicit Executor(QObject *parent = 0);
@@ -66,41 +104,84 @@ public:
                bool readStderr = true);
 
   void execute(int id, const QString &app, const QStringList &args,
-               QString input = QString(), bool readStdout = false,
-               bool readStderr = true);
+               QByteArray input = QByteArray(),
+               bool readStdout = false, bool readStderr = true);
 
   void execute(int id, const QString &workDir, const QString &app,
-               const QStringList &args, QString input = QString(),
-               bool readStdout = false, bool readStderr = true);
+               const QStringList &args, QByteArray input = QByteArray(),
+               bool readStdout = false, bool readStderr = true,
+               quint64 tag = 0);
+
+  void execute(int id, const QString &workDir, Transaction *transaction,
+               quint64 tag = 0);
 
   int executeBlocking(QString app, const QStringList &args,
-                      QString input = QString(),
-                      QString *process_out = Q_NULLPTR,
-                      QString *process_err = Q_NULLPTR);
+                      QByteArray input = QByteArray(),
+                      QByteArray *process_out = Q_NULLPTR,
+                      QByteArray *process_err = Q_NULLPTR);
 
   int executeBlocking(QString app, const QStringList &args,
-                      QString *process_out, QString *process_err = Q_NULLPTR);
+                      QByteArray *process_out,
+                      QByteArray *process_err = Q_NULLPTR);
 
   void setEnvironment(const QStringList &env);
 
-  int cancelNext();
+  int timeout(int id) const;
+  void setTimeout(int id, int msecs);
+  void setDefaultTimeout(int msecs);
+  void setBlockingTimeout(int msecs);
+  int timeoutCount(int id) const;
+  int timeoutCount() const;
+
+  /**
+   * @brief killGrace   time a terminated process gets to exit before it is
+   *                    killed
+   */
+  static const int killGrace = 3000;
+  /**
+   * @brief blockingId  id executeBlocking timeouts are counted under
+   */
+  static const int blockingId = -1;
+
+  void cancel(quint64 tag);
 private slots:
   void finished(int exitCode, QProcess::ExitStatus exitStatus);
+  void transactionFinished(int exitCode, const QByteArray &output,
+                           const QByteArray &errout);
+  void processError(QProcess::ProcessError error);
+  void failedToStart();
+  void watchdog();
 signals:
   /**
    * @brief finished    signal that is emited when process finishes
    *
    * @param id          id of the process
-   * @param exitCode    return code of the process
-   * @param output      stdout produced by the process
-   * @param errout      stderr produced by the process
+   * @param exitCode    return code of the process, -1 if it crashed
+   * @param output      stdout produced by the process, as is
+   * @param errout      stderr produced by the process, as is
+   * @param tag         tag the process was queued with
    */
-  void finished(int id, int exitCode, const QString &output,
-                const QString &errout);
+  void finished(int id, int exitCode, const QByteArray &output,
+                const QByteArray &errout, quint64 tag);
   /**
    * @brief starting    signal that is emited when process starts
    */
   void starting();
+  /**
+   * @brief progress    a step of a queued transaction is done
+   * @param id          id the transaction was queued with
+   * @param done        steps done so far
+   * @param total       steps planned so far
+   * @param tag         tag the transaction was queued with
+   */
+  void progress(int id, int done, int total, quint64 tag);
+  /**
+   * @brief timedOut    signal that is emited when a process missed its
+   * deadline and is being stopped
+   *
+   * @param id          id of the process
+   */
+  void timedOut(int id);
   /**
    * @brief error       signal that is emited when process finishes with an
    * error
@@ -110,8 +191,8 @@ signals:
    * @param output      stdout produced by the process
    * @param errout      stderr produced by the process
    */
-  void error(int id, int exitCode, const QString &output,
-             const QString &errout);
+  void error(int id, int exitCode, const QByteArray &output,
+             const QByteArray &errout);
 };
 
 #endif // EXECUTOR_H
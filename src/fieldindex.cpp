@@ -0,0 +1,334 @@
+#include "fieldindex.h"
+#include "debughelper.h"
+#include "securebuffer.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QRegExp>
+#include <QSet>
+#include <QStandardPaths>
+
+static const quint32 fieldIndexMagic = 0x51504649; // "QPFI"
+static const quint32 fieldIndexVersion = 1;
+
+/**
+ * @brief FieldIndex::FieldIndex empty index, call setRoot to point it at a
+ * store
+ * @param parent
+ */
+FieldIndex::FieldIndex(QObject *parent) : QObject(parent), m_modified(false) {}
+
+/**
+ * @brief FieldIndex::~FieldIndex wipes the field values
+ */
+FieldIndex::~FieldIndex() { clear(); }
+
+/**
+ * @brief FieldIndex::setRoot change the store that is indexed, the entries
+ * of the previous one are dropped
+ * @param root  path of the password-store
+ */
+void FieldIndex::setRoot(const QString &root) {
+  QString clean = QDir::cleanPath(root);
+  if (clean == m_root)
+    return;
+  clear();
+  m_root = clean;
+}
+
+/**
+ * @brief FieldIndex::root
+ * @return path of the indexed password-store
+ */
+QString FieldIndex::root() const { return m_root; }
+
+/**
+ * @brief FieldIndex::fileName where the encrypted index of the store is
+ * kept, outside of the store so it is never committed or synced
+ * @return
+ */
+QString FieldIndex::fileName() const {
+  QByteArray id = QCryptographicHash::hash(m_root.toUtf8(),
+                                           QCryptographicHash::Sha1)
+                      .toHex()
+                      .left(16);
+  return QStandardPaths::writableLocation(
+             QStandardPaths::AppLocalDataLocation) +
+         "/fields-" + QString::fromLatin1(id) + ".gpg";
+}
+
+/**
+ * @brief FieldIndex::isEmpty
+ * @return true if no entry is indexed
+ */
+bool FieldIndex::isEmpty() const { return m_entries.isEmpty(); }
+
+/**
+ * @brief FieldIndex::size
+ * @return number of indexed entries
+ */
+int FieldIndex::size() const { return m_entries.size(); }
+
+/**
+ * @brief FieldIndex::isModified
+ * @return whether the index changed since it was loaded or saved
+ */
+bool FieldIndex::isModified() const { return m_modified; }
+
+/**
+ * @brief FieldIndex::setModified
+ * @param modified  false once the index is saved
+ */
+void FieldIndex::setModified(bool modified) { m_modified = modified; }
+
+/**
+ * @brief FieldIndex::stale drop the entries that are gone from the store
+ * and find the ones that have to be decrypted (again)
+ * @param entries   all entries of the store, see StoreIndex::entries
+ * @return entries that are new or whose file changed since they were
+ * indexed
+ */
+QStringList FieldIndex::stale(const QStringList &entries) {
+  QSet<QString> present;
+  QStringList stale;
+  QDir root(m_root);
+  foreach (const QString &entry, entries) {
+    present.insert(entry);
+    qint64 modified = QFileInfo(root.filePath(entry + ".gpg"))
+                          .lastModified()
+                          .toMSecsSinceEpoch();
+    auto it = m_entries.constFind(entry);
+    if (it == m_entries.constEnd() || it->modified != modified)
+      stale.append(entry);
+  }
+  QStringList gone;
+  for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+    if (!present.contains(it.key()))
+      gone.append(it.key());
+  }
+  foreach (const QString &entry, gone)
+    remove(entry);
+  return stale;
+}
+
+/**
+ * @brief FieldIndex::setContent (re)index an entry
+ * @param entry     relative entry path without .gpg suffix
+ * @param content   decrypted content of the entry, the password is not kept
+ * @param modified  when the file of the entry was changed, in ms since the
+ *                  epoch
+ */
+void FieldIndex::setContent(const QString &entry, const QString &content,
+                            qint64 modified) {
+  FileContent parsed = FileContent::parse(content, QStringList(), true);
+  indexedEntry indexed;
+  indexed.modified = modified;
+  foreach (const NamedValue &field, parsed.getNamedValues()) {
+    if (!isSecretField(field.name) && !field.value.isEmpty())
+      indexed.fields.append(field);
+  }
+  // URLs in the notes, fields holding one have been taken already
+  QString remaining = parsed.getRemainingData();
+  QRegExp url("\\bhttps?://[^\\s]+");
+  for (int pos = 0; (pos = url.indexIn(remaining, pos)) >= 0;
+       pos += url.matchedLength())
+    indexed.fields.append({"url", url.cap(0)});
+  SecureBuffer::wipe(&remaining);
+
+  auto it = m_entries.find(entry);
+  if (it != m_entries.end())
+    wipe(&it.value());
+  m_entries.insert(entry, indexed);
+  m_modified = true;
+  emit changed();
+}
+
+/**
+ * @brief FieldIndex::remove forget an entry
+ * @param entry
+ */
+void FieldIndex::remove(const QString &entry) {
+  auto it = m_entries.find(entry);
+  if (it == m_entries.end())
+    return;
+  wipe(&it.value());
+  m_entries.erase(it);
+  m_modified = true;
+  emit changed();
+}
+
+/**
+ * @brief FieldIndex::clear forget all entries, e.g. when indexing is turned
+ * off
+ */
+void FieldIndex::clear() {
+  for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+    wipe(&it.value());
+  m_entries.clear();
+  m_modified = false;
+}
+
+/**
+ * @brief FieldIndex::contains
+ * @param entry
+ * @return whether the entry is indexed
+ */
+bool FieldIndex::contains(const QString &entry) const {
+  return m_entries.contains(entry);
+}
+
+/**
+ * @brief FieldIndex::fields
+ * @param entry
+ * @return indexed fields of the entry, URLs from the notes as "url"
+ */
+NamedValues FieldIndex::fields(const QString &entry) const {
+  return m_entries.value(entry).fields;
+}
+
+/**
+ * @brief FieldIndex::search find entries the way the search box does, with
+ * field terms on top.
+ *
+ * A term like "login:alice" matches entries with a field whose name starts
+ * with "login" and whose value contains "alice", case is ignored. All
+ * field terms have to match. The other terms match the path like in
+ * StoreIndex::search.
+ * @param query
+ * @param entries   entries to search, see StoreIndex::entries
+ * @return matching entries, in the order of entries
+ */
+QStringList FieldIndex::search(const QString &query,
+                               const QStringList &entries) const {
+  QStringList pathTerms;
+  QList<NamedValue> fieldTerms;
+  QRegExp fieldTerm("([^:/]+):(.+)");
+  foreach (const QString &term, query.split(' ', QString::SkipEmptyParts)) {
+    if (fieldTerm.exactMatch(term) && !fieldTerm.cap(2).startsWith("//"))
+      fieldTerms.append({fieldTerm.cap(1).toLower(), fieldTerm.cap(2)});
+    else
+      pathTerms.append(term);
+  }
+  QRegExp path(pathTerms.join(".*"), Qt::CaseInsensitive);
+
+  QStringList found;
+  foreach (const QString &entry, entries) {
+    if (!pathTerms.isEmpty() && !entry.contains(path))
+      continue;
+    auto it = m_entries.constFind(entry);
+    if (it == m_entries.constEnd()) {
+      if (fieldTerms.isEmpty())
+        found.append(entry);
+      continue;
+    }
+    bool matches = true;
+    foreach (const NamedValue &term, fieldTerms) {
+      bool matched = false;
+      foreach (const NamedValue &field, it->fields) {
+        if (field.name.toLower().startsWith(term.name) &&
+            field.value.contains(term.value, Qt::CaseInsensitive)) {
+          matched = true;
+          break;
+        }
+      }
+      if (!matched) {
+        matches = false;
+        break;
+      }
+    }
+    if (matches)
+      found.append(entry);
+  }
+  return found;
+}
+
+/**
+ * @brief FieldIndex::save the index in a form load() reads back, to be
+ * encrypted before it is written anywhere
+ * @return
+ */
+QByteArray FieldIndex::save() const {
+  QByteArray data;
+  QDataStream out(&data, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_0);
+  out << fieldIndexMagic << fieldIndexVersion
+      << static_cast<quint32>(m_entries.size());
+  for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+    out << it.key() << it->modified << static_cast<quint32>(it->fields.size());
+    foreach (const NamedValue &field, it->fields)
+      out << field.name << field.value;
+  }
+  return data;
+}
+
+/**
+ * @brief FieldIndex::load replace the entries with the ones saved before
+ * @param data  what save() returned, decrypted
+ * @return false if data is not an index this version can read, the index
+ * is left empty then
+ */
+bool FieldIndex::load(const QByteArray &data) {
+  clear();
+  QDataStream in(data);
+  in.setVersion(QDataStream::Qt_5_0);
+  quint32 magic, version, count;
+  in >> magic >> version >> count;
+  if (in.status() != QDataStream::Ok || magic != fieldIndexMagic ||
+      version != fieldIndexVersion)
+    return false;
+  for (quint32 n = 0; n < count && in.status() == QDataStream::Ok; ++n) {
+    QString entry;
+    indexedEntry indexed;
+    quint32 fields;
+    in >> entry >> indexed.modified >> fields;
+    for (quint32 f = 0; f < fields && in.status() == QDataStream::Ok; ++f) {
+      NamedValue field;
+      in >> field.name >> field.value;
+      indexed.fields.append(field);
+    }
+    m_entries.insert(entry, indexed);
+  }
+  if (in.status() != QDataStream::Ok) {
+    clear();
+    return false;
+  }
+  dbg() << "loaded fields of" << m_entries.size() << "entries";
+  emit changed();
+  return true;
+}
+
+/**
+ * @brief FieldIndex::isFieldQuery
+ * @param query text of the search box
+ * @return whether the query has a term like "login:alice", URLs do not
+ * count
+ */
+bool FieldIndex::isFieldQuery(const QString &query) {
+  return query.contains(QRegExp("(^|\\s)[^\\s:/]+:[^\\s/]"));
+}
+
+/**
+ * @brief FieldIndex::isSecretField fields that are kept out of the index,
+ * like the password
+ * @param name
+ * @return
+ */
+bool FieldIndex::isSecretField(const QString &name) {
+  static const QStringList secret = {"pin", "otp", "totp", "cvv", "cvc",
+                                     "otpauth"};
+  QString lower = name.trimmed().toLower();
+  return lower.contains("pass") || lower.contains("secret") ||
+         lower.contains("key") || secret.contains(lower);
+}
+
+/**
+ * @brief FieldIndex::wipe overwrite the field values of an entry
+ * @param entry
+ */
+void FieldIndex::wipe(indexedEntry *entry) {
+  for (int n = 0; n < entry->fields.size(); ++n)
+    SecureBuffer::wipe(&entry->fields[n].value);
+}
@@ -0,0 +1,81 @@
+#ifndef FIELDINDEX_H
+#define FIELDINDEX_H
+
+#include "filecontent.h"
+
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+
+/*!
+    \class FieldIndex
+    \brief In-memory index of the fields of the entries of a password-store,
+    for searches like "login:alice" or "url:example.com".
+
+    Holds the named fields of every entry, as FieldIndex::setContent takes
+    them out of the decrypted content, and the URLs found in its free text
+    as "url" fields. Passwords, and fields that look like they hold one,
+    are left out. Entries remember when their file was changed, so after a
+    change in the store only the entries returned by stale() have to be
+    decrypted again.
+
+    The index itself does not decrypt or encrypt anything: Pass::IndexFields
+    feeds it and keeps it on disk, encrypted to the key of the user, at
+    fileName(). Field values are wiped when they are dropped.
+ */
+class FieldIndex : public QObject {
+  Q_OBJECT
+
+public:
+  explicit FieldIndex(QObject *parent = nullptr);
+  ~FieldIndex();
+
+  void setRoot(const QString &root);
+  QString root() const;
+  QString fileName() const;
+
+  bool isEmpty() const;
+  int size() const;
+  bool isModified() const;
+  void setModified(bool modified);
+
+  QStringList stale(const QStringList &entries);
+  void setContent(const QString &entry, const QString &content,
+                  qint64 modified);
+  void remove(const QString &entry);
+  void clear();
+
+  bool contains(const QString &entry) const;
+  NamedValues fields(const QString &entry) const;
+  QStringList search(const QString &query, const QStringList &entries) const;
+
+  QByteArray save() const;
+  bool load(const QByteArray &data);
+
+  static bool isFieldQuery(const QString &query);
+  static bool isSecretField(const QString &name);
+
+signals:
+  /**
+   * @brief changed entries were added, updated or removed
+   */
+  void changed();
+
+private:
+  /*!
+      \struct indexedEntry
+      \brief The fields of one entry and when its file was changed.
+   */
+  struct indexedEntry {
+    qint64 modified;
+    NamedValues fields;
+  };
+
+  QString m_root;
+  QHash<QString, indexedEntry> m_entries;
+  bool m_modified;
+
+  static void wipe(indexedEntry *entry);
+};
+
+#endif // FIELDINDEX_H
@@ -1,4 +1,5 @@
 #include "filecontent.h"
+#include "securebuffer.h"
 
 FileContent FileContent::parse(const QString &fileContent,
                                const QStringList &templateFields,
@@ -22,7 +23,12 @@ FileContent FileContent::parse(const QString &fileContent,
     }
     remainingData.append(line);
   }
-  return FileContent(password, namedValues, remainingData.join("\n"));
+  QString remaining = remainingData.join("\n");
+  // the lines hold the decrypted content a second time
+  remainingData.clear();
+  for (QString &line : lines)
+    SecureBuffer::wipe(&line);
+  return FileContent(password, namedValues, remaining);
 }
 
 QString FileContent::getPassword() const { return this->password; }
@@ -0,0 +1,119 @@
+#include "folderscan.h"
+#include "debughelper.h"
+#include "storeindex.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QRunnable>
+
+/*!
+    \class FolderScan::Walk
+    \brief Runs FolderScan::walk on the pool of the scan.
+ */
+class FolderScan::Walk : public QRunnable {
+public:
+  explicit Walk(FolderScan *scan) : m_scan(scan) {}
+  void run() Q_DECL_OVERRIDE { m_scan->walk(); }
+
+private:
+  FolderScan *m_scan;
+};
+
+/**
+ * @brief FolderScan::FolderScan
+ * @param folder    absolute path of the folder to scan
+ * @param parent
+ */
+FolderScan::FolderScan(const QString &folder, QObject *parent)
+    : QObject(parent), m_folder(QDir::cleanPath(folder)), m_cancelled(0),
+      m_finished(0) {
+  m_pool.setMaxThreadCount(1);
+}
+
+/**
+ * @brief FolderScan::~FolderScan stop a running walk
+ */
+FolderScan::~FolderScan() {
+  cancel();
+  m_pool.waitForDone();
+}
+
+/**
+ * @brief FolderScan::start answer from the index when it is up to date,
+ * otherwise start walking the folder
+ * @param index index of the store the folder is in, may be null
+ */
+void FolderScan::start(StoreIndex *index) {
+  if (index && fromIndex(index))
+    return;
+  m_pool.start(new Walk(this));
+}
+
+/**
+ * @brief FolderScan::cancel stop walking, finished() is not emitted
+ */
+void FolderScan::cancel() { m_cancelled.storeRelease(1); }
+
+/**
+ * @brief FolderScan::isFinished
+ * @return whether finished() was emitted
+ */
+bool FolderScan::isFinished() const { return m_finished.loadAcquire(); }
+
+/**
+ * @brief FolderScan::fromIndex count what the index knows about the folder
+ * @param index
+ * @return false if the index is stale or covers another store
+ */
+bool FolderScan::fromIndex(StoreIndex *index) {
+  QDir root(index->root());
+  QString relative = root.relativeFilePath(m_folder);
+  if (!index->isValid() || index->root().isEmpty() ||
+      relative.startsWith(".."))
+    return false;
+
+  QString prefix = relative == "." ? QString() : relative + "/";
+  int passwords = 0;
+  foreach (const QString &entry, index->entries())
+    if (entry.startsWith(prefix))
+      ++passwords;
+  QStringList others;
+  foreach (const QString &other, index->others())
+    if (other.startsWith(prefix))
+      others << other.mid(prefix.size());
+  m_finished.storeRelease(1);
+  emit finished(passwords, others);
+  return true;
+}
+
+/**
+ * @brief FolderScan::walk go through the folder, reporting progress at most
+ * every 100 ms
+ */
+void FolderScan::walk() {
+  QDir folder(m_folder);
+  QDirIterator it(m_folder, QDir::Files | QDir::NoDotAndDotDot,
+                  QDirIterator::Subdirectories);
+  int passwords = 0;
+  QStringList others;
+  QElapsedTimer timer;
+  timer.start();
+  while (it.hasNext()) {
+    if (m_cancelled.loadAcquire())
+      return;
+    it.next();
+    if (it.fileInfo().suffix() == "gpg")
+      ++passwords;
+    else
+      others << folder.relativeFilePath(it.filePath());
+    if (timer.elapsed() >= 100) {
+      emit progress(passwords, others);
+      timer.restart();
+    }
+  }
+  dbg() << "scanned" << m_folder << passwords << "passwords"
+        << others.size() << "other files";
+  m_finished.storeRelease(1);
+  emit finished(passwords, others);
+}
@@ -0,0 +1,61 @@
+#ifndef FOLDERSCAN_H
+#define FOLDERSCAN_H
+
+#include <QAtomicInt>
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+
+class StoreIndex;
+
+/*!
+    \class FolderScan
+    \brief Counts the passwords in a folder of the store and finds files
+    that are not passwords, without blocking the caller.
+
+    When the StoreIndex of the store is up to date the answer comes from it
+    straight away. Otherwise the folder is walked on a thread of its own,
+    with the same rules as the index: hidden files and folders are skipped.
+    progress() reports what was found so far every now and then, so a
+    dialog can show it while the user decides.
+
+    Deleting the scan stops the walk and waits for the thread to leave it.
+ */
+class FolderScan : public QObject {
+  Q_OBJECT
+
+public:
+  explicit FolderScan(const QString &folder, QObject *parent = nullptr);
+  ~FolderScan();
+
+  void start(StoreIndex *index = nullptr);
+  void cancel();
+  bool isFinished() const;
+
+signals:
+  /**
+   * @brief progress    what the scan found so far
+   * @param passwords   .gpg files found
+   * @param others      other files, relative to the folder
+   */
+  void progress(int passwords, const QStringList &others);
+  /**
+   * @brief finished    the whole folder was scanned
+   * @param passwords
+   * @param others
+   */
+  void finished(int passwords, const QStringList &others);
+
+private:
+  class Walk;
+
+  QString m_folder;
+  QThreadPool m_pool;
+  QAtomicInt m_cancelled;
+  QAtomicInt m_finished;
+
+  bool fromIndex(StoreIndex *index);
+  void walk();
+};
+
+#endif // FOLDERSCAN_H
@@ -1,7 +1,10 @@
 #include "imitatepass.h"
+#include "copyengine.h"
 #include "debughelper.h"
+#include "importreader.h"
 #include "qtpasssettings.h"
 #include <QDirIterator>
+#include <QSet>
 
 using namespace Enums;
 
@@ -64,7 +67,6 @@ void ImitatePass::OtpGenerate(QString file) {}
  */
 void ImitatePass::Insert(QString file, QString newValue, bool overwrite) {
   file = file + ".gpg";
-  transactionHelper trans(this, PASS_INSERT);
   QStringList recipients = Pass::getRecipientList(file);
   if (recipients.isEmpty()) {
     //  TODO(bezet): probably throw here
@@ -81,27 +83,79 @@ void ImitatePass::Insert(QString file, QString newValue, bool overwrite) {
   if (overwrite)
     args.append("--yes");
   args.append("-");
-  executeGpg(PASS_INSERT, args, newValue);
+  Transaction *transaction = new Transaction;
+  transaction->touch(file);
+  int step = transaction->addProcess(QtPassSettings::getGpgExecutable(), args,
+                                     QList<int>(), newValue.toUtf8());
   if (!QtPassSettings::isUseWebDav() && QtPassSettings::isUseGit()) {
     //    TODO(bezet) why not?
     if (!overwrite)
-      executeGit(GIT_ADD, {"add", file});
+      step = addGit(transaction, {"add", file}, {step});
     QString path = QDir(QtPassSettings::getPassStore()).relativeFilePath(file);
     path.replace(QRegExp("\\.gpg$"), "");
     QString msg =
         QString(overwrite ? "Edit" : "Add") + " for " + path + " using QtPass.";
-    GitCommit(file, msg);
+    GitCommit(transaction, {file}, msg, {step});
+    gitRollback(transaction, {file});
   }
+  executeTransaction(PASS_INSERT, transaction);
 }
 
 /**
- * @brief ImitatePass::GitCommit commit a file to git with an appropriate commit
+ * @brief ImitatePass::GitCommit commit files to git with an appropriate commit
  * message
- * @param file
+ * @param transaction
+ * @param files
  * @param msg
+ * @param after
+ * @return id of the commit step
  */
-void ImitatePass::GitCommit(const QString &file, const QString &msg) {
-  executeGit(GIT_COMMIT, {"commit", "-m", msg, "--", file});
+int ImitatePass::GitCommit(Transaction *transaction, const QStringList &files,
+                           const QString &msg, const QList<int> &after) {
+  return addGit(transaction, QStringList{"commit", "-m", msg, "--"} + files,
+                after);
+}
+
+/**
+ * @brief ImitatePass::addGit add a git command to a transaction
+ * @param transaction
+ * @param args
+ * @param after
+ * @return id of the step
+ */
+int ImitatePass::addGit(Transaction *transaction, const QStringList &args,
+                        const QList<int> &after) {
+  return transaction->addProcess(QtPassSettings::getGitExecutable(), args,
+                                 after);
+}
+
+/**
+ * @brief ImitatePass::gitRollback unstage the files again when the
+ * transaction fails, their content is restored by the transaction itself
+ * @param transaction
+ * @param files
+ */
+void ImitatePass::gitRollback(Transaction *transaction,
+                              const QStringList &files) {
+  transaction->addRollback(QtPassSettings::getGitExecutable(),
+                           QStringList{"reset", "-q", "--"} + files);
+}
+
+/**
+ * @brief ImitatePass::addAutoPull pull as the prelude of a transaction when
+ * the settings ask for it, so it shows in the progress and is cancelled with
+ * the rest. It runs before the touched files are recorded, a rollback keeps
+ * what was pulled. Being offline does not fail the transaction.
+ * @param transaction
+ */
+void ImitatePass::addAutoPull(Transaction *transaction) {
+  if (!QtPassSettings::isAutoPull() || !QtPassSettings::isUseGit() ||
+      QtPassSettings::getGitExecutable().isEmpty())
+    return;
+  emit statusMsg(tr("Updating password-store"), 2000);
+  int pull = addGit(transaction, {"pull"});
+  transaction->setOptional(pull);
+  transaction->setPrelude(pull);
 }
 
 /**
@@ -109,25 +163,35 @@ void ImitatePass::GitCommit(const QString &file, const QString &msg) {
  */
 void ImitatePass::Remove(QString file, bool isDir) {
   file = QtPassSettings::getPassStore() + file;
-  transactionHelper trans(this, PASS_REMOVE);
   if (!isDir)
     file += ".gpg";
+  Transaction *transaction = new Transaction;
+  transaction->touch(file);
   if (QtPassSettings::isUseGit()) {
-    executeGit(GIT_RM, {"rm", (isDir ? "-rf" : "-f"), file});
+    int step = addGit(transaction, {"rm", (isDir ? "-rf" : "-f"), file});
     //  TODO(bezet): commit message used to have pass-like file name inside(ie.
     //  getFile(file, true)
-    GitCommit(file, "Remove for " + file + " using QtPass.");
+    GitCommit(transaction, {file}, "Remove for " + file + " using QtPass.",
+              {step});
+    gitRollback(transaction, {file});
   } else {
-    if (isDir) {
+    transaction->addJob([this, file, isDir](QString *error) {
+      bool removed;
+      if (isDir) {
 #if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
-      QDir dir(file);
-      dir.removeRecursively();
+        removed = QDir(file).removeRecursively();
 #else
-      removeDir(QtPassSettings::getPassStore() + file);
+        removed = removeDir(file);
 #endif
-    } else
-      QFile(file).remove();
+      } else {
+        removed = QFile(file).remove();
+      }
+      if (!removed)
+        *error = tr("Could not remove %1").arg(file);
+      return removed;
+    });
   }
+  executeTransaction(PASS_REMOVE, transaction);
 }
 
 /**
@@ -138,29 +202,58 @@ void ImitatePass::Remove(QString file, bool isDir) {
  * path
  */
 void ImitatePass::Init(QString path, const QList<UserInfo> &users) {
-  QString gpgIdFile = path + ".gpg-id";
-  QFile gpgId(gpgIdFile);
-  bool addFile = false;
-  transactionHelper trans(this, PASS_INIT);
-  if (QtPassSettings::isAddGPGId(true)) {
-    QFileInfo checkFile(gpgIdFile);
-    if (!checkFile.exists() || !checkFile.isFile())
-      addFile = true;
-  }
-  if (!gpgId.open(QIODevice::WriteOnly | QIODevice::Text)) {
-    emit critical(tr("Cannot update"),
-                  tr("Failed to open .gpg-id for writing."));
+  InitFolders({path}, users);
+}
+
+/**
+ * @brief ImitatePass::InitFolders give several folders the same recipients
+ * and re-encrypt what is in them, as one transaction and commit
+ *
+ * @param paths     folders, ending with /
+ * @param users     list of users who shall be able to decrypt passwords in
+ * them
+ */
+void ImitatePass::InitFolders(const QStringList &paths,
+                              const QList<UserInfo> &users) {
+  if (paths.isEmpty())
     return;
+  QStringList gpgIdFiles, newFiles;
+  foreach (const QString &path, paths) {
+    QString gpgIdFile = path + ".gpg-id";
+    gpgIdFiles << gpgIdFile;
+    if (QtPassSettings::isAddGPGId(true)) {
+      QFileInfo checkFile(gpgIdFile);
+      if (!checkFile.exists() || !checkFile.isFile())
+        newFiles << gpgIdFile;
+    }
   }
+  QByteArray ids;
   bool secret_selected = false;
   foreach (const UserInfo &user, users) {
     if (user.enabled) {
-      gpgId.write((user.key_id + "\n").toUtf8());
+      ids += (user.key_id + "\n").toUtf8();
       secret_selected |= user.have_secret;
     }
   }
-  gpgId.close();
+
+  auto writeGpgIds = [this, gpgIdFiles, ids](Transaction *, QString *error) {
+    foreach (const QString &gpgIdFile, gpgIdFiles) {
+      QFile gpgId(gpgIdFile);
+      if (!gpgId.open(QIODevice::WriteOnly | QIODevice::Text) ||
+          gpgId.write(ids) != ids.size()) {
+        *error = tr("Failed to open .gpg-id for writing.");
+        return false;
+      }
+    }
+    return true;
+  };
   if (!secret_selected) {
+    // the recipients are stored all the same, nothing gets re-encrypted
+    QString error;
+    if (!writeGpgIds(Q_NULLPTR, &error)) {
+      emit critical(tr("Cannot update"), error);
+      return;
+    }
     emit critical(
         tr("Check selected users!"),
         tr("None of the selected keys have a secret key available.\n"
@@ -168,15 +261,29 @@ void ImitatePass::Init(QString path, const QList<UserInfo> &users) {
     return;
   }
 
+  Transaction *transaction = new Transaction;
+  foreach (const QString &gpgIdFile, gpgIdFiles)
+    transaction->touch(gpgIdFile);
+  addAutoPull(transaction);
+  int step = transaction->addTask(writeGpgIds);
+  int commit = -1;
   if (!QtPassSettings::isUseWebDav() && QtPassSettings::isUseGit() &&
       !QtPassSettings::getGitExecutable().isEmpty()) {
-    if (addFile)
-      executeGit(GIT_ADD, {"add", gpgIdFile});
-    QString path = gpgIdFile;
-    path.replace(QRegExp("\\.gpg$"), "");
-    GitCommit(gpgIdFile, "Added " + path + " using QtPass.");
+    if (!newFiles.isEmpty())
+      step = addGit(transaction, QStringList{"add"} + newFiles, {step});
+    QString name = gpgIdFiles.first();
+    name.replace(QRegExp("\\.gpg$"), "");
+    QString message =
+        paths.size() == 1
+            ? "Added " + name + " using QtPass."
+            : QString("Added .gpg-id to %1 folders using QtPass.")
+                  .arg(paths.size());
+    // waits for the re-encryption, so it ends up in the same commit
+    commit = GitCommit(transaction, paths, message, {step});
+    gitRollback(transaction, paths);
   }
-  reencryptPath(path);
+  reencryptPath(transaction, paths, {step}, commit);
+  executeTransaction(PASS_INIT, transaction);
 }
 
 /**
@@ -207,42 +314,93 @@ bool ImitatePass::removeDir(const QString &dirName) {
 }
 
 /**
- * @brief ImitatePass::reencryptPath reencrypt all files under the chosen
- * directory
+ * @brief ImitatePass::reencryptPath reencrypt the chosen files and all
+ * files under the chosen directories
  *
- * This is stil quite experimental..
- * @param dir
- */
-void ImitatePass::reencryptPath(QString dir) {
-  emit statusMsg(tr("Re-encrypting from folder %1").arg(dir), 3000);
-  emit startReencryptPath();
-  if (QtPassSettings::isAutoPull()) {
-    //  TODO(bezet): move statuses inside actions?
-    emit statusMsg(tr("Updating password-store"), 2000);
-    GitPull_b();
-  }
-  QDir currentDir;
-  QDirIterator gpgFiles(dir, QStringList() << "*.gpg", QDir::Files,
-                        QDirIterator::Subdirectories);
-  QStringList gpgId;
-  while (gpgFiles.hasNext()) {
-    QString fileName = gpgFiles.next();
-    if (gpgFiles.fileInfo().path() != currentDir.path()) {
-      gpgId = getRecipientList(fileName);
-      gpgId.sort();
-    }
-    //  TODO(bezet): enable --with-colons for better future-proofness?
-    QStringList args = {
-        "-v",          "--no-secmem-warning", "--no-permission-warning",
-        "--list-only", "--keyid-format=long", fileName};
-    QString keys, err;
-    exec.executeBlocking(QtPassSettings::getGpgExecutable(), args, &keys, &err);
+ * The files are only looked at once the steps in after are done, then all
+ * of them are checked in parallel and those with the wrong recipients are
+ * re-encrypted in parallel.
+ * @param transaction
+ * @param paths     files and folders
+ * @param after     steps that have to be done first
+ * @param commit    git commit that has to include the re-encrypted files, -1
+ *                  if they are not committed
+ */
+void ImitatePass::reencryptPath(Transaction *transaction,
+                                const QStringList &paths,
+                                const QList<int> &after, int commit) {
+  int scan = transaction->addTask(
+      [this, paths, commit](Transaction *t, QString *) {
+        emit statusMsg(paths.size() == 1
+                           ? tr("Re-encrypting from folder %1")
+                                 .arg(paths.first())
+                           : tr("Re-encrypting %1 items").arg(paths.size()),
+                       3000);
+        emit startReencryptPath();
+        QStringList gpgFileNames;
+        foreach (const QString &path, paths) {
+          if (QFileInfo(path).isFile()) {
+            if (path.endsWith(".gpg"))
+              gpgFileNames << path;
+            continue;
+          }
+          QDirIterator gpgFiles(path, QStringList() << "*.gpg", QDir::Files,
+                                QDirIterator::Subdirectories);
+          while (gpgFiles.hasNext())
+            gpgFileNames << gpgFiles.next();
+        }
+        QStringList files;
+        QList<int> probes;
+        foreach (const QString &fileName, gpgFileNames) {
+          //  TODO(bezet): enable --with-colons for better future-proofness?
+          int probe = t->addProcess(
+              QtPassSettings::getGpgExecutable(),
+              {"-v", "--no-secmem-warning", "--no-permission-warning",
+               "--list-only", "--keyid-format=long", fileName});
+          t->setOptional(probe);
+          t->setPrivateOutput(probe);
+          files << fileName;
+          probes << probe;
+        }
+        int plan = t->addTask(
+            [this, files, probes, commit](Transaction *t, QString *error) {
+              return reencryptFiles(t, files, probes, commit, error);
+            },
+            probes);
+        if (commit >= 0)
+          t->addDependency(commit, plan);
+        return true;
+      },
+      after);
+  if (commit >= 0)
+    transaction->addDependency(commit, scan);
+}
+
+/**
+ * @brief ImitatePass::reencryptFiles add decrypt and encrypt steps for every
+ * file that is not encrypted for the recipients in its .gpg-id
+ * @param transaction
+ * @param files
+ * @param probes    steps listing the keys each file is encrypted for
+ * @param commit    git commit that has to include the re-encrypted files
+ * @param error
+ * @return false if the recipients of a file can not be determined
+ */
+bool ImitatePass::reencryptFiles(Transaction *transaction,
+                                 const QStringList &files,
+                                 const QList<int> &probes, int commit,
+                                 QString *error) {
+  QStringList changed;
+  QList<int> encrypts;
+  for (int n = 0; n < files.size(); ++n) {
+    const QString &fileName = files.at(n);
+    QStringList gpgId = getRecipientList(fileName);
+    gpgId.sort();
+    int probe = probes.at(n);
+    QString keys = QString::fromUtf8(transaction->output(probe) +
+                                     transaction->errorOutput(probe));
     QStringList actualKeys;
-    keys += err;
-    QStringList key = keys.split("\n");
-    QListIterator<QString> itr(key);
-    while (itr.hasNext()) {
-      QString current = itr.next();
+    foreach (const QString &current, keys.split("\n")) {
       QStringList cur = current.split(" ");
       if (cur.length() > 4) {
         QString actualKey = cur.takeAt(4);
@@ -252,128 +410,446 @@ void ImitatePass::reencryptPath(QString dir) {
       }
     }
     actualKeys.sort();
-    if (actualKeys != gpgId) {
-      // dbg()<< actualKeys << gpgId << getRecipientList(fileName);
-      dbg() << "reencrypt " << fileName << " for " << gpgId;
-      QString local_lastDecrypt = "Could not decrypt";
-      args = QStringList{"-d",      "--quiet",     "--yes", "--no-encrypt-to",
-                         "--batch", "--use-agent", fileName};
-      exec.executeBlocking(QtPassSettings::getGpgExecutable(), args,
-                           &local_lastDecrypt);
-
-      if (!local_lastDecrypt.isEmpty() &&
-          local_lastDecrypt != "Could not decrypt") {
-        if (local_lastDecrypt.right(1) != "\n")
-          local_lastDecrypt += "\n";
-
-        QStringList recipients = Pass::getRecipientList(fileName);
-        if (recipients.isEmpty()) {
-          emit critical(tr("Can not edit"),
-                        tr("Could not read encryption key to use, .gpg-id "
-                           "file missing or invalid."));
-          return;
-        }
-        args = QStringList{"--yes", "--batch", "-eq", "--output", fileName};
-        for (auto &i : recipients) {
-          args.append("-r");
-          args.append(i);
-        }
-        args.append("-");
-        exec.executeBlocking(QtPassSettings::getGpgExecutable(), args,
-                             local_lastDecrypt);
-
-        if (!QtPassSettings::isUseWebDav() && QtPassSettings::isUseGit()) {
-          exec.executeBlocking(QtPassSettings::getGitExecutable(),
-                               {"add", fileName});
-          QString path =
-              QDir(QtPassSettings::getPassStore()).relativeFilePath(fileName);
-          path.replace(QRegExp("\\.gpg$"), "");
-          exec.executeBlocking(QtPassSettings::getGitExecutable(),
-                               {"commit", fileName, "-m",
-                                "Edit for " + path + " using QtPass."});
-        }
-
-      } else {
-        dbg() << "Decrypt error on re-encrypt";
-      }
+    if (actualKeys == gpgId)
+      continue;
+    if (gpgId.isEmpty()) {
+      *error = tr("Could not read encryption key to use, .gpg-id "
+                  "file missing or invalid.");
+      return false;
     }
+    dbg() << "reencrypt " << fileName << " for " << gpgId;
+    transaction->touch(fileName);
+    int decrypt = transaction->addProcess(
+        QtPassSettings::getGpgExecutable(),
+        {"-d", "--quiet", "--yes", "--no-encrypt-to", "--batch", "--use-agent",
+         fileName});
+    // files we can not decrypt are left as they are
+    transaction->setOptional(decrypt);
+    QStringList args = {"--yes", "--batch", "-eq", "--output", fileName};
+    foreach (const QString &recipient, getRecipientList(fileName)) {
+      args.append("-r");
+      args.append(recipient);
+    }
+    args.append("-");
+    int encrypt =
+        transaction->addProcess(QtPassSettings::getGpgExecutable(), args);
+    transaction->setInputFrom(encrypt, decrypt);
+    changed << fileName;
+    encrypts << encrypt;
   }
-  if (QtPassSettings::isAutoPush()) {
-    emit statusMsg(tr("Updating password-store"), 2000);
-    //  TODO(bezet): this is non-blocking and shall be done outside
-    GitPush();
+
+  if (commit >= 0 && !changed.isEmpty()) {
+    int add = addGit(transaction, QStringList{"add"} + changed, encrypts);
+    transaction->addDependency(commit, add);
+    gitRollback(transaction, changed);
   }
-  emit endReencryptPath();
+  transaction->addTask(
+      [this](Transaction *, QString *) {
+        emit endReencryptPath();
+        return true;
+      },
+      encrypts);
+  return true;
+}
+
+/**
+ * @brief itemTarget where an item ends up when moved or copied to dest
+ * @param src
+ * @param dest      folder to put it in, or its new name
+ * @return path of the item afterwards
+ */
+static QString itemTarget(const QString &src, const QString &dest) {
+  if (QFileInfo(dest).isDir())
+    return QDir::cleanPath(dest + "/" + QFileInfo(src).fileName());
+  return QDir::cleanPath(dest);
 }
 
+/**
+ * @brief recipientsChange whether an item is encrypted for other recipients
+ * at its target, nested .gpg-id files move along and do not count
+ * @param src
+ * @param target
+ * @return true if the item has to be re-encrypted
+ */
+static bool recipientsChange(const QString &src, const QString &target) {
+  QStringList before = Pass::getRecipientList(src);
+  QStringList after = Pass::getRecipientList(target);
+  before.sort();
+  after.sort();
+  return before != after;
+}
+
+/**
+ * @brief ImitatePass::Move move a file or folder, the moved files are
+ * re-encrypted in the same transaction if their recipients change
+ * @param src
+ * @param dest
+ * @param force
+ */
 void ImitatePass::Move(const QString src, const QString dest,
                        const bool force) {
-  QFileInfo destFileInfo(dest);
-  transactionHelper trans(this, PASS_MOVE);
+  moveTo({src}, {itemTarget(src, dest)}, force,
+         QString("moved from %1 to %2 using QTPass.").arg(src).arg(dest));
+}
+
+/**
+ * @brief ImitatePass::Copy copy a file or folder, the copies are
+ * re-encrypted in the same transaction if their recipients change
+ * @param src
+ * @param dest
+ * @param force
+ */
+void ImitatePass::Copy(const QString src, const QString dest,
+                       const bool force) {
+  copyTo({src}, {itemTarget(src, dest)}, force,
+         QString("copied from %1 to %2 using QTPass.").arg(src).arg(dest));
+}
+
+/**
+ * @brief ImitatePass::MoveItems move files and folders into a folder as one
+ * transaction with one commit
+ * @param srcs
+ * @param destDir
+ */
+void ImitatePass::MoveItems(const QStringList &srcs, const QString &destDir) {
+  QStringList targets;
+  foreach (const QString &src, srcs)
+    targets << itemTarget(src, destDir);
+  moveTo(srcs, targets, false,
+         QString("moved %1 items to %2 using QTPass.")
+             .arg(srcs.size())
+             .arg(destDir));
+}
+
+/**
+ * @brief ImitatePass::CopyItems copy files and folders into a folder as one
+ * transaction with one commit
+ * @param srcs
+ * @param destDir
+ */
+void ImitatePass::CopyItems(const QStringList &srcs, const QString &destDir) {
+  QStringList targets;
+  foreach (const QString &src, srcs)
+    targets << itemTarget(src, destDir);
+  copyTo(srcs, targets, false,
+         QString("copied %1 items to %2 using QTPass.")
+             .arg(srcs.size())
+             .arg(destDir));
+}
+
+/**
+ * @brief ImitatePass::moveTo move items to their targets as one
+ * transaction, only the moved items whose recipients change are
+ * re-encrypted
+ * @param srcs
+ * @param targets   one per source, several targets share their folder
+ * @param force     overwrite existing targets
+ * @param message   for the commit
+ */
+void ImitatePass::moveTo(const QStringList &srcs, const QStringList &targets,
+                         bool force, const QString &message) {
+  if (srcs.isEmpty())
+    return;
+  QStringList reencrypt;
+  for (int n = 0; n < srcs.size(); ++n) {
+    if (recipientsChange(srcs.at(n), targets.at(n)))
+      reencrypt << targets.at(n);
+  }
+  Transaction *transaction = new Transaction;
+  foreach (const QString &path, srcs + targets)
+    transaction->touch(path);
+  addAutoPull(transaction);
+  int step, commit = -1;
   if (QtPassSettings::isUseGit()) {
     QStringList args;
     args << "mv";
-    if (force) {
+    if (force)
       args << "-f";
+    args << srcs;
+    args << (srcs.size() == 1 ? targets.first()
+                              : QFileInfo(targets.first()).path());
+    step = addGit(transaction, args);
+    commit = GitCommit(transaction, srcs + targets, message, {step});
+    gitRollback(transaction, srcs + targets);
+  } else {
+    auto move = [srcs, targets, force](QString *error) {
+      QDir qDir;
+      for (int n = 0; n < srcs.size(); ++n) {
+        if (force && QFileInfo(targets.at(n)).isFile())
+          qDir.remove(targets.at(n));
+        if (QFileInfo::exists(targets.at(n)) ||
+            !qDir.rename(srcs.at(n), targets.at(n))) {
+          *error =
+              tr("Could not move %1 to %2").arg(srcs.at(n)).arg(targets.at(n));
+          return false;
+        }
+      }
+      return true;
+    };
+    step = transaction->addJob(move);
+  }
+  if (!reencrypt.isEmpty())
+    reencryptPath(transaction, reencrypt, {step}, commit);
+  executeTransaction(PASS_MOVE, transaction);
+}
+
+/**
+ * @brief ImitatePass::copyTo copy items to their targets as one
+ * transaction, only the copies whose recipients change are re-encrypted
+ * @param srcs
+ * @param targets   one per source
+ * @param force     overwrite existing targets
+ * @param message   for the commit
+ */
+void ImitatePass::copyTo(const QStringList &srcs, const QStringList &targets,
+                         bool force, const QString &message) {
+  if (srcs.isEmpty())
+    return;
+  QStringList reencrypt;
+  for (int n = 0; n < srcs.size(); ++n) {
+    if (recipientsChange(srcs.at(n), targets.at(n)))
+      reencrypt << targets.at(n);
+  }
+  Transaction *transaction = new Transaction;
+  foreach (const QString &path, targets)
+    transaction->touch(path);
+  addAutoPull(transaction);
+  // copying a tree takes a while, keep it off the event loop
+  auto copy = [srcs, targets, force](QString *error) {
+    for (int n = 0; n < srcs.size(); ++n) {
+      if (force && QFileInfo(targets.at(n)).isFile())
+        QFile::remove(targets.at(n));
+      if (QFileInfo::exists(targets.at(n))) {
+        *error =
+            tr("Could not copy %1 to %2").arg(srcs.at(n)).arg(targets.at(n));
+        return false;
+      }
+      // reflinks where the filesystem has them, see CopyEngine
+      bool copied =
+          QFileInfo(srcs.at(n)).isDir()
+              ? CopyEngine::copyTree(srcs.at(n), targets.at(n), error)
+              : CopyEngine::copyFile(srcs.at(n), targets.at(n), error) !=
+                    CopyEngine::FAILED;
+      if (!copied)
+        return false;
     }
-    args << src;
-    args << dest;
-    executeGit(GIT_MOVE, args);
+    return true;
+  };
+  int step = transaction->addJob(copy);
+  int commit = -1;
+  if (QtPassSettings::isUseGit()) {
+    // re-encrypted copies are added again before the commit
+    step = addGit(transaction, QStringList{"add", "--"} + targets, {step});
+    commit = GitCommit(transaction, targets, message, {step});
+    gitRollback(transaction, targets);
+  }
+  if (!reencrypt.isEmpty())
+    reencryptPath(transaction, reencrypt, {step}, commit);
+  executeTransaction(PASS_COPY, transaction);
+}
 
-    QString message = QString("moved from %1 to %2 using QTPass.");
-    message = message.arg(src).arg(dest);
-    GitCommit("", message);
+/**
+ * @brief ImitatePass::RemoveItems remove files and folders as one
+ * transaction with one commit
+ * @param paths
+ */
+void ImitatePass::RemoveItems(const QStringList &paths) {
+  if (paths.size() < 2) {
+    Pass::RemoveItems(paths);
+    return;
+  }
+  Transaction *transaction = new Transaction;
+  foreach (const QString &path, paths)
+    transaction->touch(path);
+  if (QtPassSettings::isUseGit()) {
+    int step = addGit(transaction, QStringList{"rm", "-rf", "--"} + paths);
+    GitCommit(transaction, paths,
+              QString("Remove %1 items using QtPass.").arg(paths.size()),
+              {step});
+    gitRollback(transaction, paths);
   } else {
-    QDir qDir;
-    QFileInfo srcFileInfo(src);
-    QString destCopy = dest;
-    if (srcFileInfo.isFile() && destFileInfo.isDir()) {
-      destCopy = destFileInfo.absoluteFilePath() + QDir::separator() +
-                 srcFileInfo.fileName();
-    }
-    if (force) {
-      qDir.remove(destCopy);
-    }
-    qDir.rename(src, destCopy);
+    transaction->addJob([paths](QString *error) {
+      foreach (const QString &path, paths) {
+        bool removed = QFileInfo(path).isDir() ? QDir(path).removeRecursively()
+                                               : QFile::remove(path);
+        if (!removed) {
+          *error = tr("Could not remove %1").arg(path);
+          return false;
+        }
+      }
+      return true;
+    });
   }
-  // reecrypt all files under the new folder
-  if (destFileInfo.isDir()) {
-    reencryptPath(destFileInfo.absoluteFilePath());
-  } else if (destFileInfo.isFile()) {
-    reencryptPath(destFileInfo.dir().path());
+  executeTransaction(PASS_REMOVE, transaction);
+}
+
+/*!
+    \struct ImitatePass::importState
+    \brief What an import did so far, shared by its batches.
+ */
+struct ImitatePass::importState {
+  /**
+   * @brief root    absolute path of the folder imported to
+   */
+  QString root;
+  QString fileName;
+  /**
+   * @brief targets files the import creates, so names are not used twice
+   */
+  QSet<QString> targets;
+  /**
+   * @brief recipients  .gpg-id recipients by folder
+   */
+  QHash<QString, QStringList> recipients;
+  /**
+   * @brief gitPaths    top level store entries the commit has to include
+   */
+  QStringList gitPaths;
+  QList<int> gitAdds;
+  int imported;
+};
+
+/**
+ * @brief ImitatePass::Import import the entries of a CSV or KeePass XML
+ * export as one transaction with one commit
+ *
+ * The export is read in batches of a few entries per gpg process the
+ * transaction may run at once. The next batch is only read when the
+ * previous one is encrypted, so just a few entries are in memory at any
+ * time. Every entry is encrypted for the recipients of the folder it goes
+ * to, into a hidden file that is renamed when it is complete.
+ * @param fileName  export to read
+ * @param folder    store folder to import into, relative to the store
+ */
+void ImitatePass::Import(const QString &fileName, const QString &folder) {
+  QSharedPointer<ImportReader> reader(new ImportReader);
+  if (!reader->open(fileName)) {
+    emit critical(tr("Can not import"), reader->errorString());
+    return;
   }
+  QSharedPointer<importState> state(new importState);
+  state->root = QDir::cleanPath(
+      QDir(QtPassSettings::getPassStore()).absoluteFilePath(folder));
+  state->fileName = QFileInfo(fileName).fileName();
+  state->imported = 0;
+  Transaction *transaction = new Transaction;
+  // everything the import adds is below it, recorded once when it starts
+  transaction->touch(state->root);
+  transaction->addTask(
+      [this, reader, state](Transaction *t, QString *error) {
+        return importBatch(t, reader, state, error);
+      });
+  executeTransaction(PASS_IMPORT, transaction);
 }
 
-void ImitatePass::Copy(const QString src, const QString dest,
-                       const bool force) {
-  QFileInfo destFileInfo(dest);
-  transactionHelper trans(this, PASS_COPY);
-  if (QtPassSettings::isUseGit()) {
-    QStringList args;
-    args << "cp";
-    if (force) {
-      args << "-f";
+/**
+ * @brief ImitatePass::importBatch read the next entries of an import, add
+ * their encryption and the task reading the batch after them, or the
+ * commit when the export is done
+ * @param transaction
+ * @param reader
+ * @param state
+ * @param error
+ * @return false if the export is broken or a folder has no recipients
+ */
+bool ImitatePass::importBatch(Transaction *transaction,
+                              QSharedPointer<ImportReader> reader,
+                              QSharedPointer<importState> state,
+                              QString *error) {
+  bool useGit = !QtPassSettings::isUseWebDav() && QtPassSettings::isUseGit();
+  QDir store(QtPassSettings::getPassStore());
+  int batchSize = 4 * transaction->maxParallel();
+  QStringList targets;
+  QList<int> encrypts;
+  QList<int> renames;
+  ImportRecord record;
+  while (encrypts.size() < batchSize && reader->next(&record)) {
+    QString base = QDir::cleanPath(state->root + "/" + record.path());
+    QString target = base + ".gpg";
+    for (int n = 2;
+         state->targets.contains(target) || QFileInfo::exists(target); ++n)
+      target = QString("%1 (%2).gpg").arg(base).arg(n);
+    state->targets.insert(target);
+
+    QString dir = QFileInfo(target).absolutePath();
+    if (!state->recipients.contains(dir)) {
+      // new folders get the recipients of the closest existing one
+      QString existing = dir;
+      while (!QFileInfo(existing).isDir())
+        existing = QFileInfo(existing).absolutePath();
+      state->recipients.insert(dir,
+                               getRecipientList(existing + "/.gpg-id"));
+      if (!QDir().mkpath(dir)) {
+        *error = tr("Could not create %1").arg(dir);
+        return false;
+      }
+    }
+    QStringList recipients = state->recipients.value(dir);
+    if (recipients.isEmpty()) {
+      *error = tr("Could not read encryption key to use, .gpg-id "
+                  "file missing or invalid.");
+      return false;
     }
-    args << src;
-    args << dest;
-    executeGit(GIT_COPY, args);
 
-    QString message = QString("copied from %1 to %2 using QTPass.");
-    message = message.arg(src).arg(dest);
-    GitCommit("", message);
-  } else {
-    QDir qDir;
-    if (force) {
-      qDir.remove(dest);
+    QString temp = dir + "/." + QFileInfo(target).fileName() + ".import";
+    QStringList args = {"--batch", "-eq", "--yes", "--output", temp};
+    foreach (const QString &recipient, recipients) {
+      args.append("-r");
+      args.append(recipient);
     }
-    QFile::copy(src, dest);
+    args.append("-");
+    // the transaction wipes the content once gpg has it
+    int encrypt =
+        transaction->addProcess(QtPassSettings::getGpgExecutable(), args,
+                                QList<int>(), record.contentUtf8());
+    record.wipe();
+    renames << transaction->addTask(
+        [temp, target](Transaction *, QString *why) {
+          if (QFile::rename(temp, target))
+            return true;
+          *why = tr("Could not move %1 to %2").arg(temp).arg(target);
+          return false;
+        },
+        {encrypt});
+    encrypts << encrypt;
+    targets << target;
+
+    QString top = store.relativeFilePath(target).section('/', 0, 0);
+    if (useGit && !state->gitPaths.contains(top)) {
+      state->gitPaths << top;
+      gitRollback(transaction, {top});
+    }
+  }
+  if (reader->hasError()) {
+    *error = reader->errorString();
+    return false;
+  }
+  state->imported += targets.size();
+  if (useGit && !targets.isEmpty())
+    state->gitAdds << addGit(transaction, QStringList{"add", "--"} + targets,
+                             renames);
+
+  if (encrypts.size() == batchSize) {
+    emit statusMsg(tr("Importing, %1 entries read").arg(state->imported),
+                   3000);
+    transaction->addTask(
+        [this, reader, state](Transaction *t, QString *why) {
+          return importBatch(t, reader, state, why);
+        },
+        encrypts);
+    return true;
   }
-  // reecrypt all files under the new folder
-  if (destFileInfo.isDir()) {
-    reencryptPath(destFileInfo.absoluteFilePath());
-  } else if (destFileInfo.isFile()) {
-    reencryptPath(destFileInfo.dir().path());
+  if (state->imported == 0) {
+    *error = tr("No entries found in %1").arg(state->fileName);
+    return false;
   }
+  if (useGit)
+    GitCommit(transaction, state->gitPaths,
+              QString("Import %1 entries from %2 using QtPass.")
+                  .arg(state->imported)
+                  .arg(state->fileName),
+              state->gitAdds);
+  return true;
 }
 
 /**
@@ -394,54 +870,3 @@ void ImitatePass::executeGit(PROCESS id, const QStringList &args, QString input,
   executeWrapper(id, QtPassSettings::getGitExecutable(), args, input,
                  readStdout, readStderr);
 }
-
-/**
- * @brief ImitatePass::finished this function is overloaded to ensure
- *                              identical behaviour to RealPass ie. only PASS_*
- *                              processes are visible inside Pass::finish, so
- *                              that interface-wise it all looks the same
- * @param id
- * @param exitCode
- * @param out
- * @param err
- */
-void ImitatePass::finished(int id, int exitCode, const QString &out,
-                           const QString &err) {
-  dbg() << "Imitate Pass";
-  static QString transactionOutput;
-  PROCESS pid = transactionIsOver(static_cast<PROCESS>(id));
-  transactionOutput.append(out);
-
-  if (exitCode == 0) {
-    if (pid == INVALID)
-      return;
-  } else {
-    while (pid == INVALID) {
-      id = exec.cancelNext();
-      if (id == -1) {
-        //  this is probably irrecoverable and shall not happen
-        dbg() << "No such transaction!";
-        return;
-      }
-      pid = transactionIsOver(static_cast<PROCESS>(id));
-    }
-  }
-  Pass::finished(pid, exitCode, transactionOutput, err);
-  transactionOutput.clear();
-}
-
-/**
- * @brief executeWrapper    overrided so that every execution is a transaction
- * @param id
- * @param app
- * @param args
- * @param input
- * @param readStdout
- * @param readStderr
- */
-void ImitatePass::executeWrapper(PROCESS id, const QString &app,
-                                 const QStringList &args, QString input,
-                                 bool readStdout, bool readStderr) {
-  transactionAdd(id);
-  Pass::executeWrapper(id, app, args, input, readStdout, readStderr);
-}
@@ -2,18 +2,43 @@
 #define IMITATEPASS_H
 
 #include "pass.h"
-#include "simpletransaction.h"
+
+#include <QSharedPointer>
+
+class ImportReader;
 
 /*!
     \class ImitatePass
     \brief Imitates pass features when pass is not enabled or available
+
+    Operations that take several commands are run as one Transaction, so
+    they are reported once and rolled back when one of the commands fails.
 */
-class ImitatePass : public Pass, private simpleTransaction {
+class ImitatePass : public Pass {
   Q_OBJECT
 
   bool removeDir(const QString &dirName);
 
-  void GitCommit(const QString &file, const QString &msg);
+  int GitCommit(Transaction *transaction, const QStringList &files,
+                const QString &msg, const QList<int> &after);
+  int addGit(Transaction *transaction, const QStringList &args,
+             const QList<int> &after = QList<int>());
+  void gitRollback(Transaction *transaction, const QStringList &files);
+  void addAutoPull(Transaction *transaction);
+
+  void reencryptPath(Transaction *transaction, const QStringList &paths,
+                     const QList<int> &after, int commit);
+  bool reencryptFiles(Transaction *transaction, const QStringList &files,
+                      const QList<int> &probes, int commit, QString *error);
+  void moveTo(const QStringList &srcs, const QStringList &targets, bool force,
+              const QString &message);
+  void copyTo(const QStringList &srcs, const QStringList &targets, bool force,
+              const QString &message);
+
+  struct importState;
+  bool importBatch(Transaction *transaction,
+                   QSharedPointer<ImportReader> reader,
+                   QSharedPointer<importState> state, QString *error);
 
   void executeGit(PROCESS id, const QStringList &args,
                   QString input = QString(), bool readStdout = true,
@@ -22,27 +47,6 @@ class ImitatePass : public Pass, private simpleTransaction {
                   QString input = QString(), bool readStdout = true,
                   bool readStderr = true);
 
-  class transactionHelper {
-    simpleTransaction *m_transaction;
-    PROCESS m_result;
-
-  public:
-    transactionHelper(simpleTransaction *trans, PROCESS result)
-        : m_transaction(trans), m_result(result) {
-      m_transaction->transactionStart();
-    }
-    ~transactionHelper() { m_transaction->transactionEnd(m_result); }
-  };
-
-protected:
-  virtual void finished(int id, int exitCode, const QString &out,
-                        const QString &err) Q_DECL_OVERRIDE;
-
-  virtual void executeWrapper(PROCESS id, const QString &app,
-                              const QStringList &args, QString input,
-                              bool readStdout = true,
-                              bool readStderr = true) Q_DECL_OVERRIDE;
-
 public:
   ImitatePass();
   virtual ~ImitatePass() {}
@@ -57,7 +61,6 @@ public:
   virtual void Remove(QString file, bool isDir = false) Q_DECL_OVERRIDE;
   virtual void Init(QString path, const QList<UserInfo> &list) Q_DECL_OVERRIDE;
 
-  void reencryptPath(QString dir);
 signals:
   void startReencryptPath();
   void endReencryptPath();
@@ -68,6 +71,14 @@ public:
             const bool force = false) Q_DECL_OVERRIDE;
   void Copy(const QString src, const QString dest,
             const bool force = false) Q_DECL_OVERRIDE;
+  void MoveItems(const QStringList &srcs,
+                 const QString &destDir) Q_DECL_OVERRIDE;
+  void CopyItems(const QStringList &srcs,
+                 const QString &destDir) Q_DECL_OVERRIDE;
+  void RemoveItems(const QStringList &paths) Q_DECL_OVERRIDE;
+  void InitFolders(const QStringList &paths,
+                   const QList<UserInfo> &users) Q_DECL_OVERRIDE;
+  void Import(const QString &fileName, const QString &folder) Q_DECL_OVERRIDE;
 };
 
 #endif // IMITATEPASS_H
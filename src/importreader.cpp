@@ -0,0 +1,436 @@
+#include "importreader.h"
+#include "debughelper.h"
+#include "securebuffer.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QObject>
+#include <QPair>
+#include <QTextStream>
+#include <QXmlStreamReader>
+
+/**
+ * @brief ImportRecord::content what the password file of the entry holds,
+ * laid out the way FileContent::parse reads it
+ * @return
+ */
+QString ImportRecord::content() const {
+  QString content = password + "\n";
+  foreach (const NamedValue &field, fields)
+    content += field.name + ": " + field.value + "\n";
+  if (!notes.isEmpty())
+    content += notes + (notes.endsWith("\n") ? "" : "\n");
+  return content;
+}
+
+/**
+ * @brief safeName a folder or file name that stays where it is put and is
+ * not hidden
+ * @param name
+ * @return
+ */
+static QString safeName(QString name) {
+  name.replace('/', '-').replace('\\', '-');
+  name = name.trimmed();
+  if (name.startsWith('.'))
+    name[0] = '_';
+  return name;
+}
+
+/**
+ * @brief ImportRecord::path where the entry goes
+ * @return path relative to the import folder, without .gpg suffix
+ */
+QString ImportRecord::path() const {
+  QStringList parts;
+  foreach (const QString &part, folder.split('/', QString::SkipEmptyParts)) {
+    QString safe = safeName(part);
+    if (!safe.isEmpty())
+      parts << safe;
+  }
+  QString file = safeName(name);
+  parts << (file.isEmpty() ? QObject::tr("unnamed") : file);
+  return parts.join('/');
+}
+
+/**
+ * @brief ImportRecord::contentUtf8 content() ready to be encrypted, without
+ * a copy of it left behind as a QString
+ * @return
+ */
+QByteArray ImportRecord::contentUtf8() const {
+  QString text = content();
+  QByteArray data = text.toUtf8();
+  SecureBuffer::wipe(&text);
+  return data;
+}
+
+/**
+ * @brief ImportRecord::wipe overwrite the secrets of the entry
+ */
+void ImportRecord::wipe() {
+  SecureBuffer::wipe(&password);
+  SecureBuffer::wipe(&notes);
+  for (int n = 0; n < fields.size(); ++n)
+    SecureBuffer::wipe(&fields[n].value);
+  fields.clear();
+  folder.clear();
+  name.clear();
+}
+
+/**
+ * @brief ImportReader::ImportReader reader without anything to read, call
+ * open or setDevice
+ */
+ImportReader::ImportReader() : m_format(CSV), m_records(0), m_line(0) {}
+
+ImportReader::~ImportReader() {}
+
+/**
+ * @brief ImportReader::open read an export file, the format is guessed from
+ * its name
+ * @param fileName
+ * @return false if the file can not be read
+ */
+bool ImportReader::open(const QString &fileName) {
+  m_file.reset(new QFile(fileName));
+  if (!m_file->open(QIODevice::ReadOnly)) {
+    m_error = QObject::tr("Could not open %1: %2")
+                  .arg(fileName)
+                  .arg(m_file->errorString());
+    return false;
+  }
+  setDevice(m_file.data(), detectFormat(fileName));
+  return true;
+}
+
+/**
+ * @brief ImportReader::setDevice read from an open device, which has to
+ * stay around while records are read
+ * @param device
+ * @param format
+ */
+void ImportReader::setDevice(QIODevice *device, Format format) {
+  m_format = format;
+  m_error.clear();
+  m_records = 0;
+  m_line = 0;
+  m_columns.clear();
+  m_groups.clear();
+  m_recycled.clear();
+  m_recycleBin.clear();
+  m_text.reset();
+  m_xml.reset();
+  if (format == CSV) {
+    m_text.reset(new QTextStream(device));
+    m_text->setCodec("UTF-8");
+    m_text->setAutoDetectUnicode(true);
+  } else {
+    m_xml.reset(new QXmlStreamReader(device));
+  }
+}
+
+/**
+ * @brief ImportReader::next read the next entry
+ * @param record    filled with the entry, wipe it when done with it
+ * @return false at the end of the export or on an error, see hasError
+ */
+bool ImportReader::next(ImportRecord *record) {
+  record->wipe();
+  if (hasError())
+    return false;
+  bool found = m_format == CSV ? nextCsv(record) : nextXml(record);
+  if (found)
+    ++m_records;
+  return found;
+}
+
+/**
+ * @brief ImportReader::hasError
+ * @return whether reading stopped because the export is broken
+ */
+bool ImportReader::hasError() const { return !m_error.isEmpty(); }
+
+/**
+ * @brief ImportReader::errorString
+ * @return what is wrong with the export
+ */
+QString ImportReader::errorString() const { return m_error; }
+
+/**
+ * @brief ImportReader::recordsRead
+ * @return how many entries next() returned so far
+ */
+int ImportReader::recordsRead() const { return m_records; }
+
+/**
+ * @brief ImportReader::detectFormat
+ * @param fileName
+ * @return KEEPASS_XML for .xml files, CSV for anything else
+ */
+ImportReader::Format ImportReader::detectFormat(const QString &fileName) {
+  return QFileInfo(fileName).suffix().compare("xml", Qt::CaseInsensitive) == 0
+             ? KEEPASS_XML
+             : CSV;
+}
+
+/**
+ * @brief ImportReader::fieldForColumn where the value of a CSV column ends
+ * up, the column names of the common password managers are known
+ * @param column  name from the header row
+ * @return "folder", "name", "password" or "notes" for those parts of the
+ * record, "login" or "url" for the usual fields, the column name itself for
+ * other fields
+ */
+QString ImportReader::fieldForColumn(const QString &column) {
+  static const QList<QPair<QString, QStringList>> known = {
+      {"folder", {"folder", "group", "grouping", "path"}},
+      {"name", {"name", "title", "account"}},
+      {"password", {"password", "pass", "login_password"}},
+      {"login", {"login", "username", "user name", "user", "login_username"}},
+      {"url", {"url", "uri", "login_uri", "website", "web site"}},
+      {"notes", {"notes", "note", "comments", "extra"}}};
+  QString key = column.trimmed().toLower();
+  for (const auto &field : known) {
+    if (field.second.contains(key))
+      return field.first;
+  }
+  return column.trimmed();
+}
+
+/**
+ * @brief ImportReader::setRecordValue put a value where it belongs, the
+ * value is taken out of value so no copy of it stays behind
+ * @param record
+ * @param field     see fieldForColumn
+ * @param value
+ */
+void ImportReader::setRecordValue(ImportRecord *record, const QString &field,
+                                  QString *value) {
+  if (value->isEmpty())
+    return;
+  if (field == "folder")
+    record->folder.swap(*value);
+  else if (field == "name")
+    record->name.swap(*value);
+  else if (field == "password")
+    record->password.swap(*value);
+  else if (field == "notes")
+    record->notes.swap(*value);
+  else if (!field.isEmpty())
+    record->fields.append({field, *value});
+  SecureBuffer::wipe(value);
+}
+
+/**
+ * @brief ImportReader::nextCsv read the header row when needed and the next
+ * row with any content
+ * @param record
+ * @return
+ */
+bool ImportReader::nextCsv(ImportRecord *record) {
+  if (m_columns.isEmpty()) {
+    QString header;
+    while (header.trimmed().isEmpty()) {
+      if (m_text->atEnd())
+        return false;
+      header = m_text->readLine();
+      ++m_line;
+    }
+    if (header.startsWith(QChar(0xfeff)))
+      header.remove(0, 1);
+    m_separator = ',';
+    foreach (QChar separator, QList<QChar>({';', '\t'})) {
+      if (header.count(separator) > header.count(m_separator))
+        m_separator = separator;
+    }
+    if (!readCsvRow(&m_columns, &header))
+      return false;
+    for (int n = 0; n < m_columns.size(); ++n)
+      m_columns[n] = fieldForColumn(m_columns.at(n));
+  }
+
+  QStringList row;
+  while (readCsvRow(&row)) {
+    for (int n = 0; n < row.size() && n < m_columns.size(); ++n)
+      setRecordValue(record, m_columns.at(n), &row[n]);
+    for (int n = m_columns.size(); n < row.size(); ++n)
+      SecureBuffer::wipe(&row[n]);
+    if (!record->name.isEmpty() || !record->password.isEmpty())
+      return true;
+    record->wipe();
+  }
+  return false;
+}
+
+/**
+ * @brief ImportReader::readCsvRow read one row, quoted fields may span lines
+ * @param row
+ * @param first     first line of the row when it was read already
+ * @return false at the end or when a quote is not closed
+ */
+bool ImportReader::readCsvRow(QStringList *row, QString *first) {
+  row->clear();
+  if (!first && m_text->atEnd())
+    return false;
+  QString line;
+  if (first)
+    line.swap(*first);
+  else
+    line = m_text->readLine();
+  int start = first ? m_line : ++m_line;
+  QString field;
+  bool quoted = false;
+  int i = 0;
+  for (;;) {
+    if (i >= line.size()) {
+      if (!quoted)
+        break;
+      if (m_text->atEnd()) {
+        m_error = QObject::tr("Line %1: quote not closed").arg(start);
+        SecureBuffer::wipe(&field);
+        SecureBuffer::wipe(&line);
+        for (int n = 0; n < row->size(); ++n)
+          SecureBuffer::wipe(&(*row)[n]);
+        row->clear();
+        return false;
+      }
+      field += '\n';
+      SecureBuffer::wipe(&line);
+      line = m_text->readLine();
+      ++m_line;
+      i = 0;
+      continue;
+    }
+    QChar c = line.at(i++);
+    if (quoted) {
+      if (c != '"')
+        field += c;
+      else if (i < line.size() && line.at(i) == '"')
+        field += line.at(i++);
+      else
+        quoted = false;
+    } else if (c == '"') {
+      quoted = true;
+    } else if (c == m_separator) {
+      row->append(QString());
+      row->last().swap(field);
+    } else {
+      field += c;
+    }
+  }
+  row->append(QString());
+  row->last().swap(field);
+  SecureBuffer::wipe(&line);
+  return true;
+}
+
+/**
+ * @brief ImportReader::nextXml walk the groups up to the next entry that is
+ * not in the recycle bin
+ * @param record
+ * @return
+ */
+bool ImportReader::nextXml(ImportRecord *record) {
+  while (!m_xml->atEnd()) {
+    QXmlStreamReader::TokenType token = m_xml->readNext();
+    if (token == QXmlStreamReader::EndElement) {
+      if (m_xml->name() == QLatin1String("Group") && !m_groups.isEmpty()) {
+        m_groups.removeLast();
+        m_recycled.removeLast();
+      }
+      continue;
+    }
+    if (token != QXmlStreamReader::StartElement)
+      continue;
+    QStringRef name = m_xml->name();
+    if (name == QLatin1String("RecycleBinUUID")) {
+      m_recycleBin = m_xml->readElementText();
+    } else if (name == QLatin1String("Group")) {
+      m_groups.append(QString());
+      m_recycled.append(m_recycled.isEmpty() ? false : m_recycled.last());
+    } else if (m_groups.isEmpty()) {
+      continue;
+    } else if (name == QLatin1String("Name")) {
+      m_groups.last() = m_xml->readElementText();
+    } else if (name == QLatin1String("UUID")) {
+      if (m_xml->readElementText() == m_recycleBin && !m_recycleBin.isEmpty())
+        m_recycled.last() = true;
+    } else if (name == QLatin1String("Entry")) {
+      if (m_recycled.last()) {
+        m_xml->skipCurrentElement();
+        continue;
+      }
+      if (!readXmlEntry(record))
+        return false;
+      if (!record->name.isEmpty() || !record->password.isEmpty())
+        return true;
+      record->wipe();
+    } else {
+      // Times, CustomData and the like of the group
+      m_xml->skipCurrentElement();
+    }
+  }
+  if (m_xml->hasError())
+    m_error = QObject::tr("Line %1: %2")
+                  .arg(m_xml->lineNumber())
+                  .arg(m_xml->errorString());
+  return false;
+}
+
+/**
+ * @brief ImportReader::readXmlEntry read the strings of an entry, without
+ * its history
+ * @param record
+ * @return false when the export is broken or has protected values
+ */
+bool ImportReader::readXmlEntry(ImportRecord *record) {
+  record->folder = QStringList(m_groups.mid(1)).join("/");
+  while (m_xml->readNextStartElement()) {
+    if (m_xml->name() != QLatin1String("String")) {
+      // History, Times, AutoType, Binary
+      m_xml->skipCurrentElement();
+      continue;
+    }
+    QString key;
+    QString value;
+    while (m_xml->readNextStartElement()) {
+      if (m_xml->name() == QLatin1String("Key")) {
+        key = m_xml->readElementText();
+      } else if (m_xml->name() == QLatin1String("Value")) {
+        if (m_xml->attributes().value("Protected") == QLatin1String("True")) {
+          m_error = QObject::tr("Line %1: protected values can not be "
+                                "imported, export the database as XML "
+                                "from KeePass")
+                        .arg(m_xml->lineNumber());
+          return false;
+        }
+        value = m_xml->readElementText();
+      } else {
+        m_xml->skipCurrentElement();
+      }
+    }
+    if (key == "Title") {
+      setRecordValue(record, "name", &value);
+    } else if (key == "UserName") {
+      setRecordValue(record, "login", &value);
+    } else if (key == "Password") {
+      setRecordValue(record, "password", &value);
+    } else if (key == "URL") {
+      setRecordValue(record, "url", &value);
+    } else if (key == "Notes") {
+      setRecordValue(record, "notes", &value);
+    } else if (!value.isEmpty()) {
+      // custom strings keep their name, even one like "name"
+      record->fields.append({key, value});
+      SecureBuffer::wipe(&value);
+    }
+  }
+  if (m_xml->hasError()) {
+    m_error = QObject::tr("Line %1: %2")
+                  .arg(m_xml->lineNumber())
+                  .arg(m_xml->errorString());
+    return false;
+  }
+  return true;
+}
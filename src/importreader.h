@@ -0,0 +1,96 @@
+#ifndef IMPORTREADER_H
+#define IMPORTREADER_H
+
+#include "filecontent.h"
+
+#include <QScopedPointer>
+#include <QStringList>
+
+class QFile;
+class QIODevice;
+class QTextStream;
+class QXmlStreamReader;
+
+/*!
+    \struct ImportRecord
+    \brief One entry read from an export of another password manager.
+ */
+struct ImportRecord {
+  /**
+   * @brief folder  where the entry goes, relative to the import folder,
+   *                "/" separated, may be empty
+   */
+  QString folder;
+  QString name;
+  QString password;
+  NamedValues fields;
+  QString notes;
+
+  QString path() const;
+  QString content() const;
+  QByteArray contentUtf8() const;
+  void wipe();
+};
+
+/*!
+    \class ImportReader
+    \brief Reads the entries of a CSV or KeePass 2 XML export one at a time.
+
+    The export is never loaded as a whole, next() parses just enough of it
+    for the next entry, so exports with thousands of entries can be imported
+    without holding all of them in memory.
+
+    CSV files need a header row. Its columns are mapped to FileContent
+    fields by name, see fieldForColumn(), so the exports of most password
+    managers work as they are. Fields are separated by commas, semicolons
+    or tabs, whatever the header uses most.
+
+    In KeePass XML exports the groups become folders, the first group being
+    the store folder the import goes to. Entry history and the recycle bin
+    are left out.
+ */
+class ImportReader {
+public:
+  enum Format { CSV, KEEPASS_XML };
+
+  ImportReader();
+  ~ImportReader();
+
+  bool open(const QString &fileName);
+  void setDevice(QIODevice *device, Format format);
+
+  bool next(ImportRecord *record);
+  bool hasError() const;
+  QString errorString() const;
+  int recordsRead() const;
+
+  static Format detectFormat(const QString &fileName);
+  static QString fieldForColumn(const QString &column);
+
+private:
+  Format m_format;
+  QScopedPointer<QFile> m_file;
+  QScopedPointer<QTextStream> m_text;
+  QScopedPointer<QXmlStreamReader> m_xml;
+  QString m_error;
+  int m_records;
+  int m_line;
+
+  // CSV
+  QChar m_separator;
+  QStringList m_columns;
+
+  // KeePass XML
+  QString m_recycleBin;
+  QStringList m_groups;
+  QList<bool> m_recycled;
+
+  bool nextCsv(ImportRecord *record);
+  bool readCsvRow(QStringList *row, QString *first = nullptr);
+  bool nextXml(ImportRecord *record);
+  bool readXmlEntry(ImportRecord *record);
+  void setRecordValue(ImportRecord *record, const QString &field,
+                      QString *value);
+};
+
+#endif // IMPORTREADER_H
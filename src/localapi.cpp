@@ -0,0 +1,85 @@
+#include "localapi.h"
+
+#include <QJsonDocument>
+#include <QtEndian>
+
+/**
+ * @brief LocalApi::frame serialize a message for the socket
+ * @param message
+ * @return length prefixed JSON
+ */
+QByteArray LocalApi::frame(const QJsonObject &message) {
+  QByteArray payload = QJsonDocument(message).toJson(QJsonDocument::Compact);
+  QByteArray data(4, '\0');
+  qToBigEndian<quint32>(static_cast<quint32>(payload.size()),
+                        reinterpret_cast<uchar *>(data.data()));
+  return data + payload;
+}
+
+/**
+ * @brief LocalApi::takeFrame remove the first complete frame from a receive
+ * buffer
+ * @param buffer    bytes read from the socket so far
+ * @param message   receives the decoded message
+ * @return FRAME_INCOMPLETE if more data is needed, FRAME_INVALID if the
+ *         stream can not be decoded and the connection should be dropped
+ */
+LocalApi::FrameStatus LocalApi::takeFrame(QByteArray &buffer,
+                                          QJsonObject *message) {
+  if (buffer.size() < 4)
+    return FRAME_INCOMPLETE;
+  quint32 length = qFromBigEndian<quint32>(
+      reinterpret_cast<const uchar *>(buffer.constData()));
+  if (length > static_cast<quint32>(maxFrameSize))
+    return FRAME_INVALID;
+  if (static_cast<quint32>(buffer.size()) < 4 + length)
+    return FRAME_INCOMPLETE;
+
+  QJsonParseError error;
+  QJsonDocument doc = QJsonDocument::fromJson(buffer.mid(4, length), &error);
+  buffer.remove(0, 4 + length);
+  if (error.error != QJsonParseError::NoError || !doc.isObject())
+    return FRAME_INVALID;
+  *message = doc.object();
+  return FRAME_OK;
+}
+
+/**
+ * @brief LocalApi::request start a request for the current protocol version
+ * @param cmd   command name
+ * @return
+ */
+QJsonObject LocalApi::request(const QString &cmd) {
+  QJsonObject message;
+  message["v"] = version;
+  message["cmd"] = cmd;
+  return message;
+}
+
+/**
+ * @brief LocalApi::reply start a successful response to request
+ * @param request
+ * @return
+ */
+QJsonObject LocalApi::reply(const QJsonObject &request) {
+  QJsonObject message;
+  message["v"] = version;
+  if (request.contains("id"))
+    message["id"] = request.value("id");
+  message["ok"] = true;
+  return message;
+}
+
+/**
+ * @brief LocalApi::errorReply failed response to request
+ * @param request
+ * @param error human readable reason
+ * @return
+ */
+QJsonObject LocalApi::errorReply(const QJsonObject &request,
+                                 const QString &error) {
+  QJsonObject message = reply(request);
+  message["ok"] = false;
+  message["error"] = error;
+  return message;
+}
@@ -0,0 +1,35 @@
+#ifndef LOCALAPI_H
+#define LOCALAPI_H
+
+#include <QByteArray>
+#include <QJsonObject>
+
+/*!
+    \class LocalApi
+    \brief Wire format of the request/response protocol on the QtPass socket.
+
+    Every message is a frame: the payload length as a 32 bit big-endian
+    integer followed by a UTF-8 encoded JSON object. Requests carry the
+    protocol version "v", an "id" that is echoed in the response and a
+    "cmd". Responses carry "ok" and either the command result or "error".
+
+    Connections whose first byte is not 0 are the old command-line messages
+    and are passed on as text, so older QtPass binaries keep working.
+ */
+class LocalApi {
+public:
+  enum FrameStatus { FRAME_INCOMPLETE, FRAME_OK, FRAME_INVALID };
+
+  static const int version = 1;
+  static const int maxFrameSize = 1 << 20;
+
+  static QByteArray frame(const QJsonObject &message);
+  static FrameStatus takeFrame(QByteArray &buffer, QJsonObject *message);
+
+  static QJsonObject request(const QString &cmd);
+  static QJsonObject reply(const QJsonObject &request);
+  static QJsonObject errorReply(const QJsonObject &request,
+                                const QString &error);
+};
+
+#endif // LOCALAPI_H
@@ -0,0 +1,375 @@
+#include "localapiserver.h"
+#include "debughelper.h"
+#include "filecontent.h"
+#include "localapi.h"
+#include "qtpasssettings.h"
+#include "securebuffer.h"
+
+#include <QJsonArray>
+#include <QLocalSocket>
+#include <QMetaMethod>
+
+/**
+ * @brief LocalApiServer::LocalApiServer set up the index and the private
+ * Pass backends, call listen to start serving.
+ * @param parent
+ */
+LocalApiServer::LocalApiServer(QObject *parent)
+    : QObject(parent), m_matcherValid(false) {
+  connect(&m_server, &QLocalServer::newConnection, this,
+          &LocalApiServer::newConnection);
+  connect(&m_index, &StoreIndex::changed, this,
+          [this]() { m_matcherValid = false; });
+  connect(QtPassSettings::getInstance(), &QtPassSettings::settingChanged, this,
+          &LocalApiServer::settingChanged);
+
+  m_index.setRoot(QtPassSettings::getPassStore());
+
+  m_realPass.init();
+  m_realPass.updateEnv();
+  m_imitatePass.init();
+  m_imitatePass.updateEnv();
+}
+
+/**
+ * @brief LocalApiServer::listen start accepting clients.
+ *
+ * A socket left behind by a crashed instance is removed first, the caller
+ * is expected to have made sure no other instance is running.
+ * @param name  local socket name
+ * @return whether the server is listening
+ */
+bool LocalApiServer::listen(const QString &name) {
+  QLocalServer::removeServer(name);
+  m_server.setSocketOptions(QLocalServer::UserAccessOption);
+  return m_server.listen(name);
+}
+
+/**
+ * @brief LocalApiServer::errorString
+ * @return last error of the underlying QLocalServer
+ */
+QString LocalApiServer::errorString() const { return m_server.errorString(); }
+
+/**
+ * @brief LocalApiServer::index
+ * @return the entry index requests are answered from
+ */
+StoreIndex *LocalApiServer::index() { return &m_index; }
+
+/**
+ * @brief LocalApiServer::request handle a request without going through a
+ * socket, the answer is emitted as replied(), possibly before this returns.
+ * @param request
+ */
+void LocalApiServer::request(const QJsonObject &request) {
+  handleRequest(nullptr, request);
+}
+
+/**
+ * @brief LocalApiServer::newConnection accept all pending clients, they are
+ * read asynchronously so a slow client does not hold up the others.
+ */
+void LocalApiServer::newConnection() {
+  while (m_server.hasPendingConnections()) {
+    QLocalSocket *socket = m_server.nextPendingConnection();
+    m_clients.insert(socket, clientState());
+    connect(socket, &QLocalSocket::readyRead, this,
+            &LocalApiServer::readClient);
+    connect(socket, &QLocalSocket::disconnected, this,
+            &LocalApiServer::clientDisconnected);
+    if (socket->bytesAvailable() > 0)
+      readSocket(socket);
+  }
+}
+
+/**
+ * @brief LocalApiServer::readClient a client sent data
+ */
+void LocalApiServer::readClient() {
+  QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+  if (socket)
+    readSocket(socket);
+}
+
+/**
+ * @brief LocalApiServer::readSocket handle all complete frames a client has
+ * sent so far. Legacy messages are collected until the client disconnects.
+ * @param socket
+ */
+void LocalApiServer::readSocket(QLocalSocket *socket) {
+  if (!m_clients.contains(socket))
+    return;
+  clientState &client = m_clients[socket];
+  bool first = client.buffer.isEmpty() && !client.framed;
+  client.buffer.append(socket->readAll());
+  if (first && !client.buffer.isEmpty())
+    client.framed = client.buffer.at(0) == '\0';
+  if (!client.framed)
+    return;
+
+  QJsonObject request;
+  LocalApi::FrameStatus status;
+  while ((status = LocalApi::takeFrame(client.buffer, &request)) ==
+         LocalApi::FRAME_OK) {
+    handleRequest(socket, request);
+    if (!m_clients.contains(socket))
+      return;
+  }
+  if (status == LocalApi::FRAME_INVALID) {
+    dbg() << "Dropping client after invalid frame";
+    m_clients.remove(socket);
+    socket->abort();
+    socket->deleteLater();
+  }
+}
+
+/**
+ * @brief LocalApiServer::clientDisconnected forget the client, a legacy
+ * client is done talking now so its message is passed on.
+ */
+void LocalApiServer::clientDisconnected() {
+  QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+  if (!socket)
+    return;
+  if (m_clients.contains(socket)) {
+    clientState client = m_clients.take(socket);
+    client.buffer.append(socket->readAll());
+    if (!client.framed && !client.buffer.isEmpty())
+      emit messageAvailable(QString::fromUtf8(client.buffer));
+  }
+  // nobody is waiting for these any more
+  QList<PassRequest *> requests = m_pending.keys();
+  foreach (PassRequest *passRequest, requests) {
+    if (m_pending.value(passRequest).socket == socket) {
+      m_pending.remove(passRequest);
+      passRequest->cancel();
+    }
+  }
+  socket->deleteLater();
+}
+
+/**
+ * @brief LocalApiServer::settingChanged follow profile switches
+ * @param key
+ */
+void LocalApiServer::settingChanged(const QString &key) {
+  if (key != SettingsConstants::passStore)
+    return;
+  m_index.setRoot(QtPassSettings::getPassStore());
+  m_realPass.updateEnv();
+  m_imitatePass.updateEnv();
+}
+
+/**
+ * @brief LocalApiServer::handleRequest dispatch one request
+ * @param socket    client that sent it
+ * @param request
+ */
+void LocalApiServer::handleRequest(QLocalSocket *socket,
+                                   const QJsonObject &request) {
+  if (request.value("v").toInt() > LocalApi::version) {
+    send(socket,
+         LocalApi::errorReply(request, tr("Unsupported protocol version")));
+    return;
+  }
+
+  QString cmd = request.value("cmd").toString();
+  if (cmd == "status") {
+    QJsonObject reply = LocalApi::reply(request);
+    reply["version"] = QString(VERSION);
+    reply["protocol"] = LocalApi::version;
+    reply["store"] = m_index.root();
+    reply["entries"] = m_index.entries().size();
+    reply["pending"] = m_pending.size();
+    reply["backend"] = QtPassSettings::isUsePass() ? "pass" : "gpg";
+    reply["timeouts"] =
+        m_realPass.timeoutCount() + m_imitatePass.timeoutCount();
+    send(socket, reply);
+  } else if (cmd == "list") {
+    QJsonObject reply = LocalApi::reply(request);
+    reply["entries"] = QJsonArray::fromStringList(m_index.entries());
+    send(socket, reply);
+  } else if (cmd == "search") {
+    QJsonObject reply = LocalApi::reply(request);
+    reply["entries"] = QJsonArray::fromStringList(
+        m_index.search(request.value("query").toString()));
+    send(socket, reply);
+  } else if (cmd == "match") {
+    // other hosts of a domain may belong to someone else, e.g. on a hosting
+    // domain the matcher does not know, only hand out the host and its
+    // parent domains
+    QJsonObject reply = LocalApi::reply(request);
+    reply["entries"] = QJsonArray::fromStringList(
+        matcher().match(request.value("url").toString(),
+                        request.value("limit").toInt(-1), false));
+    send(socket, reply);
+  } else if (cmd == "show" || cmd == "copy" || cmd == "otp") {
+    if (!m_index.contains(request.value("entry").toString())) {
+      send(socket, LocalApi::errorReply(request, tr("No such entry")));
+    } else if (cmd == "copy" &&
+               !isSignalConnected(QMetaMethod::fromSignal(
+                   &LocalApiServer::copyToClipboard))) {
+      send(socket,
+           LocalApi::errorReply(request, tr("No clipboard available")));
+    } else if (cmd == "otp" && !QtPassSettings::isUsePass()) {
+      send(socket, LocalApi::errorReply(
+                       request, tr("OTP generation requires pass support")));
+    } else {
+      startBackendRequest(socket, request);
+    }
+  } else if (cmd == "generate") {
+    PasswordConfiguration config = QtPassSettings::getPasswordConfiguration();
+    int length = request.value("length").toInt(config.length);
+    QString password;
+    if (length > 0)
+      password = QtPassSettings::getPass()->Generate_b(
+          static_cast<unsigned int>(length),
+          config.Characters[config.selected]);
+    if (password.isEmpty()) {
+      send(socket, LocalApi::errorReply(request, tr("Could not generate")));
+    } else {
+      QJsonObject reply = LocalApi::reply(request);
+      reply["password"] = password;
+      send(socket, reply);
+    }
+  } else {
+    send(socket, LocalApi::errorReply(request, tr("Unknown command")));
+  }
+}
+
+/**
+ * @brief LocalApiServer::startBackendRequest start a decryption on the pass
+ * or gpg backend, whichever is configured.
+ * @param socket
+ * @param request
+ */
+void LocalApiServer::startBackendRequest(QLocalSocket *socket,
+                                         const QJsonObject &request) {
+  bool usePass = QtPassSettings::isUsePass();
+  QString executable = usePass ? QtPassSettings::getPassExecutable()
+                               : QtPassSettings::getGpgExecutable();
+  // without executable nothing is started and the request would succeed
+  // with an empty result
+  if (executable.isEmpty()) {
+    send(socket, LocalApi::errorReply(request, tr("No executable configured")));
+    return;
+  }
+
+  Pass *backend = usePass ? static_cast<Pass *>(&m_realPass) : &m_imitatePass;
+  QString entry = request.value("entry").toString();
+  PassRequest *passRequest = request.value("cmd").toString() == "otp"
+                                 ? backend->requestOtpGenerate(entry)
+                                 : backend->requestShow(entry);
+  m_pending.insert(passRequest,
+                   pendingRequest(socket, socket == nullptr, request));
+  connect(passRequest, &PassRequest::finished, this,
+          &LocalApiServer::backendFinished);
+}
+
+/**
+ * @brief LocalApiServer::backendFinished answer the client the decryption
+ * was done for
+ * @param passRequest
+ */
+void LocalApiServer::backendFinished(PassRequest *passRequest) {
+  pendingRequest pending = m_pending.take(passRequest);
+  if (!pending.local && pending.socket.isNull())
+    return;
+
+  const QJsonObject &request = pending.request;
+  if (passRequest->state() != PassRequest::FINISHED) {
+    QString error = passRequest->errorOutput().trimmed();
+    if (error.isEmpty())
+      error = tr("Process exited with code %1").arg(passRequest->exitCode());
+    send(pending.socket, LocalApi::errorReply(request, error));
+    return;
+  }
+
+  QString output = passRequest->secret().toString();
+  QString cmd = request.value("cmd").toString();
+  if (cmd == "otp") {
+    QJsonObject reply = LocalApi::reply(request);
+    reply["code"] = output.trimmed();
+    send(pending.socket, reply);
+  } else if (cmd == "copy") {
+    QJsonObject reply = showReply(request, output);
+    if (reply.value("ok").toBool()) {
+      emit copyToClipboard(reply.value("value").toString());
+      reply.remove("value");
+    }
+    send(pending.socket, reply);
+  } else {
+    send(pending.socket, showReply(request, output));
+  }
+  SecureBuffer::wipe(&output);
+}
+
+/**
+ * @brief LocalApiServer::matcher the URL matcher for the entries of the
+ * index, built again after the store changed
+ * @return
+ */
+const UrlMatcher &LocalApiServer::matcher() {
+  const QStringList &entries = m_index.entries();
+  if (!m_matcherValid) {
+    m_matcher.clear();
+    foreach (const QString &entry, entries)
+      m_matcher.addEntry(entry);
+    m_matcherValid = true;
+  }
+  return m_matcher;
+}
+
+/**
+ * @brief LocalApiServer::showReply build the answer to a show request.
+ *
+ * With a "field" only that value is returned (empty or "password" for the
+ * password), otherwise the password, all named fields and the remaining
+ * text.
+ * @param request
+ * @param output    decrypted entry
+ * @return
+ */
+QJsonObject LocalApiServer::showReply(const QJsonObject &request,
+                                      const QString &output) {
+  FileContent content = FileContent::parse(output, QStringList(), true);
+  QJsonObject reply = LocalApi::reply(request);
+  NamedValues namedValues = content.getNamedValues();
+
+  if (request.contains("field") || request.value("cmd").toString() == "copy") {
+    QString field = request.value("field").toString();
+    if (field.isEmpty() ||
+        field.compare("password", Qt::CaseInsensitive) == 0) {
+      reply["value"] = content.getPassword();
+      return reply;
+    }
+    foreach (const NamedValue &nv, namedValues) {
+      if (nv.name == field) {
+        reply["value"] = nv.value;
+        return reply;
+      }
+    }
+    return LocalApi::errorReply(request, tr("No such field"));
+  }
+
+  QJsonObject fields;
+  foreach (const NamedValue &nv, namedValues)
+    fields[nv.name] = nv.value;
+  reply["password"] = content.getPassword();
+  reply["fields"] = fields;
+  reply["remaining"] = content.getRemainingData();
+  return reply;
+}
+
+/**
+ * @brief LocalApiServer::send write a framed message to a client
+ * @param socket    client, null for requests made through request()
+ * @param message
+ */
+void LocalApiServer::send(QLocalSocket *socket, const QJsonObject &message) {
+  if (!socket)
+    emit replied(message);
+  else if (socket->state() == QLocalSocket::ConnectedState)
+    socket->write(LocalApi::frame(message));
+}
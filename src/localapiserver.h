@@ -0,0 +1,111 @@
+#ifndef LOCALAPISERVER_H
+#define LOCALAPISERVER_H
+
+#include "imitatepass.h"
+#include "realpass.h"
+#include "storeindex.h"
+#include "urlmatcher.h"
+
+#include <QHash>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QPointer>
+
+class QLocalSocket;
+
+/*!
+    \class LocalApiServer
+    \brief Answers LocalApi requests from scripts and helpers on the QtPass
+    socket.
+
+    Any number of clients can be connected at the same time and each may
+    send several requests without waiting for the answers. search, match,
+    list and status are answered from the StoreIndex straight away. show,
+    copy and otp are decrypted by a Pass backend owned by the server, so
+    they never interfere with what the main window is doing.
+
+    Requests can also be made in-process through request(), the answers then
+    arrive through replied().
+ */
+class LocalApiServer : public QObject {
+  Q_OBJECT
+
+public:
+  explicit LocalApiServer(QObject *parent = nullptr);
+
+  bool listen(const QString &name);
+  QString errorString() const;
+  StoreIndex *index();
+  void request(const QJsonObject &request);
+
+signals:
+  /**
+   * @brief messageAvailable legacy command-line message from another
+   * qtpass executable
+   * @param message args sent to qtpass executable
+   */
+  void messageAvailable(QString message);
+  /**
+   * @brief copyToClipboard a client asked for a value on the clipboard, only
+   * served when something is connected to this signal
+   * @param text
+   */
+  void copyToClipboard(const QString &text);
+  /**
+   * @brief replied answer to a request made through request()
+   * @param reply
+   */
+  void replied(const QJsonObject &reply);
+
+private slots:
+  void newConnection();
+  void readClient();
+  void clientDisconnected();
+  void settingChanged(const QString &key);
+  void backendFinished(PassRequest *passRequest);
+
+private:
+  /*!
+      \struct clientState
+      \brief Receive buffer of a connection and whether it speaks frames.
+   */
+  struct clientState {
+    clientState() : framed(false) {}
+    QByteArray buffer;
+    bool framed;
+  };
+
+  /*!
+      \struct pendingRequest
+      \brief Request waiting for its Pass backend. Requests made through
+      request() have no socket.
+   */
+  struct pendingRequest {
+    pendingRequest() : local(false) {}
+    pendingRequest(QLocalSocket *socket, bool local,
+                   const QJsonObject &request)
+        : socket(socket), local(local), request(request) {}
+
+    QPointer<QLocalSocket> socket;
+    bool local;
+    QJsonObject request;
+  };
+
+  QLocalServer m_server;
+  QHash<QLocalSocket *, clientState> m_clients;
+  StoreIndex m_index;
+  UrlMatcher m_matcher;
+  bool m_matcherValid;
+  RealPass m_realPass;
+  ImitatePass m_imitatePass;
+  QHash<PassRequest *, pendingRequest> m_pending;
+
+  void readSocket(QLocalSocket *socket);
+  void handleRequest(QLocalSocket *socket, const QJsonObject &request);
+  void startBackendRequest(QLocalSocket *socket, const QJsonObject &request);
+  QJsonObject showReply(const QJsonObject &request, const QString &output);
+  void send(QLocalSocket *socket, const QJsonObject &message);
+  const UrlMatcher &matcher();
+};
+
+#endif // LOCALAPISERVER_H
@@ -3,28 +3,29 @@
 #include <QClipboard>
 #include <QCloseEvent>
 #include <QDesktopServices>
+#include <QFileDialog>
 #include <QFileInfo>
 #include <QInputDialog>
 #include <QLabel>
 #include <QMenu>
 #include <QMessageBox>
+#include <QProgressBar>
 #include <QQueue>
 #include <QShortcut>
 #include <QTextCodec>
-#ifdef Q_OS_WIN
-#define WIN32_LEAN_AND_MEAN /*_KILLING_MACHINE*/
-#define WIN32_EXTRA_LEAN
-#include <windows.h>
-#include <winnetwk.h>
-#undef DELETE
-#endif
+#include <QToolButton>
 #include "configdialog.h"
 #include "filecontent.h"
+#include "folderscan.h"
 #include "keygendialog.h"
 #include "passworddialog.h"
 #include "qpushbuttonwithclipboard.h"
 #include "qtpasssettings.h"
+#include "quickopen.h"
+#include "securebuffer.h"
 #include "settingsconstants.h"
+#include "startupprofile.h"
+#include "tracer.h"
 #include "trayicon.h"
 #include "ui_mainwindow.h"
 #include "usersdialog.h"
@@ -36,15 +37,19 @@
  * @param parent
  */
 MainWindow::MainWindow(const QString &searchText, QWidget *parent)
-    : QMainWindow(parent), ui(new Ui::MainWindow), fusedav(this),
+    : QMainWindow(parent), ui(new Ui::MainWindow),
       clippedText(QString()), freshStart(true), keygen(NULL),
-      startupPhase(true), tray(NULL) {
+      startupPhase(true), tray(NULL), templateFieldsUsed(0),
+      modelLoadStarted(-1), dropProgress(NULL), dropCancel(NULL),
+      secretKeysValid(false), urlMatcherValid(false),
+      searchRankerValid(false), quickOpen(NULL) {
 #ifdef __APPLE__
   // extra treatment for mac os
   // see http://doc.qt.io/qt-5/qkeysequence.html#qt_set_sequence_auto_mnemonic
   qt_set_sequence_auto_mnemonic(true);
 #endif
   ui->setupUi(this);
+  StartupProfile::phase("ui setup");
 
   // i think this should be moved out of MainWindow (in main.cpp as example)
   if (!checkConfig()) {
@@ -52,15 +57,36 @@ MainWindow::MainWindow(const QString &searchText, QWidget *parent)
     QApplication::quit();
   }
 
+  // whatever is not needed to draw the window waits for its first paint
+  ui->treeView->viewport()->installEventFilter(this);
+  ui->resultView->viewport()->installEventFilter(this);
+
+  // matches are listed flat while searching, the tree stays as it was
+  ui->resultView->setModel(&searchResults);
+  ui->resultView->hide();
+  connect(ui->resultView->selectionModel(),
+          &QItemSelectionModel::currentChanged, this,
+          &MainWindow::resultChanged);
+
   // register shortcut ctrl/cmd + Q to close the main window
   new QShortcut(QKeySequence(Qt::CTRL + Qt::Key_Q), this, SLOT(close()));
   // register shortcut ctrl/cmd + C to copy the currently selected password
   new QShortcut(QKeySequence(QKeySequence::StandardKey::Copy), this,
                 SLOT(copyPasswordFromTreeview()));
+  // register shortcut ctrl/cmd + P to find an entry and copy its password
+  new QShortcut(QKeySequence(Qt::CTRL + Qt::Key_P), this,
+                SLOT(showQuickOpen()));
 
   //    TODO(bezet): this should be reconnected dynamically when pass changes
   connectPassSignalHandlers(QtPassSettings::getRealPass());
   connectPassSignalHandlers(QtPassSettings::getImitatePass());
+  // results of the background backends come with their requests
+  foreach (Pass *pass, QList<Pass *>({&backgroundRealPass,
+                                      &backgroundImitatePass})) {
+    pass->init();
+    connect(pass, &Pass::critical, this, &MainWindow::critical);
+    connect(pass, &Pass::statusMsg, this, &MainWindow::showStatusMessage);
+  }
 
   //    only for ipass
   connect(QtPassSettings::getImitatePass(), SIGNAL(startReencryptPath()), this,
@@ -73,6 +99,29 @@ MainWindow::MainWindow(const QString &searchText, QWidget *parent)
   clearClipboardTimer.setSingleShot(true);
   connect(&clearClipboardTimer, SIGNAL(timeout()), this,
           SLOT(clearClipboard()));
+  connect(QtPassSettings::getInstance(), &QtPassSettings::settingChanged, this,
+          &MainWindow::settingChanged);
+  connect(&webDav, &WebDavSync::finished, this, &MainWindow::webDavSynced);
+  connect(&proxyModel, &StoreModel::dropStarted, this,
+          &MainWindow::dropStarted);
+  fieldIndexTimer.setSingleShot(true);
+  fieldIndexTimer.setInterval(2000);
+  connect(&fieldIndexTimer, &QTimer::timeout, this,
+          &MainWindow::updateFieldIndex);
+  connect(&storeIndex, &StoreIndex::changed, &fieldIndexTimer,
+          static_cast<void (QTimer::*)()>(&QTimer::start));
+  connect(&storeIndex, &StoreIndex::changed, this, [this]() {
+    urlMatcherValid = false;
+    searchRankerValid = false;
+    if (ui->treeView->isHidden())
+      searchTimer.start();
+  });
+  searchTimer.setSingleShot(true);
+  searchTimer.setInterval(500);
+  connect(&searchTimer, &QTimer::timeout, this,
+          [this]() { on_lineEdit_textChanged(ui->lineEdit->text()); });
+  connect(&fieldIndex, &FieldIndex::changed, this,
+          [this]() { urlMatcherValid = false; });
 
   initToolBarButtons();
   initStatusBar();
@@ -88,6 +137,75 @@ MainWindow::MainWindow(const QString &searchText, QWidget *parent)
   QTimer::singleShot(10, this, SLOT(focusInput()));
 
   ui->lineEdit->setText(searchText);
+  StartupProfile::phase("main window");
+}
+
+/**
+ * @brief MainWindow::deferredInit the part of starting up that is not needed
+ * for the first paint: starting the WebDAV sync and the tray icon
+ */
+void MainWindow::deferredInit() {
+  if (QtPassSettings::isUseWebDav()) {
+    syncWebDav();
+    StartupProfile::phase("webdav");
+  }
+
+  if (QtPassSettings::isUseTrayIcon() && tray == NULL) {
+    initTrayIcon();
+    if (QtPassSettings::isStartMinimized())
+      hide();
+    StartupProfile::phase("tray icon");
+  }
+  if (QtPassSettings::isUseFieldIndex())
+    fieldIndexTimer.start();
+  StartupProfile::finish();
+}
+
+/**
+ * @brief MainWindow::initStoreModel point the model and the tree view at the
+ * password-store
+ */
+void MainWindow::initStoreModel() {
+  QString passStore = QtPassSettings::getPassStore();
+  model.setNameFilters(QStringList() << "*.gpg");
+  model.setNameFilterDisables(false);
+
+  proxyModel.setSourceModel(&model);
+  proxyModel.setModelAndStore(&model, passStore);
+  updateStoreRoot();
+  selectionModel.reset(new QItemSelectionModel(&proxyModel));
+  // the model loads on a thread of its own, traced until the root is listed
+  modelLoadStarted = Tracer::now();
+  connect(&model, &QFileSystemModel::directoryLoaded, this,
+          &MainWindow::modelDirectoryLoaded, Qt::UniqueConnection);
+  model.fetchMore(model.setRootPath(passStore));
+  model.sort(0, Qt::AscendingOrder);
+
+  ui->treeView->setModel(&proxyModel);
+  ui->treeView->setRootIndex(
+      proxyModel.mapFromSource(model.setRootPath(passStore)));
+  ui->treeView->setColumnHidden(1, true);
+  ui->treeView->setColumnHidden(2, true);
+  ui->treeView->setColumnHidden(3, true);
+  ui->treeView->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+}
+
+/**
+ * @brief MainWindow::updateStoreRoot point the indexes at the current
+ * password-store, after a profile or store switch their results would
+ * belong to the previous one
+ */
+void MainWindow::updateStoreRoot() {
+  QString passStore = QtPassSettings::getPassStore();
+  if (QDir::cleanPath(passStore) == storeIndex.root())
+    return;
+  // fields decrypted from the old store must not end up in the new index
+  if (fieldIndexRequest)
+    fieldIndexRequest->cancel();
+  storeIndex.setRoot(passStore);
+  fieldIndex.setRoot(passStore);
+  urlMatcherValid = false;
+  searchRankerValid = false;
 }
 
 /**
@@ -133,9 +251,283 @@ void MainWindow::initStatusBar() {
                      .scaledToHeight(statusBar()->height());
   QLabel *logoApp = new QLabel(statusBar());
   logoApp->setPixmap(logo);
+
+  // shown while a drag and drop move or copy runs
+  dropProgress = new QProgressBar(statusBar());
+  dropProgress->setMaximumWidth(120);
+  dropProgress->hide();
+  dropCancel = new QToolButton(statusBar());
+  dropCancel->setText(tr("Cancel"));
+  dropCancel->hide();
+  connect(dropCancel, &QToolButton::clicked, this, &MainWindow::cancelDrop);
+  statusBar()->addPermanentWidget(dropProgress);
+  statusBar()->addPermanentWidget(dropCancel);
   statusBar()->addPermanentWidget(logoApp);
 }
 
+/**
+ * @brief MainWindow::dropStarted show the progress of a move or copy that
+ * was started by drag and drop
+ * @param request
+ * @param action
+ * @param count     items that were dropped
+ */
+void MainWindow::dropStarted(PassRequest *request, Qt::DropAction action,
+                             int count) {
+  bool copy = action == Qt::CopyAction;
+  request->setProperty("copy", copy);
+  request->setProperty("count", count);
+  connect(request, &PassRequest::finished, this, &MainWindow::dropFinished);
+  showRequestProgress(request);
+  ui->statusBar->showMessage(copy ? tr("Copying %n item(s)", "", count)
+                                  : tr("Moving %n item(s)", "", count));
+}
+
+/**
+ * @brief MainWindow::showRequestProgress show the progress bar and cancel
+ * button in the status bar for a long running request
+ * @param request
+ */
+void MainWindow::showRequestProgress(PassRequest *request) {
+  connect(request, &PassRequest::progress, this, &MainWindow::dropProgressed);
+  dropRequest = request;
+  dropProgress->setRange(0, 0);
+  dropProgress->show();
+  dropCancel->show();
+}
+
+/**
+ * @brief MainWindow::importEntries import a CSV or KeePass XML export into
+ * the selected folder
+ */
+void MainWindow::importEntries() {
+  QString folder =
+      Util::getDir(ui->treeView->currentIndex(), true, model, proxyModel);
+  QString fileName = QFileDialog::getOpenFileName(
+      this, tr("Import passwords"), QDir::homePath(),
+      tr("Password exports (*.csv *.xml);;CSV (*.csv);;KeePass 2 XML (*.xml)"));
+  if (fileName.isEmpty())
+    return;
+  PassRequest *request = backgroundPass()->requestImport(fileName, folder);
+  connect(request, &PassRequest::finished, this, &MainWindow::importFinished);
+  showRequestProgress(request);
+  ui->statusBar->showMessage(
+      tr("Importing %1").arg(QFileInfo(fileName).fileName()));
+}
+
+/**
+ * @brief MainWindow::exportEntries export the selected folder for another
+ * key, e.g. of an auditor, into a tar archive
+ */
+void MainWindow::exportEntries() {
+  QString folder =
+      Util::getDir(ui->treeView->currentIndex(), true, model, proxyModel);
+  QList<UserInfo> keys = QtPassSettings::getPass()->listKeys();
+  QStringList names;
+  foreach (const UserInfo &key, keys)
+    names << QString("%1 (%2)").arg(key.name).arg(key.key_id);
+  bool ok;
+  QString key = QInputDialog::getItem(
+      this, tr("Export passwords"),
+      tr("Encrypt the exported passwords for:"), names, 0, false, &ok);
+  if (!ok || key.isEmpty())
+    return;
+  QString archive = QFileDialog::getSaveFileName(
+      this, tr("Export passwords"), QDir::homePath() + "/passwords.tar",
+      tr("Tar archives (*.tar)"));
+  if (archive.isEmpty())
+    return;
+  PassRequest *request = backgroundPass()->requestExport(
+      folder, {keys.at(names.indexOf(key)).key_id}, archive);
+  connect(request, &PassRequest::finished, this, &MainWindow::exportFinished);
+  showRequestProgress(request);
+  ui->statusBar->showMessage(
+      tr("Exporting to %1").arg(QFileInfo(archive).fileName()));
+}
+
+/**
+ * @brief MainWindow::exportFinished show the outcome of an export
+ * @param request
+ */
+void MainWindow::exportFinished(PassRequest *request) {
+  if (request == dropRequest) {
+    dropProgress->hide();
+    dropCancel->hide();
+  }
+  if (request->state() != PassRequest::FINISHED) {
+    processErrorExit(request->exitCode(), request->errorOutput());
+    return;
+  }
+  ui->statusBar->showMessage(tr("Export finished"), 5000);
+}
+
+/**
+ * @brief MainWindow::updateFieldIndex decrypt the entries that changed
+ * since they were indexed, in the background
+ */
+void MainWindow::updateFieldIndex() {
+  if (!QtPassSettings::isUseFieldIndex())
+    return;
+  if (fieldIndexRequest) {
+    // try again once the running update is done
+    fieldIndexTimer.start();
+    return;
+  }
+  QStringList keys = fieldIndexKeys();
+  if (keys.isEmpty()) {
+    ui->statusBar->showMessage(
+        tr("No secret key to encrypt the field index for"), 5000);
+    return;
+  }
+  fieldIndexRequest = backgroundPass()->requestIndexFields(
+      &fieldIndex, storeIndex.entries(), keys);
+  connect(fieldIndexRequest, &PassRequest::finished, this,
+          &MainWindow::fieldIndexFinished);
+}
+
+/**
+ * @brief MainWindow::fieldIndexFinished search again with the new fields
+ * @param request
+ */
+void MainWindow::fieldIndexFinished(PassRequest *request) {
+  if (request->state() != PassRequest::FINISHED) {
+    ui->statusBar->showMessage(tr("Could not index fields: %1")
+                                   .arg(request->errorOutput().trimmed()),
+                               5000);
+    return;
+  }
+  if (FieldIndex::isFieldQuery(ui->lineEdit->text()))
+    on_lineEdit_textChanged(ui->lineEdit->text());
+}
+
+/**
+ * @brief MainWindow::fieldIndexKeys the key of the user the field index is
+ * encrypted for: the secret key the store is encrypted to, or else the
+ * first secret key
+ * @return
+ */
+QStringList MainWindow::fieldIndexKeys() {
+  QStringList recipients =
+      Pass::getRecipientList(QtPassSettings::getPassStore());
+  if (!secretKeysValid) {
+    secretKeys = QtPassSettings::getPass()->listKeys("", true);
+    secretKeysValid = true;
+  }
+  const QList<UserInfo> &secret = secretKeys;
+  foreach (const UserInfo &key, secret) {
+    foreach (const QString &recipient, recipients) {
+      if (!recipient.isEmpty() && !key.key_id.isEmpty() &&
+          (recipient.endsWith(key.key_id, Qt::CaseInsensitive) ||
+           key.key_id.endsWith(recipient, Qt::CaseInsensitive) ||
+           key.name.contains(recipient, Qt::CaseInsensitive)))
+        return QStringList(key.key_id);
+    }
+  }
+  return secret.isEmpty() ? QStringList() : QStringList(secret.first().key_id);
+}
+
+/**
+ * @brief MainWindow::backgroundPass backend for indexing, import and export
+ * @return the background backend of the kind the settings ask for, set up
+ * for the current profile
+ */
+Pass *MainWindow::backgroundPass() {
+  Pass *pass = QtPassSettings::isUsePass()
+                   ? static_cast<Pass *>(&backgroundRealPass)
+                   : &backgroundImitatePass;
+  pass->updateEnv();
+  return pass;
+}
+
+/**
+ * @brief MainWindow::updateUrlMatcher build the URL matcher again after the
+ * store or the field index changed, indexed URLs included
+ */
+void MainWindow::updateUrlMatcher() {
+  if (urlMatcherValid)
+    return;
+  Tracer::Span span("url matcher", "ui");
+  urlMatcher.clear();
+  bool fields = QtPassSettings::isUseFieldIndex() && !fieldIndex.isEmpty();
+  foreach (const QString &entry, storeIndex.entries()) {
+    QStringList urls;
+    if (fields) {
+      foreach (const NamedValue &field, fieldIndex.fields(entry)) {
+        if (field.name.startsWith("url", Qt::CaseInsensitive) ||
+            field.value.contains("://"))
+          urls.append(field.value);
+      }
+    }
+    urlMatcher.addEntry(entry, urls);
+  }
+  urlMatcherValid = true;
+}
+
+/**
+ * @brief MainWindow::importFinished show the outcome of an import
+ * @param request
+ */
+void MainWindow::importFinished(PassRequest *request) {
+  if (request == dropRequest) {
+    dropProgress->hide();
+    dropCancel->hide();
+  }
+  if (request->state() != PassRequest::FINISHED) {
+    processErrorExit(request->exitCode(), request->errorOutput());
+    return;
+  }
+  passStoreChanged(request->output(), request->errorOutput());
+  ui->statusBar->showMessage(tr("Import finished"), 5000);
+}
+
+/**
+ * @brief MainWindow::dropProgressed update the progress bar
+ * @param done
+ * @param total
+ */
+void MainWindow::dropProgressed(int done, int total) {
+  if (sender() != dropRequest)
+    return;
+  dropProgress->setRange(0, total);
+  dropProgress->setValue(done);
+}
+
+/**
+ * @brief MainWindow::dropFinished summarise a drag and drop move or copy
+ * @param request
+ */
+void MainWindow::dropFinished(PassRequest *request) {
+  if (request == dropRequest) {
+    dropProgress->hide();
+    dropCancel->hide();
+  }
+  if (request->state() != PassRequest::FINISHED) {
+    processErrorExit(request->exitCode(), request->errorOutput());
+    return;
+  }
+  passStoreChanged(request->output(), request->errorOutput());
+  int count = request->property("count").toInt();
+  ui->statusBar->showMessage(request->property("copy").toBool()
+                                 ? tr("Copied %n item(s)", "", count)
+                                 : tr("Moved %n item(s)", "", count),
+                             5000);
+}
+
+/**
+ * @brief MainWindow::cancelDrop stop the running drag and drop move or
+ * copy, or the running import or export, what it already changed is rolled
+ * back
+ */
+void MainWindow::cancelDrop() {
+  dropProgress->hide();
+  dropCancel->hide();
+  if (!dropRequest)
+    return;
+  dropRequest->cancel();
+  enableUiElements(true);
+  ui->statusBar->showMessage(tr("Cancelled, rolling back"), 5000);
+}
+
 /**
  * @brief MainWindow::focusInput selects any text (if applicable) in the search
  * box and sets focus to it. Allows for easy searching, called at application
@@ -151,16 +543,6 @@ void MainWindow::focusInput() {
  * @brief MainWindow::~MainWindow destroy!
  */
 MainWindow::~MainWindow() {
-#ifdef Q_OS_WIN
-  if (QtPassSettings::isUseWebDav())
-    WNetCancelConnection2A(QtPassSettings::getPassStore().toUtf8().constData(),
-                           0, 1);
-#else
-  if (fusedav.state() == QProcess::Running) {
-    fusedav.terminate();
-    fusedav.waitForFinished(2000);
-  }
-#endif
 }
 
 /**
@@ -209,68 +591,46 @@ void MainWindow::connectPassSignalHandlers(Pass *pass) {
 }
 
 /**
- * @brief MainWindow::mountWebDav is some scary voodoo magic
- */
-void MainWindow::mountWebDav() {
-#ifdef Q_OS_WIN
-  char dst[20] = {0};
-  NETRESOURCEA netres;
-  memset(&netres, 0, sizeof(netres));
-  netres.dwType = RESOURCETYPE_DISK;
-  netres.lpLocalName = 0;
-  netres.lpRemoteName = QtPassSettings::getWebDavUrl().toUtf8().data();
-  DWORD size = sizeof(dst);
-  DWORD r = WNetUseConnectionA(
-      reinterpret_cast<HWND>(effectiveWinId()), &netres,
-      QtPassSettings::getWebDavPassword().toUtf8().constData(),
-      QtPassSettings::getWebDavUser().toUtf8().constData(),
-      CONNECT_TEMPORARY | CONNECT_INTERACTIVE | CONNECT_REDIRECT, dst, &size,
-      0);
-  if (r == NO_ERROR) {
-    QtPassSettings::setPassStore(dst);
-  } else {
-    char message[256] = {0};
-    FormatMessageA(FORMAT_MESSAGE_FROM_SYSTEM, 0, r, 0, message,
-                   sizeof(message), 0);
-    ui->textBrowser->setTextColor(Qt::red);
-    ui->textBrowser->setText(tr("Failed to connect WebDAV:\n") + message +
-                             " (0x" + QString::number(r, 16) + ")");
-    ui->textBrowser->setTextColor(Qt::black);
-  }
-#else
-  fusedav.start("fusedav -o nonempty -u \"" + QtPassSettings::getWebDavUser() +
-                "\" " + QtPassSettings::getWebDavUrl() + " \"" +
-                QtPassSettings::getPassStore() + '"');
-  fusedav.waitForStarted();
-  if (fusedav.state() == QProcess::Running) {
-    QString pwd = QtPassSettings::getWebDavPassword();
+ * @brief MainWindow::syncWebDav mirror the WebDAV store into the local
+ * password-store folder, or bring the two in line again
+ */
+void MainWindow::syncWebDav() {
+  if (webDavPassword.isEmpty())
+    webDavPassword = QtPassSettings::getWebDavPassword();
+  if (webDavPassword.isEmpty() && !QtPassSettings::getWebDavUser().isEmpty()) {
     bool ok = true;
-    if (pwd.isEmpty()) {
-      pwd = QInputDialog::getText(this, tr("QtPass WebDAV password"),
-                                  tr("Enter password to connect to WebDAV:"),
-                                  QLineEdit::Password, "", &ok);
-    }
-    if (ok && !pwd.isEmpty()) {
-      fusedav.write(pwd.toUtf8() + '\n');
-      fusedav.closeWriteChannel();
-      fusedav.waitForFinished(2000);
-    } else {
-      fusedav.terminate();
-    }
+    webDavPassword = QInputDialog::getText(
+        this, tr("QtPass WebDAV password"),
+        tr("Enter password to connect to WebDAV:"), QLineEdit::Password, "",
+        &ok);
+    if (!ok)
+      return;
   }
-  QString error = fusedav.readAllStandardError();
-  int prompt = error.indexOf("Password:");
-  if (prompt >= 0)
-    error.remove(0, prompt + 10);
-  if (fusedav.state() != QProcess::Running)
-    error = tr("fusedav exited unexpectedly\n") + error;
-  if (error.size() > 0) {
-    ui->textBrowser->setTextColor(Qt::red);
-    ui->textBrowser->setText(
-        tr("Failed to start fusedav to connect WebDAV:\n") + error);
-    ui->textBrowser->setTextColor(Qt::black);
+  webDav.setRemote(QUrl(QtPassSettings::getWebDavUrl()));
+  webDav.setCredentials(QtPassSettings::getWebDavUser(), webDavPassword);
+  webDav.setLocalRoot(QtPassSettings::getPassStore());
+  ui->statusBar->showMessage(tr("Syncing with WebDAV"), 2000);
+  webDav.sync();
+}
+
+/**
+ * @brief MainWindow::webDavSynced report the outcome of a WebDAV sync
+ * @param ok
+ * @param error
+ */
+void MainWindow::webDavSynced(bool ok, const QString &error) {
+  if (ok) {
+    ui->statusBar->showMessage(tr("WebDAV synced: %1 downloaded, %2 uploaded, "
+                                  "%3 deleted")
+                                   .arg(webDav.downloaded())
+                                   .arg(webDav.uploaded())
+                                   .arg(webDav.deleted()),
+                               3000);
+    return;
   }
-#endif
+  ui->textBrowser->setTextColor(Qt::red);
+  ui->textBrowser->setText(tr("Failed to sync with WebDAV:\n") + error);
+  ui->textBrowser->setTextColor(Qt::black);
 }
 
 /**
@@ -295,15 +655,7 @@ bool MainWindow::checkConfig() {
     this->show();
   }
 
-  if (QtPassSettings::isUseTrayIcon() && tray == NULL) {
-    initTrayIcon();
-    if (freshStart && QtPassSettings::isStartMinimized()) {
-      // since we are still in constructor, can't directly hide
-      QTimer::singleShot(10, this, SLOT(hide()));
-    }
-  } /*else if (!QtPassSettings::isUseTrayIcon() && tray != NULL) {
-    destroyTrayIcon();
-  }*/
+  // the tray icon is set up in deferredInit
 
   // dbg()<< version;
 
@@ -330,41 +682,24 @@ bool MainWindow::checkConfig() {
   }
 
   QtPassSettings::setVersion(VERSION);
+  StartupProfile::phase("settings");
 
   if (Util::checkConfig()) {
     config();
     if (freshStart && Util::checkConfig())
       return false;
   }
+  StartupProfile::phase("config check");
 
   freshStart = false;
 
-  // TODO(annejan): this needs to be before we try to access the store,
-  // but it would be better to do it after the Window is shown,
-  // as the long delay it can cause is irritating otherwise.
-  if (QtPassSettings::isUseWebDav())
-    mountWebDav();
-
-  model.setNameFilters(QStringList() << "*.gpg");
-  model.setNameFilterDisables(false);
+  initStoreModel();
+  StartupProfile::phase("store model");
 
-  proxyModel.setSourceModel(&model);
-  proxyModel.setModelAndStore(&model, passStore);
-  selectionModel.reset(new QItemSelectionModel(&proxyModel));
-  model.fetchMore(model.setRootPath(passStore));
-  model.sort(0, Qt::AscendingOrder);
-
-  ui->treeView->setModel(&proxyModel);
-  ui->treeView->setRootIndex(
-      proxyModel.mapFromSource(model.setRootPath(passStore)));
-  ui->treeView->setColumnHidden(1, true);
-  ui->treeView->setColumnHidden(2, true);
-  ui->treeView->setColumnHidden(3, true);
   ui->treeView->setHeaderHidden(true);
   ui->treeView->setIndentation(15);
   ui->treeView->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
   ui->treeView->setContextMenuPolicy(Qt::CustomContextMenu);
-  ui->treeView->header()->setSectionResizeMode(0, QHeaderView::Stretch);
   connect(ui->treeView, SIGNAL(customContextMenuRequested(const QPoint &)),
           this, SLOT(showContextMenu(const QPoint &)));
   connect(ui->treeView, SIGNAL(emptyClicked()), this, SLOT(deselect()));
@@ -380,6 +715,7 @@ bool MainWindow::checkConfig() {
   clearClipboardTimer.setInterval(1000 * QtPassSettings::getAutoclearSeconds());
   updateGitButtonVisibility();
   updateOtpButtonVisibility();
+  StartupProfile::phase("profile box");
 
   startupPhase = false;
   return true;
@@ -410,19 +746,14 @@ void MainWindow::config() {
       this->show();
 
       updateProfileBox();
+      updateStoreRoot();
       ui->treeView->setRootIndex(proxyModel.mapFromSource(
           model.setRootPath(QtPassSettings::getPassStore())));
 
       if (freshStart && Util::checkConfig())
         config();
       QtPassSettings::getPass()->updateEnv();
-      clearPanelTimer.setInterval(1000 *
-                                  QtPassSettings::getAutoclearPanelSeconds());
-      clearClipboardTimer.setInterval(1000 *
-                                      QtPassSettings::getAutoclearSeconds());
 
-      updateGitButtonVisibility();
-      updateOtpButtonVisibility();
       if (QtPassSettings::isUseTrayIcon() && tray == NULL)
         initTrayIcon();
       else if (!QtPassSettings::isUseTrayIcon() && tray != NULL) {
@@ -433,10 +764,50 @@ void MainWindow::config() {
   }
 }
 
+/**
+ * @brief MainWindow::settingChanged keep timers and buttons in line with the
+ * settings without having to poll them
+ * @param key SettingsConstants name of the changed setting
+ */
+void MainWindow::settingChanged(const QString &key) {
+  const SettingsSnapshot &settings = QtPassSettings::getSnapshot();
+  if (key == SettingsConstants::autoclearPanelSeconds) {
+    clearPanelTimer.setInterval(1000 * settings.autoclearPanelSeconds);
+  } else if (key == SettingsConstants::autoclearSeconds) {
+    clearClipboardTimer.setInterval(1000 * settings.autoclearSeconds);
+  } else if (key == SettingsConstants::useGit ||
+             key == SettingsConstants::gitExecutable ||
+             key == SettingsConstants::passExecutable) {
+    updateGitButtonVisibility();
+  } else if (key == SettingsConstants::useOtp) {
+    updateOtpButtonVisibility();
+  } else if (key == SettingsConstants::gpgExecutable ||
+             key == SettingsConstants::gpgHome) {
+    secretKeysValid = false;
+  } else if (key == SettingsConstants::passStore) {
+    updateStoreRoot();
+  } else if (key == SettingsConstants::useFieldIndex) {
+    if (QtPassSettings::isUseFieldIndex()) {
+      fieldIndexTimer.start();
+    } else {
+      // opting out removes what was indexed, also from disk
+      fieldIndexTimer.stop();
+      if (fieldIndexRequest)
+        fieldIndexRequest->cancel();
+      fieldIndex.clear();
+      QFile::remove(fieldIndex.fileName());
+    }
+  }
+}
+
 /**
  * @brief MainWindow::onUpdate do a git pull
  */
 void MainWindow::onUpdate(bool block) {
+  if (QtPassSettings::isUseWebDav()) {
+    syncWebDav();
+    return;
+  }
   ui->statusBar->showMessage(tr("Updating password-store"), 2000);
   if (block)
     QtPassSettings::getPass()->GitPull_b();
@@ -473,6 +844,19 @@ QString MainWindow::getFile(const QModelIndex &index, bool forPass) {
   return filePath;
 }
 
+/**
+ * @brief MainWindow::selectedPaths the selected files and folders, without
+ * those inside a selected folder
+ * @return absolute paths
+ */
+QStringList MainWindow::selectedPaths() {
+  QStringList paths;
+  foreach (const QModelIndex &index,
+           ui->treeView->selectionModel()->selectedRows())
+    paths << QDir::cleanPath(model.filePath(proxyModel.mapToSource(index)));
+  return Util::topLevelPaths(paths);
+}
+
 /**
  * @brief MainWindow::on_treeView_clicked read the selected password file
  * @param index
@@ -482,11 +866,16 @@ void MainWindow::on_treeView_clicked(const QModelIndex &index) {
   currentDir =
       Util::getDir(ui->treeView->currentIndex(), false, model, proxyModel);
   //    TODO(bezet): "Could not decrypt";
-  clippedText = "";
+  SecureBuffer::wipe(&clippedText);
   QString file = getFile(index, true);
   ui->passwordName->setText(getFile(index, true));
   if (!file.isEmpty() && !cleared) {
-    QtPassSettings::getPass()->Show(file);
+    // a slower decrypt of the previous selection must not overwrite this one
+    if (showRequest)
+      showRequest->cancel();
+    showRequest = QtPassSettings::getPass()->requestShow(file);
+    connect(showRequest, &PassRequest::finished, this,
+            &MainWindow::showRequestFinished);
   } else {
     clearPanel(false);
     ui->actionEdit->setEnabled(false);
@@ -543,24 +932,38 @@ void MainWindow::keyGenerationComplete(const QString &p_output,
     keygen = 0;
     // TODO(annejan) some sanity checking ?
   }
+  secretKeysValid = false;
   processFinished(p_output, p_errout);
 }
 
+/**
+ * @brief MainWindow::showRequestFinished show the entry that was selected
+ * @param request
+ */
+void MainWindow::showRequestFinished(PassRequest *request) {
+  if (request->state() == PassRequest::FINISHED) {
+    QString content = request->secret().toString();
+    passShowHandler(content);
+    SecureBuffer::wipe(&content);
+  } else {
+    processErrorExit(request->exitCode(), request->errorOutput());
+  }
+}
+
 void MainWindow::passShowHandler(const QString &p_output) {
-  QStringList templ = QtPassSettings::isUseTemplate()
-                          ? QtPassSettings::getPassTemplate().split("\n")
-                          : QStringList();
-  bool allFields =
-      QtPassSettings::isUseTemplate() && QtPassSettings::isTemplateAllFields();
+  Tracer::Span span("render", "ui");
+  const SettingsSnapshot &settings = QtPassSettings::getSnapshot();
+  QStringList templ =
+      settings.useTemplate ? settings.passTemplate.split("\n") : QStringList();
+  bool allFields = settings.useTemplate && settings.templateAllFields;
   FileContent fileContent = FileContent::parse(p_output, templ, allFields);
-  QString output = p_output;
+  QString output;
   QString password = fileContent.getPassword();
 
   // handle clipboard
-  if (QtPassSettings::getClipBoardType() != Enums::CLIPBOARD_NEVER &&
-      !p_output.isEmpty()) {
+  if (settings.clipBoardType != Enums::CLIPBOARD_NEVER && !p_output.isEmpty()) {
     clippedText = password;
-    if (QtPassSettings::getClipBoardType() == Enums::CLIPBOARD_ALWAYS)
+    if (settings.clipBoardType == Enums::CLIPBOARD_ALWAYS)
       copyTextToClipboard(password);
   }
 
@@ -568,7 +971,7 @@ void MainWindow::passShowHandler(const QString &p_output) {
   clearTemplateWidgets();
 
   // show what is needed:
-  if (QtPassSettings::isHideContent()) {
+  if (settings.hideContent) {
     output = "***" + tr("Content hidden") + "***";
   } else {
     if (!password.isEmpty()) {
@@ -578,27 +981,28 @@ void MainWindow::passShowHandler(const QString &p_output) {
 
     NamedValues namedValues = fileContent.getNamedValues();
     for (int j = 0; j < namedValues.length(); ++j) {
-      NamedValue nv = namedValues.at(j);
+      const NamedValue &nv = namedValues.at(j);
       addToGridLayout(j + 1, nv.name, nv.value);
     }
-    if (ui->gridLayout->count() == 0)
+    if (templateFieldsUsed == 0)
       ui->verticalLayoutPassword->setSpacing(0);
     else
       ui->verticalLayoutPassword->setSpacing(6);
     output = fileContent.getRemainingData();
   }
 
-  if (QtPassSettings::isUseAutoclearPanel()) {
+  if (settings.useAutoclearPanel) {
     clearPanelTimer.start();
   }
 
   DisplayInTextBrowser(output);
   enableUiElements(true);
+  span.arg("fields", templateFieldsUsed);
 }
 
 void MainWindow::passOtpHandler(const QString &p_output) {
   if (!p_output.isEmpty()) {
-      addToGridLayout(ui->gridLayout->count()+1, tr("OTP Code"), p_output);
+      addToGridLayout(templateFieldsUsed, tr("OTP Code"), p_output);
       copyTextToClipboard(p_output);
   }
   if (QtPassSettings::isUseAutoclearPanel()) {
@@ -610,6 +1014,8 @@ void MainWindow::passOtpHandler(const QString &p_output) {
 void MainWindow::passStoreChanged(const QString &p_out, const QString &p_err) {
   processFinished(p_out, p_err);
   doGitPush();
+  if (QtPassSettings::isUseWebDav())
+    syncWebDav();
 }
 
 void MainWindow::doGitPush() {
@@ -621,6 +1027,8 @@ void MainWindow::finishedInsert(const QString &p_output,
                                 const QString &p_errout) {
   processFinished(p_output, p_errout);
   doGitPush();
+  if (QtPassSettings::isUseWebDav())
+    syncWebDav();
   on_treeView_clicked(ui->treeView->currentIndex());
 }
 
@@ -684,18 +1092,14 @@ void MainWindow::clearClipboard() {
   } else {
     ui->statusBar->showMessage(tr("Clipboard not cleared"), 2000);
   }
-  this->clippedText.clear();
+  SecureBuffer::wipe(&this->clippedText);
 }
 
 /**
  * @brief MainWindow::clearPanel hide the information from shoulder surfers
  */
 void MainWindow::clearPanel(bool notify) {
-  while (ui->gridLayout->count() > 0) {
-    QLayoutItem *item = ui->gridLayout->takeAt(0);
-    delete item->widget();
-    delete item;
-  }
+  clearTemplateWidgets();
   if (notify) {
     QString output = "***" + tr("Password and Content hidden") + "***";
     ui->textBrowser->setHtml(output);
@@ -727,6 +1131,7 @@ void MainWindow::processFinished(const QString &p_output,
  */
 void MainWindow::enableUiElements(bool state) {
   ui->treeView->setEnabled(state);
+  ui->resultView->setEnabled(state);
   ui->lineEdit->setEnabled(state);
   ui->lineEdit->installEventFilter(this);
   ui->actionAddPassword->setEnabled(state);
@@ -793,22 +1198,109 @@ void MainWindow::processError(QProcess::ProcessError error) {
 void MainWindow::onConfig() { config(); }
 
 /**
- * @brief Executes when the string in the search box changes, collapses the
- * TreeView
+ * @brief Executes when the string in the search box changes, lists the
+ * matching entries instead of the tree, or brings the tree back when the
+ * search box is cleared
  * @param arg1
  */
 void MainWindow::on_lineEdit_textChanged(const QString &arg1) {
-  ui->treeView->expandAll();
+  Tracer::Span span("filter", "ui");
+  span.arg("length", arg1.length());
+  if (arg1.trimmed().isEmpty()) {
+    showTree();
+    return;
+  }
   ui->statusBar->showMessage(tr("Looking for: %1").arg(arg1), 1000);
-  QString query = arg1;
-  query.replace(QRegExp(" "), ".*");
-  QRegExp regExp(query, Qt::CaseInsensitive);
-  proxyModel.setFilterRegExp(regExp);
-  ui->treeView->setRootIndex(proxyModel.mapFromSource(
-      model.setRootPath(QtPassSettings::getPassStore())));
+  QStringList matches;
+  // a URL or host name finds the entries of its domain, not its text
+  if (UrlMatcher::looksLikeUrl(arg1)) {
+    updateUrlMatcher();
+    matches = urlMatcher.match(arg1);
+  }
+  if (matches.isEmpty() && QtPassSettings::isUseFieldIndex() &&
+      FieldIndex::isFieldQuery(arg1)) {
+    matches = fieldIndex.search(arg1, storeIndex.entries());
+  } else if (matches.isEmpty()) {
+    if (!searchRankerValid) {
+      searchRanker.setEntries(storeIndex.entries());
+      searchRankerValid = true;
+    }
+    matches = searchRanker.rank(arg1, searchRanker.size());
+  }
+  span.arg("results", matches.size());
+  showSearchResults(matches);
+}
+
+/**
+ * @brief MainWindow::showSearchResults list entries in place of the tree
+ * @param entries   best match first
+ */
+void MainWindow::showSearchResults(const QStringList &entries) {
+  if (!ui->treeView->isHidden()) {
+    treeCurrent = ui->treeView->currentIndex();
+    ui->treeView->hide();
+    ui->resultView->show();
+  }
+  searchResults.setStringList(entries);
   selectFirstFile();
 }
 
+/**
+ * @brief MainWindow::showTree leave the result list, the tree comes back
+ * with its folders expanded as before and its current item from before the
+ * search
+ */
+void MainWindow::showTree() {
+  if (ui->treeView->isHidden()) {
+    ui->resultView->hide();
+    searchResults.setStringList(QStringList());
+    ui->treeView->setCurrentIndex(treeCurrent);
+    ui->treeView->show();
+  }
+}
+
+/**
+ * @brief MainWindow::treeIndex
+ * @param entry relative entry path without .gpg suffix
+ * @return index of the entry in the tree
+ */
+QModelIndex MainWindow::treeIndex(const QString &entry) {
+  return proxyModel.mapFromSource(model.index(
+      QDir(QtPassSettings::getPassStore()).filePath(entry + ".gpg")));
+}
+
+/**
+ * @brief MainWindow::resultChanged make the entry current in the hidden
+ * tree too, so the actions on the current item work on it
+ * @param current
+ */
+void MainWindow::resultChanged(const QModelIndex &current) {
+  if (current.isValid())
+    ui->treeView->setCurrentIndex(treeIndex(current.data().toString()));
+  else
+    ui->treeView->setCurrentIndex(QModelIndex());
+}
+
+/**
+ * @brief MainWindow::on_resultView_clicked show the entry, like a click in
+ * the tree does
+ * @param index
+ */
+void MainWindow::on_resultView_clicked(const QModelIndex &index) {
+  Q_UNUSED(index)
+  on_treeView_clicked(ui->treeView->currentIndex());
+}
+
+/**
+ * @brief MainWindow::on_resultView_doubleClicked edit the entry, like a
+ * double click in the tree does
+ * @param index
+ */
+void MainWindow::on_resultView_doubleClicked(const QModelIndex &index) {
+  Q_UNUSED(index)
+  on_treeView_doubleClicked(ui->treeView->currentIndex());
+}
+
 /**
  * @brief MainWindow::on_lineEdit_returnPressed get searching
  *
@@ -821,10 +1313,14 @@ void MainWindow::on_lineEdit_returnPressed() {
 }
 
 /**
- * @brief MainWindow::selectFirstFile select the first possible file in the
- * tree
+ * @brief MainWindow::selectFirstFile select the best match while searching,
+ * the first possible file in the tree otherwise
  */
 void MainWindow::selectFirstFile() {
+  if (ui->treeView->isHidden()) {
+    ui->resultView->setCurrentIndex(searchResults.index(0));
+    return;
+  }
   QModelIndex index = proxyModel.mapFromSource(
       model.setRootPath(QtPassSettings::getPassStore()));
   index = firstFile(index);
@@ -856,10 +1352,9 @@ QModelIndex MainWindow::firstFile(QModelIndex parentIndex) {
  */
 void MainWindow::setPassword(QString file, bool isNew) {
   PasswordDialog d(file, isNew, this);
-  connect(QtPassSettings::getPass(), &Pass::finishedShow, &d,
-          &PasswordDialog::setPass);
 
   if (!d.exec()) {
+    enableUiElements(true);
     this->ui->treeView->setFocus();
   }
 }
@@ -890,6 +1385,24 @@ void MainWindow::addPassword() {
  * sure.
  */
 void MainWindow::onDelete() {
+  QStringList paths = selectedPaths();
+  if (paths.size() > 1) {
+    QDir store(QtPassSettings::getPassStore());
+    QStringList names;
+    foreach (const QString &path, paths.mid(0, 10))
+      names << store.relativeFilePath(path).replace(QRegExp("\\.gpg$"), "");
+    if (paths.size() > names.size())
+      names << tr("and %1 more").arg(paths.size() - names.size());
+    if (QMessageBox::question(
+            this, tr("Delete %1 items?").arg(paths.size()),
+            tr("Are you sure you want to delete these items and the whole "
+               "content of the folders among them?<br>%1")
+                .arg(names.join("<br>")),
+            QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes)
+      QtPassSettings::getPass()->RemoveItems(paths);
+    return;
+  }
+
   QFileInfo fileOrFolder =
       model.fileInfo(proxyModel.mapToSource(ui->treeView->currentIndex()));
   QString file = "";
@@ -902,35 +1415,57 @@ void MainWindow::onDelete() {
     isDir = true;
   }
 
-  QString dirMessage = tr(" and the whole content?");
+  QMessageBox box(QMessageBox::Question,
+                  isDir ? tr("Delete folder?") : tr("Delete password?"),
+                  tr("Are you sure you want to delete %1%2")
+                      .arg(QDir::separator() + file)
+                      .arg(isDir ? tr(" and the whole content?") : "?"),
+                  QMessageBox::Yes | QMessageBox::No, this);
+  // the folder is scanned while the question is already shown, a large
+  // folder on a network share would otherwise keep the window frozen
+  FolderScan scan(model.rootPath() + "/" + file);
   if (isDir) {
-    QDirIterator it(model.rootPath() + "/" + file,
-                    QDirIterator::Subdirectories);
-    bool okDir = true;
-    while (it.hasNext() && okDir) {
-      it.next();
-      if (QFileInfo(it.filePath()).isFile()) {
-        if (QFileInfo(it.filePath()).suffix() != "gpg") {
-          okDir = false;
-          dirMessage = tr(" and the whole content? <br><strong>Attention: "
-                          "there are unexpected files in the given folder, "
-                          "check them before continue.</strong>");
-        }
-      }
-    }
+    box.setInformativeText(folderScanText(0, QStringList(), false));
+    connect(&scan, &FolderScan::progress, &box,
+            [&box](int passwords, const QStringList &others) {
+              box.setInformativeText(
+                  folderScanText(passwords, others, false));
+            });
+    connect(&scan, &FolderScan::finished, &box,
+            [&box](int passwords, const QStringList &others) {
+              box.setInformativeText(folderScanText(passwords, others, true));
+            });
+    scan.start(&storeIndex);
   }
-
-  if (QMessageBox::question(
-          this, isDir ? tr("Delete folder?") : tr("Delete password?"),
-          tr("Are you sure you want to delete %1%2")
-              .arg(QDir::separator() + file)
-              .arg(isDir ? dirMessage : "?"),
-          QMessageBox::Yes | QMessageBox::No) != QMessageBox::Yes)
+  if (box.exec() != QMessageBox::Yes)
     return;
 
   QtPassSettings::getPass()->Remove(file, isDir);
 }
 
+/**
+ * @brief MainWindow::folderScanText what the delete question says about the
+ * content of a folder
+ * @param passwords passwords found so far
+ * @param others    files found that are not passwords
+ * @param done      whether the whole folder was scanned
+ * @return rich text
+ */
+QString MainWindow::folderScanText(int passwords, const QStringList &others,
+                                   bool done) {
+  QString text = done ? tr("%n password(s) will be deleted.", "", passwords)
+                      : tr("Counting passwords... %n so far.", "", passwords);
+  if (others.isEmpty())
+    return text;
+  QStringList names = others.mid(0, 5);
+  if (others.size() > names.size())
+    names << tr("and %1 more").arg(others.size() - names.size());
+  return text + tr("<br><strong>Attention: there are unexpected files in "
+                   "the given folder, check them before continue.</strong>"
+                   "<br>%1")
+                    .arg(names.join("<br>"));
+}
+
 /**
  * @brief MainWindow::onOTP try and generate (selected) OTP code.
  */
@@ -983,6 +1518,14 @@ void MainWindow::onUsers() {
       currentDir.isEmpty()
           ? Util::getDir(ui->treeView->currentIndex(), false, model, proxyModel)
           : currentDir;
+  // several selected folders all get the recipients of the current one
+  QStringList dirs;
+  foreach (const QString &path, selectedPaths()) {
+    if (QFileInfo(path).isDir())
+      dirs << path + "/";
+  }
+  if (dirs.size() < 2)
+    dirs = QStringList{dir};
   int count = 0;
   QString recipients = QtPassSettings::getPass()->getRecipientString(
       dir.isEmpty() ? "" : dir, " ", &count);
@@ -1015,7 +1558,10 @@ void MainWindow::onUsers() {
   }
   d.setUsers(NULL);
 
-  QtPassSettings::getPass()->Init(dir, users);
+  if (dirs.size() > 1)
+    QtPassSettings::getPass()->InitFolders(dirs, users);
+  else
+    QtPassSettings::getPass()->Init(dir, users);
 }
 
 /**
@@ -1026,7 +1572,6 @@ void MainWindow::messageAvailable(QString message) {
   if (message.isEmpty()) {
     focusInput();
   } else {
-    ui->treeView->expandAll();
     ui->lineEdit->setText(message);
     on_lineEdit_returnPressed();
   }
@@ -1101,6 +1646,7 @@ void MainWindow::on_profileBox_currentIndexChanged(QString name) {
   ui->statusBar->showMessage(tr("Profile changed to %1").arg(name), 2000);
 
   QtPassSettings::getPass()->updateEnv();
+  updateStoreRoot();
 
   ui->treeView->setRootIndex(proxyModel.mapFromSource(
       model.setRootPath(QtPassSettings::getPassStore())));
@@ -1162,10 +1708,20 @@ void MainWindow::closeEvent(QCloseEvent *event) {
  * @return
  */
 bool MainWindow::eventFilter(QObject *obj, QEvent *event) {
+  if ((obj == ui->treeView->viewport() || obj == ui->resultView->viewport()) &&
+      event->type() == QEvent::Paint) {
+    ui->treeView->viewport()->removeEventFilter(this);
+    ui->resultView->viewport()->removeEventFilter(this);
+    StartupProfile::interactive();
+    QTimer::singleShot(0, this, SLOT(deferredInit()));
+  }
   if (obj == ui->lineEdit && event->type() == QEvent::KeyPress) {
     QKeyEvent *key = static_cast<QKeyEvent *>(event);
     if (key->key() == Qt::Key_Down) {
-      ui->treeView->setFocus();
+      if (ui->treeView->isHidden())
+        ui->resultView->setFocus();
+      else
+        ui->treeView->setFocus();
     }
   }
   return QObject::eventFilter(obj, event);
@@ -1208,7 +1764,13 @@ void MainWindow::showContextMenu(const QPoint &pos) {
     selected = false;
   }
 
-  ui->treeView->setCurrentIndex(index);
+  // keep a multi-selection the menu was opened on
+  if (selected && ui->treeView->selectionModel()->isSelected(index))
+    ui->treeView->selectionModel()->setCurrentIndex(
+        index, QItemSelectionModel::NoUpdate);
+  else
+    ui->treeView->setCurrentIndex(index);
+  int count = selectedPaths().size();
 
   QPoint globalPos = ui->treeView->viewport()->mapToGlobal(pos);
 
@@ -1216,16 +1778,23 @@ void MainWindow::showContextMenu(const QPoint &pos) {
       model.fileInfo(proxyModel.mapToSource(ui->treeView->currentIndex()));
 
   QMenu contextMenu;
-  if (!selected || fileOrFolder.isDir()) {
+  if (count > 1) {
+    QAction *users = contextMenu.addAction(tr("Users"));
+    connect(users, SIGNAL(triggered()), this, SLOT(onUsers()));
+  } else if (!selected || fileOrFolder.isDir()) {
     QAction *openFolder =
         contextMenu.addAction(tr("Open folder with file manager"));
     QAction *addFolder = contextMenu.addAction(tr("Add folder"));
     QAction *addPassword = contextMenu.addAction(tr("Add password"));
     QAction *users = contextMenu.addAction(tr("Users"));
+    QAction *importEntries = contextMenu.addAction(tr("Import..."));
+    QAction *exportEntries = contextMenu.addAction(tr("Export..."));
     connect(openFolder, SIGNAL(triggered()), this, SLOT(openFolder()));
     connect(addFolder, SIGNAL(triggered()), this, SLOT(addFolder()));
     connect(addPassword, SIGNAL(triggered()), this, SLOT(addPassword()));
     connect(users, SIGNAL(triggered()), this, SLOT(onUsers()));
+    connect(importEntries, SIGNAL(triggered()), this, SLOT(importEntries()));
+    connect(exportEntries, SIGNAL(triggered()), this, SLOT(exportEntries()));
   } else if (fileOrFolder.isFile()) {
     QAction *edit = contextMenu.addAction(tr("Edit"));
     connect(edit, SIGNAL(triggered()), this, SLOT(onEdit()));
@@ -1239,7 +1808,8 @@ void MainWindow::showContextMenu(const QPoint &pos) {
     // SLOT(copyPasswordToClipboard()));
     // }
     contextMenu.addSeparator();
-    QAction *deleteItem = contextMenu.addAction(tr("Delete"));
+    QAction *deleteItem = contextMenu.addAction(
+        count > 1 ? tr("Delete %1 items").arg(count) : tr("Delete"));
     connect(deleteItem, SIGNAL(triggered()), this, SLOT(onDelete()));
   }
   contextMenu.exec(globalPos);
@@ -1253,8 +1823,51 @@ void MainWindow::showContextMenu(const QPoint &pos) {
 void MainWindow::showBrowserContextMenu(const QPoint &pos) {
   QMenu *contextMenu = ui->textBrowser->createStandardContextMenu(pos);
   QPoint globalPos = ui->textBrowser->viewport()->mapToGlobal(pos);
+  contextMenu->addSeparator();
+  QAction *trace = contextMenu->addAction(
+      Tracer::isEnabled() ? tr("Save trace...") : tr("Start tracing"));
+  connect(trace, &QAction::triggered, this, &MainWindow::saveTrace);
 
   contextMenu->exec(globalPos);
+  delete contextMenu;
+}
+
+/**
+ * @brief MainWindow::saveTrace start recording spans, or save the spans
+ * recorded so far as Chrome trace JSON
+ */
+void MainWindow::saveTrace() {
+  if (!Tracer::isEnabled()) {
+    Tracer::setEnabled(true);
+    ui->statusBar->showMessage(tr("Tracing started"), 2000);
+    return;
+  }
+  QString fileName = QFileDialog::getSaveFileName(
+      this, tr("Save trace"), QDir::homePath() + "/qtpass-trace.json",
+      tr("Chrome trace (*.json)"));
+  if (fileName.isEmpty())
+    return;
+  if (Tracer::write(fileName))
+    ui->statusBar->showMessage(
+        tr("Saved %1 spans to %2").arg(Tracer::count()).arg(fileName), 2000);
+  else
+    QMessageBox::critical(this, tr("Save trace"),
+                          tr("Could not write %1").arg(fileName));
+}
+
+/**
+ * @brief MainWindow::modelDirectoryLoaded trace how long listing the store
+ * root took
+ * @param path
+ */
+void MainWindow::modelDirectoryLoaded(const QString &path) {
+  if (modelLoadStarted < 0 || QDir(path) != QDir(model.rootPath()))
+    return;
+  QVariantMap args;
+  args["entries"] = model.rowCount(model.index(model.rootPath()));
+  Tracer::complete("model load", "ui", modelLoadStarted,
+                   Tracer::now() - modelLoadStarted, args);
+  modelLoadStarted = -1;
 }
 
 /**
@@ -1303,14 +1916,19 @@ void MainWindow::editPassword(const QString &file) {
 
 /**
  * @brief MainWindow::clearTemplateWidgets empty the template widget fields in
- * the UI
+ * the UI, the widgets are hidden and kept for reuse by addToGridLayout
  */
 void MainWindow::clearTemplateWidgets() {
-  while (ui->gridLayout->count() > 0) {
-    QLayoutItem *item = ui->gridLayout->takeAt(0);
-    delete item->widget();
-    delete item;
+  for (int i = 0; i < templateFieldsUsed; ++i) {
+    const templateFieldRow &row = templateFieldRows.at(i);
+    row.name->hide();
+    row.frame->hide();
+    row.name->clear();
+    row.copyButton->setTextToCopy(QString());
+    row.hiddenValue->clear();
+    row.value->clear();
   }
+  templateFieldsUsed = 0;
   ui->verticalLayoutPassword->setSpacing(0);
 }
 
@@ -1337,16 +1955,95 @@ void MainWindow::copyPasswordFromTreeview() {
       model.fileInfo(proxyModel.mapToSource(ui->treeView->currentIndex()));
 
   if (fileOrFolder.isFile()) {
-    QString file = getFile(ui->treeView->currentIndex(), true);
-    connect(QtPassSettings::getPass(), &Pass::finishedShow, this,
-            &MainWindow::passwordFromFileToClipboard);
-    QtPassSettings::getPass()->Show(file);
+    copyPasswordOfEntry(getFile(ui->treeView->currentIndex(), true));
+  }
+}
+
+/**
+ * @brief MainWindow::copyPasswordOfEntry decrypt an entry and copy its
+ * password
+ * @param entry relative entry path without .gpg suffix
+ */
+void MainWindow::copyPasswordOfEntry(const QString &entry) {
+  PassRequest *request = QtPassSettings::getPass()->requestShow(entry);
+  connect(request, &PassRequest::finished, this,
+          &MainWindow::passwordFromFileToClipboard);
+}
+
+/**
+ * @brief MainWindow::showQuickOpen pop up the quick open box, from the
+ * shortcut or the tray icon, it searches the indexes and leaves the tree
+ * alone
+ */
+void MainWindow::showQuickOpen() {
+  if (quickOpen == NULL) {
+    quickOpen = new QuickOpen(&storeIndex, &fieldIndex, &urlMatcher, this);
+    connect(quickOpen, &QuickOpen::activated, this,
+            &MainWindow::copyPasswordOfEntry);
   }
+  updateUrlMatcher();
+  quickOpen->popup();
+}
+
+void MainWindow::passwordFromFileToClipboard(PassRequest *request) {
+  if (request->state() != PassRequest::FINISHED) {
+    processErrorExit(request->exitCode(), request->errorOutput());
+    return;
+  }
+  const SecureBuffer &content = request->secret();
+  QString password = content.toString(content.indexOf('\n'));
+  copyTextToClipboard(password);
+  SecureBuffer::wipe(&password);
+  enableUiElements(true);
 }
 
-void MainWindow::passwordFromFileToClipboard(const QString &text) {
-  QStringList tokens = text.split('\n');
-  copyTextToClipboard(tokens[0]);
+/**
+ * @brief MainWindow::createTemplateFieldRow create the widgets for one row of
+ * the template grid, they are reused for every entry shown afterwards
+ * @param position
+ * @return the new row
+ */
+MainWindow::templateFieldRow MainWindow::createTemplateFieldRow(int position) {
+  templateFieldRow row;
+  row.name = new QLabel(this);
+
+  // Combine the Copy button and the value in one widget
+  row.frame = new QFrame(this);
+  QLayout *ly = new QHBoxLayout(row.frame);
+  ly->setContentsMargins(5, 2, 2, 2);
+
+  row.copyButton = new QPushButtonWithClipboard(QString(), row.frame);
+  connect(row.copyButton, SIGNAL(clicked(QString)), this,
+          SLOT(copyTextToClipboard(QString)));
+  row.copyButton->setStyleSheet(
+      "border-style: none ; background: transparent;");
+  ly->addWidget(row.copyButton);
+
+  row.hiddenValue = new QLineEdit(row.frame);
+  row.hiddenValue->setReadOnly(true);
+  row.hiddenValue->setStyleSheet(
+      "border-style: none ; background: transparent;");
+  row.hiddenValue->setContentsMargins(0, 0, 0, 0);
+  row.hiddenValue->setEchoMode(QLineEdit::Password);
+  ly->addWidget(row.hiddenValue);
+
+  // a rich text label paints a lot cheaper than a QTextBrowser per field
+  row.value = new QLabel(row.frame);
+  row.value->setTextFormat(Qt::RichText);
+  row.value->setTextInteractionFlags(Qt::TextBrowserInteraction);
+  row.value->setOpenExternalLinks(true);
+  row.value->setMinimumHeight(22);
+  row.value->setSizePolicy(
+      QSizePolicy(QSizePolicy::Expanding, QSizePolicy::Minimum));
+  row.value->setContentsMargins(0, 0, 0, 0);
+  ly->addWidget(row.value);
+
+  row.frame->setStyleSheet(
+      ".QFrame{border: 1px solid lightgrey; border-radius: 5px;}");
+
+  ui->gridLayout->addWidget(row.name, position, 0);
+  ui->gridLayout->addWidget(row.frame, position, 1);
+  return row;
 }
 
 /**
@@ -1357,60 +2054,45 @@ void MainWindow::passwordFromFileToClipboard(const QString &text) {
  */
 void MainWindow::addToGridLayout(int position, const QString &field,
                                  const QString &value) {
+  static const QRegExp urlPattern(
+      "((?:https?|ftp|ssh|sftp|ftps|webdav|webdavs)://\\S+)");
   QString trimmedField = field.trimmed();
   QString trimmedValue = value.trimmed();
 
-  // Combine the Copy button and the line edit in one widget
-  QFrame *frame = new QFrame();
-  QLayout *ly = new QHBoxLayout();
-  ly->setContentsMargins(5, 2, 2, 2);
-  frame->setLayout(ly);
-  if (QtPassSettings::getClipBoardType() != Enums::CLIPBOARD_NEVER) {
-    QPushButtonWithClipboard *fieldLabel =
-        new QPushButtonWithClipboard(trimmedValue, this);
-    connect(fieldLabel, SIGNAL(clicked(QString)), this,
-            SLOT(copyTextToClipboard(QString)));
+  const SettingsSnapshot &settings = QtPassSettings::getSnapshot();
 
-    fieldLabel->setStyleSheet("border-style: none ; background: transparent;");
-    // fieldLabel->setContentsMargins(0,5,5,0);
-    frame->layout()->addWidget(fieldLabel);
-  }
+  while (templateFieldRows.size() <= position)
+    templateFieldRows.append(createTemplateFieldRow(templateFieldRows.size()));
+  const templateFieldRow &row = templateFieldRows.at(position);
+
+  row.name->setText(trimmedField);
+  row.copyButton->setTextToCopy(trimmedValue);
+  row.copyButton->setVisible(settings.clipBoardType != Enums::CLIPBOARD_NEVER);
 
   // set the echo mode to password, if the field is "password"
-  if (QtPassSettings::isHidePassword() && trimmedField == tr("Password")) {
-    QLineEdit *line = new QLineEdit();
-    line->setObjectName(trimmedField);
-    line->setText(trimmedValue);
-    line->setReadOnly(true);
-    line->setStyleSheet("border-style: none ; background: transparent;");
-    line->setContentsMargins(0, 0, 0, 0);
-    line->setEchoMode(QLineEdit::Password);
-    frame->layout()->addWidget(line);
+  bool hidden = settings.hidePassword && trimmedField == tr("Password");
+  if (hidden) {
+    row.hiddenValue->setObjectName(trimmedField);
+    row.hiddenValue->setText(trimmedValue);
+    row.value->clear();
   } else {
-    QTextBrowser *line = new QTextBrowser();
-    line->setOpenExternalLinks(true);
-    line->setOpenLinks(true);
-    line->setMaximumHeight(26);
-    line->setMinimumHeight(26);
-    line->setSizePolicy(
-        QSizePolicy(QSizePolicy::Expanding, QSizePolicy::Minimum));
-    line->setObjectName(trimmedField);
-    trimmedValue.replace(
-        QRegExp("((?:https?|ftp|ssh|sftp|ftps|webdav|webdavs)://\\S+)"),
-        "<a href=\"\\1\">\\1</a>");
-    line->setText(trimmedValue);
-    line->setReadOnly(true);
-    line->setStyleSheet("border-style: none ; background: transparent;");
-    line->setContentsMargins(0, 0, 0, 0);
-    frame->layout()->addWidget(line);
+    row.value->setObjectName(trimmedField);
+    QString html = trimmedValue.toHtmlEscaped();
+    if (html.contains("://"))
+      html.replace(urlPattern, "<a href=\"\\1\">\\1</a>");
+    row.value->setText(html);
+    row.hiddenValue->clear();
   }
-
-  frame->setStyleSheet(
-      ".QFrame{border: 1px solid lightgrey; border-radius: 5px;}");
-
-  // set into the layout
-  ui->gridLayout->addWidget(new QLabel(trimmedField), position, 0);
-  ui->gridLayout->addWidget(frame, position, 1);
+  row.hiddenValue->setVisible(hidden);
+  row.value->setVisible(!hidden);
+
+  row.name->show();
+  row.frame->show();
+  for (int i = templateFieldsUsed; i < position; ++i) {
+    templateFieldRows.at(i).name->hide();
+    templateFieldRows.at(i).frame->hide();
+  }
+  templateFieldsUsed = qMax(templateFieldsUsed, position + 1);
 }
 
 /**
@@ -1429,6 +2111,7 @@ void MainWindow::showStatusMessage(QString msg, int timeout) {
 void MainWindow::startReencryptPath() {
   enableUiElements(false);
   ui->treeView->setDisabled(true);
+  ui->resultView->setDisabled(true);
 }
 
 /**
@@ -1453,6 +2136,9 @@ void MainWindow::updateGitButtonVisibility() {
   } else {
     enableGitButtons(true);
   }
+  // update syncs with WebDAV
+  if (QtPassSettings::isUseWebDav())
+    ui->actionUpdate->setEnabled(true);
 }
 
 void MainWindow::updateOtpButtonVisibility() {
@@ -1,12 +1,21 @@
 #ifndef MAINWINDOW_H_
 #define MAINWINDOW_H_
 
+#include "entryranker.h"
+#include "fieldindex.h"
+#include "imitatepass.h"
+#include "realpass.h"
+#include "storeindex.h"
 #include "storemodel.h"
+#include "urlmatcher.h"
+#include "webdavsync.h"
 
 #include <QFileSystemModel>
 #include <QItemSelectionModel>
 #include <QMainWindow>
+#include <QPointer>
 #include <QProcess>
+#include <QStringListModel>
 #include <QTimer>
 
 #if SINGLE_APP
@@ -34,6 +43,14 @@ class MainWindow;
     This class could really do with an overhaul.
  */
 class Pass;
+class PassRequest;
+class QFrame;
+class QLabel;
+class QProgressBar;
+class QToolButton;
+class QLineEdit;
+class QPushButtonWithClipboard;
+class QuickOpen;
 class TrayIcon;
 class MainWindow : public QMainWindow {
   Q_OBJECT
@@ -57,8 +74,10 @@ protected:
 
 public slots:
   void deselect();
+  void showQuickOpen();
 
 private slots:
+  void deferredInit();
   void addPassword();
   void addFolder();
   void onEdit();
@@ -76,38 +95,111 @@ private slots:
   void clearPanel(bool notify = true);
   void on_lineEdit_textChanged(const QString &arg1);
   void on_lineEdit_returnPressed();
+  void on_resultView_clicked(const QModelIndex &index);
+  void on_resultView_doubleClicked(const QModelIndex &index);
+  void resultChanged(const QModelIndex &current);
   void messageAvailable(QString message);
   void on_profileBox_currentIndexChanged(QString);
   void showContextMenu(const QPoint &pos);
   void showBrowserContextMenu(const QPoint &pos);
+  void saveTrace();
+  void modelDirectoryLoaded(const QString &path);
   void openFolder();
   void editPassword(const QString &);
   void focusInput();
   void copyTextToClipboard(const QString &text);
   void copyPasswordFromTreeview();
-  void passwordFromFileToClipboard(const QString &text);
+  void passwordFromFileToClipboard(PassRequest *request);
+  void copyPasswordOfEntry(const QString &entry);
 
   void executeWrapperStarted();
   void showStatusMessage(QString msg, int timeout);
   void startReencryptPath();
   void endReencryptPath();
   void critical(QString, QString);
+  void showRequestFinished(PassRequest *request);
   void passShowHandler(const QString &);
   void passOtpHandler(const QString &);
   void passStoreChanged(const QString &, const QString &);
   void doGitPush();
 
   void processErrorExit(int exitCode, const QString &);
+  void settingChanged(const QString &key);
+  void webDavSynced(bool ok, const QString &error);
+  void dropStarted(PassRequest *request, Qt::DropAction action, int count);
+  void dropProgressed(int done, int total);
+  void dropFinished(PassRequest *request);
+  void cancelDrop();
+  void importEntries();
+  void importFinished(PassRequest *request);
+  void exportEntries();
+  void exportFinished(PassRequest *request);
+  void updateFieldIndex();
+  void fieldIndexFinished(PassRequest *request);
 
   void finishedInsert(const QString &, const QString &);
   void keyGenerationComplete(const QString &p_output, const QString &p_errout);
 
 private:
+  /*!
+      \struct templateFieldRow
+      \brief Widgets showing one field of the password panel, kept around and
+      reused for the next entry instead of being rebuilt on every selection.
+   */
+  struct templateFieldRow {
+    QLabel *name;
+    QFrame *frame;
+    QPushButtonWithClipboard *copyButton;
+    QLineEdit *hiddenValue;
+    QLabel *value;
+  };
+
   QScopedPointer<Ui::MainWindow> ui;
   QFileSystemModel model;
   StoreModel proxyModel;
   QScopedPointer<QItemSelectionModel> selectionModel;
-  QProcess fusedav;
+  StoreIndex storeIndex;
+  FieldIndex fieldIndex;
+  QPointer<PassRequest> fieldIndexRequest;
+  /**
+   * @brief fieldIndexTimer gathers changes in the store into one update of
+   * the field index
+   */
+  QTimer fieldIndexTimer;
+  /**
+   * @brief secretKeys  keys the field index can be encrypted for, listed
+   * once instead of on every update
+   */
+  QList<UserInfo> secretKeys;
+  bool secretKeysValid;
+  /**
+   * @brief backgroundRealPass backends for indexing, import and export, with
+   * executors of their own so those do not hold up showing and copying
+   * entries on the shared one
+   */
+  RealPass backgroundRealPass;
+  ImitatePass backgroundImitatePass;
+  UrlMatcher urlMatcher;
+  bool urlMatcherValid;
+  /**
+   * @brief searchResults entries matching the search box, best first, shown
+   * in the result view instead of the tree while searching
+   */
+  QStringListModel searchResults;
+  EntryRanker searchRanker;
+  bool searchRankerValid;
+  /**
+   * @brief treeCurrent current item of the tree when the search started,
+   * it is current again when the search box is cleared
+   */
+  QPersistentModelIndex treeCurrent;
+  /**
+   * @brief searchTimer gathers changes in the store into one new search
+   */
+  QTimer searchTimer;
+  QuickOpen *quickOpen;
+  WebDavSync webDav;
+  QString webDavPassword;
   QString clippedText;
   QTimer clearPanelTimer;
   QTimer clearClipboardTimer;
@@ -116,24 +208,48 @@ private:
   QString currentDir;
   bool startupPhase;
   TrayIcon *tray;
+  QList<templateFieldRow> templateFieldRows;
+  int templateFieldsUsed;
+  QPointer<PassRequest> showRequest;
+  /**
+   * @brief dropRequest the drop, import or export whose progress the
+   * status bar shows
+   */
+  QPointer<PassRequest> dropRequest;
+  QProgressBar *dropProgress;
+  QToolButton *dropCancel;
+  qint64 modelLoadStarted;
 
   void initToolBarButtons();
   void initStatusBar();
+  void initStoreModel();
+  void updateStoreRoot();
 
   void updateText();
   void enableUiElements(bool state);
   void restoreWindow();
   void selectFirstFile();
+  void showSearchResults(const QStringList &entries);
+  void showTree();
+  QModelIndex treeIndex(const QString &entry);
   QModelIndex firstFile(QModelIndex parentIndex);
   QString getFile(const QModelIndex &, bool);
+  QStringList selectedPaths();
   void setPassword(QString, bool isNew = true);
 
-  void mountWebDav();
+  void syncWebDav();
+  QStringList fieldIndexKeys();
+  Pass *backgroundPass();
+  void updateUrlMatcher();
+  void showRequestProgress(PassRequest *request);
+  static QString folderScanText(int passwords, const QStringList &others,
+                                bool done);
   void updateProfileBox();
   void initTrayIcon();
   void destroyTrayIcon();
   void clearTemplateWidgets();
   void reencryptPath(QString dir);
+  templateFieldRow createTemplateFieldRow(int position);
   void addToGridLayout(int position, const QString &field,
                        const QString &value);
   void DisplayInTextBrowser(QString toShow, QString prefix = QString(),
@@ -1,27 +1,68 @@
 #include "pass.h"
 #include "debughelper.h"
+#include "fieldindex.h"
+#include "importreader.h"
 #include "qtpasssettings.h"
+#include "tarwriter.h"
 #include "util.h"
 
+#include <QDirIterator>
+#include <QSaveFile>
+#include <QSet>
+#include <QTimer>
+
 using namespace std;
 using namespace Enums;
 
 /**
  * @brief Pass::Pass wrapper for using either pass or the pass imitation
  */
-Pass::Pass() : wrapperRunning(false), env(QProcess::systemEnvironment()) {
+Pass::Pass()
+    : wrapperRunning(false), env(QProcess::systemEnvironment()),
+      m_lastRequestTag(0), m_startingRequest(0), m_startedProcesses(0) {
   connect(&exec,
-          static_cast<void (Executor::*)(int, int, const QString &,
-                                         const QString &)>(&Executor::finished),
-          this, &Pass::finished);
+          static_cast<void (Executor::*)(int, int, const QByteArray &,
+                                         const QByteArray &, quint64)>(
+              &Executor::finished),
+          this, &Pass::executorFinished);
+  connect(&exec, &Executor::progress, this, &Pass::executorProgress);
+  connect(this, &Pass::critical, this, &Pass::noteCritical);
 
   // TODO(bezet): stop using process
   // connect(&process, SIGNAL(error(QProcess::ProcessError)), this,
   //        SIGNAL(error(QProcess::ProcessError)));
 
   connect(&exec, &Executor::starting, this, &Pass::startingExecuteWrapper);
+
+  // gpg may be waiting for a pinentry and git for credentials, give people
+  // time to answer those but do not let a hidden prompt hold up everything
+  exec.setDefaultTimeout(2 * 60 * 1000);
+  exec.setTimeout(GIT_PULL, 5 * 60 * 1000);
+  exec.setTimeout(GIT_PUSH, 5 * 60 * 1000);
+  exec.setTimeout(PASS_SHOW, 5 * 60 * 1000);
+  exec.setTimeout(PASS_OTP_GENERATE, 5 * 60 * 1000);
+  exec.setTimeout(PASS_INSERT, 5 * 60 * 1000);
+  exec.setTimeout(PASS_INIT, 5 * 60 * 1000);
+  exec.setTimeout(PASS_MOVE, 5 * 60 * 1000);
+  exec.setTimeout(PASS_COPY, 5 * 60 * 1000);
+  exec.setTimeout(PASS_IMPORT, 5 * 60 * 1000);
+  exec.setTimeout(PASS_EXPORT, 5 * 60 * 1000);
+  exec.setTimeout(PASS_INDEX, 5 * 60 * 1000);
+  // key generation waits for entropy
+  exec.setTimeout(GPG_GENKEYS, 30 * 60 * 1000);
+  exec.setBlockingTimeout(5 * 60 * 1000);
+  connect(&exec, &Executor::timedOut, this, [this]() {
+    emit statusMsg(tr("A command did not finish in time and was stopped"),
+                   5000);
+  });
 }
 
+/**
+ * @brief Pass::timeoutCount
+ * @return how many commands were stopped for missing their deadline
+ */
+int Pass::timeoutCount() const { return exec.timeoutCount(); }
+
 void Pass::executeWrapper(PROCESS id, const QString &app,
                           const QStringList &args, bool readStdout,
                           bool readStderr) {
@@ -32,8 +73,295 @@ void Pass::executeWrapper(PROCESS id, const QString &app,
                           const QStringList &args, QString input,
                           bool readStdout, bool readStderr) {
   dbg() << app << args;
-  exec.execute(id, QtPassSettings::getPassStore(), app, args, input, readStdout,
-               readStderr);
+  if (m_startingRequest != 0 && !app.isEmpty())
+    ++m_startedProcesses;
+  exec.execute(id, QtPassSettings::getSnapshot().passStore, app, args,
+               input.toUtf8(), readStdout, readStderr, m_startingRequest);
+  SecureBuffer::wipe(&input);
+}
+
+/**
+ * @brief Pass::executeTransaction queue several steps that are reported as
+ * one operation
+ * @param id    reported to finished()
+ * @param transaction   taken over
+ */
+void Pass::executeTransaction(PROCESS id, Transaction *transaction) {
+  // tracked files are restored from git instead of being read up front
+  if (QtPassSettings::isUseGit() &&
+      !QtPassSettings::getGitExecutable().isEmpty())
+    transaction->setGit(QtPassSettings::getGitExecutable());
+  if (m_startingRequest != 0)
+    ++m_startedProcesses;
+  exec.execute(id, QtPassSettings::getSnapshot().passStore, transaction,
+               m_startingRequest);
+}
+
+/**
+ * @brief Pass::requestShow Show, with its own result
+ * @param file
+ * @return handle, output() is the decrypted content
+ */
+PassRequest *Pass::requestShow(const QString &file) {
+  PassRequest *request = beginRequest(PASS_SHOW);
+  Show(file);
+  return endRequest(request);
+}
+
+/**
+ * @brief Pass::requestOtpGenerate OtpGenerate, with its own result
+ * @param file
+ * @return handle, output() is the code
+ */
+PassRequest *Pass::requestOtpGenerate(const QString &file) {
+  PassRequest *request = beginRequest(PASS_OTP_GENERATE);
+  OtpGenerate(file);
+  return endRequest(request);
+}
+
+/**
+ * @brief Pass::requestInsert Insert, with its own result
+ * @param file
+ * @param value
+ * @param force
+ * @return handle
+ */
+PassRequest *Pass::requestInsert(const QString &file, const QString &value,
+                                 bool force) {
+  PassRequest *request = beginRequest(PASS_INSERT);
+  Insert(file, value, force);
+  return endRequest(request);
+}
+
+/**
+ * @brief Pass::requestRemove Remove, with its own result
+ * @param file
+ * @param isDir
+ * @return handle
+ */
+PassRequest *Pass::requestRemove(const QString &file, bool isDir) {
+  PassRequest *request = beginRequest(PASS_REMOVE);
+  Remove(file, isDir);
+  return endRequest(request);
+}
+
+/**
+ * @brief Pass::requestMove Move, with its own result
+ * @param src
+ * @param dest
+ * @param force
+ * @return handle
+ */
+PassRequest *Pass::requestMove(const QString &src, const QString &dest,
+                               bool force) {
+  PassRequest *request = beginRequest(PASS_MOVE);
+  Move(src, dest, force);
+  return endRequest(request);
+}
+
+/**
+ * @brief Pass::requestCopy Copy, with its own result
+ * @param src
+ * @param dest
+ * @param force
+ * @return handle
+ */
+PassRequest *Pass::requestCopy(const QString &src, const QString &dest,
+                               bool force) {
+  PassRequest *request = beginRequest(PASS_COPY);
+  Copy(src, dest, force);
+  return endRequest(request);
+}
+
+/**
+ * @brief Pass::requestMoveItems MoveItems, with its own result and progress
+ * @param srcs
+ * @param destDir
+ * @return handle
+ */
+PassRequest *Pass::requestMoveItems(const QStringList &srcs,
+                                    const QString &destDir) {
+  PassRequest *request = beginRequest(PASS_MOVE);
+  MoveItems(srcs, destDir);
+  return endRequest(request);
+}
+
+/**
+ * @brief Pass::requestCopyItems CopyItems, with its own result and progress
+ * @param srcs
+ * @param destDir
+ * @return handle
+ */
+PassRequest *Pass::requestCopyItems(const QStringList &srcs,
+                                    const QString &destDir) {
+  PassRequest *request = beginRequest(PASS_COPY);
+  CopyItems(srcs, destDir);
+  return endRequest(request);
+}
+
+/**
+ * @brief Pass::requestImport Import, with its own result and progress
+ * @param fileName
+ * @param folder
+ * @return handle
+ */
+PassRequest *Pass::requestImport(const QString &fileName,
+                                 const QString &folder) {
+  PassRequest *request = beginRequest(PASS_IMPORT);
+  Import(fileName, folder);
+  return endRequest(request);
+}
+
+/**
+ * @brief Pass::requestExport Export, with its own result and progress
+ * @param folder
+ * @param recipients
+ * @param archive
+ * @return handle
+ */
+PassRequest *Pass::requestExport(const QString &folder,
+                                 const QStringList &recipients,
+                                 const QString &archive) {
+  PassRequest *request = beginRequest(PASS_EXPORT);
+  Export(folder, recipients, archive);
+  return endRequest(request);
+}
+
+/**
+ * @brief Pass::requestIndexFields IndexFields, with its own result and
+ * progress
+ * @param index
+ * @param entries
+ * @param keys
+ * @return handle
+ */
+PassRequest *Pass::requestIndexFields(FieldIndex *index,
+                                      const QStringList &entries,
+                                      const QStringList &keys) {
+  PassRequest *request = beginRequest(PASS_INDEX);
+  IndexFields(index, entries, keys);
+  return endRequest(request);
+}
+
+/**
+ * @brief Pass::beginRequest everything executed from here on until
+ * endRequest belongs to the new request
+ * @param process
+ * @return the new request
+ */
+PassRequest *Pass::beginRequest(PROCESS process) {
+  PassRequest *request = new PassRequest(process, ++m_lastRequestTag, this);
+  m_requests.insert(request->m_tag, request);
+  m_startingRequest = request->m_tag;
+  m_startedProcesses = 0;
+  m_requestError.clear();
+  return request;
+}
+
+/**
+ * @brief Pass::endRequest stop tagging executions.
+ *
+ * Operations that did all their work in-process, or failed before starting
+ * anything, are completed here. The result is delivered from the event loop
+ * all the same, so callers can connect to the returned request first.
+ * @param request
+ * @return request
+ */
+PassRequest *Pass::endRequest(PassRequest *request) {
+  m_startingRequest = 0;
+  if (m_startedProcesses == 0) {
+    m_requests.remove(request->m_tag);
+    int exitCode = m_requestError.isEmpty() ? 0 : -1;
+    QString error = m_requestError;
+    QTimer::singleShot(0, request, [request, exitCode, error]() {
+      request->complete(exitCode, QByteArray(), error);
+    });
+  } else if (m_startedProcesses > 1) {
+    // done once all of them are, or the first one fails
+    m_pendingCommands.insert(request->m_tag,
+                             qMakePair(0, m_startedProcesses));
+  }
+  return request;
+}
+
+/**
+ * @brief Pass::cancelRequest skip the commands of a request that have not
+ * started yet
+ * @param tag
+ */
+void Pass::cancelRequest(quint64 tag) {
+  m_pendingCommands.remove(tag);
+  exec.cancel(tag);
+}
+
+/**
+ * @brief Pass::executorProgress pass on how far the transaction of a
+ * request got
+ * @param id
+ * @param done
+ * @param total
+ * @param tag
+ */
+void Pass::executorProgress(int, int done, int total, quint64 tag) {
+  QPointer<PassRequest> request = m_requests.value(tag);
+  if (request)
+    request->setProgress(done, total);
+}
+
+/**
+ * @brief Pass::noteCritical remember why a request failed before it could
+ * start any command
+ * @param msg
+ */
+void Pass::noteCritical(QString, QString msg) {
+  if (m_startingRequest != 0)
+    m_requestError = msg;
+}
+
+/**
+ * @brief Pass::executorFinished route the result to the request the command
+ * belongs to, if any, or to the (overridden) finished handler. This is
+ * where the output is decoded, once. Output of a request is not decoded at
+ * all, it goes to the SecureBuffer of the request as it is.
+ * @param id
+ * @param exitCode
+ * @param out
+ * @param err
+ * @param tag
+ */
+void Pass::executorFinished(int id, int exitCode, const QByteArray &out,
+                            const QByteArray &err, quint64 tag) {
+  if (tag != 0)
+    finishRequest(tag, exitCode, out, QString::fromUtf8(err));
+  else
+    finished(id, exitCode, QString::fromUtf8(out), QString::fromUtf8(err));
+}
+
+/**
+ * @brief Pass::finishRequest results of requests go to the request only,
+ * not to everybody
+ * @param tag
+ * @param exitCode
+ * @param out
+ * @param err
+ */
+void Pass::finishRequest(quint64 tag, int exitCode, const QByteArray &out,
+                         const QString &err) {
+  auto pending = m_pendingCommands.find(tag);
+  if (pending != m_pendingCommands.end()) {
+    int done = ++pending->first;
+    int total = pending->second;
+    if (exitCode == 0 && done < total) {
+      QPointer<PassRequest> request = m_requests.value(tag);
+      if (request)
+        request->setProgress(done, total);
+      return;
+    }
+    m_pendingCommands.erase(pending);
+  }
+  QPointer<PassRequest> request = m_requests.take(tag);
+  if (request)
+    request->complete(exitCode, out, err);
 }
 
 void Pass::init() {
@@ -53,6 +381,356 @@ void Pass::init() {
   }
 }
 
+/**
+ * @brief Pass::MoveItems move several files or folders into a folder, one
+ * Move each unless the implementation can do them at once
+ * @param srcs      absolute paths
+ * @param destDir   absolute path of the folder
+ */
+void Pass::MoveItems(const QStringList &srcs, const QString &destDir) {
+  foreach (const QString &src, srcs)
+    Move(src, destDir);
+}
+
+/**
+ * @brief Pass::CopyItems copy several files or folders into a folder, one
+ * Copy each unless the implementation can do them at once
+ * @param srcs      absolute paths
+ * @param destDir   absolute path of the folder
+ */
+void Pass::CopyItems(const QStringList &srcs, const QString &destDir) {
+  foreach (const QString &src, srcs)
+    Copy(src, destDir);
+}
+
+/**
+ * @brief Pass::RemoveItems remove several files or folders, one Remove each
+ * unless the implementation can do them at once
+ * @param paths     absolute paths
+ */
+void Pass::RemoveItems(const QStringList &paths) {
+  QDir store(QtPassSettings::getPassStore());
+  foreach (const QString &path, paths) {
+    bool isDir = QFileInfo(path).isDir();
+    QString file = store.relativeFilePath(path);
+    if (!isDir)
+      file.replace(QRegExp("\\.gpg$"), "");
+    Remove(file, isDir);
+  }
+}
+
+/**
+ * @brief Pass::InitFolders give several folders the same recipients, one
+ * Init each unless the implementation can do them at once
+ * @param paths     absolute paths of the folders, ending with /
+ * @param users
+ */
+void Pass::InitFolders(const QStringList &paths,
+                       const QList<UserInfo> &users) {
+  foreach (const QString &path, paths)
+    Init(path, users);
+}
+
+/**
+ * @brief Pass::Import insert the entries of a CSV or KeePass XML export,
+ * one Insert each unless the implementation can do them at once. Entries
+ * that would overwrite an existing one get a number added to their name.
+ * @param fileName  export to read
+ * @param folder    store folder to import into, relative to the store
+ */
+void Pass::Import(const QString &fileName, const QString &folder) {
+  ImportReader reader;
+  if (!reader.open(fileName)) {
+    emit critical(tr("Can not import"), reader.errorString());
+    return;
+  }
+  QDir store(QtPassSettings::getPassStore());
+  QSet<QString> used;
+  ImportRecord record;
+  while (reader.next(&record)) {
+    QString base = QDir::cleanPath(folder + "/" + record.path());
+    if (base.startsWith('/'))
+      base.remove(0, 1);
+    QString file = base;
+    for (int n = 2; used.contains(file) || store.exists(file + ".gpg"); ++n)
+      file = QString("%1 (%2)").arg(base).arg(n);
+    used.insert(file);
+    QByteArray content = record.contentUtf8();
+    record.wipe();
+    Insert(file, QString::fromUtf8(content), false);
+    SecureBuffer::wipe(&content);
+  }
+  if (reader.hasError())
+    emit critical(tr("Can not import"), reader.errorString());
+}
+
+/*!
+    \struct Pass::exportState
+    \brief What an export did so far, shared by its batches.
+ */
+struct Pass::exportState {
+  QDir root;
+  QStringList recipients;
+  QSharedPointer<QDirIterator> files;
+  TarWriter tar;
+};
+
+/**
+ * @brief Pass::Export re-encrypt the passwords in a folder for other keys,
+ * e.g. of an auditor, into a tar archive
+ *
+ * Every password is decrypted by one gpg process and piped into another
+ * one that encrypts it for the recipients, nothing is decrypted to disk.
+ * Like an import, the folder is gone through in batches, the next batch is
+ * only started when the previous one is in the archive, so memory use does
+ * not depend on the size of the folder. Passwords that can not be
+ * decrypted fail the export, an archive is only there when it is complete.
+ * @param folder      store folder to export, relative to the store
+ * @param recipients  keys to encrypt the archived passwords for
+ * @param archive     tar file to write, replaced if it exists
+ */
+void Pass::Export(const QString &folder, const QStringList &recipients,
+                  const QString &archive) {
+  QSharedPointer<exportState> state(new exportState);
+  state->root = QDir(QDir::cleanPath(
+      QDir(QtPassSettings::getPassStore()).absoluteFilePath(folder)));
+  state->recipients = recipients;
+  state->files.reset(new QDirIterator(state->root.absolutePath(),
+                                      QStringList() << "*.gpg", QDir::Files,
+                                      QDirIterator::Subdirectories));
+  if (recipients.isEmpty()) {
+    emit critical(tr("Can not export"), tr("No key to export for."));
+    return;
+  }
+  Transaction *transaction = new Transaction;
+  // an existing archive is only replaced once the new one is complete
+  transaction->touch(TarWriter::partName(archive));
+  int create = transaction->addTask(
+      [state, archive](Transaction *, QString *error) {
+        if (state->tar.open(archive))
+          return true;
+        *error = state->tar.errorString();
+        return false;
+      });
+  transaction->addTask(
+      [this, state](Transaction *t, QString *error) {
+        return exportBatch(t, state, error);
+      },
+      {create});
+  executeTransaction(PASS_EXPORT, transaction);
+}
+
+/**
+ * @brief Pass::exportBatch add the steps for the next passwords of an
+ * export and the task for the batch after them, or the one finishing the
+ * archive
+ * @param transaction
+ * @param state
+ * @param error
+ * @return false if the folder has no passwords
+ */
+bool Pass::exportBatch(Transaction *transaction,
+                       QSharedPointer<exportState> state, QString *error) {
+  int batchSize = 2 * transaction->maxParallel();
+  QList<int> appends;
+  while (appends.size() < batchSize && state->files->hasNext()) {
+    QString fileName = state->files->next();
+    QString name = state->root.relativeFilePath(fileName);
+    QDateTime modified = state->files->fileInfo().lastModified();
+    int decrypt = transaction->addProcess(
+        QtPassSettings::getGpgExecutable(),
+        {"-d", "--quiet", "--yes", "--no-encrypt-to", "--batch",
+         "--use-agent", fileName});
+    QStringList args = {"--batch", "--yes", "-eq", "--no-encrypt-to"};
+    foreach (const QString &recipient, state->recipients) {
+      args.append("-r");
+      args.append(recipient);
+    }
+    args.append("-");
+    int encrypt =
+        transaction->addProcess(QtPassSettings::getGpgExecutable(), args);
+    transaction->setInputFrom(encrypt, decrypt);
+    transaction->setPrivateOutput(encrypt);
+    appends << transaction->addTask(
+        [state, encrypt, name, modified](Transaction *t, QString *why) {
+          if (state->tar.addFile(name, t->output(encrypt), modified))
+            return true;
+          *why = state->tar.errorString();
+          return false;
+        },
+        {encrypt});
+  }
+
+  if (state->files->hasNext()) {
+    emit statusMsg(tr("Exporting, %1 passwords done")
+                       .arg(state->tar.fileCount()),
+                   3000);
+    transaction->addTask(
+        [this, state](Transaction *t, QString *why) {
+          return exportBatch(t, state, why);
+        },
+        appends);
+    return true;
+  }
+  if (appends.isEmpty() && state->tar.fileCount() == 0) {
+    *error = tr("No passwords found in %1").arg(state->root.absolutePath());
+    return false;
+  }
+  transaction->addTask(
+      [state](Transaction *, QString *why) {
+        if (state->tar.finish())
+          return true;
+        *why = state->tar.errorString();
+        return false;
+      },
+      appends);
+  return true;
+}
+
+/*!
+    \struct Pass::indexState
+    \brief What an update of the field index did so far, shared by its
+    batches.
+ */
+struct Pass::indexState {
+  QPointer<FieldIndex> index;
+  QString fileName;
+  QStringList entries;
+  QStringList keys;
+  QStringList stale;
+  int next;
+};
+
+/**
+ * @brief Pass::IndexFields bring the field index of the store up to date
+ * and save it, encrypted for keys
+ *
+ * The saved index is decrypted first when the index is still empty. Then
+ * only the entries that are new or changed since they were indexed are
+ * decrypted, in batches like an export, and handed to the index one by
+ * one. Entries that can not be decrypted are indexed without fields, so
+ * they are not tried again until they change.
+ * @param index     index to update, must outlive the transaction or be
+ *                  deleted, which stops it
+ * @param entries   all entries of the store, see StoreIndex::entries
+ * @param keys      keys to encrypt the saved index for, the user's own
+ */
+void Pass::IndexFields(FieldIndex *index, const QStringList &entries,
+                       const QStringList &keys) {
+  QSharedPointer<indexState> state(new indexState);
+  state->index = index;
+  state->fileName = index->fileName();
+  state->entries = entries;
+  state->keys = keys;
+  state->next = 0;
+  Transaction *transaction = new Transaction;
+  QList<int> loaded;
+  int load = -1;
+  if (index->isEmpty() && QFile::exists(state->fileName)) {
+    load = transaction->addProcess(QtPassSettings::getGpgExecutable(),
+                                   {"-d", "--quiet", "--yes", "--batch",
+                                    "--use-agent", state->fileName});
+    // an index that can not be read is built again
+    transaction->setOptional(load);
+    transaction->setPrivateOutput(load);
+    loaded << load;
+  }
+  transaction->addTask(
+      [this, state, load](Transaction *t, QString *error) {
+        if (!state->index) {
+          *error = tr("The field index is gone");
+          return false;
+        }
+        if (load >= 0 && !state->index->load(t->output(load)))
+          dbg() << "rebuilding field index" << state->fileName;
+        state->stale = state->index->stale(state->entries);
+        return indexBatch(t, state, error);
+      },
+      loaded);
+  executeTransaction(PASS_INDEX, transaction);
+}
+
+/**
+ * @brief Pass::indexBatch add the steps for the next entries to index and
+ * the task for the batch after them, or the ones saving the index
+ * @param transaction
+ * @param state
+ * @return true
+ */
+bool Pass::indexBatch(Transaction *transaction,
+                      QSharedPointer<indexState> state, QString *) {
+  int batchSize = 4 * transaction->maxParallel();
+  QDir root(state->index ? state->index->root() : QString());
+  QList<int> indexed;
+  while (indexed.size() < batchSize && state->next < state->stale.size()) {
+    QString entry = state->stale.at(state->next++);
+    QString fileName = root.filePath(entry + ".gpg");
+    qint64 modified = QFileInfo(fileName).lastModified().toMSecsSinceEpoch();
+    int decrypt = transaction->addProcess(
+        QtPassSettings::getGpgExecutable(),
+        {"-d", "--quiet", "--yes", "--batch", "--use-agent", fileName});
+    transaction->setOptional(decrypt);
+    transaction->setPrivateOutput(decrypt);
+    indexed << transaction->addTask(
+        [state, decrypt, entry, modified](Transaction *t, QString *) {
+          if (!state->index)
+            return true;
+          QString content = QString::fromUtf8(t->output(decrypt));
+          state->index->setContent(entry, content, modified);
+          SecureBuffer::wipe(&content);
+          return true;
+        },
+        {decrypt});
+  }
+
+  if (state->next < state->stale.size()) {
+    emit statusMsg(tr("Indexing fields, %1 of %2 entries done")
+                       .arg(state->next - indexed.size())
+                       .arg(state->stale.size()),
+                   3000);
+    transaction->addTask(
+        [this, state](Transaction *t, QString *why) {
+          return indexBatch(t, state, why);
+        },
+        indexed);
+    return true;
+  }
+  transaction->addTask(
+      [state](Transaction *t, QString *) {
+        if (!state->index || !state->index->isModified())
+          return true;
+        QStringList args = {"--batch", "--yes", "-eq", "--no-encrypt-to"};
+        foreach (const QString &key, state->keys) {
+          args.append("-r");
+          args.append(key);
+        }
+        args.append("-");
+        int encrypt =
+            t->addProcess(QtPassSettings::getGpgExecutable(), args,
+                          QList<int>(), state->index->save());
+        t->setPrivateOutput(encrypt);
+        t->addTask(
+            [state, encrypt](Transaction *done, QString *why) {
+              QDir().mkpath(QFileInfo(state->fileName).path());
+              QSaveFile file(state->fileName);
+              if (!file.open(QIODevice::WriteOnly) ||
+                  file.write(done->output(encrypt)) < 0 || !file.commit()) {
+                *why = tr("Could not write %1: %2")
+                           .arg(state->fileName)
+                           .arg(file.errorString());
+                return false;
+              }
+              if (state->index)
+                state->index->setModified(false);
+              return true;
+            },
+            {encrypt});
+        return true;
+      },
+      indexed);
+  return true;
+}
+
 /**
  * @brief Pass::Generate use either pwgen or internal password
  * generator
@@ -75,11 +753,11 @@ QString Pass::Generate_b(unsigned int length, const QString &charset) {
     if (QtPassSettings::isUseSymbols())
       args.append("--symbols");
     args.append(QString::number(length));
-    QString p_out;
+    QByteArray p_out;
     //  TODO(bezet): try-catch here(2 statuses to merge o_O)
     if (exec.executeBlocking(QtPassSettings::getPwgenExecutable(), args,
-                             &passwd) == 0)
-      passwd.remove(QRegExp("[\\n\\r]"));
+                             &p_out) == 0)
+      passwd = QString::fromUtf8(p_out).remove(QRegExp("[\\n\\r]"));
     else {
       passwd.clear();
       qDebug() << __FILE__ << ":" << __LINE__ << "\t"
@@ -123,11 +801,12 @@ QList<UserInfo> Pass::listKeys(QString keystring, bool secret) {
   args.append(secret ? "--list-secret-keys" : "--list-keys");
   if (!keystring.isEmpty())
     args.append(keystring);
-  QString p_out;
+  QByteArray p_out;
   if (exec.executeBlocking(QtPassSettings::getGpgExecutable(), args, &p_out) !=
       0)
     return users;
-  QStringList keys = p_out.split(QRegExp("[\r\n]"), QString::SkipEmptyParts);
+  QStringList keys = QString::fromUtf8(p_out).split(QRegExp("[\r\n]"),
+                                                    QString::SkipEmptyParts);
   UserInfo current_user;
   foreach (QString key, keys) {
     QStringList props = key.split(':');
@@ -185,6 +864,7 @@ void Pass::finished(int id, int exitCode, const QString &out,
     emit finishedOtpGenerate(out);
     break;
   case PASS_INSERT:
+  case PASS_IMPORT:
     emit finishedInsert(out, err);
     break;
   case PASS_REMOVE:
@@ -231,13 +911,13 @@ void Pass::updateEnv() {
  * @return recepients gpg-id contents
  */
 QStringList Pass::getRecipientList(QString for_file) {
-  QDir gpgIdPath(QFileInfo(for_file.startsWith(QtPassSettings::getPassStore())
+  const QString passStore = QtPassSettings::getSnapshot().passStore;
+  QDir gpgIdPath(QFileInfo(for_file.startsWith(passStore)
                                ? for_file
-                               : QtPassSettings::getPassStore() + for_file)
+                               : passStore + for_file)
                      .absoluteDir());
   bool found = false;
-  while (gpgIdPath.exists() &&
-         gpgIdPath.absolutePath().startsWith(QtPassSettings::getPassStore())) {
+  while (gpgIdPath.exists() && gpgIdPath.absolutePath().startsWith(passStore)) {
     if (QFile(gpgIdPath.absoluteFilePath(".gpg-id")).exists()) {
       found = true;
       break;
@@ -246,7 +926,7 @@ QStringList Pass::getRecipientList(QString for_file) {
       break;
   }
   QFile gpgId(found ? gpgIdPath.absoluteFilePath(".gpg-id")
-                    : QtPassSettings::getPassStore() + ".gpg-id");
+                    : passStore + ".gpg-id");
   if (!gpgId.open(QIODevice::ReadOnly | QIODevice::Text))
     return QStringList();
   QStringList recipients;
@@ -3,10 +3,16 @@
 
 #include "enums.h"
 #include "executor.h"
+#include "passrequest.h"
+#include "transaction.h"
 #include "userinfo.h"
 
+#include <QHash>
+#include <QPair>
+#include <QPointer>
 #include <QProcess>
 #include <QQueue>
+#include <QSharedPointer>
 #include <QString>
 #include <cassert>
 #include <map>
@@ -21,13 +27,41 @@
 /*!
     \class Pass
     \brief Acts as an abstraction for pass or pass imitation
+
+    The operations can be started directly, their results are then broadcast
+    through the finished* signals, or through the request* methods, which
+    return a PassRequest carrying the result of just that operation.
 */
+class FieldIndex;
 class Pass : public QObject {
   Q_OBJECT
 
   bool wrapperRunning;
   QStringList env;
 
+  quint64 m_lastRequestTag;
+  quint64 m_startingRequest;
+  int m_startedProcesses;
+  QHash<quint64, QPointer<PassRequest>> m_requests;
+  /**
+   * @brief m_pendingCommands   commands a request still waits for, by tag
+   */
+  QHash<quint64, QPair<int, int>> m_pendingCommands;
+  QString m_requestError;
+
+  struct exportState;
+  bool exportBatch(Transaction *transaction,
+                   QSharedPointer<exportState> state, QString *error);
+  struct indexState;
+  bool indexBatch(Transaction *transaction, QSharedPointer<indexState> state,
+                  QString *error);
+
+  PassRequest *beginRequest(Enums::PROCESS process);
+  PassRequest *endRequest(PassRequest *request);
+
+  friend class PassRequest;
+  void cancelRequest(quint64 tag);
+
 protected:
   Executor exec;
 
@@ -53,6 +87,40 @@ public:
   virtual void Init(QString path, const QList<UserInfo> &users) = 0;
   virtual QString Generate_b(unsigned int length, const QString &charset);
 
+  virtual void MoveItems(const QStringList &srcs, const QString &destDir);
+  virtual void CopyItems(const QStringList &srcs, const QString &destDir);
+  virtual void RemoveItems(const QStringList &paths);
+  virtual void InitFolders(const QStringList &paths,
+                           const QList<UserInfo> &users);
+  virtual void Import(const QString &fileName, const QString &folder);
+  void Export(const QString &folder, const QStringList &recipients,
+              const QString &archive);
+  void IndexFields(FieldIndex *index, const QStringList &entries,
+                   const QStringList &keys);
+
+  PassRequest *requestShow(const QString &file);
+  PassRequest *requestOtpGenerate(const QString &file);
+  PassRequest *requestInsert(const QString &file, const QString &value,
+                             bool force);
+  PassRequest *requestRemove(const QString &file, bool isDir);
+  PassRequest *requestMove(const QString &src, const QString &dest,
+                           bool force = false);
+  PassRequest *requestCopy(const QString &src, const QString &dest,
+                           bool force = false);
+  PassRequest *requestMoveItems(const QStringList &srcs,
+                                const QString &destDir);
+  PassRequest *requestCopyItems(const QStringList &srcs,
+                                const QString &destDir);
+  PassRequest *requestImport(const QString &fileName, const QString &folder);
+  PassRequest *requestExport(const QString &folder,
+                             const QStringList &recipients,
+                             const QString &archive);
+  PassRequest *requestIndexFields(FieldIndex *index,
+                                  const QStringList &entries,
+                                  const QStringList &keys);
+
+  int timeoutCount() const;
+
   void GenerateGPGKeys(QString batch);
   QList<UserInfo> listKeys(QString keystring = "", bool secret = false);
   void updateEnv();
@@ -64,6 +132,7 @@ public:
 protected:
   void executeWrapper(PROCESS id, const QString &app, const QStringList &args,
                       bool readStdout = true, bool readStderr = true);
+  void executeTransaction(PROCESS id, Transaction *transaction);
   QString generateRandomPassword(const QString &charset, unsigned int length);
   quint32 boundedRandom(quint32 bound);
 
@@ -75,6 +144,16 @@ protected slots:
   virtual void finished(int id, int exitCode, const QString &out,
                         const QString &err);
 
+private slots:
+  void noteCritical(QString, QString msg);
+  void executorFinished(int id, int exitCode, const QByteArray &out,
+                        const QByteArray &err, quint64 tag);
+  void executorProgress(int id, int done, int total, quint64 tag);
+
+private:
+  void finishRequest(quint64 tag, int exitCode, const QByteArray &out,
+                     const QString &err);
+
 signals:
   void error(QProcess::ProcessError);
   void startingExecuteWrapper();
@@ -0,0 +1,111 @@
+#include "passrequest.h"
+#include "pass.h"
+
+/**
+ * @brief PassRequest::PassRequest created by Pass only
+ * @param process   operation that was requested
+ * @param tag       identifies the commands of this request in the Executor
+ * @param pass      Pass instance executing the request, also the parent
+ */
+PassRequest::PassRequest(Enums::PROCESS process, quint64 tag, Pass *pass)
+    : QObject(pass), m_process(process), m_tag(tag), m_pass(pass),
+      m_state(PENDING), m_exitCode(0), m_autoDelete(true) {}
+
+/**
+ * @brief PassRequest::process
+ * @return operation that was requested
+ */
+Enums::PROCESS PassRequest::process() const { return m_process; }
+
+/**
+ * @brief PassRequest::state
+ * @return where the request is at
+ */
+PassRequest::State PassRequest::state() const { return m_state; }
+
+/**
+ * @brief PassRequest::isFinished
+ * @return true once the request succeeded, failed or was cancelled
+ */
+bool PassRequest::isFinished() const { return m_state != PENDING; }
+
+/**
+ * @brief PassRequest::exitCode
+ * @return exit code of the command that ended the request, -1 if it could
+ * not be run at all
+ */
+int PassRequest::exitCode() const { return m_exitCode; }
+
+/**
+ * @brief PassRequest::output
+ * @return standard output as a string, use secret() for decrypted content
+ */
+QString PassRequest::output() const { return m_output.toString(); }
+
+/**
+ * @brief PassRequest::secret
+ * @return standard output, decrypted content for PASS_SHOW, wiped when the
+ * request is deleted
+ */
+const SecureBuffer &PassRequest::secret() const { return m_output; }
+
+/**
+ * @brief PassRequest::errorOutput
+ * @return standard error or a description of why the request failed
+ */
+const QString &PassRequest::errorOutput() const { return m_errorOutput; }
+
+/**
+ * @brief PassRequest::autoDelete
+ * @return whether the request deletes itself once finished or cancelled
+ */
+bool PassRequest::autoDelete() const { return m_autoDelete; }
+
+/**
+ * @brief PassRequest::setAutoDelete keep the request around after it
+ * finished, the caller then has to delete it.
+ * @param autoDelete
+ */
+void PassRequest::setAutoDelete(bool autoDelete) { m_autoDelete = autoDelete; }
+
+/**
+ * @brief PassRequest::cancel drop the result and skip whatever has not
+ * started yet. A command that is already running is left to finish.
+ */
+void PassRequest::cancel() {
+  if (m_state != PENDING)
+    return;
+  m_state = CANCELLED;
+  m_pass->cancelRequest(m_tag);
+  if (m_autoDelete)
+    deleteLater();
+}
+
+/**
+ * @brief PassRequest::setProgress tell the caller how far the operation got
+ * @param done
+ * @param total
+ */
+void PassRequest::setProgress(int done, int total) {
+  if (m_state == PENDING)
+    emit progress(done, total);
+}
+
+/**
+ * @brief PassRequest::complete store the result and tell the caller
+ * @param exitCode
+ * @param output    copied to secure memory, wiping it is up to the caller
+ * @param err
+ */
+void PassRequest::complete(int exitCode, const QByteArray &output,
+                           const QString &err) {
+  if (m_state != PENDING)
+    return;
+  m_exitCode = exitCode;
+  m_output = SecureBuffer(output);
+  m_errorOutput = err;
+  m_state = exitCode == 0 ? FINISHED : FAILED;
+  emit finished(this);
+  if (m_autoDelete)
+    deleteLater();
+}
@@ -0,0 +1,75 @@
+#ifndef PASSREQUEST_H
+#define PASSREQUEST_H
+
+#include "enums.h"
+#include "securebuffer.h"
+
+#include <QObject>
+#include <QString>
+
+/*!
+    \class PassRequest
+    \brief Handle for one operation started through a Pass request* method.
+
+    Carries the result of exactly that operation, so callers do not have to
+    listen to the broadcast finished* signals of Pass and guess whether the
+    result is theirs. finished() is emitted once, from the event loop, after
+    which the request deletes itself unless setAutoDelete(false) was called.
+    A cancelled request never emits finished(); commands of it that have not
+    been started yet are skipped.
+
+    The standard output is kept in a SecureBuffer, read decrypted content
+    through secret() so it is not copied around.
+ */
+class Pass;
+class PassRequest : public QObject {
+  Q_OBJECT
+
+public:
+  enum State { PENDING, FINISHED, FAILED, CANCELLED };
+
+  Enums::PROCESS process() const;
+  State state() const;
+  bool isFinished() const;
+  int exitCode() const;
+  QString output() const;
+  const SecureBuffer &secret() const;
+  const QString &errorOutput() const;
+
+  bool autoDelete() const;
+  void setAutoDelete(bool autoDelete);
+
+public slots:
+  void cancel();
+
+signals:
+  /**
+   * @brief finished the operation is done, successful or not
+   * @param request this request
+   */
+  void finished(PassRequest *request);
+  /**
+   * @brief progress    part of the operation is done
+   * @param done        commands or steps done so far
+   * @param total       commands or steps planned so far
+   */
+  void progress(int done, int total);
+
+private:
+  friend class Pass;
+
+  PassRequest(Enums::PROCESS process, quint64 tag, Pass *pass);
+  void complete(int exitCode, const QByteArray &output, const QString &err);
+  void setProgress(int done, int total);
+
+  Enums::PROCESS m_process;
+  quint64 m_tag;
+  Pass *m_pass;
+  State m_state;
+  int m_exitCode;
+  SecureBuffer m_output;
+  QString m_errorOutput;
+  bool m_autoDelete;
+};
+
+#endif // PASSREQUEST_H
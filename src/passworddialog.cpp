@@ -3,10 +3,12 @@
 #include "filecontent.h"
 #include "passwordconfiguration.h"
 #include "qtpasssettings.h"
+#include "securebuffer.h"
 #include "ui_passworddialog.h"
 
 #include <QLabel>
 #include <QLineEdit>
+#include <QMessageBox>
 
 /**
  * @brief PasswordDialog::PasswordDialog basic constructor.
@@ -36,10 +38,6 @@ PasswordDialog::PasswordDialog(const QString &file, const bool &isNew,
                                QWidget *parent)
     : QDialog(parent), ui(new Ui::PasswordDialog), m_file(file),
       m_isNew(isNew) {
-
-  if (!isNew)
-    QtPassSettings::getPass()->Show(m_file);
-
   ui->setupUi(this);
 
   setWindowTitle(this->windowTitle() + " " + m_file);
@@ -52,8 +50,12 @@ PasswordDialog::PasswordDialog(const QString &file, const bool &isNew,
   setLength(m_passConfig.length);
   setPasswordCharTemplate(m_passConfig.selected);
 
-  connect(QtPassSettings::getPass(), &Pass::processErrorExit, this,
-          &PasswordDialog::close);
+  if (!isNew) {
+    m_showRequest = QtPassSettings::getPass()->requestShow(m_file);
+    connect(m_showRequest, &PassRequest::finished, this,
+            &PasswordDialog::showFinished);
+  }
+
   connect(this, &PasswordDialog::accepted, this, &PasswordDialog::on_accepted);
   connect(this, &PasswordDialog::rejected, this, &PasswordDialog::on_rejected);
 }
@@ -61,7 +63,11 @@ PasswordDialog::PasswordDialog(const QString &file, const bool &isNew,
 /**
  * @brief PasswordDialog::~PasswordDialog basic destructor.
  */
-PasswordDialog::~PasswordDialog() { delete ui; }
+PasswordDialog::~PasswordDialog() {
+  if (m_showRequest)
+    m_showRequest->cancel();
+  delete ui;
+}
 
 /**
  * @brief PasswordDialog::on_checkBoxShow_stateChanged hide or show passwords.
@@ -218,6 +224,22 @@ void PasswordDialog::usePwgen(bool usePwgen) {
   ui->label_characterset->setDisabled(usePwgen);
 }
 
+/**
+ * @brief PasswordDialog::showFinished fill in the entry being edited, or give
+ * up when it can not be decrypted.
+ * @param request
+ */
+void PasswordDialog::showFinished(PassRequest *request) {
+  if (request->state() == PassRequest::FINISHED) {
+    QString content = request->secret().toString();
+    setPass(content);
+    SecureBuffer::wipe(&content);
+    return;
+  }
+  QMessageBox::critical(this, tr("Can not edit"), request->errorOutput());
+  close();
+}
+
 void PasswordDialog::setPass(const QString &output) {
   setPassword(output);
   //    TODO(bezet): enable ui
@@ -3,11 +3,13 @@
 
 #include "passwordconfiguration.h"
 #include <QDialog>
+#include <QPointer>
 
 namespace Ui {
 class PasswordDialog;
 }
 
+class PassRequest;
 class QLineEdit;
 class QWidget;
 
@@ -53,6 +55,7 @@ public slots:
   void setPass(const QString &output);
 
 private slots:
+  void showFinished(PassRequest *request);
   void on_checkBoxShow_stateChanged(int arg1);
   void on_createPasswordButton_clicked();
   void on_accepted();
@@ -68,6 +71,7 @@ private:
   bool m_isNew;
   QList<QLineEdit *> templateLines;
   QList<QLineEdit *> otherLines;
+  QPointer<PassRequest> m_showRequest;
 };
 
 #endif // PASSWORDDIALOG_H_
@@ -11,6 +11,9 @@ Pass *QtPassSettings::pass;
 RealPass QtPassSettings::realPass;
 ImitatePass QtPassSettings::imitatePass;
 
+bool QtPassSettings::snapshotLoaded = false;
+SettingsSnapshot QtPassSettings::snapshot;
+
 QtPassSettings *QtPassSettings::m_instance = nullptr;
 QtPassSettings *QtPassSettings::getInstance() {
   if (!QtPassSettings::initialized) {
@@ -28,6 +31,92 @@ QtPassSettings *QtPassSettings::getInstance() {
   return m_instance;
 }
 
+/**
+ * @brief QtPassSettings::getSnapshot typed copy of the frequently used
+ * settings, read from QSettings the first time it is needed.
+ * @return snapshot that stays valid and current for the application lifetime
+ */
+const SettingsSnapshot &QtPassSettings::getSnapshot() {
+  if (!snapshotLoaded)
+    loadSnapshot();
+  return snapshot;
+}
+
+/**
+ * @brief QtPassSettings::loadSnapshot (re)read all snapshot values.
+ * Uses the same defaults as the corresponding getters.
+ */
+void QtPassSettings::loadSnapshot() {
+  QtPassSettings *s = getInstance();
+  snapshot.passStore =
+      normalizePassStore(s->value(SettingsConstants::passStore).toString());
+  snapshot.passExecutable =
+      s->value(SettingsConstants::passExecutable).toString();
+  snapshot.gitExecutable =
+      s->value(SettingsConstants::gitExecutable).toString();
+  snapshot.gpgExecutable =
+      s->value(SettingsConstants::gpgExecutable).toString();
+  snapshot.passTemplate = s->value(SettingsConstants::passTemplate).toString();
+  snapshot.usePass = s->value(SettingsConstants::usePass).toBool();
+  snapshot.useGit = s->value(SettingsConstants::useGit).toBool();
+  snapshot.useWebDav = s->value(SettingsConstants::useWebDav).toBool();
+  snapshot.useOtp = s->value(SettingsConstants::useOtp).toBool();
+  snapshot.useTemplate = s->value(SettingsConstants::useTemplate).toBool();
+  snapshot.templateAllFields =
+      s->value(SettingsConstants::templateAllFields).toBool();
+  snapshot.hidePassword = s->value(SettingsConstants::hidePassword).toBool();
+  snapshot.hideContent = s->value(SettingsConstants::hideContent).toBool();
+  snapshot.clipBoardType = static_cast<Enums::clipBoardType>(
+      s->value(SettingsConstants::clipBoardType,
+               static_cast<int>(Enums::CLIPBOARD_NEVER))
+          .toInt());
+  snapshot.useSelection = s->value(SettingsConstants::useSelection).toBool();
+  snapshot.useAutoclear = s->value(SettingsConstants::useAutoclear).toBool();
+  snapshot.autoclearSeconds =
+      s->value(SettingsConstants::autoclearSeconds).toInt();
+  snapshot.useAutoclearPanel =
+      s->value(SettingsConstants::useAutoclearPanel).toBool();
+  snapshot.autoclearPanelSeconds =
+      s->value(SettingsConstants::autoclearPanelSeconds).toInt();
+  snapshot.autoPull = s->value(SettingsConstants::autoPull).toBool();
+  snapshot.autoPush = s->value(SettingsConstants::autoPush).toBool();
+  snapshotLoaded = true;
+}
+
+/**
+ * @brief QtPassSettings::normalizePassStore make sure the store exists and
+ * ends in a slash.
+ * @param passStore
+ * @return normalized path
+ */
+QString QtPassSettings::normalizePassStore(QString passStore) {
+  // ensure directory exists if never used pass or misconfigured.
+  // otherwise process->setWorkingDirectory(passStore); will fail on execution.
+  if (!QDir(passStore).exists()) {
+    QDir().mkdir(passStore);
+  }
+
+  // ensure path ends in /
+  if (!passStore.endsWith("/")) {
+    passStore += "/";
+  }
+
+  return passStore;
+}
+
+/**
+ * @brief QtPassSettings::setSetting store a value and notify listeners.
+ *
+ * QSettings keeps the value in memory and writes all pending changes to disk
+ * in one go from the event loop, so setters never block on file I/O.
+ * @param key
+ * @param value
+ */
+void QtPassSettings::setSetting(const QString &key, const QVariant &value) {
+  getInstance()->setValue(key, value);
+  emit getInstance()->settingChanged(key);
+}
+
 PasswordConfiguration QtPassSettings::getPasswordConfiguration() {
   PasswordConfiguration config;
 
@@ -47,11 +136,10 @@ PasswordConfiguration QtPassSettings::getPasswordConfiguration() {
 
 void QtPassSettings::setPasswordConfiguration(
     const PasswordConfiguration &config) {
-  getInstance()->setValue(SettingsConstants::passwordLength, config.length);
-  getInstance()->setValue(SettingsConstants::passwordCharsselection,
-                          config.selected);
-  getInstance()->setValue(SettingsConstants::passwordChars,
-                          config.Characters[PasswordConfiguration::CUSTOM]);
+  setSetting(SettingsConstants::passwordLength, config.length);
+  setSetting(SettingsConstants::passwordCharsselection, config.selected);
+  setSetting(SettingsConstants::passwordChars,
+             config.Characters[PasswordConfiguration::CUSTOM]);
 }
 
 QHash<QString, QString> QtPassSettings::getProfiles() {
@@ -78,6 +166,7 @@ void QtPassSettings::setProfiles(const QHash<QString, QString> &profiles) {
   }
 
   getInstance()->endGroup();
+  emit getInstance()->settingChanged(SettingsConstants::groupProfiles);
 }
 
 Pass *QtPassSettings::getPass() {
@@ -98,7 +187,7 @@ QString QtPassSettings::getVersion(const QString &defaultValue) {
       .toString();
 }
 void QtPassSettings::setVersion(const QString &version) {
-  getInstance()->setValue(SettingsConstants::version, version);
+  setSetting(SettingsConstants::version, version);
 }
 
 QByteArray QtPassSettings::getGeometry(const QByteArray &defaultValue) {
@@ -107,7 +196,7 @@ QByteArray QtPassSettings::getGeometry(const QByteArray &defaultValue) {
       .toByteArray();
 }
 void QtPassSettings::setGeometry(const QByteArray &geometry) {
-  getInstance()->setValue(SettingsConstants::geometry, geometry);
+  setSetting(SettingsConstants::geometry, geometry);
 }
 
 QByteArray QtPassSettings::getSavestate(const QByteArray &defaultValue) {
@@ -116,21 +205,21 @@ QByteArray QtPassSettings::getSavestate(const QByteArray &defaultValue) {
       .toByteArray();
 }
 void QtPassSettings::setSavestate(const QByteArray &saveState) {
-  getInstance()->setValue(SettingsConstants::savestate, saveState);
+  setSetting(SettingsConstants::savestate, saveState);
 }
 
 QPoint QtPassSettings::getPos(const QPoint &defaultValue) {
   return getInstance()->value(SettingsConstants::pos, defaultValue).toPoint();
 }
 void QtPassSettings::setPos(const QPoint &pos) {
-  getInstance()->setValue(SettingsConstants::pos, pos);
+  setSetting(SettingsConstants::pos, pos);
 }
 
 QSize QtPassSettings::getSize(const QSize &defaultValue) {
   return getInstance()->value(SettingsConstants::size, defaultValue).toSize();
 }
 void QtPassSettings::setSize(const QSize &size) {
-  getInstance()->setValue(SettingsConstants::size, size);
+  setSetting(SettingsConstants::size, size);
 }
 
 bool QtPassSettings::isMaximized(const bool &defaultValue) {
@@ -139,10 +228,12 @@ bool QtPassSettings::isMaximized(const bool &defaultValue) {
       .toBool();
 }
 void QtPassSettings::setMaximized(const bool &maximized) {
-  getInstance()->setValue(SettingsConstants::maximized, maximized);
+  setSetting(SettingsConstants::maximized, maximized);
 }
 
 bool QtPassSettings::isUsePass(const bool &defaultValue) {
+  if (!defaultValue)
+    return getSnapshot().usePass;
   return getInstance()
       ->value(SettingsConstants::usePass, defaultValue)
       .toBool();
@@ -153,11 +244,14 @@ void QtPassSettings::setUsePass(const bool &usePass) {
   } else {
     QtPassSettings::pass = &QtPassSettings::imitatePass;
   }
-  getInstance()->setValue(SettingsConstants::usePass, usePass);
+  snapshot.usePass = usePass;
+  setSetting(SettingsConstants::usePass, usePass);
 }
 
 int QtPassSettings::getClipBoardTypeRaw(
     const Enums::clipBoardType &defaultvalue) {
+  if (defaultvalue == Enums::CLIPBOARD_NEVER)
+    return static_cast<int>(getSnapshot().clipBoardType);
   return getInstance()
       ->value(SettingsConstants::clipBoardType, static_cast<int>(defaultvalue))
       .toInt();
@@ -168,74 +262,93 @@ QtPassSettings::getClipBoardType(const Enums::clipBoardType &defaultvalue) {
   return static_cast<Enums::clipBoardType>(getClipBoardTypeRaw(defaultvalue));
 }
 void QtPassSettings::setClipBoardType(const int &clipBoardType) {
-  getInstance()->setValue(SettingsConstants::clipBoardType, clipBoardType);
+  snapshot.clipBoardType = static_cast<Enums::clipBoardType>(clipBoardType);
+  setSetting(SettingsConstants::clipBoardType, clipBoardType);
 }
 
 bool QtPassSettings::isUseSelection(const bool &defaultValue) {
+  if (!defaultValue)
+    return getSnapshot().useSelection;
   return getInstance()
       ->value(SettingsConstants::useSelection, defaultValue)
       .toBool();
 }
 void QtPassSettings::setUseSelection(const bool &useSelection) {
-  getInstance()->setValue(SettingsConstants::useSelection, useSelection);
+  snapshot.useSelection = useSelection;
+  setSetting(SettingsConstants::useSelection, useSelection);
 }
 
 bool QtPassSettings::isUseAutoclear(const bool &defaultValue) {
+  if (!defaultValue)
+    return getSnapshot().useAutoclear;
   return getInstance()
       ->value(SettingsConstants::useAutoclear, defaultValue)
       .toBool();
 }
 void QtPassSettings::setUseAutoclear(const bool &useAutoclear) {
-  getInstance()->setValue(SettingsConstants::useAutoclear, useAutoclear);
+  snapshot.useAutoclear = useAutoclear;
+  setSetting(SettingsConstants::useAutoclear, useAutoclear);
 }
 
 int QtPassSettings::getAutoclearSeconds(const int &defaultValue) {
+  if (defaultValue == 0)
+    return getSnapshot().autoclearSeconds;
   return getInstance()
       ->value(SettingsConstants::autoclearSeconds, defaultValue)
       .toInt();
 }
 void QtPassSettings::setAutoclearSeconds(const int &autoClearSeconds) {
-  getInstance()->setValue(SettingsConstants::autoclearSeconds,
-                          autoClearSeconds);
+  snapshot.autoclearSeconds = autoClearSeconds;
+  setSetting(SettingsConstants::autoclearSeconds, autoClearSeconds);
 }
 
 bool QtPassSettings::isUseAutoclearPanel(const bool &defaultValue) {
+  if (!defaultValue)
+    return getSnapshot().useAutoclearPanel;
   return getInstance()
       ->value(SettingsConstants::useAutoclearPanel, defaultValue)
       .toBool();
 }
 void QtPassSettings::setUseAutoclearPanel(const bool &useAutoclearPanel) {
-  getInstance()->setValue(SettingsConstants::useAutoclearPanel,
-                          useAutoclearPanel);
+  snapshot.useAutoclearPanel = useAutoclearPanel;
+  setSetting(SettingsConstants::useAutoclearPanel, useAutoclearPanel);
 }
 
 int QtPassSettings::getAutoclearPanelSeconds(const int &defaultValue) {
+  if (defaultValue == 0)
+    return getSnapshot().autoclearPanelSeconds;
   return getInstance()
       ->value(SettingsConstants::autoclearPanelSeconds, defaultValue)
       .toInt();
 }
 void QtPassSettings::setAutoclearPanelSeconds(
     const int &autoClearPanelSeconds) {
-  getInstance()->setValue(SettingsConstants::autoclearPanelSeconds,
-                          autoClearPanelSeconds);
+  snapshot.autoclearPanelSeconds = autoClearPanelSeconds;
+  setSetting(SettingsConstants::autoclearPanelSeconds, autoClearPanelSeconds);
 }
 
 bool QtPassSettings::isHidePassword(const bool &defaultValue) {
+  if (!defaultValue)
+    return getSnapshot().hidePassword;
   return getInstance()
       ->value(SettingsConstants::hidePassword, defaultValue)
       .toBool();
 }
 void QtPassSettings::setHidePassword(const bool &hidePassword) {
-  getInstance()->setValue(SettingsConstants::hidePassword, hidePassword);
+  snapshot.hidePassword = hidePassword;
+  setSetting(SettingsConstants::hidePassword, hidePassword);
 }
 
 bool QtPassSettings::isHideContent(const bool &defaultValue) {
+  if (!defaultValue)
+    return getSnapshot().hideContent;
   return getInstance()
       ->value(SettingsConstants::hideContent, defaultValue)
       .toBool();
 }
 void QtPassSettings::setHideContent(const bool &hideContent) {
-  getInstance()->setValue(SettingsConstants::hideContent, hideContent);
+  snapshot.hideContent = hideContent;
+  setSetting(SettingsConstants::hideContent, hideContent);
 }
 
 bool QtPassSettings::isAddGPGId(const bool &defaultValue) {
@@ -244,29 +357,18 @@ bool QtPassSettings::isAddGPGId(const bool &defaultValue) {
       .toBool();
 }
 void QtPassSettings::setAddGPGId(const bool &addGPGId) {
-  getInstance()->setValue(SettingsConstants::addGPGId, addGPGId);
+  setSetting(SettingsConstants::addGPGId, addGPGId);
 }
 
 QString QtPassSettings::getPassStore(const QString &defaultValue) {
-  QString returnValue = getInstance()
-                            ->value(SettingsConstants::passStore, defaultValue)
-                            .toString();
-
-  // ensure directory exists if never used pass or misconfigured.
-  // otherwise process->setWorkingDirectory(passStore); will fail on execution.
-  if (!QDir(returnValue).exists()) {
-    QDir().mkdir(returnValue);
-  }
-
-  // ensure path ends in /
-  if (!returnValue.endsWith("/")) {
-    returnValue += "/";
-  }
-
-  return returnValue;
+  if (defaultValue.isEmpty() ||
+      getInstance()->contains(SettingsConstants::passStore))
+    return getSnapshot().passStore;
+  return normalizePassStore(defaultValue);
 }
 void QtPassSettings::setPassStore(const QString &passStore) {
-  getInstance()->setValue(SettingsConstants::passStore, passStore);
+  snapshot.passStore = normalizePassStore(passStore);
+  setSetting(SettingsConstants::passStore, passStore);
 }
 
 void QtPassSettings::initExecutables() {
@@ -287,30 +389,39 @@ void QtPassSettings::initExecutables() {
   QtPassSettings::setPwgenExecutable(pwgenExecutable);
 }
 QString QtPassSettings::getPassExecutable(const QString &defaultValue) {
+  if (defaultValue.isEmpty())
+    return getSnapshot().passExecutable;
   return getInstance()
       ->value(SettingsConstants::passExecutable, defaultValue)
       .toString();
 }
 void QtPassSettings::setPassExecutable(const QString &passExecutable) {
-  getInstance()->setValue(SettingsConstants::passExecutable, passExecutable);
+  snapshot.passExecutable = passExecutable;
+  setSetting(SettingsConstants::passExecutable, passExecutable);
 }
 
 QString QtPassSettings::getGitExecutable(const QString &defaultValue) {
+  if (defaultValue.isEmpty())
+    return getSnapshot().gitExecutable;
   return getInstance()
       ->value(SettingsConstants::gitExecutable, defaultValue)
       .toString();
 }
 void QtPassSettings::setGitExecutable(const QString &gitExecutable) {
-  getInstance()->setValue(SettingsConstants::gitExecutable, gitExecutable);
+  snapshot.gitExecutable = gitExecutable;
+  setSetting(SettingsConstants::gitExecutable, gitExecutable);
 }
 
 QString QtPassSettings::getGpgExecutable(const QString &defaultValue) {
+  if (defaultValue.isEmpty())
+    return getSnapshot().gpgExecutable;
   return getInstance()
       ->value(SettingsConstants::gpgExecutable, defaultValue)
       .toString();
 }
 void QtPassSettings::setGpgExecutable(const QString &gpgExecutable) {
-  getInstance()->setValue(SettingsConstants::gpgExecutable, gpgExecutable);
+  snapshot.gpgExecutable = gpgExecutable;
+  setSetting(SettingsConstants::gpgExecutable, gpgExecutable);
 }
 
 QString QtPassSettings::getPwgenExecutable(const QString &defaultValue) {
@@ -319,7 +430,7 @@ QString QtPassSettings::getPwgenExecutable(const QString &defaultValue) {
       .toString();
 }
 void QtPassSettings::setPwgenExecutable(const QString &pwgenExecutable) {
-  getInstance()->setValue(SettingsConstants::pwgenExecutable, pwgenExecutable);
+  setSetting(SettingsConstants::pwgenExecutable, pwgenExecutable);
 }
 
 QString QtPassSettings::getGpgHome(const QString &defaultValue) {
@@ -329,12 +440,15 @@ QString QtPassSettings::getGpgHome(const QString &defaultValue) {
 }
 
 bool QtPassSettings::isUseWebDav(const bool &defaultValue) {
+  if (!defaultValue)
+    return getSnapshot().useWebDav;
   return getInstance()
       ->value(SettingsConstants::useWebDav, defaultValue)
       .toBool();
 }
 void QtPassSettings::setUseWebDav(const bool &useWebDav) {
-  getInstance()->setValue(SettingsConstants::useWebDav, useWebDav);
+  snapshot.useWebDav = useWebDav;
+  setSetting(SettingsConstants::useWebDav, useWebDav);
 }
 
 QString QtPassSettings::getWebDavUrl(const QString &defaultValue) {
@@ -343,7 +457,7 @@ QString QtPassSettings::getWebDavUrl(const QString &defaultValue) {
       .toString();
 }
 void QtPassSettings::setWebDavUrl(const QString &webDavUrl) {
-  getInstance()->setValue(SettingsConstants::webDavUrl, webDavUrl);
+  setSetting(SettingsConstants::webDavUrl, webDavUrl);
 }
 
 QString QtPassSettings::getWebDavUser(const QString &defaultValue) {
@@ -352,7 +466,7 @@ QString QtPassSettings::getWebDavUser(const QString &defaultValue) {
       .toString();
 }
 void QtPassSettings::setWebDavUser(const QString &webDavUser) {
-  getInstance()->setValue(SettingsConstants::webDavUser, webDavUser);
+  setSetting(SettingsConstants::webDavUser, webDavUser);
 }
 
 QString QtPassSettings::getWebDavPassword(const QString &defaultValue) {
@@ -361,7 +475,7 @@ QString QtPassSettings::getWebDavPassword(const QString &defaultValue) {
       .toString();
 }
 void QtPassSettings::setWebDavPassword(const QString &webDavPassword) {
-  getInstance()->setValue(SettingsConstants::webDavPassword, webDavPassword);
+  setSetting(SettingsConstants::webDavPassword, webDavPassword);
 }
 
 QString QtPassSettings::getProfile(const QString &defaultValue) {
@@ -370,22 +484,28 @@ QString QtPassSettings::getProfile(const QString &defaultValue) {
       .toString();
 }
 void QtPassSettings::setProfile(const QString &profile) {
-  getInstance()->setValue(SettingsConstants::profile, profile);
+  setSetting(SettingsConstants::profile, profile);
 }
 
 bool QtPassSettings::isUseGit(const bool &defaultValue) {
+  if (!defaultValue)
+    return getSnapshot().useGit;
   return getInstance()->value(SettingsConstants::useGit, defaultValue).toBool();
 }
 void QtPassSettings::setUseGit(const bool &useGit) {
-  getInstance()->setValue(SettingsConstants::useGit, useGit);
+  snapshot.useGit = useGit;
+  setSetting(SettingsConstants::useGit, useGit);
 }
 
 bool QtPassSettings::isUseOtp(const bool &defaultValue) {
+  if (!defaultValue)
+    return getSnapshot().useOtp;
   return getInstance()->value(SettingsConstants::useOtp, defaultValue).toBool();
 }
 
 void QtPassSettings::setUseOtp(const bool &useOtp) {
-  getInstance()->setValue(SettingsConstants::useOtp, useOtp);
+  snapshot.useOtp = useOtp;
+  setSetting(SettingsConstants::useOtp, useOtp);
 }
 
 bool QtPassSettings::isUsePwgen(const bool &defaultValue) {
@@ -394,7 +514,7 @@ bool QtPassSettings::isUsePwgen(const bool &defaultValue) {
       .toBool();
 }
 void QtPassSettings::setUsePwgen(const bool &usePwgen) {
-  getInstance()->setValue(SettingsConstants::usePwgen, usePwgen);
+  setSetting(SettingsConstants::usePwgen, usePwgen);
 }
 
 bool QtPassSettings::isAvoidCapitals(const bool &defaultValue) {
@@ -403,7 +523,7 @@ bool QtPassSettings::isAvoidCapitals(const bool &defaultValue) {
       .toBool();
 }
 void QtPassSettings::setAvoidCapitals(const bool &avoidCapitals) {
-  getInstance()->setValue(SettingsConstants::avoidCapitals, avoidCapitals);
+  setSetting(SettingsConstants::avoidCapitals, avoidCapitals);
 }
 
 bool QtPassSettings::isAvoidNumbers(const bool &defaultValue) {
@@ -412,7 +532,7 @@ bool QtPassSettings::isAvoidNumbers(const bool &defaultValue) {
       .toBool();
 }
 void QtPassSettings::setAvoidNumbers(const bool &avoidNumbers) {
-  getInstance()->setValue(SettingsConstants::avoidNumbers, avoidNumbers);
+  setSetting(SettingsConstants::avoidNumbers, avoidNumbers);
 }
 
 bool QtPassSettings::isLessRandom(const bool &defaultValue) {
@@ -421,7 +541,7 @@ bool QtPassSettings::isLessRandom(const bool &defaultValue) {
       .toBool();
 }
 void QtPassSettings::setLessRandom(const bool &lessRandom) {
-  getInstance()->setValue(SettingsConstants::lessRandom, lessRandom);
+  setSetting(SettingsConstants::lessRandom, lessRandom);
 }
 
 bool QtPassSettings::isUseSymbols(const bool &defaultValue) {
@@ -430,19 +550,18 @@ bool QtPassSettings::isUseSymbols(const bool &defaultValue) {
       .toBool();
 }
 void QtPassSettings::setUseSymbols(const bool &useSymbols) {
-  getInstance()->setValue(SettingsConstants::useSymbols, useSymbols);
+  setSetting(SettingsConstants::useSymbols, useSymbols);
 }
 
 void QtPassSettings::setPasswordLength(const int &passwordLength) {
-  getInstance()->setValue(SettingsConstants::passwordLength, passwordLength);
+  setSetting(SettingsConstants::passwordLength, passwordLength);
 }
 void QtPassSettings::setPasswordCharsselection(
     const int &passwordCharsselection) {
-  getInstance()->setValue(SettingsConstants::passwordCharsselection,
-                          passwordCharsselection);
+  setSetting(SettingsConstants::passwordCharsselection, passwordCharsselection);
 }
 void QtPassSettings::setPasswordChars(const QString &passwordChars) {
-  getInstance()->setValue(SettingsConstants::passwordChars, passwordChars);
+  setSetting(SettingsConstants::passwordChars, passwordChars);
 }
 
 bool QtPassSettings::isUseTrayIcon(const bool &defaultValue) {
@@ -451,7 +570,7 @@ bool QtPassSettings::isUseTrayIcon(const bool &defaultValue) {
       .toBool();
 }
 void QtPassSettings::setUseTrayIcon(const bool &useTrayIcon) {
-  getInstance()->setValue(SettingsConstants::useTrayIcon, useTrayIcon);
+  setSetting(SettingsConstants::useTrayIcon, useTrayIcon);
 }
 
 bool QtPassSettings::isHideOnClose(const bool &defaultValue) {
@@ -460,7 +579,7 @@ bool QtPassSettings::isHideOnClose(const bool &defaultValue) {
       .toBool();
 }
 void QtPassSettings::setHideOnClose(const bool &hideOnClose) {
-  getInstance()->setValue(SettingsConstants::hideOnClose, hideOnClose);
+  setSetting(SettingsConstants::hideOnClose, hideOnClose);
 }
 
 bool QtPassSettings::isStartMinimized(const bool &defaultValue) {
@@ -469,7 +588,7 @@ bool QtPassSettings::isStartMinimized(const bool &defaultValue) {
       .toBool();
 }
 void QtPassSettings::setStartMinimized(const bool &startMinimized) {
-  getInstance()->setValue(SettingsConstants::startMinimized, startMinimized);
+  setSetting(SettingsConstants::startMinimized, startMinimized);
 }
 
 bool QtPassSettings::isAlwaysOnTop(const bool &defaultValue) {
@@ -478,53 +597,76 @@ bool QtPassSettings::isAlwaysOnTop(const bool &defaultValue) {
       .toBool();
 }
 void QtPassSettings::setAlwaysOnTop(const bool &alwaysOnTop) {
-  getInstance()->setValue(SettingsConstants::alwaysOnTop, alwaysOnTop);
+  setSetting(SettingsConstants::alwaysOnTop, alwaysOnTop);
 }
 
 bool QtPassSettings::isAutoPull(const bool &defaultValue) {
+  if (!defaultValue)
+    return getSnapshot().autoPull;
   return getInstance()
       ->value(SettingsConstants::autoPull, defaultValue)
       .toBool();
 }
 void QtPassSettings::setAutoPull(const bool &autoPull) {
-  getInstance()->setValue(SettingsConstants::autoPull, autoPull);
+  snapshot.autoPull = autoPull;
+  setSetting(SettingsConstants::autoPull, autoPull);
 }
 
 bool QtPassSettings::isAutoPush(const bool &defaultValue) {
+  if (!defaultValue)
+    return getSnapshot().autoPush;
   return getInstance()
       ->value(SettingsConstants::autoPush, defaultValue)
       .toBool();
 }
 void QtPassSettings::setAutoPush(const bool &autoPush) {
-  getInstance()->setValue(SettingsConstants::autoPush, autoPush);
+  snapshot.autoPush = autoPush;
+  setSetting(SettingsConstants::autoPush, autoPush);
 }
 
 QString QtPassSettings::getPassTemplate(const QString &defaultValue) {
+  if (defaultValue.isEmpty())
+    return getSnapshot().passTemplate;
   return getInstance()
       ->value(SettingsConstants::passTemplate, defaultValue)
       .toString();
 }
 void QtPassSettings::setPassTemplate(const QString &passTemplate) {
-  getInstance()->setValue(SettingsConstants::passTemplate, passTemplate);
+  snapshot.passTemplate = passTemplate;
+  setSetting(SettingsConstants::passTemplate, passTemplate);
 }
 
 bool QtPassSettings::isUseTemplate(const bool &defaultValue) {
+  if (!defaultValue)
+    return getSnapshot().useTemplate;
   return getInstance()
       ->value(SettingsConstants::useTemplate, defaultValue)
       .toBool();
 }
 void QtPassSettings::setUseTemplate(const bool &useTemplate) {
-  getInstance()->setValue(SettingsConstants::useTemplate, useTemplate);
+  snapshot.useTemplate = useTemplate;
+  setSetting(SettingsConstants::useTemplate, useTemplate);
 }
 
 bool QtPassSettings::isTemplateAllFields(const bool &defaultValue) {
+  if (!defaultValue)
+    return getSnapshot().templateAllFields;
   return getInstance()
       ->value(SettingsConstants::templateAllFields, defaultValue)
       .toBool();
 }
 void QtPassSettings::setTemplateAllFields(const bool &templateAllFields) {
-  getInstance()->setValue(SettingsConstants::templateAllFields,
-                          templateAllFields);
+  snapshot.templateAllFields = templateAllFields;
+  setSetting(SettingsConstants::templateAllFields, templateAllFields);
+}
+
+bool QtPassSettings::isUseFieldIndex(const bool &defaultValue) {
+  return getInstance()
+      ->value(SettingsConstants::useFieldIndex, defaultValue)
+      .toBool();
+}
+void QtPassSettings::setUseFieldIndex(const bool &useFieldIndex) {
+  setSetting(SettingsConstants::useFieldIndex, useFieldIndex);
 }
 
 RealPass *QtPassSettings::getRealPass() { return &realPass; }
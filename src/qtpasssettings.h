@@ -6,6 +6,7 @@
 #include "passwordconfiguration.h"
 #include "realpass.h"
 #include "settingsconstants.h"
+#include "settingssnapshot.h"
 
 #include <QByteArray>
 #include <QHash>
@@ -17,8 +18,14 @@
 /*!
     \class QtPassSettings
     \brief Singleton that stores qtpass' settings, saves and loads config
+
+    Frequently used values are also kept in a typed SettingsSnapshot, getters
+    called with their default argument are answered from there. Setters keep
+    the snapshot current and emit settingChanged().
 */
 class QtPassSettings : public QSettings {
+  Q_OBJECT
+
 private:
   explicit QtPassSettings();
 
@@ -36,8 +43,16 @@ private:
   static RealPass realPass;
   static ImitatePass imitatePass;
 
+  static bool snapshotLoaded;
+  static SettingsSnapshot snapshot;
+
+  static void loadSnapshot();
+  static QString normalizePassStore(QString passStore);
+  static void setSetting(const QString &key, const QVariant &value);
+
 public:
   static QtPassSettings *getInstance();
+  static const SettingsSnapshot &getSnapshot();
 
   static QString
   getVersion(const QString &defaultValue = QVariant().toString());
@@ -194,12 +209,22 @@ public:
   isTemplateAllFields(const bool &defaultValue = QVariant().toBool());
   static void setTemplateAllFields(const bool &templateAllFields);
 
+  static bool isUseFieldIndex(const bool &defaultValue = QVariant().toBool());
+  static void setUseFieldIndex(const bool &useFieldIndex);
+
   static QHash<QString, QString> getProfiles();
   static void setProfiles(const QHash<QString, QString> &profiles);
 
   static Pass *getPass();
   static RealPass *getRealPass();
   static ImitatePass *getImitatePass();
+
+signals:
+  /**
+   * @brief settingChanged emitted after a setting has been written
+   * @param key the SettingsConstants name of the setting
+   */
+  void settingChanged(const QString &key);
 };
 
 #endif // QTPASSSETTINGS_H
@@ -0,0 +1,128 @@
+#include "quickopen.h"
+#include "fieldindex.h"
+#include "storeindex.h"
+#include "tracer.h"
+#include "urlmatcher.h"
+
+#include <QApplication>
+#include <QCursor>
+#include <QDesktopWidget>
+#include <QKeyEvent>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QVBoxLayout>
+
+/**
+ * @brief QuickOpen::QuickOpen the popup, hidden until popup() is called
+ * @param storeIndex    entries of the store
+ * @param fieldIndex    indexed fields, searched when it is not empty
+ * @param urlMatcher    kept up to date by the owner
+ * @param parent
+ */
+QuickOpen::QuickOpen(StoreIndex *storeIndex, FieldIndex *fieldIndex,
+                     const UrlMatcher *urlMatcher, QWidget *parent)
+    : QFrame(parent, Qt::Popup), m_storeIndex(storeIndex),
+      m_fieldIndex(fieldIndex), m_urlMatcher(urlMatcher),
+      m_rankerValid(false) {
+  setFrameStyle(QFrame::StyledPanel | QFrame::Raised);
+  QVBoxLayout *layout = new QVBoxLayout(this);
+  layout->setContentsMargins(4, 4, 4, 4);
+  m_query = new QLineEdit(this);
+  m_query->setPlaceholderText(tr("Find an entry, Enter copies its password"));
+  m_query->installEventFilter(this);
+  layout->addWidget(m_query);
+  m_results = new QListWidget(this);
+  m_results->setUniformItemSizes(true);
+  m_results->setFocusPolicy(Qt::NoFocus);
+  layout->addWidget(m_results);
+  resize(480, 360);
+
+  connect(m_query, &QLineEdit::textChanged, this, &QuickOpen::search);
+  connect(m_query, &QLineEdit::returnPressed, this, &QuickOpen::accept);
+  connect(m_results, &QListWidget::itemActivated, this, &QuickOpen::accept);
+  connect(m_storeIndex, &StoreIndex::changed, this,
+          [this]() { m_rankerValid = false; });
+}
+
+/**
+ * @brief QuickOpen::popup show the popup near the top of the screen the
+ * mouse is on, with the last query selected so typing replaces it
+ */
+void QuickOpen::popup() {
+  QRect screen = QApplication::desktop()->availableGeometry(QCursor::pos());
+  move(screen.x() + (screen.width() - width()) / 2,
+       screen.y() + screen.height() / 5);
+  search(m_query->text());
+  show();
+  raise();
+  activateWindow();
+  m_query->setFocus();
+  m_query->selectAll();
+}
+
+/**
+ * @brief QuickOpen::search list the best entries for the text typed so far
+ * @param text
+ */
+void QuickOpen::search(const QString &text) {
+  Tracer::Span span("quick open", "ui");
+  span.arg("length", text.length());
+  if (!m_rankerValid) {
+    m_ranker.setEntries(m_storeIndex->entries());
+    m_rankerValid = true;
+  }
+  QStringList found;
+  if (UrlMatcher::looksLikeUrl(text))
+    found = m_urlMatcher->match(text, maxResults);
+  if (found.isEmpty() && !m_fieldIndex->isEmpty() &&
+      FieldIndex::isFieldQuery(text))
+    found = m_fieldIndex->search(text, m_storeIndex->entries())
+                .mid(0, maxResults);
+  else if (found.isEmpty())
+    found = m_ranker.rank(text, maxResults);
+  span.arg("results", found.size());
+
+  m_results->clear();
+  m_results->addItems(found);
+  if (m_results->count() > 0)
+    m_results->setCurrentRow(0);
+}
+
+/**
+ * @brief QuickOpen::accept hand the current entry to whoever copies it
+ */
+void QuickOpen::accept() {
+  QListWidgetItem *item = m_results->currentItem();
+  if (item == nullptr)
+    return;
+  QString entry = item->text();
+  hide();
+  emit activated(entry);
+}
+
+/**
+ * @brief QuickOpen::eventFilter walk the results with the arrow keys while
+ * the focus stays in the query, Escape closes the popup
+ * @param watched
+ * @param event
+ * @return
+ */
+bool QuickOpen::eventFilter(QObject *watched, QEvent *event) {
+  if (watched == m_query && event->type() == QEvent::KeyPress) {
+    QKeyEvent *key = static_cast<QKeyEvent *>(event);
+    switch (key->key()) {
+    case Qt::Key_Up:
+    case Qt::Key_Down:
+    case Qt::Key_PageUp:
+    case Qt::Key_PageDown:
+      QApplication::sendEvent(m_results, event);
+      return true;
+    case Qt::Key_Escape:
+      hide();
+      return true;
+    default:
+      break;
+    }
+  }
+  return QFrame::eventFilter(watched, event);
+}
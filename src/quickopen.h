@@ -0,0 +1,59 @@
+#ifndef QUICKOPEN_H
+#define QUICKOPEN_H
+
+#include "entryranker.h"
+
+#include <QFrame>
+
+/*!
+    \class QuickOpen
+    \brief Popup to find an entry by typing and copy its password.
+
+    Searches the in-memory indexes of the main window instead of filtering
+    the tree: the entry paths of StoreIndex ranked by EntryRanker, terms
+    like "login:alice" in the FieldIndex and URLs with the UrlMatcher. Only
+    the best QuickOpen::maxResults entries are listed. Enter, or a double
+    click, emits activated() for the current one and closes the popup.
+ */
+class FieldIndex;
+class QLineEdit;
+class QListWidget;
+class StoreIndex;
+class UrlMatcher;
+class QuickOpen : public QFrame {
+  Q_OBJECT
+
+public:
+  QuickOpen(StoreIndex *storeIndex, FieldIndex *fieldIndex,
+            const UrlMatcher *urlMatcher, QWidget *parent = nullptr);
+
+  static const int maxResults = 20;
+
+public slots:
+  void popup();
+
+signals:
+  /**
+   * @brief activated an entry was picked
+   * @param entry relative entry path without .gpg suffix
+   */
+  void activated(const QString &entry);
+
+protected:
+  bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+  void search(const QString &text);
+  void accept();
+
+private:
+  StoreIndex *m_storeIndex;
+  FieldIndex *m_fieldIndex;
+  const UrlMatcher *m_urlMatcher;
+  EntryRanker m_ranker;
+  bool m_rankerValid;
+  QLineEdit *m_query;
+  QListWidget *m_results;
+};
+
+#endif // QUICKOPEN_H
@@ -0,0 +1,330 @@
+#include "securebuffer.h"
+#include "debughelper.h"
+
+#include <QMutex>
+#include <QVector>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+/*!
+    \class SecureArena
+    \brief Hands out the memory of all secure buffers.
+
+    Small blocks come in power of two sizes from 32 bytes to 64 KiB and are
+    cut from locked chunks of 256 KiB. Released blocks are wiped and kept on
+    a free list of their size, chunks are never given back, so the arena
+    stays as big as the most that was held at once. Bigger blocks get
+    locked pages of their own that are unmapped on release.
+ */
+class SecureArena {
+public:
+  static SecureArena &instance() {
+    static SecureArena arena;
+    return arena;
+  }
+
+  char *allocate(int size, int *capacity) {
+    QMutexLocker lock(&m_mutex);
+    int sizeClass = 0;
+    size_t bytes = minBlock;
+    while (bytes < static_cast<size_t>(size) && sizeClass < sizeClasses) {
+      bytes <<= 1;
+      ++sizeClass;
+    }
+    char *data;
+    if (sizeClass == sizeClasses) {
+      bytes = (static_cast<size_t>(size) + m_pageSize - 1) / m_pageSize *
+              m_pageSize;
+      data = map(bytes);
+    } else if (!m_free[sizeClass].isEmpty()) {
+      data = m_free[sizeClass].takeLast();
+    } else {
+      if (!m_chunk || m_chunkUsed + bytes > chunkSize) {
+        m_chunk = map(chunkSize);
+        m_chunkUsed = 0;
+      }
+      data = m_chunk ? m_chunk + m_chunkUsed : nullptr;
+      m_chunkUsed += bytes;
+    }
+    Q_CHECK_PTR(data);
+    *capacity = static_cast<int>(bytes);
+    m_live += *capacity;
+    return data;
+  }
+
+  void release(char *data, int capacity) {
+    SecureBuffer::wipe(data, static_cast<size_t>(capacity));
+    QMutexLocker lock(&m_mutex);
+    m_live -= capacity;
+    if (static_cast<size_t>(capacity) > minBlock << (sizeClasses - 1)) {
+      unmap(data, static_cast<size_t>(capacity));
+      return;
+    }
+    int sizeClass = 0;
+    while ((minBlock << sizeClass) < static_cast<size_t>(capacity))
+      ++sizeClass;
+    m_free[sizeClass].append(data);
+  }
+
+  qint64 live() {
+    QMutexLocker lock(&m_mutex);
+    return m_live;
+  }
+
+  bool locked() {
+    QMutexLocker lock(&m_mutex);
+    return m_locked;
+  }
+
+private:
+  static const size_t minBlock = 32;
+  static const int sizeClasses = 12;
+  static const size_t chunkSize = 256 * 1024;
+
+  QMutex m_mutex;
+  QVector<char *> m_free[sizeClasses];
+  char *m_chunk;
+  size_t m_chunkUsed;
+  size_t m_pageSize;
+  qint64 m_live;
+  bool m_locked;
+
+  SecureArena() : m_chunk(nullptr), m_chunkUsed(0), m_live(0) {
+#ifdef Q_OS_UNIX
+    m_pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    m_locked = true;
+#else
+    m_pageSize = 4096;
+    m_locked = false;
+#endif
+  }
+
+  /**
+   * @brief map get locked pages from the system
+   * @param bytes   a multiple of the page size
+   * @return nullptr if there is no memory left
+   */
+  char *map(size_t bytes) {
+#ifdef Q_OS_UNIX
+    void *data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (data == MAP_FAILED)
+      return nullptr;
+    if (mlock(data, bytes) != 0 && m_locked) {
+      dbg() << "secure memory could not be locked, raise RLIMIT_MEMLOCK";
+      m_locked = false;
+    }
+#ifdef MADV_DONTDUMP
+    madvise(data, bytes, MADV_DONTDUMP);
+#endif
+    return static_cast<char *>(data);
+#else
+    return static_cast<char *>(std::malloc(bytes));
+#endif
+  }
+
+  void unmap(char *data, size_t bytes) {
+#ifdef Q_OS_UNIX
+    munlock(data, bytes);
+    munmap(data, bytes);
+#else
+    Q_UNUSED(bytes)
+    std::free(data);
+#endif
+  }
+};
+
+} // namespace
+
+/**
+ * @brief SecureBuffer::SecureBuffer an empty buffer, it takes no memory
+ */
+SecureBuffer::SecureBuffer() : m_data(nullptr), m_size(0), m_capacity(0) {}
+
+/**
+ * @brief SecureBuffer::SecureBuffer copy data in, wipe data yourself if it
+ * is secret too
+ * @param data
+ */
+SecureBuffer::SecureBuffer(const QByteArray &data)
+    : m_data(nullptr), m_size(0), m_capacity(0) {
+  append(data.constData(), data.size());
+}
+
+/**
+ * @brief SecureBuffer::SecureBuffer copy size bytes of data in
+ * @param data
+ * @param size
+ */
+SecureBuffer::SecureBuffer(const char *data, int size)
+    : m_data(nullptr), m_size(0), m_capacity(0) {
+  append(data, size);
+}
+
+/**
+ * @brief SecureBuffer::SecureBuffer take over the content of other, which
+ * is left empty
+ * @param other
+ */
+SecureBuffer::SecureBuffer(SecureBuffer &&other)
+    : m_data(other.m_data), m_size(other.m_size),
+      m_capacity(other.m_capacity) {
+  other.m_data = nullptr;
+  other.m_size = 0;
+  other.m_capacity = 0;
+}
+
+/**
+ * @brief SecureBuffer::operator = wipe the content and take over the one of
+ * other, which is left empty
+ * @param other
+ * @return
+ */
+SecureBuffer &SecureBuffer::operator=(SecureBuffer &&other) {
+  if (this != &other) {
+    clear();
+    m_data = other.m_data;
+    m_size = other.m_size;
+    m_capacity = other.m_capacity;
+    other.m_data = nullptr;
+    other.m_size = 0;
+    other.m_capacity = 0;
+  }
+  return *this;
+}
+
+/**
+ * @brief SecureBuffer::~SecureBuffer wipes the content
+ */
+SecureBuffer::~SecureBuffer() { clear(); }
+
+/**
+ * @brief SecureBuffer::constData
+ * @return the content, not NUL terminated, nullptr when empty
+ */
+const char *SecureBuffer::constData() const { return m_data; }
+
+/**
+ * @brief SecureBuffer::size
+ * @return bytes held
+ */
+int SecureBuffer::size() const { return m_size; }
+
+/**
+ * @brief SecureBuffer::isEmpty
+ * @return
+ */
+bool SecureBuffer::isEmpty() const { return m_size == 0; }
+
+/**
+ * @brief SecureBuffer::indexOf
+ * @param c
+ * @param from
+ * @return where c is first found from from on, -1 if it is not
+ */
+int SecureBuffer::indexOf(char c, int from) const {
+  if (from < 0 || from >= m_size)
+    return -1;
+  const void *found = memchr(m_data + from, c, m_size - from);
+  return found ? static_cast<int>(static_cast<const char *>(found) - m_data)
+               : -1;
+}
+
+/**
+ * @brief SecureBuffer::append add bytes, moving the content to a bigger
+ * block when needed and wiping the old one
+ * @param data
+ * @param size
+ */
+void SecureBuffer::append(const char *data, int size) {
+  if (size <= 0)
+    return;
+  if (m_size + size > m_capacity) {
+    int capacity;
+    char *grown = SecureArena::instance().allocate(m_size + size, &capacity);
+    if (m_data) {
+      memcpy(grown, m_data, m_size);
+      SecureArena::instance().release(m_data, m_capacity);
+    }
+    m_data = grown;
+    m_capacity = capacity;
+  }
+  memcpy(m_data + m_size, data, size);
+  m_size += size;
+}
+
+/**
+ * @brief SecureBuffer::clear wipe the content and give the memory back
+ */
+void SecureBuffer::clear() {
+  if (m_data)
+    SecureArena::instance().release(m_data, m_capacity);
+  m_data = nullptr;
+  m_size = 0;
+  m_capacity = 0;
+}
+
+/**
+ * @brief SecureBuffer::toString decode the content as UTF-8, for showing it
+ * @param size  bytes to decode, -1 for all of them
+ * @return an ordinary string, wipe() it when done
+ */
+QString SecureBuffer::toString(int size) const {
+  if (size < 0 || size > m_size)
+    size = m_size;
+  return QString::fromUtf8(m_data, size);
+}
+
+/**
+ * @brief SecureBuffer::liveBytes
+ * @return arena memory held by buffers right now, over all threads
+ */
+qint64 SecureBuffer::liveBytes() { return SecureArena::instance().live(); }
+
+/**
+ * @brief SecureBuffer::isLocked
+ * @return false once the arena got pages it could not lock
+ */
+bool SecureBuffer::isLocked() { return SecureArena::instance().locked(); }
+
+/**
+ * @brief SecureBuffer::wipe overwrite memory in a way the compiler can not
+ * leave out because it is not read afterwards
+ * @param data
+ * @param size
+ */
+void SecureBuffer::wipe(void *data, size_t size) {
+  volatile char *bytes = static_cast<volatile char *>(data);
+  while (size--)
+    *bytes++ = 0;
+}
+
+/**
+ * @brief SecureBuffer::wipe overwrite a string before letting go of it. A
+ * string that shares its data with another one is only let go of, the
+ * other one still needs the content.
+ * @param text
+ */
+void SecureBuffer::wipe(QString *text) {
+  if (!text->isEmpty() && text->isDetached())
+    wipe(text->data(), static_cast<size_t>(text->size()) * sizeof(QChar));
+  text->clear();
+}
+
+/**
+ * @brief SecureBuffer::wipe overwrite bytes before letting go of them, like
+ * wipe(QString *)
+ * @param data
+ */
+void SecureBuffer::wipe(QByteArray *data) {
+  if (!data->isEmpty() && data->isDetached())
+    wipe(data->data(), static_cast<size_t>(data->size()));
+  data->clear();
+}
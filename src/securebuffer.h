@@ -0,0 +1,57 @@
+#ifndef SECUREBUFFER_H
+#define SECUREBUFFER_H
+
+#include <QByteArray>
+#include <QString>
+
+/*!
+    \class SecureBuffer
+    \brief Holds decrypted content in memory that is locked and wiped.
+
+    The bytes live in an arena of pages that are locked with mlock, so they
+    are never written to swap, and left out of core dumps where the system
+    supports that. When a buffer is cleared, destroyed or grows, the memory
+    it gave up is overwritten before it goes back to the arena. Where pages
+    can not be locked, because the limit for locked memory is reached or
+    the system has no mlock, the buffer still wipes.
+
+    A buffer can be moved but not copied, so passing it on never leaves a
+    second copy behind. Whatever is turned into a QString for a widget is
+    out of its reach; wipe() that string once it is no longer needed.
+
+    liveBytes() counts the bytes that buffers hold right now, so tests can
+    check that nothing is kept longer than it should be.
+ */
+class SecureBuffer {
+public:
+  SecureBuffer();
+  explicit SecureBuffer(const QByteArray &data);
+  SecureBuffer(const char *data, int size);
+  SecureBuffer(SecureBuffer &&other);
+  SecureBuffer &operator=(SecureBuffer &&other);
+  ~SecureBuffer();
+
+  const char *constData() const;
+  int size() const;
+  bool isEmpty() const;
+  int indexOf(char c, int from = 0) const;
+
+  void append(const char *data, int size);
+  void clear();
+  QString toString(int size = -1) const;
+
+  static qint64 liveBytes();
+  static bool isLocked();
+  static void wipe(void *data, size_t size);
+  static void wipe(QString *text);
+  static void wipe(QByteArray *data);
+
+private:
+  Q_DISABLE_COPY(SecureBuffer)
+
+  char *m_data;
+  int m_size;
+  int m_capacity;
+};
+
+#endif // SECUREBUFFER_H
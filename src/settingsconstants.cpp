@@ -63,4 +63,5 @@ const QString SettingsConstants::autoPush = "autoPush";
 const QString SettingsConstants::passTemplate = "passTemplate";
 const QString SettingsConstants::useTemplate = "useTemplate";
 const QString SettingsConstants::templateAllFields = "templateAllFields";
+const QString SettingsConstants::useFieldIndex = "useFieldIndex";
 const QString SettingsConstants::clipBoardType = "clipBoardType";
@@ -59,6 +59,7 @@ public:
   const static QString passTemplate;
   const static QString useTemplate;
   const static QString templateAllFields;
+  const static QString useFieldIndex;
   const static QString clipBoardType;
 
 private:
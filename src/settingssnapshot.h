@@ -0,0 +1,50 @@
+#ifndef SETTINGSSNAPSHOT_H
+#define SETTINGSSNAPSHOT_H
+
+#include "enums.h"
+
+#include <QString>
+
+/*!
+    \struct SettingsSnapshot
+    \brief Typed copy of the settings that are read on hot paths.
+
+    Loaded once by QtPassSettings and updated by its setters, so lookups do
+    not go through QSettings and a QVariant conversion every time.
+ */
+struct SettingsSnapshot {
+  SettingsSnapshot()
+      : usePass(false), useGit(false), useWebDav(false), useOtp(false),
+        useTemplate(false), templateAllFields(false), hidePassword(false),
+        hideContent(false), clipBoardType(Enums::CLIPBOARD_NEVER),
+        useSelection(false), useAutoclear(false), autoclearSeconds(0),
+        useAutoclearPanel(false), autoclearPanelSeconds(0), autoPull(false),
+        autoPush(false) {}
+
+  /**
+   * @brief passStore   password-store path, always ending in a slash
+   */
+  QString passStore;
+  QString passExecutable;
+  QString gitExecutable;
+  QString gpgExecutable;
+  QString passTemplate;
+  bool usePass;
+  bool useGit;
+  bool useWebDav;
+  bool useOtp;
+  bool useTemplate;
+  bool templateAllFields;
+  bool hidePassword;
+  bool hideContent;
+  Enums::clipBoardType clipBoardType;
+  bool useSelection;
+  bool useAutoclear;
+  int autoclearSeconds;
+  bool useAutoclearPanel;
+  int autoclearPanelSeconds;
+  bool autoPull;
+  bool autoPush;
+};
+
+#endif // SETTINGSSNAPSHOT_H
@@ -1,5 +1,6 @@
 #include "singleapplication.h"
 #include "debughelper.h"
+#include "localapiserver.h"
 #include <QLocalSocket>
 
 /**
@@ -11,7 +12,7 @@
  */
 SingleApplication::SingleApplication(int &argc, char *argv[],
                                      const QString uniqueKey)
-    : QApplication(argc, argv), _uniqueKey(uniqueKey) {
+    : QApplication(argc, argv), _uniqueKey(uniqueKey), localServer(nullptr) {
   sharedMemory.setKey(_uniqueKey);
   if (sharedMemory.attach()) {
     _isRunning = true;
@@ -22,33 +23,16 @@ SingleApplication::SingleApplication(int &argc, char *argv[],
       dbg() << "Unable to create single instance.";
       return;
     }
-    // create local server and listen to incomming messages from other
-    // instances.
-    localServer.reset(new QLocalServer(this));
-    connect(localServer.data(), SIGNAL(newConnection()), this,
-            SLOT(receiveMessage()));
-    localServer->listen(_uniqueKey);
+    // create local server and listen to incomming messages and requests
+    // from other instances and clients.
+    localServer = new LocalApiServer(this);
+    connect(localServer, SIGNAL(messageAvailable(QString)), this,
+            SIGNAL(messageAvailable(QString)));
+    if (!localServer->listen(_uniqueKey))
+      dbg() << localServer->errorString().toLatin1();
   }
 }
 
-// public slots.
-
-/**
- * @brief SingleApplication::receiveMessage we have received (a command line)
- * message.
- */
-void SingleApplication::receiveMessage() {
-  QLocalSocket *localSocket = localServer->nextPendingConnection();
-  if (!localSocket->waitForReadyRead(timeout)) {
-    dbg() << localSocket->errorString().toLatin1();
-    return;
-  }
-  QByteArray byteArray = localSocket->readAll();
-  QString message = QString::fromUtf8(byteArray.constData());
-  emit messageAvailable(message);
-  localSocket->disconnectFromServer();
-}
-
 // public functions.
 /**
  * @brief SingleApplication::isRunning is there already a QtPass instance
@@ -57,6 +41,12 @@ void SingleApplication::receiveMessage() {
  */
 bool SingleApplication::isRunning() { return _isRunning; }
 
+/**
+ * @brief SingleApplication::localApi server answering requests on our socket
+ * @return null when another instance is running
+ */
+LocalApiServer *SingleApplication::localApi() { return localServer; }
+
 /**
  * @brief SingleApplication::sendMessage send a message (from commandline) to an
  * already running QtPass instance.
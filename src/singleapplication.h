@@ -2,24 +2,23 @@
 #define SINGLEAPPLICATION_H_
 
 #include <QApplication>
-#include <QLocalServer>
 #include <QSharedMemory>
 
 /*!
     \class SingleApplication
     \brief The SingleApplication class is used for commandline intergration.
 
-    This class needs a bit of work or possibly replacement.
+    The first instance serves the LocalApi protocol on its socket through a
+    LocalApiServer, later instances pass their command line to it.
  */
+class LocalApiServer;
 class SingleApplication : public QApplication {
   Q_OBJECT
 public:
   SingleApplication(int &argc, char *argv[], const QString uniqueKey);
   bool isRunning();
   bool sendMessage(const QString &message);
-
-public slots:
-  void receiveMessage();
+  LocalApiServer *localApi();
 
 signals:
   /**
@@ -32,7 +31,7 @@ private:
   bool _isRunning;
   QString _uniqueKey;
   QSharedMemory sharedMemory;
-  QScopedPointer<QLocalServer> localServer;
+  LocalApiServer *localServer;
 
   static const int timeout = 1000;
 };
@@ -20,11 +20,26 @@ SOURCES   += mainwindow.cpp \
              qtpasssettings.cpp \
              settingsconstants.cpp \
              pass.cpp \
+             passrequest.cpp \
              realpass.cpp \
              imitatepass.cpp \
              executor.cpp \
-             simpletransaction.cpp \
-             filecontent.cpp
+             transaction.cpp \
+             tracer.cpp \
+             startupprofile.cpp \
+             webdavsync.cpp \
+             copyengine.cpp \
+             folderscan.cpp \
+             importreader.cpp \
+             tarwriter.cpp \
+             securebuffer.cpp \
+             fieldindex.cpp \
+             urlmatcher.cpp \
+             entryranker.cpp \
+             quickopen.cpp \
+             filecontent.cpp \
+             storeindex.cpp \
+             localapi.cpp
 
 HEADERS   += mainwindow.h \
              configdialog.h \
@@ -41,13 +56,29 @@ HEADERS   += mainwindow.h \
              enums.h \
              settingsconstants.h \
              pass.h \
+             passrequest.h \
              realpass.h \
              imitatepass.h \
              debughelper.h \
              executor.h \
-             simpletransaction.h \
+             transaction.h \
+             tracer.h \
+             startupprofile.h \
+             webdavsync.h \
+             copyengine.h \
+             folderscan.h \
+             importreader.h \
+             tarwriter.h \
+             securebuffer.h \
+             fieldindex.h \
+             urlmatcher.h \
+             entryranker.h \
+             quickopen.h \
              filecontent.h \
              passwordconfiguration.h \
+             settingssnapshot.h \
+             storeindex.h \
+             localapi.h \
              userinfo.h
 
 FORMS     += mainwindow.ui \
@@ -64,8 +95,12 @@ QMAKE_EXTRA_COMPILERS += updateqm
 PRE_TARGETDEPS += compiler_updateqm_make_all
 
 !nosingleapp {
-    SOURCES += singleapplication.cpp
-    HEADERS += singleapplication.h
+    SOURCES += singleapplication.cpp \
+               localapiserver.cpp \
+               daemon.cpp
+    HEADERS += singleapplication.h \
+               localapiserver.h \
+               daemon.h
 }
 
 RESOURCES   += ../resources.qrc
@@ -0,0 +1,80 @@
+#include "startupprofile.h"
+#include "tracer.h"
+#include <QTextStream>
+
+QElapsedTimer StartupProfile::m_clock;
+qint64 StartupProfile::m_last = 0;
+qint64 StartupProfile::m_interactive = -1;
+QList<QPair<QString, qint64>> StartupProfile::m_phases;
+bool StartupProfile::m_enabled = false;
+
+/**
+ * @brief StartupProfile::start the process is up, called first thing in main
+ */
+void StartupProfile::start() {
+  m_clock.start();
+  m_last = 0;
+}
+
+/**
+ * @brief StartupProfile::setEnabled print the phases on finish()
+ * @param enabled
+ */
+void StartupProfile::setEnabled(bool enabled) { m_enabled = enabled; }
+
+/**
+ * @brief StartupProfile::isEnabled
+ * @return whether --profile-startup was given
+ */
+bool StartupProfile::isEnabled() { return m_enabled; }
+
+/**
+ * @brief StartupProfile::phase the work since the previous phase is done
+ * @param name  what that work was
+ */
+void StartupProfile::phase(const QString &name) {
+  if (!m_clock.isValid())
+    return;
+  qint64 now = m_clock.nsecsElapsed() / 1000;
+  if (m_enabled)
+    m_phases.append(qMakePair(name, now - m_last));
+  if (Tracer::isEnabled()) {
+    qint64 end = Tracer::now();
+    Tracer::complete(name, "startup", end - (now - m_last), now - m_last);
+  }
+  m_last = now;
+}
+
+/**
+ * @brief StartupProfile::interactive the window has been painted for the
+ * first time
+ */
+void StartupProfile::interactive() {
+  phase("first paint");
+  m_interactive = m_last;
+}
+
+/**
+ * @brief StartupProfile::finish the deferred work is done too, print the
+ * phases if asked for
+ */
+void StartupProfile::finish() {
+  phase("deferred");
+  if (!m_enabled)
+    return;
+  QTextStream err(stderr);
+  err << "Startup phases (ms):\n";
+  for (int n = 0; n < m_phases.size(); ++n) {
+    err << "  " << m_phases.at(n).first.leftJustified(24)
+        << QString::number(m_phases.at(n).second / 1000.0, 'f', 1)
+               .rightJustified(9)
+        << "\n";
+  }
+  if (m_interactive >= 0)
+    err << "Interactive after "
+        << QString::number(m_interactive / 1000.0, 'f', 1) << " ms\n";
+  err << "Deferred work done after " << QString::number(m_last / 1000.0, 'f', 1)
+      << " ms\n";
+  m_phases.clear();
+  m_enabled = false;
+}
@@ -0,0 +1,35 @@
+#ifndef STARTUPPROFILE_H
+#define STARTUPPROFILE_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QPair>
+#include <QString>
+
+/*!
+    \class StartupProfile
+    \brief Times the phases of starting up, for --profile-startup.
+
+    Each call to phase() names the work done since the previous one. The
+    phases up to interactive() are what delays the first paint, the ones
+    after it run once the window is shown. finish() prints all of them to
+    stderr. With tracing on, the phases are recorded as spans as well.
+ */
+class StartupProfile {
+public:
+  static void start();
+  static void setEnabled(bool enabled);
+  static bool isEnabled();
+  static void phase(const QString &name);
+  static void interactive();
+  static void finish();
+
+private:
+  static QElapsedTimer m_clock;
+  static qint64 m_last;
+  static qint64 m_interactive;
+  static QList<QPair<QString, qint64>> m_phases;
+  static bool m_enabled;
+};
+
+#endif // STARTUPPROFILE_H
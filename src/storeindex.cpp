@@ -0,0 +1,133 @@
+#include "storeindex.h"
+#include "debughelper.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QRegExp>
+
+/**
+ * @brief StoreIndex::StoreIndex index of a password-store, call setRoot to
+ * point it at one.
+ * @param parent
+ */
+StoreIndex::StoreIndex(QObject *parent) : QObject(parent), m_valid(false) {
+  connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this,
+          &StoreIndex::invalidate);
+}
+
+/**
+ * @brief StoreIndex::setRoot change the store that is indexed, the same
+ * store with or without a trailing slash keeps the entries
+ * @param root  path of the password-store
+ */
+void StoreIndex::setRoot(const QString &root) {
+  QString clean = QDir::cleanPath(root);
+  if (clean == m_root)
+    return;
+  m_root = clean;
+  m_valid = false;
+  emit changed();
+}
+
+/**
+ * @brief StoreIndex::root
+ * @return path of the indexed password-store
+ */
+QString StoreIndex::root() const { return m_root; }
+
+/**
+ * @brief StoreIndex::isValid
+ * @return whether the list is up to date, entries() will not walk the store
+ */
+bool StoreIndex::isValid() const { return m_valid; }
+
+/**
+ * @brief StoreIndex::entries all entries of the store, sorted
+ * @return relative entry paths without .gpg suffix
+ */
+const QStringList &StoreIndex::entries() {
+  if (!m_valid)
+    rebuild();
+  return m_entries;
+}
+
+/**
+ * @brief StoreIndex::others files in the store that are not passwords,
+ * hidden ones like .gpg-id left out
+ * @return relative file paths, sorted
+ */
+const QStringList &StoreIndex::others() {
+  if (!m_valid)
+    rebuild();
+  return m_others;
+}
+
+/**
+ * @brief StoreIndex::search find entries the same way the search box of the
+ * main window does: spaces match anything, case is ignored.
+ * @param query
+ * @return matching entries
+ */
+QStringList StoreIndex::search(const QString &query) {
+  QString pattern = query;
+  pattern.replace(QRegExp(" "), ".*");
+  return entries().filter(QRegExp(pattern, Qt::CaseInsensitive));
+}
+
+/**
+ * @brief StoreIndex::contains
+ * @param entry relative entry path without .gpg suffix
+ * @return whether the entry exists in the store
+ */
+bool StoreIndex::contains(const QString &entry) {
+  return entries().contains(entry);
+}
+
+/**
+ * @brief StoreIndex::invalidate drop the current list, it gets rebuilt when
+ * it is needed next.
+ */
+void StoreIndex::invalidate() {
+  if (!m_valid)
+    return;
+  m_valid = false;
+  emit changed();
+}
+
+/**
+ * @brief StoreIndex::rebuild walk the store and (re)install the directory
+ * watches. Hidden directories like .git are skipped.
+ */
+void StoreIndex::rebuild() {
+  m_entries.clear();
+  m_others.clear();
+  if (!m_watcher.directories().isEmpty())
+    m_watcher.removePaths(m_watcher.directories());
+  m_valid = true;
+
+  QDir root(m_root);
+  if (m_root.isEmpty() || !root.exists())
+    return;
+
+  QStringList dirs(root.absolutePath());
+  QDirIterator it(root.absolutePath(),
+                  QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot,
+                  QDirIterator::Subdirectories);
+  while (it.hasNext()) {
+    it.next();
+    QFileInfo info = it.fileInfo();
+    if (info.isDir()) {
+      dirs.append(info.absoluteFilePath());
+    } else if (info.suffix() == "gpg") {
+      QString entry = root.relativeFilePath(info.absoluteFilePath());
+      entry.chop(4);
+      m_entries.append(entry);
+    } else {
+      m_others.append(root.relativeFilePath(info.absoluteFilePath()));
+    }
+  }
+  m_entries.sort(Qt::CaseInsensitive);
+  m_others.sort(Qt::CaseInsensitive);
+  m_watcher.addPaths(dirs);
+  dbg() << "indexed" << m_entries.size() << "entries in" << m_root;
+}
@@ -0,0 +1,53 @@
+#ifndef STOREINDEX_H
+#define STOREINDEX_H
+
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QStringList>
+
+/*!
+    \class StoreIndex
+    \brief In-memory list of the entries in a password-store.
+
+    Entries are paths relative to the store root without the .gpg suffix,
+    e.g. "web/example.com". Other files in the store, which are not
+    expected there, are kept in others(). The lists are built on first use
+    and rebuilt lazily after a QFileSystemWatcher reports a change in one of
+    the store directories.
+ */
+class StoreIndex : public QObject {
+  Q_OBJECT
+
+public:
+  explicit StoreIndex(QObject *parent = nullptr);
+
+  void setRoot(const QString &root);
+  QString root() const;
+
+  bool isValid() const;
+  const QStringList &entries();
+  const QStringList &others();
+  QStringList search(const QString &query);
+  bool contains(const QString &entry);
+
+public slots:
+  void invalidate();
+
+signals:
+  /**
+   * @brief changed the store changed on disk, entries() will be rebuilt on
+   * next access
+   */
+  void changed();
+
+private:
+  QString m_root;
+  QStringList m_entries;
+  QStringList m_others;
+  bool m_valid;
+  QFileSystemWatcher m_watcher;
+
+  void rebuild();
+};
+
+#endif // STOREINDEX_H
@@ -1,5 +1,6 @@
 #include "storemodel.h"
 #include "qtpasssettings.h"
+#include "util.h"
 
 #include <QDebug>
 #include <QMessageBox>
@@ -22,6 +23,27 @@ operator>>(QDataStream &in,
   return in;
 }
 
+/**
+ * @brief dragAndDropInfos read what is being dragged
+ * @param data
+ * @return one entry per dragged file or folder
+ */
+static QList<dragAndDropInfoPasswordStore>
+dragAndDropInfos(const QMimeData *data) {
+  QList<dragAndDropInfoPasswordStore> infos;
+  QByteArray encodedData =
+      data->data("application/vnd+qtpass.dragAndDropInfoPasswordStore");
+  QDataStream stream(&encodedData, QIODevice::ReadOnly);
+  while (!stream.atEnd()) {
+    dragAndDropInfoPasswordStore info;
+    stream >> info;
+    if (stream.status() != QDataStream::Ok)
+      break;
+    infos << info;
+  }
+  return infos;
+}
+
 /**
  * @brief StoreModel::StoreModel
  * SubClass of QSortFilterProxyModel via
@@ -137,18 +159,20 @@ QStringList StoreModel::mimeTypes() const {
 }
 
 QMimeData *StoreModel::mimeData(const QModelIndexList &indexes) const {
-  dragAndDropInfoPasswordStore info;
-
+  QStringList paths;
+  foreach (const QModelIndex &index, indexes) {
+    if (index.isValid() && index.column() == 0)
+      paths << fs->fileInfo(mapToSource(index)).absoluteFilePath();
+  }
   QByteArray encodedData;
-  // only use the first, otherwise we should enable multiselection
-  QModelIndex index = indexes.at(0);
-  if (index.isValid()) {
-    QModelIndex useIndex = mapToSource(index);
-
-    info.isDir = fs->fileInfo(useIndex).isDir();
-    info.isFile = fs->fileInfo(useIndex).isFile();
-    info.path = fs->fileInfo(useIndex).absoluteFilePath();
-    QDataStream stream(&encodedData, QIODevice::WriteOnly);
+  QDataStream stream(&encodedData, QIODevice::WriteOnly);
+  // what is inside a dragged folder goes along with it
+  foreach (const QString &path, Util::topLevelPaths(paths)) {
+    QFileInfo fileInfo(path);
+    dragAndDropInfoPasswordStore info;
+    info.isDir = fileInfo.isDir();
+    info.isFile = fileInfo.isFile();
+    info.path = path;
     stream << info;
   }
 
@@ -170,19 +194,31 @@ bool StoreModel::canDropMimeData(const QMimeData *data, Qt::DropAction action,
 
   QModelIndex useIndex =
       this->index(parent.row(), parent.column(), parent.parent());
-  QByteArray encodedData =
-      data->data("application/vnd+qtpass.dragAndDropInfoPasswordStore");
-  QDataStream stream(&encodedData, QIODevice::ReadOnly);
-  dragAndDropInfoPasswordStore info;
-  stream >> info;
   if (data->hasFormat("application/vnd+qtpass.dragAndDropInfoPasswordStore") ==
       false)
     return false;
+  QList<dragAndDropInfoPasswordStore> infos = dragAndDropInfos(data);
+  if (infos.isEmpty())
+    return false;
+  dragAndDropInfoPasswordStore info = infos.first();
 
   if (column > 0) {
     return false;
   }
 
+  // several items can only go into a folder, and not into one of them
+  if (infos.size() > 1) {
+    QFileInfo dest = fs->fileInfo(mapToSource(useIndex));
+    if (!dest.isDir())
+      return false;
+    QString destPath = QDir::cleanPath(dest.absoluteFilePath()) + "/";
+    foreach (const dragAndDropInfoPasswordStore &item, infos) {
+      if (destPath.startsWith(QDir::cleanPath(item.path) + "/"))
+        return false;
+    }
+    return true;
+  }
+
   // you can drop a folder on a folder
   if (fs->fileInfo(mapToSource(useIndex)).isDir() && info.isDir) {
     return true;
@@ -207,52 +243,54 @@ bool StoreModel::dropMimeData(const QMimeData *data, Qt::DropAction action,
   if (action == Qt::IgnoreAction) {
     return true;
   }
-  QByteArray encodedData =
-      data->data("application/vnd+qtpass.dragAndDropInfoPasswordStore");
-
-  QDataStream stream(&encodedData, QIODevice::ReadOnly);
-  dragAndDropInfoPasswordStore info;
-  stream >> info;
+  QList<dragAndDropInfoPasswordStore> infos = dragAndDropInfos(data);
+  dragAndDropInfoPasswordStore info = infos.first();
   QModelIndex destIndex =
       this->index(parent.row(), parent.column(), parent.parent());
   QFileInfo destFileinfo = fs->fileInfo(mapToSource(destIndex));
+  if (infos.size() > 1) {
+    // one transaction for all of them
+    QStringList srcs;
+    foreach (const dragAndDropInfoPasswordStore &item, infos)
+      srcs << QDir::cleanPath(item.path);
+    QString destDir = QDir::cleanPath(destFileinfo.absoluteFilePath());
+    Pass *pass = QtPassSettings::getPass();
+    emit dropStarted(action == Qt::MoveAction
+                         ? pass->requestMoveItems(srcs, destDir)
+                         : pass->requestCopyItems(srcs, destDir),
+                     action, srcs.size());
+    return true;
+  }
   QFileInfo srcFileInfo = QFileInfo(info.path);
   QDir qdir;
   QString cleanedSrc = qdir.cleanPath(srcFileInfo.absoluteFilePath());
   QString cleanedDest = qdir.cleanPath(destFileinfo.absoluteFilePath());
+  bool force = false;
   if (info.isDir) {
-    QDir srcDir = QDir(info.path);
     // dropped dir onto dir
-    if (destFileinfo.isDir()) {
-      QDir destDir = QDir(cleanedDest).filePath(srcFileInfo.fileName());
-      QString cleanedDestDir = qdir.cleanPath(destDir.absolutePath());
-      if (action == Qt::MoveAction) {
-        QtPassSettings::getPass()->Move(cleanedSrc, cleanedDestDir);
-      } else if (action == Qt::CopyAction) {
-        QtPassSettings::getPass()->Copy(cleanedSrc, cleanedDestDir);
-      }
-    }
+    if (!destFileinfo.isDir())
+      return true;
+    QDir destDir = QDir(cleanedDest).filePath(srcFileInfo.fileName());
+    cleanedDest = qdir.cleanPath(destDir.absolutePath());
   } else if (info.isFile) {
-    // dropped file onto a directory
-    if (destFileinfo.isDir()) {
-      if (action == Qt::MoveAction) {
-        QtPassSettings::getPass()->Move(cleanedSrc, cleanedDest);
-      } else if (action == Qt::CopyAction) {
-        QtPassSettings::getPass()->Copy(cleanedSrc, cleanedDest);
-      }
-    } else if (destFileinfo.isFile()) {
-      // dropped file onto a file
+    // dropped file onto a file
+    if (destFileinfo.isFile()) {
       int answer = QMessageBox::question(
           0, tr("force overwrite?"),
           tr("overwrite %1 with %2?").arg(cleanedDest).arg(cleanedSrc),
           QMessageBox::Yes | QMessageBox::No);
-      bool force = answer == QMessageBox::Yes;
-      if (action == Qt::MoveAction) {
-        QtPassSettings::getPass()->Move(cleanedSrc, cleanedDest, force);
-      } else if (action == Qt::CopyAction) {
-        QtPassSettings::getPass()->Copy(cleanedSrc, cleanedDest, force);
-      }
+      force = answer == QMessageBox::Yes;
+    } else if (!destFileinfo.isDir()) {
+      return true;
     }
+  } else {
+    return true;
   }
+  // runs in the background, whoever started the drag shows its progress
+  Pass *pass = QtPassSettings::getPass();
+  emit dropStarted(action == Qt::MoveAction
+                       ? pass->requestMove(cleanedSrc, cleanedDest, force)
+                       : pass->requestCopy(cleanedSrc, cleanedDest, force),
+                   action, 1);
   return true;
 }
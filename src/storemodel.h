@@ -8,6 +8,7 @@
     \class StoreModel
     \brief The QSortFilterProxyModel for handling filesystem searches.
  */
+class PassRequest;
 class QFileSystemModel;
 class StoreModel : public QSortFilterProxyModel {
   Q_OBJECT
@@ -35,6 +36,15 @@ public:
                        int column, const QModelIndex &parent) const;
   bool dropMimeData(const QMimeData *data, Qt::DropAction action, int row,
                     int column, const QModelIndex &parent);
+
+signals:
+  /**
+   * @brief dropStarted a drop started moving or copying in the background
+   * @param request     the move or copy, can be cancelled
+   * @param action      Qt::MoveAction or Qt::CopyAction
+   * @param count       number of dropped items
+   */
+  void dropStarted(PassRequest *request, Qt::DropAction action, int count);
 };
 /*!
     \struct dragAndDropInfo
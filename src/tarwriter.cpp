@@ -0,0 +1,187 @@
+#include "tarwriter.h"
+#include "debughelper.h"
+
+#include <QObject>
+
+/**
+ * @brief octal a zero padded octal number that fills a header field,
+ * including the terminating NUL
+ * @param value
+ * @param width     size of the field
+ * @return
+ */
+static QByteArray octal(qint64 value, int width) {
+  return QByteArray::number(value, 8).rightJustified(width - 1, '0') + '\0';
+}
+
+/**
+ * @brief TarWriter::TarWriter call open before adding files
+ */
+TarWriter::TarWriter() : m_files(0) {}
+
+/**
+ * @brief TarWriter::~TarWriter an archive that was not finished is removed
+ */
+TarWriter::~TarWriter() {
+  if (m_file.isOpen()) {
+    m_file.close();
+    m_file.remove();
+  }
+}
+
+/**
+ * @brief TarWriter::partName
+ * @param fileName  name of the archive
+ * @return where the archive is written until it is finished
+ */
+QString TarWriter::partName(const QString &fileName) {
+  return fileName + ".part";
+}
+
+/**
+ * @brief TarWriter::open start a new archive
+ * @param fileName  name of the archive once finished
+ * @return false if it can not be written
+ */
+bool TarWriter::open(const QString &fileName) {
+  m_fileName = fileName;
+  m_files = 0;
+  m_file.setFileName(partName(fileName));
+  if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    m_error = QObject::tr("Could not write %1: %2")
+                  .arg(m_file.fileName())
+                  .arg(m_file.errorString());
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief TarWriter::addFile append a regular file, readable by its owner
+ * only
+ * @param name      path in the archive, "/" separated
+ * @param data
+ * @param modified
+ * @return false on a write error
+ */
+bool TarWriter::addFile(const QString &name, const QByteArray &data,
+                        const QDateTime &modified) {
+  QByteArray path = name.toUtf8();
+  qint64 mtime = modified.toMSecsSinceEpoch() / 1000;
+  if (path.size() > 100) {
+    // split between prefix and name at a slash when that is enough
+    int slash = path.lastIndexOf('/', 155);
+    if (slash <= 0 || path.size() - slash - 1 > 100) {
+      if (!writeEntry("././@LongLink", 'L', path + '\0', mtime))
+        return false;
+      path.truncate(100);
+    }
+  }
+  if (!writeEntry(path, '0', data, mtime))
+    return false;
+  ++m_files;
+  return true;
+}
+
+/**
+ * @brief TarWriter::finish end the archive and give it its name, replacing
+ * an existing file
+ * @return false if that fails, the partial archive is removed
+ */
+bool TarWriter::finish() {
+  bool ok = write(QByteArray(2 * blockSize, '\0')) && m_file.flush();
+  m_file.close();
+  if (ok && QFile::exists(m_fileName) && !QFile::remove(m_fileName)) {
+    m_error = QObject::tr("Could not replace %1").arg(m_fileName);
+    ok = false;
+  }
+  if (ok && !m_file.rename(m_fileName)) {
+    m_error = QObject::tr("Could not write %1: %2")
+                  .arg(m_fileName)
+                  .arg(m_file.errorString());
+    ok = false;
+  }
+  if (!ok)
+    m_file.remove();
+  dbg() << "archived" << m_files << "files in" << m_fileName << ok;
+  return ok;
+}
+
+/**
+ * @brief TarWriter::errorString
+ * @return why the last call failed
+ */
+QString TarWriter::errorString() const { return m_error; }
+
+/**
+ * @brief TarWriter::fileCount
+ * @return files added so far
+ */
+int TarWriter::fileCount() const { return m_files; }
+
+/**
+ * @brief TarWriter::writeEntry write a header and the data, padded to full
+ * blocks
+ * @param name      at most 255 bytes, split into prefix and name if needed
+ * @param type
+ * @param data
+ * @param mtime     seconds since the epoch
+ * @return false on a write error
+ */
+bool TarWriter::writeEntry(const QByteArray &name, char type,
+                           const QByteArray &data, qint64 mtime) {
+  QByteArray prefix;
+  QByteArray base = name;
+  if (name.size() > 100) {
+    int slash = name.lastIndexOf('/', 155);
+    prefix = name.left(slash);
+    base = name.mid(slash + 1);
+  }
+  int padding = (blockSize - data.size() % blockSize) % blockSize;
+  return write(header(base, prefix, type, data.size(), mtime)) &&
+         write(data) && write(QByteArray(padding, '\0'));
+}
+
+/**
+ * @brief TarWriter::write
+ * @param data
+ * @return false on a write error
+ */
+bool TarWriter::write(const QByteArray &data) {
+  if (m_file.write(data) == data.size())
+    return true;
+  m_error = QObject::tr("Could not write %1: %2")
+                .arg(m_file.fileName())
+                .arg(m_file.errorString());
+  return false;
+}
+
+/**
+ * @brief TarWriter::header a ustar header block
+ * @param name      at most 100 bytes
+ * @param prefix    at most 155 bytes
+ * @param type      '0' for a file, 'L' for a GNU long name
+ * @param size
+ * @param mtime
+ * @return
+ */
+QByteArray TarWriter::header(const QByteArray &name, const QByteArray &prefix,
+                             char type, qint64 size, qint64 mtime) {
+  QByteArray block(blockSize, '\0');
+  block.replace(0, name.size(), name);
+  block.replace(100, 8, octal(0600, 8));
+  block.replace(108, 8, octal(0, 8));
+  block.replace(116, 8, octal(0, 8));
+  block.replace(124, 12, octal(size, 12));
+  block.replace(136, 12, octal(mtime, 12));
+  block.replace(148, 8, QByteArray(8, ' '));
+  block[156] = type;
+  block.replace(257, 6, QByteArray("ustar\0", 6));
+  block.replace(263, 2, "00");
+  block.replace(345, prefix.size(), prefix);
+  unsigned int sum = 0;
+  foreach (char c, block)
+    sum += static_cast<unsigned char>(c);
+  block.replace(148, 8, octal(sum, 7) + ' ');
+  return block;
+}
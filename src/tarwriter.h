@@ -0,0 +1,50 @@
+#ifndef TARWRITER_H
+#define TARWRITER_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QString>
+
+/*!
+    \class TarWriter
+    \brief Writes a POSIX ustar archive one file at a time.
+
+    Files are written out as they are added, so the archive can be any size
+    while only the file being added is in memory. The archive is written to
+    "<name>.part" and only renamed to its name by finish(), so a failed or
+    cancelled export never leaves an archive that looks complete.
+
+    Names too long for a ustar header get a GNU long name record, which GNU
+    tar, bsdtar and 7-Zip all read.
+ */
+class TarWriter {
+public:
+  TarWriter();
+  ~TarWriter();
+
+  bool open(const QString &fileName);
+  bool addFile(const QString &name, const QByteArray &data,
+               const QDateTime &modified = QDateTime::currentDateTime());
+  bool finish();
+  QString errorString() const;
+  int fileCount() const;
+
+  static QString partName(const QString &fileName);
+
+private:
+  QString m_fileName;
+  QFile m_file;
+  QString m_error;
+  int m_files;
+
+  bool writeEntry(const QByteArray &name, char type, const QByteArray &data,
+                  qint64 mtime);
+  bool write(const QByteArray &data);
+  static QByteArray header(const QByteArray &name, const QByteArray &prefix,
+                           char type, qint64 size, qint64 mtime);
+
+  static const int blockSize = 512;
+};
+
+#endif // TARWRITER_H
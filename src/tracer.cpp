@@ -0,0 +1,165 @@
+#include "tracer.h"
+#include "debughelper.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+
+QMutex Tracer::m_mutex;
+QElapsedTimer Tracer::m_clock;
+QVector<Tracer::event> Tracer::m_events;
+int Tracer::m_first = 0;
+bool Tracer::m_enabled = false;
+
+/**
+ * @brief Tracer::setEnabled start or stop recording, the clock starts with
+ * the first call
+ * @param enabled
+ */
+void Tracer::setEnabled(bool enabled) {
+  QMutexLocker locker(&m_mutex);
+  if (!m_clock.isValid())
+    m_clock.start();
+  m_enabled = enabled;
+}
+
+/**
+ * @brief Tracer::isEnabled
+ * @return whether spans are recorded
+ */
+bool Tracer::isEnabled() {
+  QMutexLocker locker(&m_mutex);
+  return m_enabled;
+}
+
+/**
+ * @brief Tracer::now
+ * @return microseconds since recording was first enabled, 0 when disabled
+ */
+qint64 Tracer::now() {
+  QMutexLocker locker(&m_mutex);
+  return m_enabled ? m_clock.nsecsElapsed() / 1000 : 0;
+}
+
+/**
+ * @brief Tracer::complete record a span that is over
+ * @param name
+ * @param category  "process", "transaction" or "ui"
+ * @param start     from now()
+ * @param duration  microseconds
+ * @param args      shown with the span, nothing secret
+ * @param lane      trace thread the span is drawn on
+ */
+void Tracer::complete(const QString &name, const QString &category,
+                      qint64 start, qint64 duration, const QVariantMap &args,
+                      int lane) {
+  QMutexLocker locker(&m_mutex);
+  if (!m_enabled)
+    return;
+  event e = {name, category, start, qMax(Q_INT64_C(0), duration), lane, args};
+  if (m_events.size() < maxEvents) {
+    m_events.append(e);
+  } else {
+    // ring buffer, keep the latest spans
+    m_events[m_first] = e;
+    m_first = (m_first + 1) % maxEvents;
+  }
+}
+
+/**
+ * @brief Tracer::count
+ * @return number of recorded spans
+ */
+int Tracer::count() {
+  QMutexLocker locker(&m_mutex);
+  return m_events.size();
+}
+
+/**
+ * @brief Tracer::clear drop all recorded spans
+ */
+void Tracer::clear() {
+  QMutexLocker locker(&m_mutex);
+  m_events.clear();
+  m_first = 0;
+}
+
+/**
+ * @brief Tracer::toJson
+ * @return the recorded spans as Chrome trace event JSON, oldest first
+ */
+QByteArray Tracer::toJson() {
+  QJsonArray events;
+  QMutexLocker locker(&m_mutex);
+  const qint64 pid = QCoreApplication::applicationPid();
+  QJsonObject meta;
+  meta["name"] = "process_name";
+  meta["ph"] = "M";
+  meta["pid"] = pid;
+  meta["args"] = QJsonObject{{"name", "QtPass"}};
+  events.append(meta);
+  for (int n = 0; n < m_events.size(); ++n) {
+    const event &e = m_events.at((m_first + n) % m_events.size());
+    QJsonObject o;
+    o["name"] = e.name;
+    o["cat"] = e.category;
+    o["ph"] = "X";
+    o["ts"] = e.start;
+    o["dur"] = e.duration;
+    o["pid"] = pid;
+    o["tid"] = e.lane;
+    if (!e.args.isEmpty())
+      o["args"] = QJsonObject::fromVariantMap(e.args);
+    events.append(o);
+  }
+  QJsonObject trace;
+  trace["traceEvents"] = events;
+  trace["displayTimeUnit"] = "ms";
+  return QJsonDocument(trace).toJson(QJsonDocument::Compact);
+}
+
+/**
+ * @brief Tracer::write save the recorded spans
+ * @param fileName
+ * @return false if the file could not be written
+ */
+bool Tracer::write(const QString &fileName) {
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    dbg() << "Could not write trace:" << fileName << file.errorString();
+    return false;
+  }
+  return file.write(toJson()) >= 0;
+}
+
+/**
+ * @brief Tracer::Span::Span start a span, nothing is recorded when tracing
+ * is off
+ * @param name
+ * @param category
+ * @param lane
+ */
+Tracer::Span::Span(const QString &name, const QString &category, int lane)
+    : m_name(name), m_category(category), m_lane(lane),
+      m_start(Tracer::isEnabled() ? Tracer::now() : -1) {}
+
+/**
+ * @brief Tracer::Span::~Span record the span
+ */
+Tracer::Span::~Span() {
+  if (m_start >= 0)
+    Tracer::complete(m_name, m_category, m_start, Tracer::now() - m_start,
+                     m_args, m_lane);
+}
+
+/**
+ * @brief Tracer::Span::arg add an argument shown with the span
+ * @param key
+ * @param value
+ */
+void Tracer::Span::arg(const QString &key, const QVariant &value) {
+  if (m_start >= 0)
+    m_args.insert(key, value);
+}
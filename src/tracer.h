@@ -0,0 +1,84 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+/*!
+    \class Tracer
+    \brief Records timed spans of processes and UI stages.
+
+    Spans are kept in memory, up to maxEvents, and written out in the Chrome
+    trace event format so they can be opened in chrome://tracing or
+    Perfetto. Recording is cheap, but off until setEnabled(true), which
+    --trace and the "Save trace" menu entry take care of.
+
+    Span arguments must not contain secrets: app names, sizes, counts and
+    exit codes only, never input, output or search text.
+ */
+class Tracer {
+public:
+  /*!
+      \class Span
+      \brief Records a span from construction to destruction.
+   */
+  class Span {
+  public:
+    Span(const QString &name, const QString &category, int lane = 0);
+    ~Span();
+    void arg(const QString &key, const QVariant &value);
+
+  private:
+    QString m_name;
+    QString m_category;
+    int m_lane;
+    qint64 m_start;
+    QVariantMap m_args;
+  };
+
+  /**
+   * @brief lane  trace threads used to keep concurrent spans apart
+   */
+  enum Lane { UI = 0, EXECUTOR = 1, QUEUE = 2, STEPS = 10 };
+
+  static void setEnabled(bool enabled);
+  static bool isEnabled();
+  static qint64 now();
+  static void complete(const QString &name, const QString &category,
+                       qint64 start, qint64 duration,
+                       const QVariantMap &args = QVariantMap(), int lane = 0);
+  static int count();
+  static void clear();
+  static QByteArray toJson();
+  static bool write(const QString &fileName);
+
+  /**
+   * @brief maxEvents   older spans are dropped beyond this
+   */
+  static const int maxEvents = 100000;
+
+private:
+  /*!
+      \struct event
+      \brief One complete ("X") trace event, times in microseconds.
+   */
+  struct event {
+    QString name;
+    QString category;
+    qint64 start;
+    qint64 duration;
+    int lane;
+    QVariantMap args;
+  };
+
+  static QMutex m_mutex;
+  static QElapsedTimer m_clock;
+  static QVector<event> m_events;
+  static int m_first;
+  static bool m_enabled;
+};
+
+#endif // TRACER_H
@@ -0,0 +1,1100 @@
+#include "transaction.h"
+#include "debughelper.h"
+#include "executor.h"
+#include "securebuffer.h"
+#include "tracer.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QThread>
+#include <algorithm>
+
+/*!
+    \class Transaction::Work
+    \brief Runs a job on the pool of a transaction and hands the result to
+    Transaction::workFinished, from the event loop.
+ */
+class Transaction::Work : public QRunnable {
+public:
+  Work(Transaction *transaction, int id, const Job &job)
+      : m_transaction(transaction), m_id(id), m_job(job) {}
+  void run() Q_DECL_OVERRIDE {
+    QString error;
+    bool ok = m_job(&error);
+    QMetaObject::invokeMethod(m_transaction, "workFinished",
+                              Qt::QueuedConnection, Q_ARG(int, m_id),
+                              Q_ARG(bool, ok), Q_ARG(QString, error));
+  }
+
+private:
+  Transaction *m_transaction;
+  int m_id;
+  Job m_job;
+};
+
+/**
+ * @brief Transaction::Transaction empty transaction, add steps and start it
+ * @param parent
+ */
+Transaction::Transaction(QObject *parent)
+    : QObject(parent), m_lastWork(0),
+      m_maxParallel(qMax(1, QThread::idealThreadCount())), m_stepTimeout(0),
+      m_timeoutCount(0), m_running(0), m_jobs(0), m_backingUp(0),
+      m_stepsDone(0), m_started(false), m_ready(false), m_recording(false),
+      m_scheduling(false), m_failed(false), m_done(false), m_reported(false),
+      m_exitCode(0) {}
+
+/**
+ * @brief Transaction::~Transaction wait for the jobs that are running
+ */
+Transaction::~Transaction() { m_pool.waitForDone(); }
+
+/**
+ * @brief Transaction::addProcess add an external command
+ * @param app   executable, relative to the application directory or in PATH
+ * @param args
+ * @param after steps that have to finish before this one starts
+ * @param input data to write to stdin
+ * @return id of the step
+ */
+int Transaction::addProcess(const QString &app, const QStringList &args,
+                            const QList<int> &after,
+                            const QByteArray &input) {
+  step s;
+  // an empty app is a step that does nothing, like Executor::execute
+  if (!app.isEmpty())
+    s.app = QDir(QCoreApplication::applicationDirPath()).absoluteFilePath(app);
+  s.args = args;
+  s.input = input;
+  return addStep(s, after);
+}
+
+/**
+ * @brief Transaction::addTask add work done in-process, from the event loop
+ * @param task
+ * @param after steps that have to finish before this one runs
+ * @return id of the step
+ */
+int Transaction::addTask(const Task &task, const QList<int> &after) {
+  step s;
+  s.task = task;
+  return addStep(s, after);
+}
+
+/**
+ * @brief Transaction::addJob add file work that is done on a thread of the
+ * transaction, so it does not block the event loop
+ * @param job
+ * @param after steps that have to finish before this one runs
+ * @return id of the step
+ */
+int Transaction::addJob(const Job &job, const QList<int> &after) {
+  step s;
+  s.job = job;
+  return addStep(s, after);
+}
+
+/**
+ * @brief Transaction::addStep common part of addProcess, addTask and addJob
+ * @param s
+ * @param after
+ * @return id of the step
+ */
+int Transaction::addStep(const step &s, const QList<int> &after) {
+  int n = m_steps.size();
+  m_steps.append(s);
+  step &added = m_steps[n];
+  added.inputFrom = -1;
+  added.started = -1;
+  added.bytesIn = 0;
+  added.pending = 0;
+  added.optional = false;
+  added.privateOutput = false;
+  added.prelude = false;
+  added.state = WAITING;
+  added.timedOut = false;
+  added.exitCode = 0;
+  foreach (int d, after)
+    addDependency(n, d);
+  return n;
+}
+
+/**
+ * @brief Transaction::addDependency let a step wait for another one, also
+ * while the transaction runs, as long as the step has not started
+ * @param step
+ * @param after step that has to finish first
+ */
+void Transaction::addDependency(int step, int after) {
+  Q_ASSERT(step >= 0 && step < m_steps.size());
+  Q_ASSERT(after >= 0 && after < m_steps.size() && after != step);
+  if (m_steps.at(step).state != WAITING ||
+      m_steps.at(step).after.contains(after))
+    return;
+  m_steps[step].after.append(after);
+  m_steps[after].dependents.append(step);
+  StepState state = m_steps.at(after).state;
+  if (state == WAITING || state == RUNNING) {
+    ++m_steps[step].pending;
+  } else if (state == FAILED || state == SKIPPED) {
+    m_steps[step].state = SKIPPED;
+    settle(step);
+  } else if (state == DROPPED && m_steps.at(step).inputFrom == after) {
+    m_steps[step].state = DROPPED;
+    settle(step);
+  }
+}
+
+/**
+ * @brief Transaction::setInputFrom write the output of one step to the stdin
+ * of another, instead of its own input. The output becomes private.
+ * @param step
+ * @param from
+ */
+void Transaction::setInputFrom(int step, int from) {
+  m_steps[step].inputFrom = from;
+  m_steps[from].privateOutput = true;
+  addDependency(step, from);
+}
+
+/**
+ * @brief Transaction::setOptional failure of the step does not fail the
+ * transaction, steps reading its output are dropped, other dependents run.
+ * @param step
+ */
+void Transaction::setOptional(int step) { m_steps[step].optional = true; }
+
+/**
+ * @brief Transaction::setPrivateOutput keep the output of the step out of
+ * the result and free it once its dependents are done
+ * @param step
+ */
+void Transaction::setPrivateOutput(int step) {
+  m_steps[step].privateOutput = true;
+}
+
+/**
+ * @brief Transaction::setPrelude run the step before the touched files are
+ * recorded, the other steps wait for it. It must not depend on steps that
+ * are not preludes themselves.
+ * @param step
+ */
+void Transaction::setPrelude(int step) { m_steps[step].prelude = true; }
+
+/**
+ * @brief Transaction::touch the path may be changed by the transaction and
+ * is restored when it fails. Directories are restored with everything below.
+ *
+ * Relative paths are taken from the working directory, which the Executor
+ * only sets right before it starts the transaction, so they are resolved
+ * and recorded when the transaction starts. Paths touched while it runs are
+ * recorded on a thread of the transaction, no step starts until that is
+ * done.
+ * @param path
+ */
+void Transaction::touch(const QString &path) {
+  if (!m_started) {
+    m_touched.append(path);
+    return;
+  }
+  // before m_ready the root is recorded with the others
+  QString root = addRoot(path);
+  if (!root.isEmpty() && m_ready)
+    backupLater(root);
+}
+
+/**
+ * @brief Transaction::addRoot resolve a touched path and keep it, unless it
+ * is below one that is kept already. Roots below it are dropped.
+ *
+ * The roots are kept sorted, so the parents of the path are looked up and
+ * the roots below it follow each other.
+ * @param path
+ * @return the absolute path, empty if it was covered already
+ */
+QString Transaction::addRoot(const QString &path) {
+  QString absolute =
+      QDir::cleanPath(QDir(m_workingDir).absoluteFilePath(path));
+  for (QString dir = absolute; !dir.isEmpty();
+       dir.truncate(qMax(0, dir.lastIndexOf('/')))) {
+    if (std::binary_search(m_touched.constBegin(), m_touched.constEnd(), dir))
+      return QString();
+  }
+  QString prefix = absolute + '/';
+  QStringList::iterator below =
+      std::lower_bound(m_touched.begin(), m_touched.end(), prefix);
+  QStringList::iterator last = below;
+  while (last != m_touched.end() && last->startsWith(prefix))
+    ++last;
+  m_touched.erase(below, last);
+  m_touched.insert(
+      std::lower_bound(m_touched.begin(), m_touched.end(), absolute),
+      absolute);
+  return absolute;
+}
+
+/**
+ * @brief Transaction::backupLater record a path touched while the
+ * transaction runs, on a thread of the transaction. What was recorded
+ * before is kept.
+ * @param root
+ */
+void Transaction::backupLater(const QString &root) {
+  ++m_backingUp;
+  QSharedPointer<QHash<QString, fileBackup>> backups(
+      new QHash<QString, fileBackup>);
+  runInBackground(
+      [root, backups](QString *) {
+        backupTree(root, QSet<QString>(), QString(), backups.data());
+        return true;
+      },
+      [this, backups](bool, const QString &) {
+        --m_backingUp;
+        for (auto it = backups->constBegin(); it != backups->constEnd(); ++it) {
+          if (!m_backups.contains(it.key()))
+            m_backups.insert(it.key(), it.value());
+        }
+        schedule();
+      });
+}
+
+/**
+ * @brief Transaction::addRollback command to run when the transaction
+ * fails, after the touched files are restored, eg. to reset the git index
+ * @param app
+ * @param args
+ */
+void Transaction::addRollback(const QString &app, const QStringList &args) {
+  if (!app.isEmpty())
+    m_rollback.append(qMakePair(app, args));
+}
+
+/**
+ * @brief Transaction::output stdout of a step, for tasks depending on it
+ * @param step
+ * @return
+ */
+QByteArray Transaction::output(int step) const {
+  return m_steps.at(step).output;
+}
+
+/**
+ * @brief Transaction::errorOutput stderr of a step, for tasks depending on it
+ * @param step
+ * @return
+ */
+QByteArray Transaction::errorOutput(int step) const {
+  return m_steps.at(step).errout;
+}
+
+/**
+ * @brief Transaction::setWorkingDirectory
+ * @param dir
+ */
+void Transaction::setWorkingDirectory(const QString &dir) {
+  m_workingDir = dir;
+}
+
+/**
+ * @brief Transaction::setEnvironment environment for the processes
+ * @param env
+ */
+void Transaction::setEnvironment(const QStringList &env) { m_env = env; }
+
+/**
+ * @brief Transaction::setGit the working directory is in a git repository,
+ * tracked files are restored from it instead of from memory
+ * @param executable
+ */
+void Transaction::setGit(const QString &executable) { m_git = executable; }
+
+/**
+ * @brief Transaction::maxParallel
+ * @return how many processes run at the same time at most
+ */
+int Transaction::maxParallel() const { return m_maxParallel; }
+
+/**
+ * @brief Transaction::setMaxParallel defaults to the number of cores
+ * @param count
+ */
+void Transaction::setMaxParallel(int count) { m_maxParallel = qMax(1, count); }
+
+/**
+ * @brief Transaction::setStepTimeout deadline for every process, after
+ * which it is terminated and, if that does not help, killed
+ * @param msecs     0 for no limit
+ */
+void Transaction::setStepTimeout(int msecs) { m_stepTimeout = msecs; }
+
+/**
+ * @brief Transaction::timeoutCount
+ * @return how many processes missed their deadline
+ */
+int Transaction::timeoutCount() const { return m_timeoutCount; }
+
+/**
+ * @brief Transaction::isRunning
+ * @return true from start until finished
+ */
+bool Transaction::isRunning() const { return m_started && !m_reported; }
+
+/**
+ * @brief Transaction::start run the preludes, record the touched files,
+ * then start the other steps
+ */
+void Transaction::start() {
+  if (m_started || m_done)
+    return;
+  m_started = true;
+  const QStringList touched = m_touched;
+  m_touched.clear();
+  foreach (const QString &path, touched)
+    addRoot(path);
+  schedule();
+}
+
+/**
+ * @brief Transaction::record record the touched files once the preludes are
+ * done
+ *
+ * With git, first ask it which touched files differ from HEAD or are not
+ * tracked, only those are read. If that fails everything is read.
+ */
+void Transaction::record() {
+  m_recording = true;
+  const QStringList paths = gitPaths();
+  if (m_git.isEmpty() || paths.isEmpty()) {
+    startBackup(QSet<QString>(), QString());
+    return;
+  }
+  QStringList diff = {"diff", "--name-only", "--relative", "-z", "HEAD", "--"};
+  QStringList others = {"ls-files", "-z", "--others", "--"};
+  runHelper(m_git, diff + paths, [=](bool ok, const QByteArray &changed) {
+    if (!ok) {
+      // not a repository or nothing committed yet
+      startBackup(QSet<QString>(), QString());
+      return;
+    }
+    runHelper(m_git, others + paths, [=](bool ok, const QByteArray &untracked) {
+      if (ok)
+        startBackup(absolutePaths(changed + untracked),
+                    QDir::cleanPath(m_workingDir));
+      else
+        startBackup(QSet<QString>(), QString());
+    });
+  });
+}
+
+/**
+ * @brief Transaction::absolutePaths
+ * @param names   paths relative to the working directory, as git -z lists
+ *                them
+ * @return
+ */
+QSet<QString> Transaction::absolutePaths(const QByteArray &names) const {
+  QSet<QString> paths;
+  QDir dir(m_workingDir);
+  foreach (const QByteArray &name, names.split('\0')) {
+    if (!name.isEmpty())
+      paths.insert(
+          QDir::cleanPath(dir.absoluteFilePath(QString::fromUtf8(name))));
+  }
+  return paths;
+}
+
+/**
+ * @brief Transaction::gitPaths
+ * @return touched paths in the working directory, relative to it
+ */
+QStringList Transaction::gitPaths() const {
+  QStringList paths;
+  if (m_workingDir.isEmpty())
+    return paths;
+  QString workTree = QDir::cleanPath(m_workingDir);
+  QDir dir(workTree);
+  foreach (const QString &root, m_touched) {
+    if (root == workTree)
+      paths.append(".");
+    else if (isBelow(root, workTree))
+      paths.append(dir.relativeFilePath(root));
+  }
+  return paths;
+}
+
+/**
+ * @brief Transaction::startBackup record the touched files on a thread of
+ * the transaction and start the steps when that is done
+ * @param changed   absolute paths that differ from HEAD or are not tracked
+ * @param workTree  files below it, except those in changed, are left to git,
+ *                  empty to keep everything in memory
+ */
+void Transaction::startBackup(const QSet<QString> &changed,
+                              const QString &workTree) {
+  const QStringList roots = m_touched;
+  QSharedPointer<QHash<QString, fileBackup>> backups(
+      new QHash<QString, fileBackup>);
+  QSharedPointer<QStringList> gitRoots(new QStringList);
+  runInBackground(
+      [roots, changed, workTree, backups, gitRoots](QString *) {
+        foreach (const QString &root, roots) {
+          if (backupTree(root, changed, workTree, backups.data()))
+            gitRoots->append(root);
+        }
+        return true;
+      },
+      [this, backups, gitRoots](bool, const QString &) {
+        m_backups = *backups;
+        m_gitRoots = *gitRoots;
+        m_recording = false;
+        m_ready = true;
+        // touched while the others were recorded
+        foreach (const QString &root, m_touched) {
+          if (!m_backups.contains(root))
+            backupLater(root);
+        }
+        schedule();
+      });
+}
+
+/**
+ * @brief Transaction::cancel do not start anything else and roll back once
+ * the running steps are done
+ */
+void Transaction::cancel() {
+  if (m_done)
+    return;
+  if (!m_failed) {
+    m_failed = true;
+    m_exitCode = -1;
+    m_error = tr("Cancelled").toUtf8();
+  }
+  if (m_started)
+    schedule();
+  else
+    finish();
+}
+
+/**
+ * @brief Transaction::schedule start every step that is ready, as long as
+ * there is room, and finish when nothing runs anymore. Until the touched
+ * files are recorded only the preludes are started.
+ */
+void Transaction::schedule() {
+  if (m_done || m_scheduling || m_recording || m_backingUp > 0)
+    return;
+  m_scheduling = true;
+  bool again = true;
+  // a task may touch paths, their backup has to be done first
+  while (again && !m_failed && m_backingUp == 0) {
+    again = false;
+    for (int n = 0; n < m_steps.size() && !m_failed && m_backingUp == 0;
+         ++n) {
+      const step &s = m_steps.at(n);
+      if (s.state != WAITING || s.pending > 0 || (!m_ready && !s.prelude))
+        continue;
+      if (s.job) {
+        startJob(n);
+        again = true;
+        continue;
+      }
+      if (s.task || s.app.isEmpty()) {
+        // tasks may add steps, look at all of them again
+        runTask(n);
+        again = true;
+        break;
+      }
+      if (m_running < m_maxParallel) {
+        startProcess(n);
+        again = true;
+      }
+    }
+  }
+  m_scheduling = false;
+  if (m_running > 0 || m_jobs > 0 || m_backingUp > 0)
+    return;
+  // also after a failed prelude, the rollback needs the recorded files
+  if (m_ready)
+    finish();
+  else
+    record();
+}
+
+/**
+ * @brief Transaction::startProcess
+ * @param n
+ */
+void Transaction::startProcess(int n) {
+  QProcess *process = new QProcess(this);
+  if (!m_env.isEmpty())
+    process->setEnvironment(m_env);
+  if (!m_workingDir.isEmpty())
+    process->setWorkingDirectory(m_workingDir);
+  connect(process,
+          static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(
+              &QProcess::finished),
+          this, &Transaction::processFinished);
+  connect(process, SIGNAL(error(QProcess::ProcessError)), this,
+          SLOT(processError(QProcess::ProcessError)));
+
+  m_steps[n].state = RUNNING;
+  m_steps[n].started = Tracer::now();
+  ++m_running;
+  m_processes.insert(process, n);
+  dbg() << m_steps.at(n).app << m_steps.at(n).args;
+  process->start(m_steps.at(n).app, m_steps.at(n).args);
+  if (!m_processes.contains(process))
+    return; // failed to start right away
+
+  const step &s = m_steps.at(n);
+  const QByteArray &input =
+      s.inputFrom >= 0 ? m_steps.at(s.inputFrom).output : s.input;
+  // buffered by QProcess until the process is up
+  if (!input.isEmpty() && process->write(input) != input.length())
+    dbg() << "Not all data written to process:" << s.app;
+  process->closeWriteChannel();
+  m_steps[n].bytesIn = input.size();
+  // the input may be a secret, like the content of a new password file
+  SecureBuffer::wipe(&m_steps[n].input);
+
+  if (m_stepTimeout > 0) {
+    QTimer *deadline = new QTimer(process);
+    deadline->setSingleShot(true);
+    connect(deadline, &QTimer::timeout, this,
+            [this, process, deadline]() { stepTimedOut(process, deadline); });
+    deadline->start(m_stepTimeout);
+  }
+}
+
+/**
+ * @brief Transaction::stepTimedOut terminate a process that missed its
+ * deadline, kill it when it is still there after the grace period
+ * @param process
+ * @param deadline
+ */
+void Transaction::stepTimedOut(QProcess *process, QTimer *deadline) {
+  if (!m_processes.contains(process))
+    return;
+  step &s = m_steps[m_processes.value(process)];
+  if (!s.timedOut) {
+    s.timedOut = true;
+    ++m_timeoutCount;
+    dbg() << "Stopping" << s.app << "after" << m_stepTimeout << "ms";
+    process->terminate();
+    deadline->start(Executor::killGrace);
+  } else {
+    process->kill();
+  }
+}
+
+/**
+ * @brief Transaction::runTask
+ * @param n
+ */
+void Transaction::runTask(int n) {
+  m_steps[n].state = RUNNING;
+  m_steps[n].started = Tracer::now();
+  if (!m_steps.at(n).task) {
+    dbg() << "Trying to execute nothing...";
+    stepFinished(n, true);
+    return;
+  }
+  // the task may add steps, which can move m_steps around
+  Task task = m_steps.at(n).task;
+  QString error;
+  bool ok = task(this, &error);
+  m_steps[n].exitCode = ok ? 0 : -1;
+  m_steps[n].errout = error.toUtf8();
+  stepFinished(n, ok);
+}
+
+/**
+ * @brief Transaction::startJob
+ * @param n
+ */
+void Transaction::startJob(int n) {
+  m_steps[n].state = RUNNING;
+  m_steps[n].started = Tracer::now();
+  ++m_jobs;
+  runInBackground(m_steps.at(n).job, [this, n](bool ok, const QString &error) {
+    --m_jobs;
+    m_steps[n].exitCode = ok ? 0 : -1;
+    m_steps[n].errout = error.toUtf8();
+    stepFinished(n, ok);
+    schedule();
+  });
+}
+
+/**
+ * @brief Transaction::runInBackground run work on the pool
+ * @param job
+ * @param done  called from the event loop with the result
+ */
+void Transaction::runInBackground(const Job &job, const WorkDone &done) {
+  int id = ++m_lastWork;
+  m_work.insert(id, done);
+  m_pool.start(new Work(this, id, job));
+}
+
+/**
+ * @brief Transaction::workFinished pass the result of background work on
+ * @param id
+ * @param ok
+ * @param error
+ */
+void Transaction::workFinished(int id, bool ok, const QString &error) {
+  WorkDone done = m_work.take(id);
+  if (done)
+    done(ok, error);
+}
+
+/**
+ * @brief Transaction::runHelper run git or a rollback command, which is not
+ * a step, killed when it does not finish in time
+ * @param app
+ * @param args
+ * @param done  called with the stdout once it is over
+ */
+void Transaction::runHelper(const QString &app, const QStringList &args,
+                            const HelperDone &done) {
+  QProcess *process = new QProcess(this);
+  if (!m_env.isEmpty())
+    process->setEnvironment(m_env);
+  if (!m_workingDir.isEmpty())
+    process->setWorkingDirectory(m_workingDir);
+  QTimer *deadline = new QTimer(process);
+  deadline->setSingleShot(true);
+  connect(deadline, &QTimer::timeout, process, &QProcess::kill);
+  connect(process,
+          static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(
+              &QProcess::finished),
+          this,
+          [process, done](int exitCode, QProcess::ExitStatus exitStatus) {
+            process->deleteLater();
+            done(exitStatus == QProcess::NormalExit && exitCode == 0,
+                 process->readAllStandardOutput());
+          });
+  connect(process,
+          static_cast<void (QProcess::*)(QProcess::ProcessError)>(
+              &QProcess::error),
+          this, [process, done](QProcess::ProcessError error) {
+            if (error != QProcess::FailedToStart)
+              return;
+            process->deleteLater();
+            done(false, QByteArray());
+          });
+  dbg() << app << args;
+  deadline->start(helperTimeout);
+  process->start(app, args);
+}
+
+/**
+ * @brief Transaction::runCommands run commands one after the other, a
+ * failure is logged and does not stop the others
+ * @param commands
+ * @param done  called when all of them are over
+ */
+void Transaction::runCommands(CommandList commands,
+                              const std::function<void()> &done) {
+  if (commands.isEmpty()) {
+    done();
+    return;
+  }
+  const QPair<QString, QStringList> command = commands.takeFirst();
+  runHelper(command.first, command.second,
+            [this, command, commands, done](bool ok, const QByteArray &) {
+              if (!ok)
+                dbg() << "Rollback command failed:" << command.first
+                      << command.second;
+              runCommands(commands, done);
+            });
+}
+
+/**
+ * @brief Transaction::processFinished collect the output of a step
+ * @param exitCode
+ * @param exitStatus
+ */
+void Transaction::processFinished(int exitCode,
+                                  QProcess::ExitStatus exitStatus) {
+  QProcess *process = qobject_cast<QProcess *>(sender());
+  if (!m_processes.contains(process))
+    return;
+  int n = m_processes.take(process);
+  --m_running;
+  step &s = m_steps[n];
+  s.output = process->readAllStandardOutput();
+  s.errout = process->readAllStandardError();
+  if (s.timedOut) {
+    s.exitCode = -1;
+    s.errout = tr("%1 did not finish within %2 seconds and was stopped.")
+                   .arg(QFileInfo(s.app).fileName())
+                   .arg(m_stepTimeout / 1000)
+                   .toUtf8();
+  } else if (exitStatus == QProcess::NormalExit) {
+    s.exitCode = exitCode;
+  } else {
+    dbg() << "Process crashed:" << s.app;
+    s.exitCode = -1;
+    s.errout += process->errorString().toUtf8();
+  }
+  if (s.exitCode != 0)
+    dbg() << s.exitCode << s.errout;
+  process->deleteLater();
+  stepFinished(n, s.exitCode == 0);
+  schedule();
+}
+
+/**
+ * @brief Transaction::processError a process that could not be started does
+ * not emit finished, fail its step here
+ * @param error
+ */
+void Transaction::processError(QProcess::ProcessError error) {
+  QProcess *process = qobject_cast<QProcess *>(sender());
+  if (error != QProcess::FailedToStart || !m_processes.contains(process))
+    return;
+  int n = m_processes.take(process);
+  --m_running;
+  m_steps[n].exitCode = -1;
+  m_steps[n].errout = process->errorString().toUtf8();
+  dbg() << "Failed to start:" << m_steps.at(n).app;
+  process->deleteLater();
+  stepFinished(n, false);
+  schedule();
+}
+
+/**
+ * @brief Transaction::stepFinished record the outcome of a step and pass it
+ * on to the steps waiting for it
+ * @param n
+ * @param ok
+ */
+void Transaction::stepFinished(int n, bool ok) {
+  trace(n);
+  step &s = m_steps[n];
+  if (ok) {
+    s.state = DONE;
+  } else if (s.optional) {
+    s.state = DROPPED;
+  } else {
+    s.state = FAILED;
+    if (!m_failed) {
+      m_failed = true;
+      m_exitCode = s.exitCode != 0 ? s.exitCode : -1;
+      m_error = s.errout;
+    }
+  }
+  settle(n);
+  release(n);
+  foreach (int d, m_steps.at(n).after)
+    release(d);
+  emit progress(++m_stepsDone, m_steps.size());
+}
+
+/**
+ * @brief Transaction::trace record a span for a step that ran, each step on
+ * its own lane so concurrent steps do not overlap
+ * @param n
+ */
+void Transaction::trace(int n) {
+  const step &s = m_steps.at(n);
+  if (s.started < 0 || !Tracer::isEnabled())
+    return;
+  QString name = s.task  ? QString("task")
+                 : s.job ? QString("job")
+                         : QFileInfo(s.app).fileName();
+  QVariantMap args;
+  args["step"] = n;
+  args["bytesIn"] = s.bytesIn;
+  args["bytesOut"] = s.output.size();
+  args["exitCode"] = s.exitCode;
+  Tracer::complete(name, "transaction", s.started, Tracer::now() - s.started,
+                   args, Tracer::STEPS + n);
+}
+
+/**
+ * @brief Transaction::settle a step is over, update the steps depending on
+ * it. Skipped and dropped steps are passed on right away.
+ * @param n
+ */
+void Transaction::settle(int n) {
+  StepState state = m_steps.at(n).state;
+  const QList<int> dependents = m_steps.at(n).dependents;
+  foreach (int d, dependents) {
+    step &s = m_steps[d];
+    if (s.state != WAITING)
+      continue;
+    if (state == FAILED || state == SKIPPED) {
+      s.state = SKIPPED;
+      settle(d);
+    } else if (state == DROPPED && s.inputFrom == n) {
+      s.state = DROPPED;
+      settle(d);
+    } else {
+      --s.pending;
+    }
+  }
+}
+
+/**
+ * @brief Transaction::release free private output nobody needs anymore, it
+ * may hold decrypted content
+ * @param n
+ */
+void Transaction::release(int n) {
+  step &s = m_steps[n];
+  if (!s.privateOutput || !isOver(n))
+    return;
+  foreach (int d, s.dependents) {
+    if (!isOver(d))
+      return;
+  }
+  SecureBuffer::wipe(&s.output);
+  s.errout.clear();
+}
+
+/**
+ * @brief Transaction::isOver
+ * @param n
+ * @return whether the step will not change anymore
+ */
+bool Transaction::isOver(int n) const {
+  StepState state = m_steps.at(n).state;
+  return state != WAITING && state != RUNNING;
+}
+
+/**
+ * @brief Transaction::finish roll back if needed and report the result
+ */
+void Transaction::finish() {
+  if (m_done)
+    return;
+  m_done = true;
+  for (int n = 0; n < m_steps.size(); ++n) {
+    if (m_steps.at(n).state != WAITING)
+      continue;
+    m_steps[n].state = SKIPPED;
+    if (!m_failed) {
+      m_failed = true;
+      m_exitCode = -1;
+      m_error = tr("Steps are waiting for each other").toUtf8();
+    }
+  }
+  if (m_failed && m_started)
+    rollback();
+  else
+    report();
+}
+
+/**
+ * @brief Transaction::report emit the result, once
+ */
+void Transaction::report() {
+  if (m_reported)
+    return;
+  m_reported = true;
+  QByteArray output, errout;
+  foreach (const step &s, m_steps) {
+    if (s.privateOutput)
+      continue;
+    output += s.output;
+    if (!m_failed)
+      errout += s.errout;
+  }
+  if (m_failed)
+    errout = m_error;
+  emit finished(m_failed ? m_exitCode : 0, output, errout);
+}
+
+/**
+ * @brief Transaction::rollback put the touched files back the way they were
+ * and run the rollback commands, then report
+ *
+ * What was added is removed first, then the files left to git are checked
+ * out again and the others written back, so a file that was changed before
+ * the transaction keeps that change.
+ */
+void Transaction::rollback() {
+  dbg() << "Rolling back" << m_touched;
+  const QStringList roots = m_touched;
+  const QHash<QString, fileBackup> backups = m_backups;
+  runInBackground(
+      [roots, backups](QString *) {
+        foreach (const QString &root, roots)
+          removeAdded(root, backups);
+        return true;
+      },
+      [this, roots, backups](bool, const QString &) {
+        CommandList checkouts;
+        QDir dir(m_workingDir);
+        foreach (const QString &root, m_gitRoots) {
+          QString path = dir.relativeFilePath(root);
+          checkouts.append(qMakePair(
+              m_git, QStringList({"checkout", "-q", "HEAD", "--",
+                                  path.isEmpty() ? QString(".") : path})));
+        }
+        runCommands(checkouts, [this, roots, backups]() {
+          runInBackground(
+              [roots, backups](QString *) {
+                foreach (const QString &root, roots)
+                  writeBack(root, backups);
+                return true;
+              },
+              [this](bool, const QString &) {
+                runCommands(m_rollback, [this]() { report(); });
+              });
+        });
+      });
+}
+
+/**
+ * @brief Transaction::backupTree record a touched path and, for directories,
+ * everything below it. Runs on the pool.
+ * @param root
+ * @param changed   paths that differ from HEAD or are not tracked
+ * @param workTree  other files below it are left to git, may be empty
+ * @param backups
+ * @return whether files were left to git
+ */
+bool Transaction::backupTree(const QString &root, const QSet<QString> &changed,
+                             const QString &workTree,
+                             QHash<QString, fileBackup> *backups) {
+  // the repository itself is not tracked, it is kept like any other files
+  QString gitDir = workTree + "/.git";
+  auto inGit = [&](const QString &path) {
+    return !workTree.isEmpty() && isBelow(path, workTree) &&
+           !isBelow(path, gitDir) && !changed.contains(path);
+  };
+  bool leftToGit = backupEntry(root, inGit(root), backups);
+  if (backups->value(root).isDir) {
+    QDirIterator entries(root, QDir::AllEntries | QDir::Hidden |
+                                   QDir::System | QDir::NoDotAndDotDot,
+                         QDirIterator::Subdirectories);
+    while (entries.hasNext()) {
+      QString entry = entries.next();
+      if (backupEntry(entry, inGit(entry), backups))
+        leftToGit = true;
+    }
+  }
+  // tracked files that were deleted before, git would bring them back
+  foreach (const QString &path, changed) {
+    if (isBelow(path, root) && !backups->contains(path))
+      backupEntry(path, false, backups);
+  }
+  return leftToGit;
+}
+
+/**
+ * @brief Transaction::backupEntry record a single file or directory
+ * @param path
+ * @param inGit     tracked and unchanged, the content is not read
+ * @param backups
+ * @return whether the file is left to git
+ */
+bool Transaction::backupEntry(const QString &path, bool inGit,
+                              QHash<QString, fileBackup> *backups) {
+  if (backups->contains(path))
+    return false;
+  QFileInfo info(path);
+  fileBackup backup;
+  backup.existed = info.exists();
+  backup.isDir = info.isDir();
+  backup.inGit = inGit && backup.existed && !backup.isDir;
+  if (backup.existed && !backup.isDir && !backup.inGit) {
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly))
+      backup.content = file.readAll();
+    else
+      dbg() << "Can not back up" << path;
+  }
+  backups->insert(path, backup);
+  return backup.inGit;
+}
+
+/**
+ * @brief Transaction::removeAdded remove what was added below a touched
+ * path, or the path itself if it is new or changed its type. Runs on the
+ * pool.
+ * @param root
+ * @param backups
+ */
+void Transaction::removeAdded(const QString &root,
+                              const QHash<QString, fileBackup> &backups) {
+  QFileInfo info(root);
+  const fileBackup rootBackup = backups.value(root);
+  if (!rootBackup.existed || info.isDir() != rootBackup.isDir) {
+    if (info.isDir())
+      QDir(root).removeRecursively();
+    else if (info.exists() || info.isSymLink())
+      QFile::remove(root);
+    return;
+  }
+  if (!info.isDir())
+    return;
+  QStringList added;
+  QDirIterator entries(root, QDir::AllEntries | QDir::Hidden | QDir::System |
+                                 QDir::NoDotAndDotDot,
+                       QDirIterator::Subdirectories);
+  while (entries.hasNext()) {
+    QString entry = entries.next();
+    if (!backups.contains(entry))
+      added.append(entry);
+  }
+  foreach (const QString &entry, added) {
+    QFileInfo addedInfo(entry);
+    if (addedInfo.isDir())
+      QDir(entry).removeRecursively();
+    else if (addedInfo.exists())
+      QFile::remove(entry);
+  }
+}
+
+/**
+ * @brief Transaction::writeBack write back what was changed or removed below
+ * a touched path, except what git restores. Runs on the pool.
+ * @param root
+ * @param backups
+ */
+void Transaction::writeBack(const QString &root,
+                            const QHash<QString, fileBackup> &backups) {
+  for (auto it = backups.constBegin(); it != backups.constEnd(); ++it) {
+    const QString &path = it.key();
+    if (!isBelow(path, root))
+      continue;
+    if (!it->existed) {
+      QFileInfo info(path);
+      if (info.isDir())
+        QDir(path).removeRecursively();
+      else if (info.exists() || info.isSymLink())
+        QFile::remove(path);
+      continue;
+    }
+    if (it->isDir) {
+      QDir().mkpath(path);
+      continue;
+    }
+    if (it->inGit)
+      continue;
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly) && file.readAll() == it->content)
+      continue;
+    file.close();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+        file.write(it->content) != it->content.size())
+      dbg() << "Can not restore" << path;
+  }
+}
+
+/**
+ * @brief Transaction::isBelow
+ * @param path
+ * @param dir
+ * @return whether path is dir or inside it
+ */
+bool Transaction::isBelow(const QString &path, const QString &dir) {
+  return path == dir || path.startsWith(dir + '/');
+}
@@ -0,0 +1,279 @@
+#ifndef TRANSACTION_H
+#define TRANSACTION_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QProcess>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+#include <functional>
+
+/*!
+    \class Transaction
+    \brief Runs a set of dependent steps as one operation.
+
+    Steps are external processes, tasks run in-process from the event loop
+    or jobs run on a thread of the transaction. Each step lists the
+    steps it has to wait for, steps without pending dependencies run
+    concurrently (up to maxParallel() processes at once), each with its own
+    deadline when a step timeout is set. A task may add more
+    steps while it runs, which is how work is planned that depends on the
+    output of earlier steps.
+
+    Prelude steps, like a git pull, run before the touched files are
+    recorded and everything else waits for them, so what they change is
+    kept when the transaction is rolled back.
+
+    If a step fails, the steps depending on it are skipped, nothing else is
+    started, and once the running steps are done the touched files are
+    restored and the rollback commands are run. The result is reported once,
+    through finished().
+
+    Nothing of that blocks the event loop: the touched files are recorded and
+    restored on a thread of the transaction, git and the rollback commands
+    run as processes. When git is set, files that are tracked and unchanged
+    are not read at all but checked out again on rollback, only the others
+    are kept in memory.
+
+    Deleting the transaction waits for the jobs that are running.
+ */
+class Transaction : public QObject {
+  Q_OBJECT
+
+public:
+  /**
+   * @brief Task  in-process step, gets the transaction to read outputs or
+   *              add steps and returns false with a reason on failure
+   */
+  typedef std::function<bool(Transaction *transaction, QString *error)> Task;
+  /**
+   * @brief Job   step run on a thread of the transaction, for file work that
+   *              takes a while. It must not use the transaction, returns
+   *              false with a reason on failure.
+   */
+  typedef std::function<bool(QString *error)> Job;
+
+  explicit Transaction(QObject *parent = nullptr);
+  ~Transaction();
+
+  int addProcess(const QString &app, const QStringList &args,
+                 const QList<int> &after = QList<int>(),
+                 const QByteArray &input = QByteArray());
+  int addTask(const Task &task, const QList<int> &after = QList<int>());
+  int addJob(const Job &job, const QList<int> &after = QList<int>());
+  void addDependency(int step, int after);
+  void setInputFrom(int step, int from);
+  void setOptional(int step);
+  void setPrivateOutput(int step);
+  void setPrelude(int step);
+
+  void touch(const QString &path);
+  void addRollback(const QString &app, const QStringList &args);
+
+  QByteArray output(int step) const;
+  QByteArray errorOutput(int step) const;
+
+  void setWorkingDirectory(const QString &dir);
+  void setEnvironment(const QStringList &env);
+  void setGit(const QString &executable);
+  int maxParallel() const;
+  void setMaxParallel(int count);
+  void setStepTimeout(int msecs);
+  int timeoutCount() const;
+
+  bool isRunning() const;
+
+public slots:
+  void start();
+  void cancel();
+
+signals:
+  /**
+   * @brief finished    all steps are done or the transaction was rolled back
+   * @param exitCode    0 on success, otherwise the exit code of the step that
+   *                    failed, -1 if it did not run at all
+   * @param output      stdout of the steps whose output is not private
+   * @param errout      stderr of those steps, or of the step that failed
+   */
+  void finished(int exitCode, const QByteArray &output,
+                const QByteArray &errout);
+  /**
+   * @brief progress    a step is done
+   * @param done        steps done so far
+   * @param total       steps planned so far, grows while tasks add steps
+   */
+  void progress(int done, int total);
+
+private slots:
+  void schedule();
+  void processFinished(int exitCode, QProcess::ExitStatus exitStatus);
+  void processError(QProcess::ProcessError error);
+  void workFinished(int id, bool ok, const QString &error);
+
+private:
+  class Work;
+
+  /**
+   * @brief WorkDone    called from the event loop when background work is done
+   */
+  typedef std::function<void(bool ok, const QString &error)> WorkDone;
+  /**
+   * @brief HelperDone  called when a git or rollback command is done
+   */
+  typedef std::function<void(bool ok, const QByteArray &output)> HelperDone;
+  typedef QList<QPair<QString, QStringList>> CommandList;
+
+  enum StepState { WAITING, RUNNING, DONE, DROPPED, FAILED, SKIPPED };
+
+  /*!
+      \struct step
+      \brief One process or task of the transaction.
+   */
+  struct step {
+    QString app;
+    QStringList args;
+    Task task;
+    Job job;
+    QByteArray input;
+    /**
+     * @brief inputFrom step whose output is written to stdin, -1 for none
+     */
+    int inputFrom;
+    QList<int> after;
+    QList<int> dependents;
+    /**
+     * @brief pending   number of steps in after that have not finished
+     */
+    int pending;
+    /**
+     * @brief optional  a failure does not fail the transaction, only steps
+     *                  reading its output are dropped with it
+     */
+    bool optional;
+    /**
+     * @brief privateOutput not part of the result, released as soon as the
+     *                      dependents are done with it
+     */
+    bool privateOutput;
+    /**
+     * @brief prelude   runs before the touched files are recorded
+     */
+    bool prelude;
+    StepState state;
+    /**
+     * @brief timedOut  the process missed its deadline and is being stopped
+     */
+    bool timedOut;
+    int exitCode;
+    /**
+     * @brief started   Tracer::now() when the step started, -1 before
+     */
+    qint64 started;
+    qint64 bytesIn;
+    QByteArray output;
+    QByteArray errout;
+  };
+
+  /*!
+      \struct fileBackup
+      \brief State of a touched path before the transaction changed it.
+   */
+  struct fileBackup {
+    bool existed;
+    bool isDir;
+    /**
+     * @brief inGit     tracked and unchanged, restored with git checkout,
+     *                  content is empty
+     */
+    bool inGit;
+    QByteArray content;
+  };
+
+  QVector<step> m_steps;
+  QHash<QProcess *, int> m_processes;
+  /**
+   * @brief m_touched   touched paths, sorted once the transaction started
+   */
+  QStringList m_touched;
+  QHash<QString, fileBackup> m_backups;
+  /**
+   * @brief m_gitRoots  touched paths with files left to git checkout
+   */
+  QStringList m_gitRoots;
+  CommandList m_rollback;
+  QString m_workingDir;
+  QStringList m_env;
+  QString m_git;
+  QThreadPool m_pool;
+  QHash<int, WorkDone> m_work;
+  int m_lastWork;
+  int m_maxParallel;
+  int m_stepTimeout;
+  int m_timeoutCount;
+  int m_running;
+  int m_jobs;
+  /**
+   * @brief m_backingUp paths touched while running that are being recorded
+   */
+  int m_backingUp;
+  int m_stepsDone;
+  bool m_started;
+  /**
+   * @brief m_ready     the touched files are recorded, steps may start
+   */
+  bool m_ready;
+  /**
+   * @brief m_recording the touched files are being recorded
+   */
+  bool m_recording;
+  bool m_scheduling;
+  bool m_failed;
+  bool m_done;
+  bool m_reported;
+  int m_exitCode;
+  QByteArray m_error;
+
+  int addStep(const step &s, const QList<int> &after);
+  void startProcess(int n);
+  void stepTimedOut(QProcess *process, QTimer *deadline);
+  void runTask(int n);
+  void startJob(int n);
+  void runInBackground(const Job &job, const WorkDone &done);
+  void runHelper(const QString &app, const QStringList &args,
+                 const HelperDone &done);
+  void runCommands(CommandList commands, const std::function<void()> &done);
+  void stepFinished(int n, bool ok);
+  void trace(int n);
+  void settle(int n);
+  void release(int n);
+  bool isOver(int n) const;
+  void finish();
+  void report();
+  void rollback();
+  QString addRoot(const QString &path);
+  void backupLater(const QString &root);
+  QStringList gitPaths() const;
+  QSet<QString> absolutePaths(const QByteArray &names) const;
+  void record();
+  void startBackup(const QSet<QString> &changed, const QString &workTree);
+
+  static bool backupTree(const QString &root, const QSet<QString> &changed,
+                         const QString &workTree,
+                         QHash<QString, fileBackup> *backups);
+  static bool backupEntry(const QString &path, bool inGit,
+                          QHash<QString, fileBackup> *backups);
+  static void removeAdded(const QString &root,
+                          const QHash<QString, fileBackup> &backups);
+  static void writeBack(const QString &root,
+                        const QHash<QString, fileBackup> &backups);
+  static bool isBelow(const QString &path, const QString &dir);
+
+  static const int helperTimeout = 10000;
+};
+
+#endif // TRANSACTION_H
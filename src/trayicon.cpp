@@ -32,6 +32,7 @@ TrayIcon::TrayIcon(QMainWindow *parent) {
 
     isAllocated = false;
 
+    quickOpenAction = nullptr;
     showAction = nullptr;
     hideAction = nullptr;
     minimizeAction = nullptr;
@@ -63,6 +64,9 @@ bool TrayIcon::getIsAllocated() { return isAllocated; }
  * @brief TrayIcon::createActions setup the signals.
  */
 void TrayIcon::createActions() {
+  quickOpenAction = new QAction(tr("&Quick open..."), this);
+  connect(quickOpenAction, SIGNAL(triggered()), parentwin,
+          SLOT(showQuickOpen()));
   showAction = new QAction(tr("&Show"), this);
   connect(showAction, SIGNAL(triggered()), parentwin, SLOT(show()));
   hideAction = new QAction(tr("&Hide"), this);
@@ -86,6 +90,8 @@ void TrayIcon::createActions() {
  */
 void TrayIcon::createTrayIcon() {
   trayIconMenu = new QMenu(this);
+  trayIconMenu->addAction(quickOpenAction);
+  trayIconMenu->addSeparator();
   trayIconMenu->addAction(showAction);
   trayIconMenu->addAction(hideAction);
   trayIconMenu->addAction(minimizeAction);
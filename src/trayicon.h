@@ -30,6 +30,7 @@ private:
   void createActions();
   void createTrayIcon();
 
+  QAction *quickOpenAction;
   QAction *showAction;
   QAction *hideAction;
   QAction *minimizeAction;
@@ -0,0 +1,246 @@
+#include "urlmatcher.h"
+
+#include <QRegExp>
+#include <QUrl>
+#include <algorithm>
+
+/**
+ * @brief UrlMatcher::UrlMatcher empty matcher, add the entries of a store
+ * with addEntry
+ */
+UrlMatcher::UrlMatcher() { clear(); }
+
+/**
+ * @brief UrlMatcher::clear forget all entries
+ */
+void UrlMatcher::clear() {
+  m_nodes.clear();
+  m_nodes.append(node());
+  m_entries.clear();
+}
+
+/**
+ * @brief UrlMatcher::isEmpty
+ * @return true if no entry was added
+ */
+bool UrlMatcher::isEmpty() const { return m_entries.isEmpty(); }
+
+/**
+ * @brief UrlMatcher::addEntry make an entry findable by the hosts in its
+ * path and in urls
+ * @param entry relative entry path without .gpg suffix
+ * @param urls  URLs or host names stored in the entry, may be empty
+ */
+void UrlMatcher::addEntry(const QString &entry, const QStringList &urls) {
+  QStringList hosts = hostsInPath(entry);
+  foreach (const QString &url, urls) {
+    QString name = host(url);
+    if (!name.isEmpty() && !hosts.contains(name))
+      hosts.append(name);
+  }
+  if (hosts.isEmpty())
+    return;
+  int id = m_entries.size();
+  m_entries.append(entry);
+  foreach (const QString &name, hosts)
+    addHost(name, id);
+}
+
+/**
+ * @brief UrlMatcher::addHost put a host in the trie
+ * @param host
+ * @param entry index in m_entries
+ */
+void UrlMatcher::addHost(const QString &host, int entry) {
+  int n = 0;
+  foreach (const QString &label, reversedLabels(host)) {
+    int child = m_nodes.at(n).children.value(label, -1);
+    if (child < 0) {
+      child = m_nodes.size();
+      m_nodes[n].children.insert(label, child);
+      m_nodes.append(node());
+    }
+    n = child;
+  }
+  if (m_nodes.at(n).entries.isEmpty() || m_nodes.at(n).entries.last() != entry)
+    m_nodes[n].entries.append(entry);
+}
+
+/**
+ * @brief UrlMatcher::match find the entries for a URL
+ * @param url   URL or host name, scheme, port and path are ignored
+ * @param limit most results to return, -1 for all
+ * @param siblings  also other hosts in the registrable domain
+ * @return entries in the domain of the URL, most specific first, entries
+ * that are as specific sorted by name
+ */
+QStringList UrlMatcher::match(const QString &url, int limit,
+                              bool siblings) const {
+  QStringList labels = reversedLabels(host(url));
+  int registrable = registrableLabels(labels);
+  if (labels.isEmpty() || labels.size() < registrable)
+    return QStringList();
+
+  // nodes of the host and the domains above it, as far as they are known
+  QVector<int> path;
+  int n = 0;
+  foreach (const QString &label, labels) {
+    n = m_nodes.at(n).children.value(label, -1);
+    if (n < 0)
+      break;
+    path.append(n);
+  }
+  if (path.size() < registrable)
+    return QStringList();
+
+  QHash<int, int> scores;
+  if (siblings) {
+    collect(path.at(registrable - 1), registrable, registrable, path, &scores);
+  } else {
+    // deeper nodes score higher, so an entry keeps its best score
+    for (int depth = registrable; depth <= path.size(); ++depth) {
+      foreach (int entry, m_nodes.at(path.at(depth - 1)).entries)
+        scores.insert(entry, 2 * depth);
+    }
+  }
+  QVector<QPair<int, int>> ranked;
+  ranked.reserve(scores.size());
+  for (auto it = scores.constBegin(); it != scores.constEnd(); ++it)
+    ranked.append(qMakePair(it.value(), it.key()));
+  const QStringList &entries = m_entries;
+  std::sort(ranked.begin(), ranked.end(),
+            [&entries](const QPair<int, int> &a, const QPair<int, int> &b) {
+              if (a.first != b.first)
+                return a.first > b.first;
+              return entries.at(a.second) < entries.at(b.second);
+            });
+  QStringList found;
+  for (int i = 0; i < ranked.size() && (limit < 0 || i < limit); ++i)
+    found.append(m_entries.at(ranked.at(i).second));
+  return found;
+}
+
+/**
+ * @brief UrlMatcher::collect score the entries below a node of the
+ * registrable domain. Entries on the path of the URL score twice the labels
+ * they share with it, the others one less than that, so the host and its
+ * parent domains come before sibling hosts.
+ * @param n         node
+ * @param depth     labels from the root to n
+ * @param common    labels n shares with the URL
+ * @param path      nodes of the URL
+ * @param scores    best score per entry
+ */
+void UrlMatcher::collect(int n, int depth, int common,
+                         const QVector<int> &path,
+                         QHash<int, int> *scores) const {
+  bool onPath = depth <= path.size() && path.at(depth - 1) == n;
+  int score = onPath ? 2 * depth : 2 * common - 1;
+  foreach (int entry, m_nodes.at(n).entries) {
+    auto it = scores->find(entry);
+    if (it == scores->end())
+      scores->insert(entry, score);
+    else if (it.value() < score)
+      it.value() = score;
+  }
+  const QHash<QString, int> &children = m_nodes.at(n).children;
+  for (auto it = children.constBegin(); it != children.constEnd(); ++it)
+    collect(it.value(), depth + 1, onPath ? depth : common, path, scores);
+}
+
+/**
+ * @brief UrlMatcher::host normalise a URL or host name
+ * @param url
+ * @return lower case host without a leading "www." or trailing dot, empty
+ * if there is none
+ */
+QString UrlMatcher::host(const QString &url) {
+  QString text = url.trimmed();
+  if (text.isEmpty())
+    return QString();
+  if (!text.contains("://"))
+    text.prepend("http://");
+  QString name = QUrl(text).host().toLower();
+  while (name.endsWith('.'))
+    name.chop(1);
+  if (name.startsWith("www."))
+    name.remove(0, 4);
+  return name;
+}
+
+/**
+ * @brief UrlMatcher::hostsInPath host names in the folders and name of an
+ * entry, "alice@example.com" counts as example.com
+ * @param entry
+ * @return
+ */
+QStringList UrlMatcher::hostsInPath(const QString &entry) {
+  static const QRegExp hostName(
+      "([a-z0-9-]+\\.)+[a-z][a-z0-9-]*[a-z0-9]|(\\d+\\.){3}\\d+",
+      Qt::CaseInsensitive);
+  QStringList hosts;
+  foreach (QString part, entry.split('/', QString::SkipEmptyParts)) {
+    int at = part.lastIndexOf('@');
+    if (at >= 0)
+      part.remove(0, at + 1);
+    if (!hostName.exactMatch(part))
+      continue;
+    QString name = host(part);
+    if (!name.isEmpty() && !hosts.contains(name))
+      hosts.append(name);
+  }
+  return hosts;
+}
+
+/**
+ * @brief UrlMatcher::registrableLabels how many labels, from the top, make
+ * the domain that can be registered
+ * @param reversedLabels   labels of a host, top level domain first
+ * @return 2, 3 for domains like example.co.uk or alice.github.io, all for
+ * IPv4 addresses
+ */
+int UrlMatcher::registrableLabels(const QStringList &reversedLabels) {
+  static const QStringList genericSecondLevel = {
+      "ac", "co", "com", "edu", "go", "gov", "ne", "net", "or", "org"};
+  // from the private part of the public suffix list, reversed
+  static const QStringList sharedHosting = {
+      "app.netlify",       "app.onrender",   "app.vercel",
+      "app.web",           "com.appspot",    "com.blogspot",
+      "com.firebaseapp",   "com.herokuapp",  "dev.pages",
+      "io.github",         "io.gitlab",      "me.glitch",
+      "net.azurewebsites", "net.cloudfront", "page.codeberg"};
+  int count = reversedLabels.size();
+  if (count == 4 && QRegExp("\\d+").exactMatch(reversedLabels.first()))
+    return 4;
+  if (count >= 2 && reversedLabels.at(0).size() == 2 &&
+      genericSecondLevel.contains(reversedLabels.at(1)))
+    return 3;
+  if (count >= 2 &&
+      sharedHosting.contains(reversedLabels.at(0) + "." + reversedLabels.at(1)))
+    return 3;
+  return 2;
+}
+
+/**
+ * @brief UrlMatcher::looksLikeUrl whether search text is a URL or host name
+ * rather than part of an entry path
+ * @param text
+ * @return
+ */
+bool UrlMatcher::looksLikeUrl(const QString &text) {
+  static const QRegExp url(
+      "([a-z][a-z0-9+.-]*://)?[^\\s/:@]+\\.[a-z]{2,}\\.?(:\\d+)?([/?#]\\S*)?",
+      Qt::CaseInsensitive);
+  return url.exactMatch(text.trimmed());
+}
+
+/**
+ * @brief UrlMatcher::reversedLabels
+ * @param host
+ * @return labels of host, top level domain first
+ */
+QStringList UrlMatcher::reversedLabels(const QString &host) {
+  QStringList labels = host.split('.', QString::SkipEmptyParts);
+  std::reverse(labels.begin(), labels.end());
+  return labels;
+}
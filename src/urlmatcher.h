@@ -0,0 +1,66 @@
+#ifndef URLMATCHER_H
+#define URLMATCHER_H
+
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+/*!
+    \class UrlMatcher
+    \brief Finds the entries for a URL or host name by domain.
+
+    Hosts are taken from the entry paths, like "web/example.com" or
+    "mail/alice@example.com", and from URLs given for an entry, e.g. its
+    indexed "url" fields. They are kept in a trie of their labels in
+    reverse order, "com" -> "example" -> "login", so a lookup only walks as
+    many nodes as the URL has labels.
+
+    A URL matches the entries of its host, of the domains above it down to
+    the registrable domain, and of the other hosts in that domain. The
+    results are ranked by how many labels they share with the URL: for
+    https://login.example.com/ an entry for login.example.com comes before
+    one for example.com, which comes before one for mail.example.com.
+
+    The registrable domain is the last two labels, or three for two-letter
+    country domains with a generic second level like co.uk and for well
+    known hosting domains like github.io, where every user has a host of
+    their own. That covers the common cases without shipping the public
+    suffix list, so where a wrong guess would hand out an entry, e.g. to
+    other programs, match with siblings off: only the host and the domains
+    above it are matched then.
+ */
+class UrlMatcher {
+public:
+  UrlMatcher();
+
+  void clear();
+  void addEntry(const QString &entry, const QStringList &urls = QStringList());
+  QStringList match(const QString &url, int limit = -1,
+                    bool siblings = true) const;
+  bool isEmpty() const;
+
+  static QString host(const QString &url);
+  static QStringList hostsInPath(const QString &entry);
+  static int registrableLabels(const QStringList &reversedLabels);
+  static bool looksLikeUrl(const QString &text);
+
+private:
+  /*!
+      \struct node
+      \brief One label of a host, with the entries of the host ending here.
+   */
+  struct node {
+    QHash<QString, int> children;
+    QVector<int> entries;
+  };
+
+  QVector<node> m_nodes;
+  QStringList m_entries;
+
+  void addHost(const QString &host, int entry);
+  void collect(int n, int depth, int common, const QVector<int> &path,
+               QHash<int, int> *scores) const;
+  static QStringList reversedLabels(const QString &host);
+};
+
+#endif // URLMATCHER_H
@@ -1,7 +1,9 @@
 #include "util.h"
+#include "copyengine.h"
 #include "debughelper.h"
 #include <QDir>
 #include <QFileInfo>
+#include <QSet>
 #ifdef Q_OS_WIN
 #include <windows.h>
 #else
@@ -67,6 +69,29 @@ QString Util::normalizeFolderPath(QString path) {
   return QDir::toNativeSeparators(path);
 }
 
+/**
+ * @brief Util::topLevelPaths drop the paths that are inside another one of
+ * the list, they go along with it anyway
+ * @param paths     absolute paths, with '/' as separator
+ * @return the remaining paths, sorted, without duplicates
+ */
+QStringList Util::topLevelPaths(const QStringList &paths) {
+  // sorting alone does not put a folder right before what is inside it,
+  // "a-b" sorts between "a" and "a/x", so look at every parent
+  QSet<QString> selected = paths.toSet();
+  QStringList top;
+  foreach (const QString &path, selected) {
+    bool nested = false;
+    for (int slash = path.lastIndexOf('/'); slash > 0 && !nested;
+         slash = path.lastIndexOf('/', slash - 1))
+      nested = selected.contains(path.left(slash));
+    if (!nested)
+      top << path;
+  }
+  top.sort();
+  return top;
+}
+
 /**
  * @brief Util::findBinaryInPath search for executables.
  * @param binary
@@ -146,18 +171,13 @@ QString Util::getDir(const QModelIndex &index, bool forPass,
   return filePath;
 }
 
-void Util::copyDir(const QString src, const QString dest) {
-  QDir srcDir(src);
-  if (srcDir.exists() == false) {
-    return;
-  }
-  srcDir.mkpath(dest);
-  foreach (QString dir, srcDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
-    copyDir(src + QDir::separator() + dir, dest + QDir::separator() + dir);
-  }
-
-  foreach (QString file, srcDir.entryList(QDir::Files)) {
-    QFile::copy(src + QDir::separator() + file,
-                dest + QDir::separator() + file);
-  }
+/**
+ * @brief Util::copyDir copy a folder with everything in it, see
+ * CopyEngine::copyTree
+ * @param src
+ * @param dest
+ * @return false if something could not be copied
+ */
+bool Util::copyDir(const QString src, const QString dest) {
+  return CopyEngine::copyTree(src, dest);
 }
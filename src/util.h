@@ -21,7 +21,8 @@ public:
   static QString getDir(const QModelIndex &index, bool forPass,
                         const QFileSystemModel &model,
                         const StoreModel &storeModel);
-  static void copyDir(const QString src, const QString dest);
+  static bool copyDir(const QString src, const QString dest);
+  static QStringList topLevelPaths(const QStringList &paths);
 
 private:
   static void initialiseEnvironment();
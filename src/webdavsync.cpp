@@ -0,0 +1,637 @@
+#include "webdavsync.h"
+#include "debughelper.h"
+#include <QAuthenticator>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkReply>
+#include <QSaveFile>
+#include <QSet>
+#include <QTimer>
+#include <QXmlStreamReader>
+
+const QString WebDavSync::stateFile = ".qtpass-webdav";
+
+/**
+ * @brief sha1
+ * @param data
+ * @return hash used to tell whether a local file changed
+ */
+static QByteArray sha1(const QByteArray &data) {
+  return QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+}
+
+/**
+ * @brief conflictName where the local side of a conflict is kept
+ * @param path
+ * @return path with .conflict before the .gpg suffix
+ */
+static QString conflictName(const QString &path) {
+  if (path.endsWith(".gpg"))
+    return path.left(path.length() - 4) + ".conflict.gpg";
+  return path + ".conflict";
+}
+
+/**
+ * @brief WebDavSync::WebDavSync
+ * @param parent
+ */
+WebDavSync::WebDavSync(QObject *parent)
+    : QObject(parent), m_phase(IDLE), m_outstanding(0), m_failed(false),
+      m_again(false), m_downloaded(0), m_uploaded(0), m_deleted(0) {
+  connect(&m_network, &QNetworkAccessManager::authenticationRequired, this,
+          &WebDavSync::authenticate);
+}
+
+/**
+ * @brief WebDavSync::setRemote
+ * @param url   collection holding the password-store
+ */
+void WebDavSync::setRemote(const QUrl &url) {
+  m_remote = url;
+  if (!m_remote.path().endsWith('/'))
+    m_remote.setPath(m_remote.path() + '/');
+}
+
+/**
+ * @brief WebDavSync::remote
+ * @return collection holding the password-store
+ */
+QUrl WebDavSync::remote() const { return m_remote; }
+
+/**
+ * @brief WebDavSync::setCredentials used when the server asks for them
+ * @param user
+ * @param password
+ */
+void WebDavSync::setCredentials(const QString &user, const QString &password) {
+  m_user = user;
+  m_password = password;
+}
+
+/**
+ * @brief WebDavSync::setLocalRoot
+ * @param root  folder the store is mirrored into
+ */
+void WebDavSync::setLocalRoot(const QString &root) {
+  m_root = QDir::cleanPath(root);
+}
+
+/**
+ * @brief WebDavSync::localRoot
+ * @return folder the store is mirrored into
+ */
+QString WebDavSync::localRoot() const { return m_root; }
+
+/**
+ * @brief WebDavSync::isRunning
+ * @return whether a sync is in progress
+ */
+bool WebDavSync::isRunning() const { return m_phase != IDLE; }
+
+/**
+ * @brief WebDavSync::downloaded
+ * @return files downloaded by the last sync
+ */
+int WebDavSync::downloaded() const { return m_downloaded; }
+
+/**
+ * @brief WebDavSync::uploaded
+ * @return files uploaded by the last sync
+ */
+int WebDavSync::uploaded() const { return m_uploaded; }
+
+/**
+ * @brief WebDavSync::deleted
+ * @return files deleted on either side by the last sync
+ */
+int WebDavSync::deleted() const { return m_deleted; }
+
+/**
+ * @brief WebDavSync::sync start a sync, or queue one more if one is running
+ */
+void WebDavSync::sync() {
+  if (m_phase != IDLE) {
+    m_again = true;
+    return;
+  }
+  m_failed = false;
+  m_error.clear();
+  m_downloaded = m_uploaded = m_deleted = 0;
+  m_remoteFiles.clear();
+  m_remoteDirs.clear();
+  m_collections.clear();
+  m_downloads.clear();
+  m_conflicts.clear();
+  m_uploads.clear();
+  m_remoteDeletes.clear();
+  if (!m_remote.isValid() || m_root.isEmpty() || !QDir().mkpath(m_root)) {
+    m_failed = true;
+    m_error = tr("WebDAV URL or local folder not set");
+    finish();
+    return;
+  }
+  loadState();
+  scanLocal();
+  m_phase = LISTING;
+  list(QString());
+}
+
+/**
+ * @brief WebDavSync::authenticate answer the server once per request, so
+ * wrong credentials fail instead of looping
+ * @param reply
+ * @param authenticator
+ */
+void WebDavSync::authenticate(QNetworkReply *reply,
+                              QAuthenticator *authenticator) {
+  if (reply->property("authenticated").toBool() || m_user.isEmpty())
+    return;
+  reply->setProperty("authenticated", true);
+  authenticator->setUser(m_user);
+  authenticator->setPassword(m_password);
+}
+
+/**
+ * @brief WebDavSync::request
+ * @param path  relative to the remote store, collections end with /
+ * @return request for path
+ */
+QNetworkRequest WebDavSync::request(const QString &path) const {
+  // file names may hold % or #, which are not escapes or a fragment here
+  QUrl url = m_remote;
+  url.setPath(m_remote.path(QUrl::FullyDecoded) + path, QUrl::DecodedMode);
+  QNetworkRequest request(url);
+  request.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
+                       QNetworkRequest::AlwaysNetwork);
+  return request;
+}
+
+/**
+ * @brief WebDavSync::requestFailed check the reply and remember the first
+ * error
+ * @param reply
+ * @return true if the request failed
+ */
+bool WebDavSync::requestFailed(QNetworkReply *reply) {
+  if (reply->error() == QNetworkReply::NoError)
+    return false;
+  dbg() << "WebDAV request failed:" << reply->url() << reply->errorString();
+  if (!m_failed)
+    m_error = reply->errorString();
+  m_failed = true;
+  return true;
+}
+
+/**
+ * @brief WebDavSync::isSynced
+ * @param path  relative to the store
+ * @return false for hidden files and anything in hidden folders, except
+ * .gpg-id files
+ */
+bool WebDavSync::isSynced(const QString &path) {
+  QStringList parts = path.split('/', QString::SkipEmptyParts);
+  if (parts.isEmpty())
+    return false;
+  for (int n = 0; n < parts.size(); ++n) {
+    if (parts.at(n).startsWith('.') &&
+        !(n == parts.size() - 1 && parts.at(n) == ".gpg-id"))
+      return false;
+  }
+  return true;
+}
+
+/**
+ * @brief WebDavSync::isBelowAny
+ * @param path  relative to the store
+ * @param dirs  relative to the store
+ * @return whether path is one of dirs or inside one of them
+ */
+bool WebDavSync::isBelowAny(const QString &path, const QStringList &dirs) {
+  foreach (const QString &dir, dirs) {
+    if (path == dir || path.startsWith(dir + '/'))
+      return true;
+  }
+  return false;
+}
+
+/**
+ * @brief WebDavSync::list PROPFIND one collection
+ * @param dir   relative to the store, empty or ending with /
+ */
+void WebDavSync::list(const QString &dir) {
+  static const QByteArray body =
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+      "<d:propfind xmlns:d=\"DAV:\"><d:prop>"
+      "<d:getetag/><d:resourcetype/>"
+      "</d:prop></d:propfind>";
+  QNetworkRequest listing = request(dir);
+  listing.setRawHeader("Depth", "1");
+  listing.setHeader(QNetworkRequest::ContentTypeHeader,
+                    "application/xml; charset=utf-8");
+  ++m_outstanding;
+  QNetworkReply *reply = m_network.sendCustomRequest(listing, "PROPFIND", body);
+  connect(reply, &QNetworkReply::finished, this,
+          [this, reply, dir]() { listed(reply, dir); });
+}
+
+/**
+ * @brief WebDavSync::listed collect the files of a collection and list its
+ * sub-collections
+ * @param reply
+ * @param dir
+ */
+void WebDavSync::listed(QNetworkReply *reply, const QString &dir) {
+  reply->deleteLater();
+  --m_outstanding;
+  if (!requestFailed(reply) && !m_failed) {
+    const QString base = m_remote.path(QUrl::FullyDecoded);
+    QXmlStreamReader xml(reply->readAll());
+    QString href, etag;
+    bool collection = false;
+    while (!xml.atEnd()) {
+      xml.readNext();
+      if (xml.namespaceUri() != "DAV:")
+        continue;
+      if (xml.isStartElement()) {
+        if (xml.name() == "response") {
+          href.clear();
+          etag.clear();
+          collection = false;
+        } else if (xml.name() == "href") {
+          href = xml.readElementText();
+        } else if (xml.name() == "getetag") {
+          etag = xml.readElementText();
+        } else if (xml.name() == "collection") {
+          collection = true;
+        }
+      } else if (xml.isEndElement() && xml.name() == "response") {
+        QString path = QUrl(href).path(QUrl::FullyDecoded);
+        if (!path.startsWith(base))
+          continue;
+        path = path.mid(base.length());
+        if (path.endsWith('/'))
+          path.chop(1);
+        if (path.isEmpty() || path + '/' == dir || !isSynced(path))
+          continue;
+        if (collection) {
+          m_remoteDirs << path;
+          list(path + '/');
+        } else {
+          m_remoteFiles.insert(path, etag);
+        }
+      }
+    }
+    if (xml.hasError()) {
+      m_failed = true;
+      m_error = tr("Invalid WebDAV listing: %1").arg(xml.errorString());
+    }
+  }
+  if (m_outstanding > 0)
+    return;
+  if (m_failed)
+    finish();
+  else
+    plan();
+}
+
+/**
+ * @brief WebDavSync::scanLocal hash every synced local file
+ */
+void WebDavSync::scanLocal() {
+  m_localFiles.clear();
+  QDir root(m_root);
+  QDirIterator it(m_root, QDir::Files | QDir::Hidden,
+                  QDirIterator::Subdirectories);
+  while (it.hasNext()) {
+    QString path = root.relativeFilePath(it.next());
+    if (!isSynced(path))
+      continue;
+    QFile file(it.filePath());
+    if (file.open(QIODevice::ReadOnly))
+      m_localFiles.insert(path, sha1(file.readAll()));
+  }
+}
+
+/**
+ * @brief WebDavSync::plan decide per file what has to happen, local
+ * deletions are done right away
+ */
+void WebDavSync::plan() {
+  QSet<QString> paths = m_remoteFiles.keys().toSet();
+  paths.unite(m_localFiles.keys().toSet());
+  paths.unite(m_state.keys().toSet());
+
+  QDir root(m_root);
+  foreach (const QString &path, paths) {
+    bool remote = m_remoteFiles.contains(path);
+    bool local = m_localFiles.contains(path);
+    bool known = m_state.contains(path);
+    bool remoteChanged =
+        remote && (!known || m_state.value(path).etag !=
+                                 m_remoteFiles.value(path));
+    bool localChanged =
+        local && (!known || m_state.value(path).hash !=
+                                m_localFiles.value(path));
+
+    if (remote && local) {
+      if (remoteChanged && localChanged) {
+        m_downloads << path;
+        m_conflicts << path;
+      } else if (remoteChanged) {
+        m_downloads << path;
+      } else if (localChanged) {
+        m_uploads << path;
+      }
+    } else if (remote) {
+      if (!known || remoteChanged)
+        m_downloads << path;
+      else
+        m_remoteDeletes << path;
+    } else if (local) {
+      if (known && !localChanged) {
+        if (root.remove(path))
+          ++m_deleted;
+        m_state.remove(path);
+      } else {
+        m_uploads << path;
+      }
+    } else {
+      m_state.remove(path);
+    }
+  }
+
+  // a folder removed locally is removed on the server as a whole, unless
+  // something below it changed there since the last sync
+  QStringList removed;
+  QStringList dirs = m_remoteDirs;
+  dirs.sort();
+  foreach (const QString &dir, dirs) {
+    if (isBelowAny(dir, removed) || root.exists(dir))
+      continue;
+    bool changed = !m_dirs.contains(dir);
+    foreach (const QString &other, m_remoteDirs)
+      changed = changed || (other.startsWith(dir + '/') &&
+                            !m_dirs.contains(other));
+    foreach (const QString &path, m_downloads)
+      changed = changed || path.startsWith(dir + '/');
+    if (!changed)
+      removed << dir;
+  }
+  foreach (const QString &dir, removed) {
+    QStringList files = m_remoteDeletes;
+    m_remoteDeletes.clear();
+    foreach (const QString &path, files) {
+      if (!path.startsWith(dir + '/'))
+        m_remoteDeletes << path;
+    }
+    m_remoteDeletes << dir + '/';
+  }
+  foreach (const QString &dir, m_remoteDirs) {
+    if (!isBelowAny(dir, removed))
+      root.mkpath(dir);
+  }
+
+  // new local folders have to exist on the server before files go in
+  QSet<QString> remoteDirs = m_remoteDirs.toSet();
+  QStringList missing;
+  foreach (const QString &path, m_uploads) {
+    QString dir = QFileInfo(path).path();
+    while (dir != "." && !dir.isEmpty() && !remoteDirs.contains(dir)) {
+      remoteDirs.insert(dir);
+      missing << dir;
+      dir = QFileInfo(dir).path();
+    }
+  }
+  // folders on both sides after this sync, removed ones are dropped once
+  // their DELETE went through
+  m_dirs = remoteDirs;
+  // parents sort before their children
+  missing.sort();
+  foreach (const QString &dir, missing)
+    m_collections.enqueue(dir);
+  m_phase = CREATING;
+  createNext();
+}
+
+/**
+ * @brief WebDavSync::createNext MKCOL the missing folders one by one
+ */
+void WebDavSync::createNext() {
+  if (m_collections.isEmpty()) {
+    transfer();
+    return;
+  }
+  QString dir = m_collections.dequeue();
+  QNetworkReply *reply =
+      m_network.sendCustomRequest(request(dir + '/'), "MKCOL");
+  connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+    reply->deleteLater();
+    // 405: it is there already
+    if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() !=
+        405)
+      requestFailed(reply);
+    createNext();
+  });
+}
+
+/**
+ * @brief WebDavSync::transfer start all downloads, uploads and deletes
+ */
+void WebDavSync::transfer() {
+  m_phase = TRANSFERRING;
+  m_outstanding = 1;
+  foreach (const QString &path, m_downloads)
+    download(path);
+  foreach (const QString &path, m_uploads)
+    upload(path);
+  foreach (const QString &path, m_remoteDeletes)
+    removeRemote(path);
+  transferred();
+}
+
+/**
+ * @brief WebDavSync::download GET a file, keeping the local version next to
+ * it if both changed
+ * @param path
+ */
+void WebDavSync::download(const QString &path) {
+  ++m_outstanding;
+  QNetworkReply *reply = m_network.get(request(path));
+  connect(reply, &QNetworkReply::finished, this, [this, reply, path]() {
+    reply->deleteLater();
+    if (!requestFailed(reply)) {
+      QByteArray data = reply->readAll();
+      QByteArray hash = sha1(data);
+      QString fileName = QDir(m_root).filePath(path);
+      if (m_conflicts.contains(path) && m_localFiles.value(path) != hash) {
+        QString conflict = conflictName(path);
+        QFile::remove(QDir(m_root).filePath(conflict));
+        if (QFile::copy(fileName, QDir(m_root).filePath(conflict))) {
+          m_localFiles.insert(conflict, m_localFiles.value(path));
+          upload(conflict);
+        }
+      }
+      QDir().mkpath(QFileInfo(fileName).path());
+      QSaveFile file(fileName);
+      if (file.open(QIODevice::WriteOnly) && file.write(data) == data.size() &&
+          file.commit()) {
+        m_state.insert(path, {m_remoteFiles.value(path), hash});
+        ++m_downloaded;
+      } else if (!m_failed) {
+        m_failed = true;
+        m_error = tr("Could not write %1").arg(fileName);
+      }
+    }
+    transferred();
+  });
+}
+
+/**
+ * @brief WebDavSync::upload PUT a file, only if the remote side is still
+ * what was listed
+ * @param path
+ */
+void WebDavSync::upload(const QString &path) {
+  QFile file(QDir(m_root).filePath(path));
+  if (!file.open(QIODevice::ReadOnly)) {
+    if (!m_failed)
+      m_error = tr("Could not read %1").arg(file.fileName());
+    m_failed = true;
+    return;
+  }
+  QByteArray data = file.readAll();
+  QNetworkRequest put = request(path);
+  put.setHeader(QNetworkRequest::ContentTypeHeader,
+                "application/octet-stream");
+  if (m_remoteFiles.contains(path) && !m_remoteFiles.value(path).isEmpty())
+    put.setRawHeader("If-Match", m_remoteFiles.value(path).toUtf8());
+  else if (!m_remoteFiles.contains(path))
+    put.setRawHeader("If-None-Match", "*");
+  ++m_outstanding;
+  QNetworkReply *reply = m_network.put(put, data);
+  QByteArray hash = sha1(data);
+  connect(reply, &QNetworkReply::finished, this, [this, reply, path, hash]() {
+    reply->deleteLater();
+    if (!requestFailed(reply)) {
+      // without an ETag the file is downloaded once more next time
+      m_state.insert(path, {QString::fromUtf8(reply->rawHeader("ETag")), hash});
+      ++m_uploaded;
+    }
+    transferred();
+  });
+}
+
+/**
+ * @brief WebDavSync::removeRemote DELETE a file or folder that was removed
+ * locally
+ * @param path  folders end with /
+ */
+void WebDavSync::removeRemote(const QString &path) {
+  QNetworkRequest remove = request(path);
+  if (!m_remoteFiles.value(path).isEmpty())
+    remove.setRawHeader("If-Match", m_remoteFiles.value(path).toUtf8());
+  ++m_outstanding;
+  QNetworkReply *reply = m_network.deleteResource(remove);
+  connect(reply, &QNetworkReply::finished, this, [this, reply, path]() {
+    reply->deleteLater();
+    if (reply->error() == QNetworkReply::ContentNotFoundError ||
+        !requestFailed(reply)) {
+      if (!path.endsWith('/')) {
+        m_state.remove(path);
+        ++m_deleted;
+      } else {
+        QString dir = path.left(path.length() - 1);
+        foreach (const QString &file, m_state.keys()) {
+          if (file.startsWith(path)) {
+            m_state.remove(file);
+            ++m_deleted;
+          }
+        }
+        foreach (const QString &known, m_dirs.toList()) {
+          if (known == dir || known.startsWith(path))
+            m_dirs.remove(known);
+        }
+      }
+    }
+    transferred();
+  });
+}
+
+/**
+ * @brief WebDavSync::transferred a transfer is done, finish after the last
+ */
+void WebDavSync::transferred() {
+  if (--m_outstanding == 0)
+    finish();
+}
+
+/**
+ * @brief WebDavSync::finish record the state and report
+ */
+void WebDavSync::finish() {
+  if (m_phase != IDLE && !saveState() && !m_failed) {
+    m_failed = true;
+    m_error = tr("Could not write %1").arg(stateFile);
+  }
+  m_phase = IDLE;
+  m_outstanding = 0;
+  dbg() << "WebDAV sync done, downloaded" << m_downloaded << "uploaded"
+        << m_uploaded << "deleted" << m_deleted;
+  emit finished(!m_failed, m_error);
+  if (m_again) {
+    m_again = false;
+    QTimer::singleShot(0, this, SLOT(sync()));
+  }
+}
+
+/**
+ * @brief WebDavSync::loadState read what the previous sync saw, nothing if
+ * it synced with another server
+ */
+void WebDavSync::loadState() {
+  m_state.clear();
+  m_dirs.clear();
+  QFile file(QDir(m_root).filePath(stateFile));
+  if (!file.open(QIODevice::ReadOnly))
+    return;
+  QJsonObject state = QJsonDocument::fromJson(file.readAll()).object();
+  if (state.value("remote").toString() != m_remote.toString())
+    return;
+  QJsonObject files = state.value("files").toObject();
+  for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+    QJsonObject f = it.value().toObject();
+    QByteArray hash = f.value("sha1").toString().toLatin1();
+    m_state.insert(it.key(),
+                   {f.value("etag").toString(), QByteArray::fromHex(hash)});
+  }
+  foreach (const QJsonValue &dir, state.value("dirs").toArray())
+    m_dirs.insert(dir.toString());
+}
+
+/**
+ * @brief WebDavSync::saveState
+ * @return false if the state file could not be written
+ */
+bool WebDavSync::saveState() {
+  QJsonObject files;
+  for (auto it = m_state.constBegin(); it != m_state.constEnd(); ++it) {
+    QJsonObject f;
+    f["etag"] = it.value().etag;
+    f["sha1"] = QString::fromLatin1(it.value().hash.toHex());
+    files[it.key()] = f;
+  }
+  QJsonObject state;
+  state["remote"] = m_remote.toString();
+  state["files"] = files;
+  QStringList dirs = m_dirs.toList();
+  dirs.sort();
+  state["dirs"] = QJsonArray::fromStringList(dirs);
+  QSaveFile file(QDir(m_root).filePath(stateFile));
+  return file.open(QIODevice::WriteOnly) &&
+         file.write(QJsonDocument(state).toJson()) >= 0 && file.commit();
+}
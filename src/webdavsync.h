@@ -0,0 +1,134 @@
+#ifndef WEBDAVSYNC_H
+#define WEBDAVSYNC_H
+
+#include <QMap>
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QQueue>
+#include <QSet>
+#include <QUrl>
+
+/*!
+    \class WebDavSync
+    \brief Mirrors a password-store on a WebDAV server into a local folder.
+
+    The remote store is listed with PROPFIND, one collection at a time, and
+    compared to the ETags and content hashes recorded by the previous sync
+    in stateFile. Only files that changed on one side are transferred:
+    remote changes are downloaded, local changes uploaded, and deletions on
+    either side are carried over when the other side did not change the
+    file in the meantime. A folder removed locally is removed on the server
+    as a whole when nothing below it changed there. When both sides changed
+    a file, the remote version wins and the local one is kept, and
+    uploaded, next to it as "<name>.conflict.gpg".
+
+    Hidden files and folders, like .git, are left alone except for .gpg-id.
+ */
+class QAuthenticator;
+class QNetworkReply;
+class WebDavSync : public QObject {
+  Q_OBJECT
+
+public:
+  explicit WebDavSync(QObject *parent = nullptr);
+
+  void setRemote(const QUrl &url);
+  QUrl remote() const;
+  void setCredentials(const QString &user, const QString &password);
+  void setLocalRoot(const QString &root);
+  QString localRoot() const;
+
+  bool isRunning() const;
+  int downloaded() const;
+  int uploaded() const;
+  int deleted() const;
+
+  /**
+   * @brief stateFile   name of the file in the local root that holds what
+   *                    the previous sync saw
+   */
+  static const QString stateFile;
+
+public slots:
+  void sync();
+
+signals:
+  /**
+   * @brief finished    the sync is over
+   * @param ok          false if a request failed, files that were
+   *                    transferred before that are kept and recorded
+   * @param error       what went wrong
+   */
+  void finished(bool ok, const QString &error);
+
+private slots:
+  void authenticate(QNetworkReply *reply, QAuthenticator *authenticator);
+
+private:
+  enum Phase { IDLE, LISTING, CREATING, TRANSFERRING };
+
+  /*!
+      \struct fileState
+      \brief What both sides looked like when a file was last in sync.
+   */
+  struct fileState {
+    QString etag;
+    QByteArray hash;
+  };
+
+  QNetworkAccessManager m_network;
+  QUrl m_remote;
+  QString m_user;
+  QString m_password;
+  QString m_root;
+  Phase m_phase;
+  int m_outstanding;
+  bool m_failed;
+  QString m_error;
+  bool m_again;
+  int m_downloaded;
+  int m_uploaded;
+  int m_deleted;
+  /**
+   * @brief m_remoteFiles   ETag of every remote file, by relative path
+   */
+  QMap<QString, QString> m_remoteFiles;
+  QStringList m_remoteDirs;
+  QMap<QString, QByteArray> m_localFiles;
+  QMap<QString, fileState> m_state;
+  /**
+   * @brief m_dirs  folders that were on both sides after the previous sync
+   */
+  QSet<QString> m_dirs;
+  QQueue<QString> m_collections;
+  QStringList m_downloads;
+  /**
+   * @brief m_conflicts downloads that may overwrite a local change
+   */
+  QStringList m_conflicts;
+  QStringList m_uploads;
+  QStringList m_remoteDeletes;
+
+  QNetworkRequest request(const QString &path) const;
+  bool requestFailed(QNetworkReply *reply);
+  static bool isSynced(const QString &path);
+  static bool isBelowAny(const QString &path, const QStringList &dirs);
+
+  void list(const QString &dir);
+  void listed(QNetworkReply *reply, const QString &dir);
+  void scanLocal();
+  void plan();
+  void createNext();
+  void transfer();
+  void download(const QString &path);
+  void upload(const QString &path);
+  void removeRemote(const QString &path);
+  void transferred();
+  void finish();
+
+  void loadState();
+  bool saveState();
+};
+
+#endif // WEBDAVSYNC_H
@@ -1,7 +1,23 @@
+#include "../../../src/copyengine.h"
+#include "../../../src/entryranker.h"
+#include "../../../src/fieldindex.h"
 #include "../../../src/filecontent.h"
+#include "../../../src/folderscan.h"
+#include "../../../src/importreader.h"
+#include "../../../src/localapi.h"
+#include "../../../src/securebuffer.h"
+#include "../../../src/storeindex.h"
+#include "../../../src/tarwriter.h"
+#include "../../../src/tracer.h"
+#include "../../../src/urlmatcher.h"
+#include "../../../src/transaction.h"
 #include "../../../src/util.h"
+#include <QBuffer>
 #include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
 #include <QList>
+#include <QTemporaryDir>
 #include <QtTest>
 
 /**
@@ -22,7 +38,22 @@ private Q_SLOTS:
   void initTestCase();
   void cleanupTestCase();
   void normalizeFolderPath();
+  void topLevelPaths();
   void fileContent();
+  void localApiFrames();
+  void tracer();
+  void storeIndex();
+  void storeSwitch();
+  void transaction();
+  void copyEngine();
+  void folderScan();
+  void importCsv();
+  void importKeePassXml();
+  void tarWriter();
+  void secureBuffer();
+  void fieldIndex();
+  void urlMatcher();
+  void entryRanker();
 };
 
 bool operator==(const NamedValue &a, const NamedValue &b) {
@@ -70,6 +101,16 @@ void tst_util::normalizeFolderPath() {
            QDir::toNativeSeparators("test/"));
 }
 
+/**
+ * @brief tst_util::topLevelPaths paths inside a selected folder are dropped,
+ * also when siblings sort between the folder and its content
+ */
+void tst_util::topLevelPaths() {
+  QCOMPARE(Util::topLevelPaths({"/s/a/x", "/s/a-b", "/s/a", "/s/a-b/y",
+                                "/s/c.gpg", "/s/a"}),
+           QStringList({"/s/a", "/s/a-b", "/s/c.gpg"}));
+}
+
 void tst_util::fileContent() {
   NamedValue key = {"key", "val"};
   NamedValue key2 = {"key2", "val2"};
@@ -101,5 +142,641 @@ void tst_util::fileContent() {
   QCOMPARE(fc.getRemainingData(), QString());
 }
 
+/**
+ * @brief tst_util::localApiFrames messages survive the wire format, also when
+ * they arrive in pieces.
+ */
+void tst_util::localApiFrames() {
+  QJsonObject request = LocalApi::request("search");
+  request["id"] = 7;
+  request["query"] = QString::fromUtf8("caf\xc3\xa9 web");
+
+  QByteArray data = LocalApi::frame(request) + LocalApi::frame(request);
+  QCOMPARE(data.at(0), '\0');
+
+  QByteArray buffer = data.left(5);
+  QJsonObject message;
+  QCOMPARE(LocalApi::takeFrame(buffer, &message), LocalApi::FRAME_INCOMPLETE);
+  buffer.append(data.mid(5));
+  QCOMPARE(LocalApi::takeFrame(buffer, &message), LocalApi::FRAME_OK);
+  QCOMPARE(message, request);
+  QCOMPARE(LocalApi::takeFrame(buffer, &message), LocalApi::FRAME_OK);
+  QCOMPARE(LocalApi::takeFrame(buffer, &message), LocalApi::FRAME_INCOMPLETE);
+
+  QJsonObject reply = LocalApi::errorReply(request, "nope");
+  QCOMPARE(reply.value("id").toInt(), 7);
+  QCOMPARE(reply.value("ok").toBool(), false);
+
+  buffer = QByteArray("\xff\xff\xff\xff", 4);
+  QCOMPARE(LocalApi::takeFrame(buffer, &message), LocalApi::FRAME_INVALID);
+}
+
+/**
+ * @brief tst_util::tracer spans are only recorded while enabled and come out
+ * as Chrome trace events.
+ */
+void tst_util::tracer() {
+  Tracer::clear();
+  {
+    Tracer::Span ignored("ignored", "ui");
+    ignored.arg("length", 1);
+  }
+  QCOMPARE(Tracer::count(), 0);
+
+  Tracer::setEnabled(true);
+  {
+    Tracer::Span span("filter", "ui");
+    span.arg("length", 3);
+  }
+  Tracer::complete("gpg2", "process", Tracer::now(), 42,
+                   QVariantMap{{"exitCode", 0}}, Tracer::EXECUTOR);
+  Tracer::setEnabled(false);
+  QCOMPARE(Tracer::count(), 2);
+
+  QJsonArray events = QJsonDocument::fromJson(Tracer::toJson())
+                          .object()
+                          .value("traceEvents")
+                          .toArray();
+  QCOMPARE(events.size(), 3); // process name and the two spans
+  QJsonObject filter = events.at(1).toObject();
+  QCOMPARE(filter.value("name").toString(), QString("filter"));
+  QCOMPARE(filter.value("ph").toString(), QString("X"));
+  QCOMPARE(filter.value("args").toObject().value("length").toInt(), 3);
+  QJsonObject gpg = events.at(2).toObject();
+  QCOMPARE(gpg.value("dur").toInt(), 42);
+  QCOMPARE(gpg.value("tid").toInt(), int(Tracer::EXECUTOR));
+  Tracer::clear();
+}
+
+/**
+ * @brief tst_util::storeIndex entries are found like the search box finds
+ * them and hidden directories are ignored.
+ */
+void tst_util::storeIndex() {
+  QTemporaryDir store;
+  QVERIFY(store.isValid());
+  QDir root(store.path());
+  QVERIFY(root.mkpath("web/shop"));
+  QVERIFY(root.mkpath(".git"));
+  QStringList files = {"web/shop/Example.gpg", "web/mail.gpg", "bank.gpg",
+                       ".gpg-id", ".git/config.gpg"};
+  foreach (QString file, files) {
+    QFile f(root.filePath(file));
+    QVERIFY(f.open(QIODevice::WriteOnly));
+  }
+
+  StoreIndex index;
+  index.setRoot(store.path());
+  QCOMPARE(index.entries(),
+           QStringList({"bank", "web/mail", "web/shop/Example"}));
+  QCOMPARE(index.search("web exa"), QStringList({"web/shop/Example"}));
+  QVERIFY(index.contains("web/mail"));
+  QVERIFY(!index.contains("web/mail.gpg"));
+}
+
+/**
+ * @brief tst_util::storeSwitch pointing the indexes at another store, like a
+ * profile switch does, drops the results of the previous one.
+ */
+void tst_util::storeSwitch() {
+  QTemporaryDir work, personal;
+  QVERIFY(work.isValid() && personal.isValid());
+  QVERIFY(QFile(work.filePath("vpn.gpg")).open(QIODevice::WriteOnly));
+  QVERIFY(QFile(personal.filePath("bank.gpg")).open(QIODevice::WriteOnly));
+
+  StoreIndex index;
+  FieldIndex fields;
+  index.setRoot(work.path() + "/");
+  fields.setRoot(work.path() + "/");
+  fields.setContent("vpn", "s3cret\nuser: alice\n", 0);
+  QCOMPARE(index.search("vpn"), QStringList("vpn"));
+  QCOMPARE(fields.search("user:alice", index.entries()), QStringList("vpn"));
+
+  QSignalSpy changed(&index, SIGNAL(changed()));
+  index.setRoot(personal.path() + "/");
+  fields.setRoot(personal.path() + "/");
+  index.setRoot(personal.path());
+  QCOMPARE(changed.count(), 1);
+  QCOMPARE(index.entries(), QStringList("bank"));
+  QCOMPARE(index.search("vpn"), QStringList());
+  QVERIFY(fields.isEmpty());
+  QCOMPARE(fields.search("user:alice", index.entries()), QStringList());
+}
+
+/**
+ * @brief tst_util::transaction steps run in dependency order with piped
+ * input and report progress, a failure skips the dependents and restores
+ * the touched file as it was after the preludes.
+ */
+void tst_util::transaction() {
+#ifdef Q_OS_UNIX
+  QTemporaryDir store;
+  QVERIFY(store.isValid());
+  QString file = store.path() + "/entry";
+  QStringList steps;
+
+  Transaction *write = new Transaction(this);
+  write->touch(file);
+  int secret = write->addProcess("/bin/sh", {"-c", "printf secret"});
+  int save = write->addProcess("/bin/sh", {"-c", "cat > \"$0\"", file});
+  write->setInputFrom(save, secret);
+  write->addTask(
+      [&](Transaction *, QString *) {
+        QFile f(file);
+        steps << (f.open(QIODevice::ReadOnly) ? QString(f.readAll())
+                                               : QString("missing"));
+        return true;
+      },
+      {save});
+  QSignalSpy written(write, SIGNAL(finished(int, QByteArray, QByteArray)));
+  QSignalSpy progress(write, SIGNAL(progress(int, int)));
+  write->start();
+  QVERIFY(written.wait());
+  QCOMPARE(written.at(0).at(0).toInt(), 0);
+  QCOMPARE(progress.size(), 3);
+  QCOMPARE(progress.last().at(0).toInt(), 3);
+  QCOMPARE(progress.last().at(1).toInt(), 3);
+  QVERIFY(!written.at(0).at(1).toByteArray().contains("secret"));
+  QCOMPARE(steps, QStringList({"secret"}));
+
+  Transaction *broken = new Transaction(this);
+  broken->touch(file);
+  broken->touch(store.path() + "/new");
+  broken->addProcess("/bin/sh", {"-c", "printf changed > \"$0\"", file});
+  broken->addProcess("/bin/sh", {"-c", "touch \"$0\"", store.path() + "/new"});
+  int fail = broken->addProcess("/bin/sh", {"-c", "exit 3"});
+  broken->addTask(
+      [&](Transaction *, QString *) {
+        steps << "dependent";
+        return true;
+      },
+      {fail});
+  QSignalSpy failed(broken, SIGNAL(finished(int, QByteArray, QByteArray)));
+  broken->start();
+  QVERIFY(failed.wait());
+  QCOMPARE(failed.at(0).at(0).toInt(), 3);
+  QCOMPARE(steps, QStringList({"secret"}));
+  QFile restored(file);
+  QVERIFY(restored.open(QIODevice::ReadOnly));
+  QCOMPARE(restored.readAll(), QByteArray("secret"));
+  QVERIFY(!QFile::exists(store.path() + "/new"));
+
+  // relative paths are touched before the Executor sets the working dir
+  Transaction *relative = new Transaction(this);
+  relative->touch("entry");
+  relative->touch("folder/added.gpg");
+  relative->addProcess("/bin/sh", {"-c", "printf changed > entry"});
+  QString folder = store.path() + "/folder";
+  relative->addJob([folder](QString *) {
+    QFile added(folder + "/added.gpg");
+    return QDir().mkpath(folder) && added.open(QIODevice::WriteOnly);
+  });
+  relative->addProcess("/bin/sh", {"-c", "exit 1"});
+  relative->setWorkingDirectory(store.path());
+  QSignalSpy undone(relative, SIGNAL(finished(int, QByteArray, QByteArray)));
+  relative->start();
+  QVERIFY(undone.wait());
+  QCOMPARE(undone.at(0).at(0).toInt(), 1);
+  restored.close();
+  QVERIFY(restored.open(QIODevice::ReadOnly));
+  QCOMPARE(restored.readAll(), QByteArray("secret"));
+  QVERIFY(!QFile::exists(store.path() + "/folder/added.gpg"));
+
+  // what a prelude, like a pull, changed is kept on rollback
+  Transaction *pulled = new Transaction(this);
+  pulled->touch(store.path());
+  int pull = pulled->addProcess(
+      "/bin/sh", {"-c", "printf pulled > \"$0\"; : > \"$0.new\"", file});
+  pulled->setPrelude(pull);
+  pulled->addProcess("/bin/sh", {"-c", "printf changed > \"$0\"", file});
+  pulled->addProcess("/bin/sh", {"-c", "exit 2"});
+  QSignalSpy kept(pulled, SIGNAL(finished(int, QByteArray, QByteArray)));
+  pulled->start();
+  QVERIFY(kept.wait());
+  QCOMPARE(kept.at(0).at(0).toInt(), 2);
+  restored.close();
+  QVERIFY(restored.open(QIODevice::ReadOnly));
+  QCOMPARE(restored.readAll(), QByteArray("pulled"));
+  QVERIFY(QFile::exists(file + ".new"));
+
+  // paths touched by a task are recorded before the next steps run
+  Transaction *late = new Transaction(this);
+  late->touch(store.path() + "/late/entry.gpg");
+  late->addTask([&](Transaction *t, QString *) {
+    t->touch(file);
+    t->touch(store.path() + "/late");
+    int change = t->addProcess(
+        "/bin/sh", {"-c", "printf late > \"$0\"; mkdir \"$1\"", file,
+                    store.path() + "/late"});
+    t->addProcess("/bin/sh", {"-c", "exit 4"}, {change});
+    return true;
+  });
+  QSignalSpy lateDone(late, SIGNAL(finished(int, QByteArray, QByteArray)));
+  late->start();
+  QVERIFY(lateDone.wait());
+  QCOMPARE(lateDone.at(0).at(0).toInt(), 4);
+  restored.close();
+  QVERIFY(restored.open(QIODevice::ReadOnly));
+  QCOMPARE(restored.readAll(), QByteArray("pulled"));
+  QVERIFY(!QFile::exists(store.path() + "/late"));
+#endif
+}
+
+/**
+ * @brief tst_util::copyEngine a tree is copied with its hidden files and
+ * permissions, and nothing is overwritten.
+ */
+void tst_util::copyEngine() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  QString src = dir.path() + "/src";
+  QStringList files = {".gpg-id", "a.gpg", "team/.gpg-id", "team/b.gpg",
+                       "team/deep/c.gpg"};
+  foreach (const QString &file, files) {
+    QString fileName = src + "/" + file;
+    QVERIFY(QDir().mkpath(QFileInfo(fileName).path()));
+    QFile f(fileName);
+    QVERIFY(f.open(QIODevice::WriteOnly));
+    f.write(file.toUtf8().repeated(1000));
+  }
+  QVERIFY(QFile::setPermissions(src + "/a.gpg",
+                                QFile::ReadOwner | QFile::WriteOwner));
+#ifdef Q_OS_UNIX
+  // read-only folders get their permissions once their files are copied
+  QFile::Permissions owner =
+      QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner;
+  QFile::Permissions readOnly = QFile::ReadOwner | QFile::ExeOwner;
+  QVERIFY(QFile::setPermissions(src + "/team/deep", readOnly));
+#endif
+
+  QString error;
+  bool copied = CopyEngine::copyTree(src, dir.path() + "/copy", &error, 2);
+#ifdef Q_OS_UNIX
+  QFile::Permissions copiedDeep =
+      QFile::permissions(dir.path() + "/copy/team/deep");
+  // let QTemporaryDir clean up
+  QFile::setPermissions(src + "/team/deep", owner);
+  QFile::setPermissions(dir.path() + "/copy/team/deep", owner);
+  QCOMPARE(copiedDeep & owner, readOnly);
+#endif
+  QVERIFY(copied);
+  QVERIFY(error.isEmpty());
+  foreach (const QString &file, files) {
+    QFile original(src + "/" + file);
+    QFile copy(dir.path() + "/copy/" + file);
+    QVERIFY(original.open(QIODevice::ReadOnly));
+    QVERIFY(copy.open(QIODevice::ReadOnly));
+    QCOMPARE(copy.readAll(), original.readAll());
+  }
+  QCOMPARE(QFile::permissions(dir.path() + "/copy/a.gpg"),
+           QFile::permissions(src + "/a.gpg"));
+
+  QVERIFY(CopyEngine::copyFile(src + "/a.gpg", dir.path() + "/copy/a.gpg",
+                               &error) == CopyEngine::FAILED);
+  QVERIFY(!error.isEmpty());
+  QVERIFY(CopyEngine::copyFile(src + "/team/b.gpg", dir.path() + "/b.gpg") !=
+          CopyEngine::FAILED);
+}
+
+/**
+ * @brief tst_util::folderScan a folder is counted on a thread of its own,
+ * or straight from an up to date index, and stray files are reported.
+ */
+void tst_util::folderScan() {
+  QTemporaryDir store;
+  QVERIFY(store.isValid());
+  QDir root(store.path());
+  QVERIFY(root.mkpath("web/shop"));
+  QVERIFY(root.mkpath("web/.hidden"));
+  QStringList files = {"web/shop/Example.gpg", "web/mail.gpg",
+                       "web/notes.txt",        "web/.gpg-id",
+                       "web/.hidden/x.txt",    "bank.gpg"};
+  foreach (QString file, files) {
+    QFile f(root.filePath(file));
+    QVERIFY(f.open(QIODevice::WriteOnly));
+  }
+
+  FolderScan walk(root.filePath("web"));
+  QSignalSpy walked(&walk, SIGNAL(finished(int, const QStringList &)));
+  walk.start();
+  QVERIFY(walked.wait(5000));
+  QCOMPARE(walked.first().at(0).toInt(), 2);
+  QCOMPARE(walked.first().at(1).toStringList(), QStringList({"notes.txt"}));
+
+  StoreIndex index;
+  index.setRoot(store.path());
+  QCOMPARE(index.others(), QStringList({"web/notes.txt"}));
+  FolderScan indexed(root.filePath("web"));
+  QSignalSpy found(&indexed, SIGNAL(finished(int, const QStringList &)));
+  indexed.start(&index);
+  QCOMPARE(found.size(), 1);
+  QCOMPARE(found.first().at(0).toInt(), 2);
+  QCOMPARE(found.first().at(1).toStringList(), QStringList({"notes.txt"}));
+}
+
+/**
+ * @brief tst_util::importCsv columns are mapped by their names, quoted
+ * fields may hold separators, quotes and line breaks.
+ */
+void tst_util::importCsv() {
+  QByteArray csv = "\xef\xbb\xbfGroup;Title;Username;Password;URL;Notes;PIN\n"
+                   "web/shop;Example;alice;\"se;cr\"\"et\";https://e.com;"
+                   "\"two\nlines\";1234\n"
+                   "\n"
+                   ";a/b;;x;;;\n";
+  QBuffer buffer(&csv);
+  QVERIFY(buffer.open(QIODevice::ReadOnly));
+  ImportReader reader;
+  reader.setDevice(&buffer, ImportReader::CSV);
+  ImportRecord record;
+
+  QVERIFY(reader.next(&record));
+  QCOMPARE(record.path(), QString("web/shop/Example"));
+  QCOMPARE(record.password, QString("se;cr\"et"));
+  QCOMPARE(record.content(), QString("se;cr\"et\nlogin: alice\n"
+                                     "url: https://e.com\nPIN: 1234\n"
+                                     "two\nlines\n"));
+  FileContent parsed =
+      FileContent::parse(record.content(), {"login", "url"}, true);
+  QCOMPARE(parsed.getPassword(), QString("se;cr\"et"));
+  QCOMPARE(parsed.getNamedValues().takeValue("PIN"), QString("1234"));
+
+  QVERIFY(reader.next(&record));
+  QCOMPARE(record.path(), QString("a-b"));
+  QVERIFY(!reader.next(&record));
+  QVERIFY(!reader.hasError());
+  QCOMPARE(reader.recordsRead(), 2);
+  QVERIFY(record.password.isEmpty());
+
+  QByteArray broken = "name,password\nx,\"open\n";
+  QBuffer brokenBuffer(&broken);
+  QVERIFY(brokenBuffer.open(QIODevice::ReadOnly));
+  reader.setDevice(&brokenBuffer, ImportReader::CSV);
+  QVERIFY(!reader.next(&record));
+  QVERIFY(reader.hasError());
+}
+
+/**
+ * @brief tst_util::importKeePassXml groups become folders below the root
+ * group, history and the recycle bin are left out.
+ */
+void tst_util::importKeePassXml() {
+  QByteArray xml =
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?><KeePassFile><Meta>"
+      "<RecycleBinUUID>BIN</RecycleBinUUID></Meta><Root><Group>"
+      "<UUID>ROOT</UUID><Name>Database</Name>"
+      "<Entry><UUID>E1</UUID><String><Key>Title</Key><Value>.top</Value>"
+      "</String><String><Key>Password</Key><Value ProtectInMemory=\"True\">"
+      "p1</Value></String><History><Entry><String><Key>Title</Key>"
+      "<Value>old</Value></String></Entry></History></Entry>"
+      "<Group><UUID>G1</UUID><Name>Mail</Name><Times><LastModificationTime>"
+      "2020</LastModificationTime></Times><Entry><String><Key>Title</Key>"
+      "<Value>Work</Value></String><String><Key>UserName</Key><Value>bob"
+      "</Value></String><String><Key>Password</Key><Value>p2</Value>"
+      "</String><String><Key>name</Key><Value>custom</Value></String>"
+      "</Entry></Group>"
+      "<Group><UUID>BIN</UUID><Name>Recycle Bin</Name><Entry><String>"
+      "<Key>Title</Key><Value>gone</Value></String></Entry></Group>"
+      "</Group></Root></KeePassFile>";
+  QBuffer buffer(&xml);
+  QVERIFY(buffer.open(QIODevice::ReadOnly));
+  ImportReader reader;
+  reader.setDevice(&buffer, ImportReader::KEEPASS_XML);
+  ImportRecord record;
+
+  QVERIFY(reader.next(&record));
+  QCOMPARE(record.path(), QString("_top"));
+  QCOMPARE(record.password, QString("p1"));
+  QVERIFY(reader.next(&record));
+  QCOMPARE(record.path(), QString("Mail/Work"));
+  QCOMPARE(record.content(),
+           QString("p2\nlogin: bob\nname: custom\n"));
+  QVERIFY(!reader.next(&record));
+  QVERIFY(!reader.hasError());
+  QCOMPARE(reader.recordsRead(), 2);
+}
+
+/**
+ * @brief tst_util::tarWriter headers are valid ustar, long names are kept
+ * and the archive only gets its name when finished.
+ */
+void tst_util::tarWriter() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  QString archive = dir.filePath("export.tar");
+  // too long for a ustar header, even when split at the slash
+  QString longName = "folder/" + QString(120, 'x') + ".gpg";
+  {
+    TarWriter tar;
+    QVERIFY(tar.open(archive));
+    QVERIFY(tar.addFile("web/mail.gpg", "secret"));
+    QVERIFY(!QFile::exists(archive));
+  }
+  QVERIFY(!QFile::exists(TarWriter::partName(archive)));
+
+  TarWriter tar;
+  QVERIFY(tar.open(archive));
+  QVERIFY(tar.addFile("web/mail.gpg", "secret"));
+  QVERIFY(tar.addFile(longName, QByteArray(600, 'x')));
+  QVERIFY(tar.finish());
+  QCOMPARE(tar.fileCount(), 2);
+  QVERIFY(!QFile::exists(TarWriter::partName(archive)));
+
+  QFile file(archive);
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  QByteArray data = file.readAll();
+  QCOMPARE(data.size() % 512, 0);
+  QCOMPARE(data.right(1024), QByteArray(1024, '\0'));
+
+  // header, data, then a long name record, its block and the header
+  QByteArray header = data.left(512);
+  QCOMPARE(header.left(13), QByteArray("web/mail.gpg\0"));
+  QCOMPARE(header.mid(257, 6), QByteArray("ustar\0", 6));
+  QCOMPARE(header.mid(124, 12).toInt(nullptr, 8), 6);
+  int sum = 0;
+  for (int n = 0; n < 512; ++n)
+    sum += n >= 148 && n < 156 ? ' ' : static_cast<unsigned char>(header.at(n));
+  QCOMPARE(header.mid(148, 6).toInt(nullptr, 8), sum);
+  QCOMPARE(data.mid(512, 6), QByteArray("secret"));
+
+  QByteArray longLink = data.mid(1024, 512);
+  QCOMPARE(longLink.at(156), 'L');
+  QCOMPARE(data.mid(1536, longName.size()), longName.toUtf8());
+  QCOMPARE(data.mid(2048 + 156, 1), QByteArray("0"));
+  QCOMPARE(data.size(), 2560 + 1024 + 1024);
+}
+
+/**
+ * @brief tst_util::secureBuffer moving keeps one copy, growing and clearing
+ * give the memory back and nothing is held once the buffers are gone.
+ */
+void tst_util::secureBuffer() {
+  qint64 before = SecureBuffer::liveBytes();
+  {
+    SecureBuffer buffer(QByteArray("hunter2\nlogin: me"));
+    QCOMPARE(buffer.size(), 17);
+    QVERIFY(SecureBuffer::liveBytes() >= before + 17);
+    QCOMPARE(buffer.toString(buffer.indexOf('\n')), QString("hunter2"));
+    QCOMPARE(buffer.indexOf('x'), -1);
+
+    qint64 held = SecureBuffer::liveBytes();
+    SecureBuffer moved(std::move(buffer));
+    QVERIFY(buffer.isEmpty());
+    QCOMPARE(SecureBuffer::liveBytes(), held);
+    QCOMPARE(moved.toString(), QString("hunter2\nlogin: me"));
+
+    QByteArray big(100000, 'x');
+    moved.append(big.constData(), big.size());
+    QCOMPARE(moved.size(), 100017);
+    QCOMPARE(moved.toString(7), QString("hunter2"));
+    QVERIFY(SecureBuffer::liveBytes() >= before + 100017);
+
+    moved.clear();
+    QVERIFY(moved.isEmpty());
+    QCOMPARE(SecureBuffer::liveBytes(), before);
+    moved = SecureBuffer("again", 5);
+  }
+  QCOMPARE(SecureBuffer::liveBytes(), before);
+
+  QString text = QString("secret").repeated(2);
+  SecureBuffer::wipe(&text);
+  QVERIFY(text.isEmpty());
+  QString shared = "still needed";
+  QString copy = shared;
+  SecureBuffer::wipe(&copy);
+  QCOMPARE(shared, QString("still needed"));
+}
+
+/**
+ * @brief tst_util::fieldIndex field terms search the indexed fields,
+ * passwords are not kept and only changed entries are stale.
+ */
+void tst_util::fieldIndex() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  QDir(dir.path()).mkpath("web");
+  QStringList entries = {"web/mail", "web/shop", "bank"};
+  foreach (const QString &entry, entries) {
+    QFile file(dir.filePath(entry + ".gpg"));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+  }
+
+  FieldIndex index;
+  index.setRoot(dir.path());
+  QCOMPARE(index.stale(entries), entries);
+  index.setContent("web/mail",
+                   "hunter2\nusername: alice\npin: 1234\n"
+                   "see https://mail.example.com/login\n",
+                   QFileInfo(dir.filePath("web/mail.gpg"))
+                       .lastModified()
+                       .toMSecsSinceEpoch());
+  index.setContent("web/shop", "s3cret\nlogin: bob\nurl: shop.example.org\n",
+                   0);
+  QVERIFY(index.isModified());
+  QCOMPARE(index.stale(entries), QStringList({"web/shop", "bank"}));
+
+  NamedValues fields = index.fields("web/mail");
+  QCOMPARE(fields.size(), 2);
+  QCOMPARE(fields.at(0).name, QString("username"));
+  QCOMPARE(fields.at(1).value, QString("https://mail.example.com/login"));
+
+  QVERIFY(FieldIndex::isFieldQuery("user:alice"));
+  QVERIFY(!FieldIndex::isFieldQuery("https://example.com"));
+  QCOMPARE(index.search("user:alice", entries), QStringList("web/mail"));
+  QCOMPARE(index.search("url:example", entries),
+           QStringList({"web/mail", "web/shop"}));
+  QCOMPARE(index.search("shop url:example", entries),
+           QStringList("web/shop"));
+  QCOMPARE(index.search("pin:1234", entries), QStringList());
+  QCOMPARE(index.search("web", entries), QStringList({"web/mail", "web/shop"}));
+
+  QByteArray saved = index.save();
+  FieldIndex loaded;
+  loaded.setRoot(dir.path());
+  QVERIFY(loaded.load(saved));
+  QCOMPARE(loaded.size(), 2);
+  QCOMPARE(loaded.search("login:bob", entries), QStringList("web/shop"));
+  QVERIFY(!loaded.load("not an index"));
+  QVERIFY(loaded.isEmpty());
+
+  index.stale({"bank"});
+  QCOMPARE(index.size(), 0);
+}
+
+/**
+ * @brief tst_util::urlMatcher URLs find the entries of their domain, the
+ * most specific ones first.
+ */
+void tst_util::urlMatcher() {
+  QCOMPARE(UrlMatcher::host("HTTPS://www.Example.com:8443/path?q=1"),
+           QString("example.com"));
+  QCOMPARE(UrlMatcher::hostsInPath("mail/bob@mail.example.com"),
+           QStringList("mail.example.com"));
+  QVERIFY(UrlMatcher::looksLikeUrl("https://login.example.com/x"));
+  QVERIFY(UrlMatcher::looksLikeUrl("example.com"));
+  QVERIFY(!UrlMatcher::looksLikeUrl("web/example"));
+  QVERIFY(!UrlMatcher::looksLikeUrl("url:example.com"));
+
+  UrlMatcher matcher;
+  QVERIFY(matcher.isEmpty());
+  matcher.addEntry("web/example.com");
+  matcher.addEntry("web/login.example.com/alice");
+  matcher.addEntry("mail/bob@mail.example.com");
+  matcher.addEntry("shop/amazon.co.uk");
+  matcher.addEntry("bank", {"https://www.bank.example.org/login"});
+  matcher.addEntry("notes/todo");
+  matcher.addEntry("dev/alice.github.io");
+  QVERIFY(!matcher.isEmpty());
+
+  QCOMPARE(matcher.match("https://login.example.com/x"),
+           QStringList({"web/login.example.com/alice", "web/example.com",
+                        "mail/bob@mail.example.com"}));
+  QCOMPARE(matcher.match("example.com"),
+           QStringList({"web/example.com", "mail/bob@mail.example.com",
+                        "web/login.example.com/alice"}));
+  QCOMPARE(matcher.match("https://deep.login.example.com", 1),
+           QStringList("web/login.example.com/alice"));
+  QCOMPARE(matcher.match("amazon.co.uk"), QStringList("shop/amazon.co.uk"));
+  QCOMPARE(matcher.match("bank.example.org"), QStringList("bank"));
+  QVERIFY(matcher.match("ebay.co.uk").isEmpty());
+  QVERIFY(matcher.match("example.net").isEmpty());
+  QVERIFY(matcher.match("com").isEmpty());
+  QVERIFY(matcher.match("evil.github.io").isEmpty());
+  QCOMPARE(matcher.match("https://login.example.com/x", -1, false),
+           QStringList({"web/login.example.com/alice", "web/example.com"}));
+  QCOMPARE(matcher.match("shop.example.com", -1, false),
+           QStringList("web/example.com"));
+  QCOMPARE(matcher.match("alice.github.io"),
+           QStringList("dev/alice.github.io"));
+}
+
+/**
+ * @brief tst_util::entryRanker hits in the name come first, a longer query
+ * narrows the previous results
+ */
+void tst_util::entryRanker() {
+  QVERIFY(EntryRanker::score("web/github.com", {"git"}) >
+          EntryRanker::score("git/example", {"git"}));
+  QVERIFY(EntryRanker::score("web/git", {"git"}) >
+          EntryRanker::score("web/github.com", {"git"}));
+  QCOMPARE(EntryRanker::score("web/example", {"mail"}), -1);
+  QCOMPARE(EntryRanker::score("web/example", {"example", "web"}), -1);
+
+  EntryRanker ranker;
+  ranker.setEntries({"git/example", "mail/alice", "web/digital",
+                     "web/github.com", "web/git"});
+  QCOMPARE(ranker.size(), 5);
+  QCOMPARE(ranker.rank("", 2), QStringList({"git/example", "mail/alice"}));
+  QCOMPARE(ranker.rank("g", 10).size(), 4);
+  QCOMPARE(ranker.rank("GIT", 10),
+           QStringList({"web/git", "web/github.com", "web/digital",
+                        "git/example"}));
+  QCOMPARE(ranker.rank("git", 1), QStringList("web/git"));
+  QCOMPARE(ranker.rank("git hub", 10), QStringList("web/github.com"));
+  QCOMPARE(ranker.rank("git ex", 10), QStringList("git/example"));
+  QVERIFY(ranker.rank("gitx", 10).isEmpty());
+  QCOMPARE(ranker.rank("ali", 10), QStringList("mail/alice"));
+}
+
 QTEST_MAIN(tst_util)
 #include "tst_util.moc"
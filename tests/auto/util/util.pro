@@ -5,7 +5,18 @@ SOURCES += tst_util.cpp \
 LIBS = -L"$$OUT_PWD/../../../src/$(OBJECTS_DIR)" -lqtpass $$LIBS
 
 HEADERS   += util.h \
-             filecontent.h
+             filecontent.h \
+             localapi.h \
+             tracer.h \
+             copyengine.h \
+             folderscan.h \
+             importreader.h \
+             tarwriter.h \
+             securebuffer.h \
+             fieldindex.h \
+             urlmatcher.h \
+             entryranker.h \
+             storeindex.h
 
 OBJ_PATH += ../../../src/$(OBJECTS_DIR)
 
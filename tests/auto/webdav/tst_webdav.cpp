@@ -0,0 +1,381 @@
+#include "../../../src/webdavsync.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QtTest>
+
+/**
+ * @brief The FakeDav class is a minimal WebDAV server on a temporary folder,
+ * it knows just enough of PROPFIND, GET, PUT, DELETE and MKCOL for
+ * WebDavSync and counts the requests it gets.
+ */
+class FakeDav : public QObject {
+  Q_OBJECT
+
+public:
+  QTemporaryDir files;
+  QStringList requests;
+
+  bool start() {
+    connect(&server, &QTcpServer::newConnection, this, &FakeDav::accept);
+    return files.isValid() && server.listen(QHostAddress::LocalHost);
+  }
+
+  QUrl url() const {
+    return QUrl(QString("http://127.0.0.1:%1/store/").arg(server.serverPort()));
+  }
+
+  void write(const QString &path, const QByteArray &data) {
+    QString fileName = files.filePath(path);
+    QDir().mkpath(QFileInfo(fileName).path());
+    QFile file(fileName);
+    file.open(QIODevice::WriteOnly);
+    file.write(data);
+  }
+
+  QByteArray read(const QString &path) const {
+    QFile file(files.filePath(path));
+    file.open(QIODevice::ReadOnly);
+    return file.readAll();
+  }
+
+  QStringList requested(const QString &method) const {
+    return requests.filter(QRegularExpression("^" + method + " "));
+  }
+
+private:
+  QTcpServer server;
+  QHash<QTcpSocket *, QByteArray> buffers;
+
+  static QByteArray etag(const QString &fileName) {
+    QFile file(fileName);
+    file.open(QIODevice::ReadOnly);
+    return '"' +
+           QCryptographicHash::hash(file.readAll(), QCryptographicHash::Md5)
+               .toHex() +
+           '"';
+  }
+
+  static QByteArray entry(const QString &href, const QFileInfo &info) {
+    QByteArray response = "<d:response><d:href>" +
+                          QUrl::toPercentEncoding(href, "/") +
+                          "</d:href><d:propstat><d:prop>";
+    if (info.isDir())
+      response += "<d:resourcetype><d:collection/></d:resourcetype>";
+    else
+      response += "<d:resourcetype/><d:getetag>" +
+                  etag(info.filePath()) + "</d:getetag>";
+    return response + "</d:prop><d:status>HTTP/1.1 200 OK</d:status>"
+                      "</d:propstat></d:response>";
+  }
+
+  static void reply(QTcpSocket *socket, int status,
+                    const QByteArray &body = QByteArray(),
+                    const QByteArray &headers = QByteArray()) {
+    socket->write("HTTP/1.1 " + QByteArray::number(status) +
+                  " Status\r\nConnection: close\r\nContent-Length: " +
+                  QByteArray::number(body.size()) + "\r\n" + headers +
+                  "\r\n" + body);
+    socket->disconnectFromHost();
+  }
+
+  void accept() {
+    while (server.hasPendingConnections()) {
+      QTcpSocket *socket = server.nextPendingConnection();
+      connect(socket, &QTcpSocket::readyRead, this,
+              [this, socket]() { received(socket); });
+      connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+        buffers.remove(socket);
+        socket->deleteLater();
+      });
+    }
+  }
+
+  void received(QTcpSocket *socket) {
+    QByteArray &buffer = buffers[socket];
+    buffer += socket->readAll();
+    int end = buffer.indexOf("\r\n\r\n");
+    if (end < 0)
+      return;
+    QList<QByteArray> lines = buffer.left(end).split('\n');
+    QList<QByteArray> requestLine = lines.takeFirst().trimmed().split(' ');
+    QMap<QByteArray, QByteArray> headers;
+    foreach (const QByteArray &line, lines) {
+      int colon = line.indexOf(':');
+      headers.insert(line.left(colon).trimmed().toLower(),
+                     line.mid(colon + 1).trimmed());
+    }
+    int length = headers.value("content-length").toInt();
+    if (buffer.size() < end + 4 + length)
+      return;
+    QByteArray body = buffer.mid(end + 4, length);
+    buffer.clear();
+
+    QByteArray method = requestLine.value(0);
+    QString path = QUrl::fromPercentEncoding(requestLine.value(1));
+    requests << QString(method) + " " + path;
+    if (!path.startsWith("/store/")) {
+      reply(socket, 404);
+      return;
+    }
+    QString relative = path.mid(7);
+    QString fileName = QDir::cleanPath(files.filePath(relative));
+    QFileInfo info(fileName);
+    QByteArray ifMatch = headers.value("if-match");
+
+    if (method == "PROPFIND") {
+      if (!info.exists()) {
+        reply(socket, 404);
+        return;
+      }
+      QByteArray listing = "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+                           "<d:multistatus xmlns:d=\"DAV:\">" +
+                           entry(path, info);
+      if (info.isDir()) {
+        foreach (const QFileInfo &child,
+                 QDir(fileName).entryInfoList(QDir::AllEntries | QDir::Hidden |
+                                              QDir::NoDotAndDotDot)) {
+          listing += entry(path + child.fileName() +
+                               (child.isDir() ? "/" : ""),
+                           child);
+        }
+      }
+      reply(socket, 207, listing + "</d:multistatus>");
+    } else if (method == "GET") {
+      QFile file(fileName);
+      if (!info.isFile() || !file.open(QIODevice::ReadOnly))
+        reply(socket, 404);
+      else
+        reply(socket, 200, file.readAll(), "ETag: " + etag(fileName) + "\r\n");
+    } else if (method == "PUT") {
+      bool changed = !info.isFile() || etag(fileName) != ifMatch;
+      if ((!ifMatch.isEmpty() && changed) ||
+          (headers.value("if-none-match") == "*" && info.exists())) {
+        reply(socket, 412);
+        return;
+      }
+      write(relative, body);
+      reply(socket, 201, QByteArray(), "ETag: " + etag(fileName) + "\r\n");
+    } else if (method == "DELETE") {
+      if (info.isDir())
+        reply(socket, QDir(fileName).removeRecursively() ? 204 : 500);
+      else if (!info.isFile())
+        reply(socket, 404);
+      else if (!ifMatch.isEmpty() && etag(fileName) != ifMatch)
+        reply(socket, 412);
+      else
+        reply(socket, QFile::remove(fileName) ? 204 : 500);
+    } else if (method == "MKCOL") {
+      reply(socket, info.exists() ? 405 : QDir().mkdir(fileName) ? 201 : 409);
+    } else {
+      reply(socket, 405);
+    }
+  }
+};
+
+/**
+ * @brief The tst_webdav class tests WebDavSync against FakeDav
+ */
+class tst_webdav : public QObject {
+  Q_OBJECT
+
+private:
+  FakeDav *dav;
+  QTemporaryDir *local;
+  WebDavSync *webDav;
+
+  bool sync();
+  void writeLocal(const QString &path, const QByteArray &data);
+  QByteArray readLocal(const QString &path);
+
+private Q_SLOTS:
+  void init();
+  void cleanup();
+  void initialPull();
+  void onlyChangesTransferred();
+  void deletions();
+  void folderDeletion();
+  void specialCharacters();
+  void conflict();
+};
+
+/**
+ * @brief tst_webdav::init a server with a small store and an empty local
+ * folder
+ */
+void tst_webdav::init() {
+  dav = new FakeDav;
+  QVERIFY(dav->start());
+  dav->write(".gpg-id", "ABCDEF\n");
+  dav->write("a.gpg", "a1");
+  dav->write("sub/b.gpg", "b1");
+  dav->write(".git/config", "not synced");
+  local = new QTemporaryDir;
+  QVERIFY(local->isValid());
+  webDav = new WebDavSync;
+  webDav->setRemote(dav->url());
+  webDav->setLocalRoot(local->path());
+}
+
+/**
+ * @brief tst_webdav::cleanup
+ */
+void tst_webdav::cleanup() {
+  delete webDav;
+  delete local;
+  delete dav;
+}
+
+/**
+ * @brief tst_webdav::sync run one sync to its end
+ * @return whether it succeeded
+ */
+bool tst_webdav::sync() {
+  QSignalSpy spy(webDav, SIGNAL(finished(bool, const QString &)));
+  dav->requests.clear();
+  webDav->sync();
+  if (!spy.wait(10000))
+    return false;
+  if (!spy.first().at(0).toBool())
+    qWarning() << spy.first().at(1).toString();
+  return spy.first().at(0).toBool();
+}
+
+void tst_webdav::writeLocal(const QString &path, const QByteArray &data) {
+  QFile file(local->filePath(path));
+  QVERIFY(file.open(QIODevice::WriteOnly));
+  file.write(data);
+}
+
+QByteArray tst_webdav::readLocal(const QString &path) {
+  QFile file(local->filePath(path));
+  file.open(QIODevice::ReadOnly);
+  return file.readAll();
+}
+
+/**
+ * @brief tst_webdav::initialPull an empty folder gets the whole store,
+ * without hidden folders
+ */
+void tst_webdav::initialPull() {
+  QVERIFY(sync());
+  QCOMPARE(webDav->downloaded(), 3);
+  QCOMPARE(webDav->uploaded(), 0);
+  QCOMPARE(readLocal(".gpg-id"), QByteArray("ABCDEF\n"));
+  QCOMPARE(readLocal("a.gpg"), QByteArray("a1"));
+  QCOMPARE(readLocal("sub/b.gpg"), QByteArray("b1"));
+  QVERIFY(!QFile::exists(local->filePath(".git")));
+  QVERIFY(QFile::exists(local->filePath(WebDavSync::stateFile)));
+  QVERIFY(dav->requested("PUT").isEmpty());
+}
+
+/**
+ * @brief tst_webdav::onlyChangesTransferred a second sync only moves what
+ * changed since the first
+ */
+void tst_webdav::onlyChangesTransferred() {
+  QVERIFY(sync());
+
+  QVERIFY(sync());
+  QCOMPARE(webDav->downloaded(), 0);
+  QCOMPARE(webDav->uploaded(), 0);
+  QVERIFY(dav->requested("GET").isEmpty());
+
+  dav->write("sub/b.gpg", "b2");
+  writeLocal("a.gpg", "a2");
+  QVERIFY(QDir(local->path()).mkpath("new/deeper"));
+  writeLocal("new/deeper/c.gpg", "c1");
+  QVERIFY(sync());
+  QCOMPARE(dav->requested("GET"), QStringList() << "GET /store/sub/b.gpg");
+  QCOMPARE(dav->requested("PUT").size(), 2);
+  QCOMPARE(dav->requested("MKCOL"),
+           QStringList() << "MKCOL /store/new/" << "MKCOL /store/new/deeper/");
+  QCOMPARE(readLocal("sub/b.gpg"), QByteArray("b2"));
+  QCOMPARE(dav->read("a.gpg"), QByteArray("a2"));
+  QCOMPARE(dav->read("new/deeper/c.gpg"), QByteArray("c1"));
+
+  QVERIFY(sync());
+  QVERIFY(dav->requested("GET").isEmpty());
+  QVERIFY(dav->requested("PUT").isEmpty());
+}
+
+/**
+ * @brief tst_webdav::deletions files removed on one side go on the other
+ */
+void tst_webdav::deletions() {
+  QVERIFY(sync());
+  QVERIFY(QFile::remove(dav->files.filePath("a.gpg")));
+  QVERIFY(QFile::remove(local->filePath("sub/b.gpg")));
+  QVERIFY(sync());
+  QCOMPARE(webDav->deleted(), 2);
+  QVERIFY(!QFile::exists(local->filePath("a.gpg")));
+  QVERIFY(!QFile::exists(dav->files.filePath("sub/b.gpg")));
+  QCOMPARE(dav->requested("DELETE"),
+           QStringList() << "DELETE /store/sub/b.gpg");
+  QVERIFY(dav->requested("GET").isEmpty());
+}
+
+/**
+ * @brief tst_webdav::folderDeletion a folder removed locally is removed on
+ * the server, unless something was added to it there
+ */
+void tst_webdav::folderDeletion() {
+  dav->write("sub/deeper/c.gpg", "c1");
+  dav->write("kept/d.gpg", "d1");
+  QVERIFY(sync());
+  QVERIFY(QDir(local->filePath("sub")).removeRecursively());
+  QVERIFY(QDir(local->filePath("kept")).removeRecursively());
+  dav->write("kept/e.gpg", "e1");
+  QVERIFY(sync());
+  QStringList deletes = dav->requested("DELETE");
+  deletes.sort();
+  QCOMPARE(deletes, QStringList() << "DELETE /store/kept/d.gpg"
+                                  << "DELETE /store/sub/");
+  QVERIFY(!QFileInfo::exists(dav->files.filePath("sub")));
+  QVERIFY(!QFileInfo::exists(local->filePath("sub")));
+  QCOMPARE(readLocal("kept/e.gpg"), QByteArray("e1"));
+  QCOMPARE(webDav->deleted(), 3);
+
+  QVERIFY(sync());
+  QVERIFY(dav->requested("DELETE").isEmpty());
+  QVERIFY(!QFileInfo::exists(local->filePath("sub")));
+}
+
+/**
+ * @brief tst_webdav::specialCharacters % and # in names are part of the
+ * name, not escapes or a fragment
+ */
+void tst_webdav::specialCharacters() {
+  dav->write("100%41.gpg", "percent");
+  QVERIFY(sync());
+  QCOMPARE(readLocal("100%41.gpg"), QByteArray("percent"));
+  writeLocal("issue #1.gpg", "hash");
+  QVERIFY(sync());
+  QCOMPARE(dav->requested("PUT"), QStringList() << "PUT /store/issue #1.gpg");
+  QCOMPARE(dav->read("issue #1.gpg"), QByteArray("hash"));
+  QVERIFY(sync());
+  QVERIFY(dav->requested("GET").isEmpty());
+  QVERIFY(dav->requested("PUT").isEmpty());
+}
+
+/**
+ * @brief tst_webdav::conflict when both sides changed a file the remote one
+ * wins and the local one is kept as a conflict copy
+ */
+void tst_webdav::conflict() {
+  QVERIFY(sync());
+  dav->write("a.gpg", "remote");
+  writeLocal("a.gpg", "local");
+  QVERIFY(sync());
+  QCOMPARE(readLocal("a.gpg"), QByteArray("remote"));
+  QCOMPARE(readLocal("a.conflict.gpg"), QByteArray("local"));
+  QCOMPARE(dav->read("a.gpg"), QByteArray("remote"));
+  QCOMPARE(dav->read("a.conflict.gpg"), QByteArray("local"));
+}
+
+QTEST_MAIN(tst_webdav)
+#include "tst_webdav.moc"
@@ -0,0 +1,42 @@
+!include(../../qtpass.pri) { error("Couldn't find the qtpass.pri file!") }
+
+TEMPLATE = app
+TARGET = bench_qtpass
+CONFIG += qt warn_on depend_includepath
+QT += testlib widgets
+
+SOURCES += bench_qtpass.cpp \
+           benchcompare.cpp
+
+HEADERS += benchcompare.h
+
+LIBS = -L"$$OUT_PWD/../../src/$(OBJECTS_DIR)" -lqtpass $$LIBS
+
+OBJ_PATH += ../../src/$(OBJECTS_DIR)
+
+VPATH += ../../src
+INCLUDEPATH += ../../src
+
+OTHER_FILES += stubs/gpg \
+               stubs/git \
+               stubs/pass
+
+# not part of make check, run with make bench, results end up in bench.xml
+bench.target = bench
+bench.commands = QT_QPA_PLATFORM=offscreen ./$(TARGET) -xml -o bench.xml
+bench.depends = $(TARGET)
+
+# fails on benchmarks that got slower than baseline.json allows, or that it
+# has no value for, unless BENCH_COMPARE_FLAGS=--allow-missing-baseline. The
+# baseline is not committed, make bench-baseline records it on this machine
+benchcompare.target = bench-compare
+benchcompare.commands = ./$(TARGET) --compare $(BENCH_COMPARE_FLAGS) $$PWD/baseline.json bench.xml
+benchcompare.depends = bench
+
+# record the results of this machine as the new baseline
+benchbaseline.target = bench-baseline
+benchbaseline.commands = ./$(TARGET) --update-baseline $$PWD/baseline.json bench.xml
+benchbaseline.depends = bench
+
+QMAKE_EXTRA_TARGETS += bench benchcompare benchbaseline
+QMAKE_CLEAN += bench.xml
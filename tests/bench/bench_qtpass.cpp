@@ -0,0 +1,452 @@
+#include "../../src/executor.h"
+#include "../../src/filecontent.h"
+#include "../../src/imitatepass.h"
+#include "../../src/qtpasssettings.h"
+#include "../../src/storeindex.h"
+#include "../../src/storemodel.h"
+#include "benchcompare.h"
+#include <QApplication>
+#include <QEventLoop>
+#include <QFileSystemModel>
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+#include <QTemporaryDir>
+#include <QtTest>
+
+/**
+ * @brief The bench_qtpass class measures the hot paths against synthetic
+ * stores, with stub gpg, git and pass executables standing in for the real
+ * ones.
+ *
+ * Run with -xml (make bench does) for machine-readable results. The largest
+ * store is limited with QTPASS_BENCH_MAX_ENTRIES, the stubs answer after
+ * QTPASS_STUB_LATENCY_MS.
+ */
+class bench_qtpass : public QObject {
+  Q_OBJECT
+
+public:
+  bench_qtpass();
+
+private Q_SLOTS:
+  void initTestCase();
+  void cleanupTestCase();
+  void modelLoad_data();
+  void modelLoad();
+  void indexLoad_data();
+  void indexLoad();
+  void searchAsYouType_data();
+  void searchAsYouType();
+  void reencryptPath_data();
+  void reencryptPath();
+  void listKeys_data();
+  void listKeys();
+  void fileContentParse_data();
+  void fileContentParse();
+  void executorThroughput_data();
+  void executorThroughput();
+
+private:
+  QString store(int entries, bool deep);
+  void storeData();
+
+  QString m_stubs;
+  int m_maxEntries;
+  QHash<QString, QSharedPointer<QTemporaryDir>> m_stores;
+};
+
+/**
+ * @brief generateStore write a synthetic password-store
+ *
+ * Flat stores keep every entry in the root, deep stores spread them over
+ * three levels of ten folders each, with a .gpg-id in every top level folder.
+ * @param root
+ * @param entries
+ * @param deep
+ * @return false if a file could not be written
+ */
+static bool generateStore(const QString &root, int entries, bool deep) {
+  QDir dir(root);
+  QFile rootId(dir.filePath(".gpg-id"));
+  if (!rootId.open(QIODevice::WriteOnly) ||
+      rootId.write("1111111111111111\n") < 0)
+    return false;
+  rootId.close();
+  if (deep) {
+    for (int team = 0; team < 10; ++team) {
+      QString teamDir = QString("team%1").arg(team);
+      if (!dir.mkpath(teamDir))
+        return false;
+      QFile teamId(dir.filePath(teamDir + "/.gpg-id"));
+      QByteArray key = QByteArray(15, '2') + QByteArray::number(team) + "\n";
+      if (!teamId.open(QIODevice::WriteOnly) || teamId.write(key) < 0)
+        return false;
+    }
+  }
+  for (int n = 0; n < entries; ++n) {
+    QString path = QString("site%1.example.org.gpg").arg(n);
+    if (deep) {
+      path = QString("team%1/group%2/unit%3/")
+                 .arg(n % 10)
+                 .arg(n / 10 % 10)
+                 .arg(n / 100 % 10) +
+             path;
+      if (n < 1000 && !dir.mkpath(QFileInfo(dir.filePath(path)).path()))
+        return false;
+    }
+    QFile file(dir.filePath(path));
+    if (!file.open(QIODevice::WriteOnly) ||
+        file.write(QString("password%1\nlogin: user%1\n"
+                           "url: https://site%1.example.org/\n")
+                       .arg(n)
+                       .toUtf8()) < 0)
+      return false;
+  }
+  return true;
+}
+
+/**
+ * @brief loadModel list the whole store in model, like expanding every
+ * folder in the tree view
+ * @param model
+ * @param root
+ * @return number of directories that were loaded, -1 on timeout
+ */
+static int loadModel(QFileSystemModel *model, const QString &root) {
+  QSet<QString> pending;
+  int loaded = 0;
+  QEventLoop loop;
+  QMetaObject::Connection connection = QObject::connect(
+      model, &QFileSystemModel::directoryLoaded, [&](const QString &path) {
+        QString dir = QDir::cleanPath(path);
+        if (!pending.remove(dir))
+          return;
+        ++loaded;
+        QModelIndex parent = model->index(dir);
+        for (int row = 0; row < model->rowCount(parent); ++row) {
+          QModelIndex child = model->index(row, 0, parent);
+          if (!model->isDir(child))
+            continue;
+          pending.insert(QDir::cleanPath(model->filePath(child)));
+          model->fetchMore(child);
+        }
+        if (pending.isEmpty())
+          loop.quit();
+      });
+  pending.insert(QDir::cleanPath(root));
+  model->fetchMore(model->setRootPath(root));
+  QTimer::singleShot(600000, &loop, SLOT(quit()));
+  loop.exec();
+  QObject::disconnect(connection);
+  return pending.isEmpty() ? loaded : -1;
+}
+
+/**
+ * @brief countRows walk the proxy like a fully expanded view does
+ * @param model
+ * @param parent
+ * @return number of visible rows
+ */
+static int countRows(QAbstractItemModel *model, const QModelIndex &parent) {
+  int rows = model->rowCount(parent);
+  int count = rows;
+  for (int row = 0; row < rows; ++row)
+    count += countRows(model, model->index(row, 0, parent));
+  return count;
+}
+
+/**
+ * @brief bench_qtpass::bench_qtpass
+ */
+bench_qtpass::bench_qtpass() : m_maxEntries(100000) {}
+
+/**
+ * @brief bench_qtpass::initTestCase point the settings at the stubs, in a
+ * portable qtpass.ini next to the benchmark so the user settings are left
+ * alone
+ */
+void bench_qtpass::initTestCase() {
+  QString stub = QFINDTESTDATA("stubs/gpg");
+  QVERIFY2(!stub.isEmpty(), "stub executables not found");
+  m_stubs = QFileInfo(stub).absolutePath();
+  QFile ini(QCoreApplication::applicationDirPath() + "/qtpass.ini");
+  QVERIFY(ini.open(QIODevice::WriteOnly | QIODevice::Truncate));
+  ini.close();
+
+  if (qEnvironmentVariableIsSet("QTPASS_BENCH_MAX_ENTRIES"))
+    m_maxEntries = qgetenv("QTPASS_BENCH_MAX_ENTRIES").toInt();
+  QtPassSettings::setGpgExecutable(m_stubs + "/gpg");
+  QtPassSettings::setGitExecutable(m_stubs + "/git");
+  QtPassSettings::setPassExecutable(m_stubs + "/pass");
+  QtPassSettings::setUsePass(false);
+  QtPassSettings::setUseGit(false);
+  QtPassSettings::setAutoPull(false);
+  QtPassSettings::setAddGPGId(false);
+}
+
+/**
+ * @brief bench_qtpass::cleanupTestCase drop the stores and the settings
+ */
+void bench_qtpass::cleanupTestCase() {
+  m_stores.clear();
+  QFile::remove(QCoreApplication::applicationDirPath() + "/qtpass.ini");
+}
+
+/**
+ * @brief bench_qtpass::store a synthetic store, generated on first use and
+ * shared by the benchmarks
+ * @param entries
+ * @param deep
+ * @return path of the store root, empty if it could not be written
+ */
+QString bench_qtpass::store(int entries, bool deep) {
+  QString key = QString("%1-%2").arg(entries).arg(deep);
+  if (!m_stores.contains(key)) {
+    QSharedPointer<QTemporaryDir> dir(new QTemporaryDir);
+    if (!dir->isValid() || !generateStore(dir->path(), entries, deep))
+      return QString();
+    m_stores.insert(key, dir);
+  }
+  return m_stores.value(key)->path();
+}
+
+/**
+ * @brief bench_qtpass::storeData store sizes and layouts, up to
+ * QTPASS_BENCH_MAX_ENTRIES entries
+ */
+void bench_qtpass::storeData() {
+  QTest::addColumn<int>("entries");
+  QTest::addColumn<bool>("deep");
+  foreach (int entries, QList<int>({1000, 10000, 100000})) {
+    if (entries > m_maxEntries)
+      continue;
+    QTest::newRow(qPrintable(QString("flat-%1").arg(entries)))
+        << entries << false;
+    QTest::newRow(qPrintable(QString("deep-%1").arg(entries)))
+        << entries << true;
+  }
+}
+
+void bench_qtpass::modelLoad_data() { storeData(); }
+
+/**
+ * @brief bench_qtpass::modelLoad list the whole store through
+ * QFileSystemModel and StoreModel, as the main window does
+ */
+void bench_qtpass::modelLoad() {
+  QFETCH(int, entries);
+  QFETCH(bool, deep);
+  QString root = store(entries, deep);
+  QVERIFY(!root.isEmpty());
+  QBENCHMARK {
+    QFileSystemModel model;
+    model.setNameFilters(QStringList() << "*.gpg");
+    model.setNameFilterDisables(false);
+    StoreModel proxy;
+    proxy.setSourceModel(&model);
+    proxy.setModelAndStore(&model, root);
+    QVERIFY(loadModel(&model, root) > 0);
+  }
+}
+
+void bench_qtpass::indexLoad_data() { storeData(); }
+
+/**
+ * @brief bench_qtpass::indexLoad build the StoreIndex from scratch
+ */
+void bench_qtpass::indexLoad() {
+  QFETCH(int, entries);
+  QFETCH(bool, deep);
+  QString root = store(entries, deep);
+  QVERIFY(!root.isEmpty());
+  StoreIndex index;
+  index.setRoot(root);
+  QBENCHMARK {
+    index.invalidate();
+    QCOMPARE(index.entries().size(), entries);
+  }
+}
+
+void bench_qtpass::searchAsYouType_data() { storeData(); }
+
+/**
+ * @brief bench_qtpass::searchAsYouType filter the loaded tree once per typed
+ * character, as the search box does, and walk the result like the expanded
+ * view
+ */
+void bench_qtpass::searchAsYouType() {
+  QFETCH(int, entries);
+  QFETCH(bool, deep);
+  QString root = store(entries, deep);
+  QVERIFY(!root.isEmpty());
+  QFileSystemModel model;
+  model.setNameFilters(QStringList() << "*.gpg");
+  model.setNameFilterDisables(false);
+  StoreModel proxy;
+  proxy.setSourceModel(&model);
+  proxy.setModelAndStore(&model, root);
+  QVERIFY(loadModel(&model, root) > 0);
+
+  const QString typed = "site 42 exa";
+  QBENCHMARK {
+    for (int n = 1; n <= typed.length(); ++n) {
+      QString query = typed.left(n);
+      query.replace(QRegExp(" "), ".*");
+      proxy.setFilterRegExp(QRegExp(query, Qt::CaseInsensitive));
+      countRows(&proxy, proxy.mapFromSource(model.index(root)));
+    }
+  }
+}
+
+/**
+ * @brief bench_qtpass::reencryptPath_data number of files re-encrypted and
+ * stub latency
+ */
+void bench_qtpass::reencryptPath_data() {
+  QTest::addColumn<int>("entries");
+  QTest::addColumn<int>("latency");
+  QTest::newRow("100") << 100 << 0;
+  QTest::newRow("1000") << 1000 << 0;
+  QTest::newRow("100-10ms") << 100 << 10;
+}
+
+/**
+ * @brief bench_qtpass::reencryptPath change the recipients of a folder, the
+ * stub gpg reports a different key for every file so all are re-encrypted
+ */
+void bench_qtpass::reencryptPath() {
+  QFETCH(int, entries);
+  QFETCH(int, latency);
+  if (entries > m_maxEntries)
+    QSKIP("store larger than QTPASS_BENCH_MAX_ENTRIES");
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  QVERIFY(generateStore(dir.path(), entries, false));
+  QtPassSettings::setPassStore(dir.path() + "/");
+  qputenv("QTPASS_STUB_LATENCY_MS", QByteArray::number(latency));
+
+  UserInfo user;
+  user.key_id = "3333333333333333";
+  user.enabled = true;
+  user.have_secret = true;
+  ImitatePass pass;
+  QBENCHMARK_ONCE {
+    QSignalSpy failed(&pass, SIGNAL(processErrorExit(int, QString)));
+    QSignalSpy done(&pass, SIGNAL(finishedInit(QString, QString)));
+    pass.Init(dir.path() + "/", {user});
+    QVERIFY(done.wait(600000));
+    QCOMPARE(failed.count(), 0);
+  }
+  qunsetenv("QTPASS_STUB_LATENCY_MS");
+}
+
+/**
+ * @brief bench_qtpass::listKeys_data number of keys gpg reports
+ */
+void bench_qtpass::listKeys_data() {
+  QTest::addColumn<int>("keys");
+  QTest::newRow("10") << 10;
+  QTest::newRow("100") << 100;
+  QTest::newRow("1000") << 1000;
+}
+
+/**
+ * @brief bench_qtpass::listKeys run and parse gpg --list-keys --with-colons
+ */
+void bench_qtpass::listKeys() {
+  QFETCH(int, keys);
+  qputenv("QTPASS_STUB_KEYS", QByteArray::number(keys));
+  ImitatePass pass;
+  QBENCHMARK { QCOMPARE(pass.listKeys().size(), keys); }
+  qunsetenv("QTPASS_STUB_KEYS");
+}
+
+/**
+ * @brief bench_qtpass::fileContentParse_data entry sizes and templates
+ */
+void bench_qtpass::fileContentParse_data() {
+  QTest::addColumn<QString>("content");
+  QTest::addColumn<QStringList>("templateFields");
+  QTest::addColumn<bool>("allFields");
+
+  QString fields;
+  for (int n = 0; n < 50; ++n)
+    fields += QString("field%1: value %1\n").arg(n);
+  QString large = "password\n";
+  while (large.size() < 1024 * 1024)
+    large += "login: user\nnotes: some remaining text that is not a field\n";
+
+  QTest::newRow("small") << "password\nlogin: user\nurl: https://x.org\n"
+                         << QStringList({"login", "url"}) << false;
+  QTest::newRow("50-fields") << "password\n" + fields
+                             << QStringList({"field1", "field2"}) << true;
+  QTest::newRow("1MB") << large << QStringList({"login"}) << false;
+}
+
+/**
+ * @brief bench_qtpass::fileContentParse split an entry into password,
+ * fields and the rest
+ */
+void bench_qtpass::fileContentParse() {
+  QFETCH(QString, content);
+  QFETCH(QStringList, templateFields);
+  QFETCH(bool, allFields);
+  QBENCHMARK {
+    FileContent parsed =
+        FileContent::parse(content, templateFields, allFields);
+    QVERIFY(!parsed.getPassword().isEmpty());
+  }
+}
+
+/**
+ * @brief bench_qtpass::executorThroughput_data queued processes and stub
+ * latency
+ */
+void bench_qtpass::executorThroughput_data() {
+  QTest::addColumn<int>("processes");
+  QTest::addColumn<int>("latency");
+  QTest::newRow("100") << 100 << 0;
+  QTest::newRow("20-10ms") << 20 << 10;
+}
+
+/**
+ * @brief bench_qtpass::executorThroughput queue processes and wait for the
+ * last one, measures spawn and queue overhead
+ */
+void bench_qtpass::executorThroughput() {
+  QFETCH(int, processes);
+  QFETCH(int, latency);
+  qputenv("QTPASS_STUB_LATENCY_MS", QByteArray::number(latency));
+  Executor exec;
+  QSignalSpy finished(
+      &exec, SIGNAL(finished(int, int, QByteArray, QByteArray, quint64)));
+  QBENCHMARK {
+    finished.clear();
+    for (int n = 0; n < processes; ++n)
+      exec.execute(n, m_stubs + "/git", {"--version"}, true);
+    QTRY_COMPARE_WITH_TIMEOUT(finished.count(), processes, 600000);
+  }
+  qunsetenv("QTPASS_STUB_LATENCY_MS");
+}
+
+/**
+ * @brief main run the benchmarks, or compare a results file to the baseline
+ * with --compare or --update-baseline
+ * @param argc
+ * @param argv
+ * @return
+ */
+int main(int argc, char *argv[]) {
+  if (argc > 1 && (qstrcmp(argv[1], "--compare") == 0 ||
+                   qstrcmp(argv[1], "--update-baseline") == 0)) {
+    QCoreApplication app(argc, argv);
+    return BenchCompare::run(app.arguments().mid(1));
+  }
+  QApplication app(argc, argv);
+  bench_qtpass bench;
+  QTEST_SET_MAIN_SOURCE_PATH
+  return QTest::qExec(&bench, argc, argv);
+}
+
+#include "bench_qtpass.moc"
@@ -0,0 +1,256 @@
+#include "benchcompare.h"
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+#include <QTextStream>
+#include <QXmlStreamReader>
+
+constexpr double BenchCompare::defaultTolerance;
+
+/**
+ * @brief BenchCompare::run handle the command line of --compare and
+ * --update-baseline
+ * @param args  mode, --allow-missing-baseline for --compare, baseline and
+ *              results file
+ * @return 0 when nothing regressed, 1 on regressions or benchmarks without
+ * baseline, 2 on errors
+ */
+int BenchCompare::run(const QStringList &args) {
+  QTextStream err(stderr);
+  QStringList files = args.mid(1);
+  bool allowMissingBaseline = files.removeAll("--allow-missing-baseline") > 0;
+  if (files.size() != 2 ||
+      (allowMissingBaseline && args.at(0) != "--compare")) {
+    err << "Usage: bench_qtpass --compare [--allow-missing-baseline] "
+           "<baseline.json> <bench.xml>\n"
+           "       bench_qtpass --update-baseline <baseline.json> "
+           "<bench.xml>\n";
+    return 2;
+  }
+  QMap<QString, result> results;
+  QString error;
+  if (!readResults(files.at(1), &results, &error)) {
+    err << error << "\n";
+    return 2;
+  }
+  if (args.at(0) == "--update-baseline")
+    return updateBaseline(files.at(0), results);
+  return compare(files.at(0), results, allowMissingBaseline);
+}
+
+/**
+ * @brief BenchCompare::readResults collect the benchmark results of a QtTest
+ * XML log
+ * @param fileName
+ * @param results   keyed by function:row
+ * @param error
+ * @return false if the file can not be read or parsed
+ */
+bool BenchCompare::readResults(const QString &fileName,
+                               QMap<QString, result> *results,
+                               QString *error) {
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    *error = QString("Cannot read %1: %2").arg(fileName, file.errorString());
+    return false;
+  }
+  QXmlStreamReader xml(&file);
+  QString function;
+  while (!xml.atEnd()) {
+    if (xml.readNext() != QXmlStreamReader::StartElement)
+      continue;
+    QXmlStreamAttributes attributes = xml.attributes();
+    if (xml.name() == "TestFunction") {
+      function = attributes.value("name").toString();
+    } else if (xml.name() == "BenchmarkResult") {
+      // value is the total over all iterations
+      double iterations =
+          qMax(1.0, attributes.value("iterations").toString().toDouble());
+      result r = {attributes.value("metric").toString(),
+                  attributes.value("value").toString().toDouble() /
+                      iterations};
+      QString tag = attributes.value("tag").toString();
+      results->insert(tag.isEmpty() ? function : function + ":" + tag, r);
+    }
+  }
+  if (xml.hasError()) {
+    *error = QString("Cannot parse %1: %2").arg(fileName, xml.errorString());
+    return false;
+  }
+  if (results->isEmpty()) {
+    *error = QString("No benchmark results in %1").arg(fileName);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief readBaseline
+ * @param fileName
+ * @param baseline  receives the baseline document
+ * @return false if it can not be read
+ */
+static bool readBaseline(const QString &fileName, QJsonObject *baseline) {
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    QTextStream(stderr) << "Cannot read " << fileName << ": "
+                        << file.errorString() << "\n";
+    return false;
+  }
+  QJsonParseError parseError;
+  QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+  if (!document.isObject()) {
+    QTextStream(stderr) << "Cannot parse " << fileName << ": "
+                        << parseError.errorString() << "\n";
+    return false;
+  }
+  *baseline = document.object();
+  return true;
+}
+
+/**
+ * @brief BenchCompare::compare print a table of the results next to the
+ * baseline
+ * @param baselineFile
+ * @param results
+ * @param allowMissingBaseline  do not fail on results without baseline value
+ * @return 1 if a benchmark got slower than its tolerance allows or has no
+ * baseline to compare to, 2 if there is no baseline file, 0 otherwise
+ */
+int BenchCompare::compare(const QString &baselineFile,
+                          const QMap<QString, result> &results,
+                          bool allowMissingBaseline) {
+  QJsonObject baseline;
+  if (!QFile::exists(baselineFile)) {
+    QTextStream(stderr) << "No baseline at " << baselineFile
+                        << ", record one on this machine with make "
+                           "bench-baseline.\n";
+    if (!allowMissingBaseline)
+      return 2;
+  } else if (!readBaseline(baselineFile, &baseline)) {
+    return 2;
+  }
+  QJsonObject benchmarks = baseline.value("benchmarks").toObject();
+
+  QTextStream out(stdout);
+  int width = 9;
+  QSet<QString> names = results.keys().toSet();
+  foreach (const QString &name, benchmarks.keys())
+    names.insert(name);
+  foreach (const QString &name, names)
+    width = qMax(width, name.length());
+  QStringList sorted = names.toList();
+  sorted.sort();
+
+  out << QString("benchmark").leftJustified(width) << "   baseline"
+      << "    current" << "   change" << "  allowed" << "  status\n";
+  int regressions = 0;
+  int unchecked = 0;
+  foreach (const QString &name, sorted) {
+    QJsonObject expected = benchmarks.value(name).toObject();
+    double allowed = expected.value("tolerance").toDouble(
+        baseline.value("tolerance").toDouble(tolerance(name)));
+    bool hasBaseline = expected.value("value").isDouble();
+    double before = expected.value("value").toDouble();
+    QString status;
+    QString change = "-";
+    if (!results.contains(name)) {
+      status = "missing";
+    } else if (!hasBaseline || before <= 0) {
+      status = allowMissingBaseline ? "new" : "NO BASELINE";
+      ++unchecked;
+    } else if (expected.contains("metric") &&
+               expected.value("metric").toString() !=
+                   results.value(name).metric) {
+      status = allowMissingBaseline ? "metric differs" : "METRIC DIFFERS";
+      ++unchecked;
+    } else {
+      double ratio = results.value(name).value / before - 1;
+      change = QString("%1%2%").arg(ratio >= 0 ? "+" : "").arg(
+          ratio * 100, 0, 'f', 1);
+      if (ratio > allowed) {
+        status = "SLOWER";
+        ++regressions;
+      } else {
+        status = ratio < -allowed ? "faster" : "ok";
+      }
+    }
+    out << name.leftJustified(width)
+        << (hasBaseline ? QString::number(before, 'f', 3) : QString("-"))
+               .rightJustified(11)
+        << (results.contains(name)
+                ? QString::number(results.value(name).value, 'f', 3)
+                : QString("-"))
+               .rightJustified(11)
+        << change.rightJustified(9)
+        << QString("%1%").arg(allowed * 100, 0, 'f', 0).rightJustified(9)
+        << "  " << status << "\n";
+  }
+  out << "\n"
+      << (regressions == 0
+              ? QString("No regressions.")
+              : QString("%1 benchmark(s) slower than allowed.")
+                    .arg(regressions))
+      << "\n";
+  if (unchecked > 0 && !allowMissingBaseline)
+    out << QString("%1 benchmark(s) without a baseline to compare to, record "
+                   "it with make bench-baseline or pass "
+                   "--allow-missing-baseline.")
+               .arg(unchecked)
+        << "\n";
+  bool failed = regressions > 0 || (unchecked > 0 && !allowMissingBaseline);
+  return failed ? 1 : 0;
+}
+
+/**
+ * @brief BenchCompare::updateBaseline store the results as the new
+ * baseline, keeping the tolerances
+ * @param baselineFile
+ * @param results
+ * @return 0 on success, 2 if the baseline can not be written
+ */
+int BenchCompare::updateBaseline(const QString &baselineFile,
+                                 const QMap<QString, result> &results) {
+  QJsonObject baseline;
+  if (QFile::exists(baselineFile) && !readBaseline(baselineFile, &baseline))
+    return 2;
+  QJsonObject benchmarks = baseline.value("benchmarks").toObject();
+  for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+    QJsonObject expected = benchmarks.value(it.key()).toObject();
+    if (!expected.contains("tolerance"))
+      expected["tolerance"] = tolerance(it.key());
+    expected["value"] = it.value().value;
+    expected["metric"] = it.value().metric;
+    benchmarks[it.key()] = expected;
+  }
+  baseline["benchmarks"] = benchmarks;
+
+  QFile file(baselineFile);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+      file.write(QJsonDocument(baseline).toJson()) < 0) {
+    QTextStream(stderr) << "Cannot write " << baselineFile << ": "
+                        << file.errorString() << "\n";
+    return 2;
+  }
+  QTextStream(stdout) << "Updated " << results.size() << " benchmarks in "
+                      << baselineFile << "\n";
+  return 0;
+}
+
+/**
+ * @brief BenchCompare::tolerance allowed slowdown of a benchmark a new
+ * baseline starts with. Those that wait for processes or the file system
+ * model vary more from run to run.
+ * @param benchmark   function:row
+ * @return
+ */
+double BenchCompare::tolerance(const QString &benchmark) {
+  QString function = benchmark.section(':', 0, 0);
+  if (function == "executorThroughput" || function == "listKeys" ||
+      function == "reencryptPath")
+    return 0.5;
+  if (function == "modelLoad")
+    return 0.35;
+  return defaultTolerance;
+}
@@ -0,0 +1,57 @@
+#ifndef BENCHCOMPARE_H
+#define BENCHCOMPARE_H
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+/*!
+    \class BenchCompare
+    \brief Compares benchmark results to a committed baseline.
+
+    Results are read from the QtTest XML bench_qtpass writes, the baseline is
+    a JSON file with the expected time per iteration and the slowdown each
+    benchmark may show before it counts as a regression:
+
+        {
+          "tolerance": 0.25,
+          "benchmarks": {
+            "modelLoad:flat-1000": { "value": 41.5, "tolerance": 0.5 }
+          }
+        }
+
+    No baseline is committed, timings only mean something on the machine
+    they were taken on. --update-baseline records one, with the tolerance of
+    tolerance() for new benchmarks. Without a baseline file, or a value in
+    it, the comparison fails unless --allow-missing-baseline is given.
+    Baseline entries the run did not produce, e.g. stores skipped with
+    QTPASS_BENCH_MAX_ENTRIES, are only reported.
+ */
+class BenchCompare {
+public:
+  /*!
+      \struct result
+      \brief Time per iteration of one benchmark row.
+   */
+  struct result {
+    QString metric;
+    double value;
+  };
+
+  static int run(const QStringList &args);
+  static bool readResults(const QString &fileName,
+                          QMap<QString, result> *results, QString *error);
+  static int compare(const QString &baselineFile,
+                     const QMap<QString, result> &results,
+                     bool allowMissingBaseline = false);
+  static int updateBaseline(const QString &baselineFile,
+                            const QMap<QString, result> &results);
+  static double tolerance(const QString &benchmark);
+
+  /**
+   * @brief defaultTolerance   allowed slowdown when the baseline sets none
+   */
+  static constexpr double defaultTolerance = 0.25;
+};
+
+#endif // BENCHCOMPARE_H
@@ -4,3 +4,5 @@ TEMPLATE = subdirs
 CONFIG += no_docs_target
 SUBDIRS += auto
 exists(manual): SUBDIRS += manual
+# the benchmarks are built by make bench, or always with qmake CONFIG+=bench
+unix:CONFIG(bench): SUBDIRS += bench